@@ -64,6 +64,18 @@ public:
     virtual zmsg_t *
     handleSocket(sphactor_event_t *ev) { if ( ev->msg ) zmsg_destroy(&ev->msg); return nullptr; }
 
+    // batches of messages, see sphactor_ask_set_batch
+    virtual zmsg_t *
+    handleSocketBatch(sphactor_event_t *ev)
+    {
+        zframe_t *frame = zmsg_first(ev->msg);
+        zmsg_t **msgs = (zmsg_t **) zframe_data(frame);
+        for (size_t i = 0; i < zframe_size(frame) / sizeof(zmsg_t *); i++)
+            zmsg_destroy(&msgs[i]);
+        zmsg_destroy(&ev->msg);
+        return nullptr;
+    }
+
     virtual zmsg_t *
     handleCustomSocket(sphactor_event_t *ev) { if ( ev->msg ) zmsg_destroy(&ev->msg); return nullptr; }
 
@@ -73,37 +85,38 @@ public:
     zmsg_t *handleMsg(sphactor_event_t *ev)
     {
         zmsg_t *ret = nullptr;
-        if ( streq(ev->type, "INIT") )
+        switch ( ev->kind )
         {
+        case SPHACTOR_EVENT_INIT:
             ret = this->handleInit(ev);
-        }
-        else if ( streq(ev->type, "TIME") )
-        {
+            break;
+        case SPHACTOR_EVENT_TIME:
             ret = this->handleTimer(ev);
-        }
-        else if ( streq(ev->type, "API") )
-        {
+            break;
+        case SPHACTOR_EVENT_API:
             ret = this->handleAPI(ev);
-        }
-        else if ( streq(ev->type, "SOCK") )
-        {
+            break;
+        case SPHACTOR_EVENT_SOCK:
             ret = this->handleSocket(ev);
-        }
-        else if ( streq(ev->type, "FDSOCK") )
-        {
+            break;
+        case SPHACTOR_EVENT_SOCKBATCH:
+            assert(ev->msg);
+            ret = this->handleSocketBatch(ev);
+            break;
+        case SPHACTOR_EVENT_FDSOCK:
             assert(ev->msg);
             ret = this->handleCustomSocket(ev);
-        }
-        else if ( streq(ev->type, "STOP") )
-        {
+            break;
+        case SPHACTOR_EVENT_STOP:
             ret = this->handleStop(ev);
-        }
-        else if ( streq(ev->type, "DESTROY") )
-        {
+            break;
+        case SPHACTOR_EVENT_DESTROY:
             delete this;
-        }
-        else
+            break;
+        default:
             zsys_error("Unhandled sphactor event: %s", ev->type);
+            break;
+        }
 
         if (ev->msg && ret != ev->msg)
             zmsg_destroy (&ev->msg);
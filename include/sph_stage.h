@@ -28,8 +28,8 @@ extern "C" {
 SPHACTOR_EXPORT sph_stage_t *
     sph_stage_new (const char *stage_name);
 
-//  Load a new stage from a stage config filepath.
-//  Returns NULL on failure.
+//  Load a new stage from a stage config filepath, either in text or in
+//  the snapshot format. Returns NULL on failure.
 SPHACTOR_EXPORT sph_stage_t *
     sph_stage_load (const char *config_path);
 
@@ -37,17 +37,51 @@ SPHACTOR_EXPORT sph_stage_t *
 SPHACTOR_EXPORT void
     sph_stage_destroy (sph_stage_t **self_p);
 
+//  Reload the stage from a stage config filepath, either in text or in the
+//  snapshot format, by comparing it to the running stage by actor uuid.
+//  Only added actors are created and only removed actors destroyed, an
+//  actor which changed type is created again. Running actors get their
+//  changed name, position and capability values and only the changed
+//  connections are made or broken. Untouched actors keep running.
+//  Returns the number of actors, or -1 on failure.
+SPHACTOR_EXPORT int
+    sph_stage_reload (sph_stage_t *self, const char *config_path);
+
 //  Save the stage to the active config filepath.
 //  Return -1 on failure or 0 on success.
 SPHACTOR_EXPORT int
     sph_stage_save (sph_stage_t *self);
 
 //  Save the stage to the a config filepath.
+//  The file is left alone if it is the file saved last, unchanged since,
+//  and the stage didn't change either.
 //  Return -1 on failure or 0 on success.
 SPHACTOR_EXPORT int
     sph_stage_save_as (sph_stage_t *self, const char *config_path);
 
-//  Clear the stage, destroying all actors in the stage.
+//  Save the stage to a config filepath as a binary snapshot, which loads
+//  faster than the text format. Saving the stage after this keeps the
+//  snapshot format, until saved as text with save_as.
+//  Return -1 on failure or 0 on success.
+SPHACTOR_EXPORT int
+    sph_stage_save_snapshot (sph_stage_t *self, const char *config_path);
+
+//  Convert a stage file between the text and the snapshot format, the
+//  destination gets the format the source doesn't have.
+//  Return -1 on failure or 0 on success.
+SPHACTOR_EXPORT int
+    sph_stage_convert (const char *source, const char *destination);
+
+//  Stop all actors in the stage at once and destroy them. With drain the
+//  actors first handle the messages in flight between them. Waits at most
+//  timeout msecs (-1 for no limit) for draining and for the actors to stop,
+//  actors which are later are still waited for as their threads can't be
+//  abandoned. Returns the number of actors which did not stop in time.
+SPHACTOR_EXPORT int
+    sph_stage_shutdown (sph_stage_t *self, int timeout, bool drain);
+
+//  Clear the stage, destroying all actors in the stage. All actors are told to
+//  stop at once and are destroyed once they all stopped.
 SPHACTOR_EXPORT int
     sph_stage_clear (sph_stage_t *self);
 
@@ -61,6 +95,16 @@ SPHACTOR_EXPORT const zhash_t *
 SPHACTOR_EXPORT sphactor_t *
     sph_stage_find_actor (sph_stage_t *self, const char *id);
 
+//  Find an actor by its endpoint. Returns a sphactor reference or NULL if not found.
+SPHACTOR_EXPORT sphactor_t *
+    sph_stage_find_actor_by_endpoint (sph_stage_t *self, const char *endpoint);
+
+//  Find an actor by its name. Names need not be unique, this returns the first
+//  actor added with the name, or renamed to it. Returns a sphactor reference
+//  or NULL if not found.
+SPHACTOR_EXPORT sphactor_t *
+    sph_stage_find_actor_by_name (sph_stage_t *self, const char *name);
+
 //  Remove an actor by it's identifier (uuid) and destroy it. Returns 0 if succesful -1 if not found.
 SPHACTOR_EXPORT int
     sph_stage_remove_actor (sph_stage_t *self, const char *id);
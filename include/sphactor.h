@@ -18,6 +18,24 @@
 extern "C" {
 #endif
 
+//  kinds of events, the same as the matching SPHACTOR_REPORT_* status except
+//  for INIT. 0 is never sent so a zeroed event or one from a caller which
+//  only fills in the type doesn't pass for an INIT event.
+#define SPHACTOR_EVENT_UNKNOWN   0
+#define SPHACTOR_EVENT_INIT      1
+#define SPHACTOR_EVENT_STOP      2
+#define SPHACTOR_EVENT_DESTROY   3
+#define SPHACTOR_EVENT_SOCK      4
+#define SPHACTOR_EVENT_TIME      5
+#define SPHACTOR_EVENT_FDSOCK    6
+#define SPHACTOR_EVENT_API       7
+#define SPHACTOR_EVENT_SOCKBATCH 8
+
+//  reserved timer ids of TIME events, the ids of timers the handler adds
+//  are larger than 0
+#define SPHACTOR_TIMER_TIMEOUT   0      //  the actor's timeout
+#define SPHACTOR_TIMER_INTERVAL  -1     //  the actor's interval
+
 //  sphactor event type is received by the handlers (perhaps we'll make this into a zproject class)
 typedef struct _sphactor_event_t{
     zmsg_t *msg;  // msg received on the socket
@@ -25,6 +43,8 @@ typedef struct _sphactor_event_t{
     const char  *name;  // name of the actor
     const char  *uuid;  // uuid of the actor
     const sphactor_actor_t  *actor;   // name of the actor
+    int         kind;   // type of event as SPHACTOR_EVENT_* constant, switch on this instead of comparing type
+    int         timer;  // id of the timer of a TIME event, SPHACTOR_TIMER_TIMEOUT (0) for the actor's timeout, SPHACTOR_TIMER_INTERVAL for its interval
 } sphactor_event_t;
 
 //  @warning THE FOLLOWING @INTERFACE BLOCK IS AUTO-GENERATED BY ZPROJECT
@@ -44,6 +64,17 @@ typedef void * (sphactor_constructor_fn) (
 SPHACTOR_EXPORT sphactor_t *
     sphactor_new (sphactor_handler_fn handler, void *arg, const char *name, zuuid_t *uuid);
 
+//  Constructor, creates a new Sphactor instance fused to upstream. The
+//  actor runs in the thread of upstream and its handler is called
+//  directly with every message upstream publishes, without passing a
+//  socket. Use it for chains of cheap actors. A fused actor still has
+//  its own report and answers the sphactor_ask_* methods, but it only
+//  gets the messages of upstream and it has no timer events. Connecting
+//  it or setting its timeout fails. Returns NULL if upstream is run by a
+//  sphactor_tick, which calls the handlers of its actors itself.
+SPHACTOR_EXPORT sphactor_t *
+    sphactor_new_fused (sphactor_handler_fn handler, void *arg, const char *name, zuuid_t *uuid, sphactor_t *upstream);
+
 //  Constructor, creates a new Sphactor instance by its typename.
 SPHACTOR_EXPORT sphactor_t *
     sphactor_new_by_type (const char *actor_type, const char *name, zuuid_t *uuid);
@@ -128,8 +159,17 @@ SPHACTOR_EXPORT void
 SPHACTOR_EXPORT int64_t
     sphactor_ask_timeout (sphactor_t *self);
 
+//  Have this Sphactor's actor handle a TIME event every interval usecs, 0
+//  to stop. Unlike the timeout this runs on a timerfd on Linux so it
+//  keeps periods below a millisecond. The report holds how late the
+//  events fired. The timer of the events is SPHACTOR_TIMER_INTERVAL.
+SPHACTOR_EXPORT void
+    sphactor_ask_set_interval (sphactor_t *self, int64_t interval);
+
 //  Connect the actor's sub socket to a pub endpoint. Returns 0 if succesful -1 on
 //  failure.
+//  Prefix the endpoint of an actor in the same process with "ring+" to
+//  receive its messages through a lock-free ring instead of the sub socket.
 SPHACTOR_EXPORT int
     sphactor_ask_connect (sphactor_t *self, const char *endpoint);
 
@@ -143,6 +183,56 @@ SPHACTOR_EXPORT int
 SPHACTOR_EXPORT zlist_t *
     sphactor_ask_filters (sphactor_t *self);
 
+//  Ask for our sphactor's UUID without waiting for the reply, which
+//  holds the UUID bytes. The reply fills the cache of sphactor_ask_uuid.
+//  Caller owns return value and must destroy it when done.
+SPHACTOR_EXPORT sphactor_future_t *
+    sphactor_ask_uuid_async (sphactor_t *self);
+
+//  Ask for our sphactor's name without waiting for the reply. The reply
+//  fills the cache of sphactor_ask_name.
+//  Caller owns return value and must destroy it when done.
+SPHACTOR_EXPORT sphactor_future_t *
+    sphactor_ask_name_async (sphactor_t *self);
+
+//  Ask for our sphactor's endpoint without waiting for the reply. The
+//  reply fills the cache of sphactor_ask_endpoint.
+//  Caller owns return value and must destroy it when done.
+SPHACTOR_EXPORT sphactor_future_t *
+    sphactor_ask_endpoint_async (sphactor_t *self);
+
+//  Ask for the timeout without waiting for the reply, which holds the
+//  timeout as a native int64_t.
+//  Caller owns return value and must destroy it when done.
+SPHACTOR_EXPORT sphactor_future_t *
+    sphactor_ask_timeout_async (sphactor_t *self);
+
+//  Connect the actor's sub socket without waiting for the reply, which
+//  holds "CONNECTED", the endpoint and the return code as strings. The
+//  reply adds the endpoint to our connections on success.
+//  Caller owns return value and must destroy it when done.
+SPHACTOR_EXPORT sphactor_future_t *
+    sphactor_ask_connect_async (sphactor_t *self, const char *endpoint);
+
+//  Ask for the filters without waiting for the reply, which holds a
+//  frame per filter or a single empty frame if there are none.
+//  Caller owns return value and must destroy it when done.
+SPHACTOR_EXPORT sphactor_future_t *
+    sphactor_ask_filters_async (sphactor_t *self);
+
+//  Ask the actor to handle the messages waiting on its inputs, for at
+//  most timeout msecs (-1 for no limit), without waiting for the reply.
+//  The reply holds the number of messages handled as an int64_t frame.
+//  Caller owns return value and must destroy it when done.
+SPHACTOR_EXPORT sphactor_future_t *
+    sphactor_ask_drain_async (sphactor_t *self, int64_t timeout);
+
+//  Tell the actor to terminate without waiting for it. The actor's socket
+//  becomes readable once it terminated, so many actors can be waited for
+//  at once. sphactor_destroy then waits for the actor and destroys it.
+SPHACTOR_EXPORT void
+    sphactor_ask_terminate (sphactor_t *self);
+
 //  Add a filter to the incoming socket. You can add multiple filters. Data will pass if
 //  at least one filter matches the data. Filters are performed bitwise!
 SPHACTOR_EXPORT void
@@ -170,11 +260,50 @@ SPHACTOR_EXPORT void
 SPHACTOR_EXPORT void
     sphactor_ask_set_reporting (sphactor_t *self, bool on);
 
+//  Publish through a multicast ring written once for all actors
+//  connecting to this actor through "ring+" from now on, instead of a
+//  ring per actor. The policy ("BLOCK", "OVERWRITE" or "DROP") decides
+//  what happens when the slowest reader is a full ring behind. The lag
+//  of every reader is in the actor's report.
+SPHACTOR_EXPORT void
+    sphactor_ask_set_multicast (sphactor_t *self, const char *policy);
+
+//  Handle up to size messages waiting on the actor's subscribe socket and rings
+//  each time it wakes up, updating its report and clock once for all
+//  of them instead of once per message. The handler gets a "SOCK" event
+//  per message, or with events set a single "SOCKBATCH" event. Its
+//  message holds one frame with an array of zmsg_t pointers, the handler
+//  owns the event message and the messages in the array. A size of 1,
+//  the default, turns batching off.
+SPHACTOR_EXPORT void
+    sphactor_ask_set_batch (sphactor_t *self, size_t size, bool events);
+
+//  Forget the handler and queue times measured so far, the latency
+//  histograms in the actor's report start over. See sphactor_latency.
+SPHACTOR_EXPORT void
+    sphactor_ask_reset_latency (sphactor_t *self);
+
+//  Start a trace for every message the actor publishes. Actors
+//  receiving a traced message pass the trace on with the messages they
+//  publish, the last one gets it with sphactor_actor_trace.
+SPHACTOR_EXPORT void
+    sphactor_ask_set_tracing (sphactor_t *self, bool tracing);
+
 //  Do an API request to the running actor. (TODO perhaps make this variadic)
+//  An "i" or "f" value reaches the handler as its text and its native
+//  value, pop it with sphactor_actor_pop_int or sphactor_actor_pop_double.
+//  The newer built-in commands, like "SET BATCH" or "FUSE", have no
+//  string form and reach the handler like its own commands.
 //  Returns 0 if send succesfully.
 SPHACTOR_EXPORT int
     sphactor_ask_api (sphactor_t *self, const char *api_call, const char *api_format, const char *value);
 
+//  Set a capability value by its name, as sphactor_save stores it. The
+//  value is sent through the api_call of the capability if it has one.
+//  Returns 0 on success, -1 if the capability has no such value.
+SPHACTOR_EXPORT int
+    sphactor_set_value (sphactor_t *self, const char *name, const char *value);
+
 //  Set the stage position of the actor.
 SPHACTOR_EXPORT void
     sphactor_set_position (sphactor_t *self, float x, float y);
@@ -187,6 +316,12 @@ SPHACTOR_EXPORT float
 SPHACTOR_EXPORT float
     sphactor_position_y (sphactor_t *self);
 
+//  Return a number which changes whenever something sphactor_save writes
+//  changes: the name, type, position, capability values or connections.
+//  Use it to find out if a saved actor needs saving again.
+SPHACTOR_EXPORT uint64_t
+    sphactor_revision (sphactor_t *self);
+
 //  Create new zconfig
 SPHACTOR_EXPORT zconfig_t *
     sphactor_zconfig_new (const char *filename);
@@ -200,6 +335,12 @@ SPHACTOR_EXPORT zconfig_t *
 SPHACTOR_EXPORT sphactor_report_t *
     sphactor_report (sphactor_t *self);
 
+//  Gets the current status report from the actor like sphactor_report,
+//  with the latency histograms copied in too.
+//  A NULL pointer is returned if reporting is disabled.
+SPHACTOR_EXPORT sphactor_report_t *
+    sphactor_latency (sphactor_t *self);
+
 //  Self test of this class.
 SPHACTOR_EXPORT void
     sphactor_test (bool verbose);
@@ -41,7 +41,7 @@ SPHACTOR_EXPORT int
     sphactor_actor_stop (sphactor_actor_t *self);
 
 //  Connect this sphactor_actor to another. Returns 0 on success -1
-//  on failure
+//  on failure, a fused actor can't connect
 //
 //  Note: sphactor_actor methods can only be called from within its instance!
 SPHACTOR_EXPORT int
@@ -88,12 +88,48 @@ SPHACTOR_EXPORT const char *
 SPHACTOR_EXPORT int64_t
     sphactor_actor_timeout (sphactor_actor_t *self);
 
-//  Set the timeout for the polling of the sphactor_actor.
+//  Set the timeout for the polling of the sphactor_actor. Returns 0 on
+//  success, -1 if the actor is fused and has no timeout of its own.
 //
 //  Note: sphactor_actor methods can only be called from within its instance!
-SPHACTOR_EXPORT void
+SPHACTOR_EXPORT int
     sphactor_actor_set_timeout (sphactor_actor_t *self, int64_t timeout);
 
+//  Return the period (usecs) of the high resolution TIME events of the
+//  sphactor_actor, 0 if it has none.
+//
+//  Note: sphactor_actor methods can only be called from within its instance!
+SPHACTOR_EXPORT int64_t
+    sphactor_actor_interval (sphactor_actor_t *self);
+
+//  Call the handler with a TIME event every interval usecs, 0 to stop.
+//  On Linux a timerfd on absolute deadlines wakes the poller so periods
+//  below a millisecond keep their rate. Elsewhere the poller wakes up for
+//  it in msecs, next to the timeout which it leaves alone. How late the
+//  events fire is in the timer jitter of the report. The timer of the
+//  events is SPHACTOR_TIMER_INTERVAL. Returns 0 on success, -1 if the
+//  actor is fused.
+//
+//  Note: sphactor_actor methods can only be called from within its instance!
+SPHACTOR_EXPORT int
+    sphactor_actor_set_interval (sphactor_actor_t *self, int64_t interval);
+
+//  Add a timer which calls the handler with a TIME event after delay
+//  msecs, and every interval msecs after that unless interval is 0. The
+//  timer member of the event holds the id of the timer, it is
+//  SPHACTOR_TIMER_TIMEOUT (0) for the events of our timeout. Returns the id of the timer, -1 if the
+//  actor is fused. An actor can have thousands of timers.
+//
+//  Note: sphactor_actor methods can only be called from within its instance!
+SPHACTOR_EXPORT int
+    sphactor_actor_timer_add (sphactor_actor_t *self, int64_t delay, int64_t interval);
+
+//  Cancel a timer. Returns 0 on success, -1 if there is no such timer.
+//
+//  Note: sphactor_actor methods can only be called from within its instance!
+SPHACTOR_EXPORT int
+    sphactor_actor_timer_cancel (sphactor_actor_t *self, int id);
+
 //  Adds a file descriptor to our poller (wraps zpoller_add).
 //
 //  Note: sphactor_actor methods can only be called from within its instance!
@@ -123,9 +159,27 @@ SPHACTOR_EXPORT void
 
 //  Gets the status report. This is a very specific threadsafe lockfree method
 //  to enable the controlling thread to get this actor's status.
+//  Returns NULL if the report didn't change since it was last taken. The
+//  caller owns the report and must destroy it, see report snapshot to
+//  reuse a report instead.
 SPHACTOR_EXPORT sphactor_report_t *
     sphactor_actor_atomic_report (sphactor_actor_t *self);
 
+//  Copies the status report into the given report without allocating,
+//  the custom message is only copied when it changed. The latency
+//  histograms are left alone, see latency snapshot. This is a
+//  threadsafe lockfree method for the controlling thread.
+//  Returns 0 on success, -1 if reporting is disabled.
+SPHACTOR_EXPORT int
+    sphactor_actor_report_snapshot (sphactor_actor_t *self, sphactor_report_t *report);
+
+//  Copies the status report into the given report like report snapshot,
+//  and the latency histograms too. That copies some 13KB so only ask for
+//  them when you show them.
+//  Returns 0 on success, -1 if reporting is disabled.
+SPHACTOR_EXPORT int
+    sphactor_actor_latency_snapshot (sphactor_actor_t *self, sphactor_report_t *report);
+
 //  Sets the actor's osc message for future reports. Use this in
 //  handler functions to store data for use in rendering gui.
 SPHACTOR_EXPORT void
@@ -141,6 +195,23 @@ SPHACTOR_EXPORT int
 SPHACTOR_EXPORT int
     sphactor_actor_send (sphactor_actor_t *self, zmsg_t *message);
 
+//  Return the trace of the message being handled, or NULL if it isn't
+//  traced. Only valid during the handler call.
+SPHACTOR_EXPORT sphactor_trace_t *
+    sphactor_actor_trace (sphactor_actor_t *self);
+
+//  Pop an int value of an API command from the message. The native value
+//  sent by sphactor_ask_api is used without parsing, a string is parsed.
+//  Returns the fallback if there is no value.
+SPHACTOR_EXPORT int64_t
+    sphactor_actor_pop_int (zmsg_t *message, int64_t fallback);
+
+//  Pop a float value of an API command from the message. The native value
+//  sent by sphactor_ask_api is used without parsing, a string is parsed.
+//  Returns the fallback if there is no value.
+SPHACTOR_EXPORT double
+    sphactor_actor_pop_double (zmsg_t *message, double fallback);
+
 //  Self test of this class.
 SPHACTOR_EXPORT void
     sphactor_actor_test (bool verbose);
@@ -0,0 +1,84 @@
+/*  =========================================================================
+    sphactor_future - class description
+
+    Copyright (c) the Contributors as noted in the AUTHORS file.
+
+    This file is part of Sphactor, an open-source framework for high level
+    actor model concurrency --- http://sphactor.org
+
+    This Source Code Form is subject to the terms of the Mozilla Public
+    License, v. 2.0. If a copy of the MPL was not distributed with this
+    file, You can obtain one at http://mozilla.org/MPL/2.0/.
+    =========================================================================
+*/
+
+#ifndef SPHACTOR_FUTURE_H_INCLUDED
+#define SPHACTOR_FUTURE_H_INCLUDED
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//  @warning THE FOLLOWING @INTERFACE BLOCK IS AUTO-GENERATED BY ZPROJECT
+//  @warning Please edit the model at "api/sphactor_future.api" to make changes.
+//  @interface
+//  This is a stable class, and may not change except for emergencies. It
+//  is provided in stable builds.
+// Called when the reply arrives, before anyone sees the future ready.
+// The reply stays owned by the future.
+typedef void (sphactor_future_fn) (
+    sphactor_future_t *self, zmsg_t *reply, void *args);
+
+//  Send the request on the pipe and return the future of its reply.
+//  The future is appended to the pending list of the pipe, which all
+//  requests expecting a reply on that pipe must share. Takes ownership
+//  of the request.
+SPHACTOR_EXPORT sphactor_future_t *
+    sphactor_future_new (zsock_t *pipe, zlist_t *pending, zmsg_t **request_p);
+
+//  Create a future which is ready already, e.g. for a cached value.
+//  Takes ownership of the reply.
+SPHACTOR_EXPORT sphactor_future_t *
+    sphactor_future_new_ready (zmsg_t **reply_p);
+
+//  Destructor, waits for the reply first if it is still in flight.
+SPHACTOR_EXPORT void
+    sphactor_future_destroy (sphactor_future_t **self_p);
+
+//  Set a handler to call when the reply arrives
+SPHACTOR_EXPORT void
+    sphactor_future_set_handler (sphactor_future_t *self, sphactor_future_fn handler, void *args);
+
+//  Return true if the reply arrived
+SPHACTOR_EXPORT bool
+    sphactor_future_ready (sphactor_future_t *self);
+
+//  Return the reply, NULL if it did not arrive yet. The future keeps
+//  owning the reply.
+SPHACTOR_EXPORT zmsg_t *
+    sphactor_future_reply (sphactor_future_t *self);
+
+//  Wait at most timeout msecs for the reply, -1 waits forever. Replies
+//  to earlier requests on the same pipe complete their futures first.
+//  Returns 0 if the reply arrived, -1 on timeout or interrupt.
+SPHACTOR_EXPORT int
+    sphactor_future_wait (sphactor_future_t *self, int timeout);
+
+//  Wait at most timeout msecs for the replies of all futures in the
+//  list, -1 waits forever. Polls all their pipes at once so requests
+//  to many actors are in flight together. Returns 0 if all replies
+//  arrived, -1 on timeout or interrupt.
+SPHACTOR_EXPORT int
+    sphactor_future_wait_all (zlist_t *futures, int timeout);
+
+//  Self test of this class.
+SPHACTOR_EXPORT void
+    sphactor_future_test (bool verbose);
+
+//  @end
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
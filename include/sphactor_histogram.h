@@ -0,0 +1,72 @@
+/*  =========================================================================
+    sphactor_histogram - class description
+
+    Copyright (c) the Contributors as noted in the AUTHORS file.
+
+    This file is part of Sphactor, an open-source framework for high level
+    actor model concurrency --- http://sphactor.org
+
+    This Source Code Form is subject to the terms of the Mozilla Public
+    License, v. 2.0. If a copy of the MPL was not distributed with this
+    file, You can obtain one at http://mozilla.org/MPL/2.0/.
+    =========================================================================
+*/
+
+#ifndef SPHACTOR_HISTOGRAM_H_INCLUDED
+#define SPHACTOR_HISTOGRAM_H_INCLUDED
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//  @warning THE FOLLOWING @INTERFACE BLOCK IS AUTO-GENERATED BY ZPROJECT
+//  @warning Please edit the model at "api/sphactor_histogram.api" to make changes.
+//  @interface
+//  This is a stable class, and may not change except for emergencies. It
+//  is provided in stable builds.
+//  Constructor, creates an empty histogram.
+SPHACTOR_EXPORT sphactor_histogram_t *
+    sphactor_histogram_new (void);
+
+//  Destructor, destroys a histogram.
+SPHACTOR_EXPORT void
+    sphactor_histogram_destroy (sphactor_histogram_t **self_p);
+
+//  Record a value in microseconds. Only one thread may record into a
+//  histogram.
+SPHACTOR_EXPORT void
+    sphactor_histogram_record (sphactor_histogram_t *self, uint64_t value);
+
+//  Return the number of recorded values
+SPHACTOR_EXPORT uint64_t
+    sphactor_histogram_count (sphactor_histogram_t *self);
+
+//  Return the largest recorded value, 0 if there are none
+SPHACTOR_EXPORT uint64_t
+    sphactor_histogram_max (sphactor_histogram_t *self);
+
+//  Return the value below which the given percentage of the recorded
+//  values lie, e.g. 99.9 for p999. Returns 0 if there are no values.
+SPHACTOR_EXPORT uint64_t
+    sphactor_histogram_percentile (sphactor_histogram_t *self, double percentile);
+
+//  Remove all recorded values, only the recording thread may do this.
+SPHACTOR_EXPORT void
+    sphactor_histogram_reset (sphactor_histogram_t *self);
+
+//  Copy the recorded values into dest, may be called while another
+//  thread records into the histogram.
+SPHACTOR_EXPORT void
+    sphactor_histogram_copy (sphactor_histogram_t *self, sphactor_histogram_t *dest);
+
+//  Self test of this class.
+SPHACTOR_EXPORT void
+    sphactor_histogram_test (bool verbose);
+
+//  @end
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
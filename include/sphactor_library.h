@@ -76,6 +76,20 @@ typedef struct _sph_stage_t sph_stage_t;
 typedef struct _sph_stock_t sph_stock_t;
 #define SPH_STOCK_T_DEFINED
 
+typedef struct _sphactor_pool_t sphactor_pool_t;
+#define SPHACTOR_POOL_T_DEFINED
+typedef struct _sphactor_payload_t sphactor_payload_t;
+#define SPHACTOR_PAYLOAD_T_DEFINED
+typedef struct _sphactor_histogram_t sphactor_histogram_t;
+#define SPHACTOR_HISTOGRAM_T_DEFINED
+typedef struct _sphactor_trace_t sphactor_trace_t;
+#define SPHACTOR_TRACE_T_DEFINED
+typedef struct _sphactor_timeline_t sphactor_timeline_t;
+#define SPHACTOR_TIMELINE_T_DEFINED
+typedef struct _sphactor_future_t sphactor_future_t;
+#define SPHACTOR_FUTURE_T_DEFINED
+typedef struct _sphactor_tick_t sphactor_tick_t;
+#define SPHACTOR_TICK_T_DEFINED
 
 //  Public classes, each with its own header file
 #include "sphactor.h"
@@ -83,6 +97,13 @@ typedef struct _sph_stock_t sph_stock_t;
 #include "sphactor_report.h"
 #include "sph_stage.h"
 #include "sph_stock.h"
+#include "sphactor_pool.h"
+#include "sphactor_payload.h"
+#include "sphactor_histogram.h"
+#include "sphactor_trace.h"
+#include "sphactor_timeline.h"
+#include "sphactor_future.h"
+#include "sphactor_tick.h"
 
 #ifdef SPHACTOR_BUILD_DRAFT_API
 
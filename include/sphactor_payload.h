@@ -0,0 +1,98 @@
+/*  =========================================================================
+    sphactor_payload - class description
+
+    Copyright (c) the Contributors as noted in the AUTHORS file.
+
+    This file is part of Sphactor, an open-source framework for high level
+    actor model concurrency --- http://sphactor.org
+
+    This Source Code Form is subject to the terms of the Mozilla Public
+    License, v. 2.0. If a copy of the MPL was not distributed with this
+    file, You can obtain one at http://mozilla.org/MPL/2.0/.
+    =========================================================================
+*/
+
+#ifndef SPHACTOR_PAYLOAD_H_INCLUDED
+#define SPHACTOR_PAYLOAD_H_INCLUDED
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//  @warning THE FOLLOWING @INTERFACE BLOCK IS AUTO-GENERATED BY ZPROJECT
+//  @warning Please edit the model at "api/sphactor_payload.api" to make changes.
+//  @interface
+//  This is a stable class, and may not change except for emergencies. It
+//  is provided in stable builds.
+// Callback function destroying the payload's data
+typedef void (sphactor_payload_free_fn) (
+    void *data, void *hint);
+
+//  Constructor, creates a payload for size bytes of data. The caller
+//  holds the first reference. Once the last reference is dropped
+//  free_fn, if not NULL, is called with data and hint.
+SPHACTOR_EXPORT sphactor_payload_t *
+    sphactor_payload_new (void *data, size_t size, sphactor_payload_free_fn free_fn, void *hint);
+
+//  Destructor, drops a reference to the payload.
+SPHACTOR_EXPORT void
+    sphactor_payload_destroy (sphactor_payload_t **self_p);
+
+//  Add a reference to the payload and return it, destroy the payload
+//  to drop the reference.
+SPHACTOR_EXPORT sphactor_payload_t *
+    sphactor_payload_ref (sphactor_payload_t *self);
+
+//  Return the number of references to the payload
+SPHACTOR_EXPORT size_t
+    sphactor_payload_refs (sphactor_payload_t *self);
+
+//  Return the payload's data. Receivers share the data with all other
+//  receivers so they must treat it as read-only.
+SPHACTOR_EXPORT void *
+    sphactor_payload_data (sphactor_payload_t *self);
+
+//  Return the size of the payload's data
+SPHACTOR_EXPORT size_t
+    sphactor_payload_size (sphactor_payload_t *self);
+
+//  Return a new frame carrying a reference to the payload, the
+//  reference is dropped with the last copy of the frame libzmq holds.
+//  Caller owns return value and must destroy it when done.
+SPHACTOR_EXPORT zframe_t *
+    sphactor_payload_frame (sphactor_payload_t *self);
+
+//  Append a frame carrying a reference to the payload to the message.
+//  Returns 0 on success.
+SPHACTOR_EXPORT int
+    sphactor_payload_append (sphactor_payload_t *self, zmsg_t *msg);
+
+//  Return the payload carried by the frame, or NULL if it carries none.
+//  The payload stays valid as long as the frame, take a reference to
+//  keep it longer. Copies of a frame made by zframe_dup carry none.
+SPHACTOR_EXPORT sphactor_payload_t *
+    sphactor_payload_lookup (zframe_t *frame);
+
+//  Return the first payload carried by the message, or NULL if it
+//  carries none.
+SPHACTOR_EXPORT sphactor_payload_t *
+    sphactor_payload_first (zmsg_t *msg);
+
+//  Duplicate a message like zmsg_dup, frames carrying a payload get a
+//  new reference instead of a copy. Use this instead of zmsg_dup on
+//  messages carrying payloads, zmsg_dup loses them.
+//  Caller owns return value and must destroy it when done.
+SPHACTOR_EXPORT zmsg_t *
+    sphactor_payload_msg_dup (zmsg_t *msg);
+
+//  Self test of this class.
+SPHACTOR_EXPORT void
+    sphactor_payload_test (bool verbose);
+
+//  @end
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
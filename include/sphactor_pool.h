@@ -0,0 +1,87 @@
+/*  =========================================================================
+    sphactor_pool - class description
+
+    Copyright (c) the Contributors as noted in the AUTHORS file.
+
+    This file is part of Sphactor, an open-source framework for high level
+    actor model concurrency --- http://sphactor.org
+
+    This Source Code Form is subject to the terms of the Mozilla Public
+    License, v. 2.0. If a copy of the MPL was not distributed with this
+    file, You can obtain one at http://mozilla.org/MPL/2.0/.
+    =========================================================================
+*/
+
+#ifndef SPHACTOR_POOL_H_INCLUDED
+#define SPHACTOR_POOL_H_INCLUDED
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//  @warning THE FOLLOWING @INTERFACE BLOCK IS AUTO-GENERATED BY ZPROJECT
+//  @warning Please edit the model at "api/sphactor_pool.api" to make changes.
+//  @interface
+//  This is a stable class, and may not change except for emergencies. It
+//  is provided in stable builds.
+//  Constructor, creates a new pool with the given number of worker threads.
+//  Pass 0 to start a worker for every available core.
+SPHACTOR_EXPORT sphactor_pool_t *
+    sphactor_pool_new (size_t workers);
+
+//  Destructor, destroys the pool. Destroy the actors running in the pool
+//  before destroying it.
+SPHACTOR_EXPORT void
+    sphactor_pool_destroy (sphactor_pool_t **self_p);
+
+//  Return the number of worker threads of the pool
+SPHACTOR_EXPORT size_t
+    sphactor_pool_workers (sphactor_pool_t *self);
+
+//  Return the number of actors running in the pool
+SPHACTOR_EXPORT size_t
+    sphactor_pool_size (sphactor_pool_t *self);
+
+//  Return the number of actor runs done by a worker, the index of the
+//  worker is from 0 to sphactor_pool_workers
+SPHACTOR_EXPORT uint64_t
+    sphactor_pool_runs (sphactor_pool_t *self, size_t worker);
+
+//  Return the number of actors a worker stole from the run queues of the
+//  other workers
+SPHACTOR_EXPORT uint64_t
+    sphactor_pool_steals (sphactor_pool_t *self, size_t worker);
+
+//  Return the number of times a worker ran out of work and went to sleep
+SPHACTOR_EXPORT uint64_t
+    sphactor_pool_idles (sphactor_pool_t *self, size_t worker);
+
+//  Create a new actor running in the pool. Pass the same arguments as to
+//  sphactor_actor_run (a sphactor_shim_t). Returns the pipe to the actor
+//  which behaves like the pipe of a zactor: send it "$TERM" and wait for
+//  its signal to destroy the actor.
+//  Caller owns return value and must destroy it when done.
+SPHACTOR_EXPORT zsock_t *
+    sphactor_pool_spawn (sphactor_pool_t *self, void *args);
+
+//  Set the pool sphactor_new creates its actors in. Pass NULL to run new
+//  actors in their own thread again, which is the default.
+SPHACTOR_EXPORT void
+    sphactor_pool_set_default (sphactor_pool_t *pool);
+
+//  Return the pool sphactor_new creates its actors in or NULL if actors
+//  run in their own thread.
+SPHACTOR_EXPORT sphactor_pool_t *
+    sphactor_pool_default (void);
+
+//  Self test of this class.
+SPHACTOR_EXPORT void
+    sphactor_pool_test (bool verbose);
+
+//  @end
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -76,6 +76,52 @@ SPHACTOR_EXPORT int64_t
 SPHACTOR_EXPORT zosc_t *
     sphactor_report_custom (sphactor_report_t *self);
 
+//  Return the version of the custom status, it changes whenever the
+//  actor sets a new custom status
+SPHACTOR_EXPORT uint64_t
+    sphactor_report_custom_version (sphactor_report_t *self);
+
+//  Return the number of multicast readers in the report, 0 if the
+//  actor doesn't multicast
+SPHACTOR_EXPORT size_t
+    sphactor_report_readers (sphactor_report_t *self);
+
+//  Return the number of messages a multicast reader is behind
+SPHACTOR_EXPORT uint64_t
+    sphactor_report_lag (sphactor_report_t *self, size_t reader);
+
+//  Return the histogram of the time the actor's handler took in
+//  microseconds. The report owns the histogram.
+SPHACTOR_EXPORT sphactor_histogram_t *
+    sphactor_report_handler_time (sphactor_report_t *self);
+
+//  Return the histogram of the time messages waited between being
+//  published and being received by the actor, in microseconds. Messages
+//  from rings, and from the sockets of actors which report, are measured.
+//  The report owns the histogram.
+SPHACTOR_EXPORT sphactor_histogram_t *
+    sphactor_report_queue_time (sphactor_report_t *self);
+
+//  Return the histogram of how late the TIME events of the actor's
+//  interval fired, in microseconds. The report owns the histogram.
+SPHACTOR_EXPORT sphactor_histogram_t *
+    sphactor_report_timer_jitter (sphactor_report_t *self);
+
+//  Return the handler time below which the given percentage of the
+//  handler calls lie, e.g. 99.9 for p999 and 100 for the maximum.
+SPHACTOR_EXPORT uint64_t
+    sphactor_report_handler_latency (sphactor_report_t *self, double percentile);
+
+//  Return the queue time below which the given percentage of the
+//  messages lie, e.g. 99.9 for p999 and 100 for the maximum.
+SPHACTOR_EXPORT uint64_t
+    sphactor_report_queue_latency (sphactor_report_t *self, double percentile);
+
+//  Return the timer jitter below which the given percentage of the
+//  interval TIME events lie, e.g. 99.9 for p999 and 100 for the maximum.
+SPHACTOR_EXPORT uint64_t
+    sphactor_report_jitter_latency (sphactor_report_t *self, double percentile);
+
 //  Set the status in the report
 SPHACTOR_EXPORT void
     sphactor_report_set_status (sphactor_report_t *self, int status);
@@ -96,6 +142,19 @@ SPHACTOR_EXPORT void
 SPHACTOR_EXPORT void
     sphactor_report_set_custom (sphactor_report_t *self, zosc_t *message);
 
+//  Set the version of the custom status
+SPHACTOR_EXPORT void
+    sphactor_report_set_custom_version (sphactor_report_t *self, uint64_t version);
+
+//  Set the number of multicast readers, new readers have no lag
+SPHACTOR_EXPORT void
+    sphactor_report_set_readers (sphactor_report_t *self, size_t readers);
+
+//  Set the number of messages a multicast reader is behind, adds the
+//  reader if needed
+SPHACTOR_EXPORT void
+    sphactor_report_set_lag (sphactor_report_t *self, size_t reader, uint64_t lag);
+
 //  Self test of this class.
 SPHACTOR_EXPORT void
     sphactor_report_test (bool verbose);
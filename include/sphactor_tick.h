@@ -0,0 +1,93 @@
+/*  =========================================================================
+    sphactor_tick - class description
+
+    Copyright (c) the Contributors as noted in the AUTHORS file.
+
+    This file is part of Sphactor, an open-source framework for high level
+    actor model concurrency --- http://sphactor.org
+
+    This Source Code Form is subject to the terms of the Mozilla Public
+    License, v. 2.0. If a copy of the MPL was not distributed with this
+    file, You can obtain one at http://mozilla.org/MPL/2.0/.
+    =========================================================================
+*/
+
+#ifndef SPHACTOR_TICK_H_INCLUDED
+#define SPHACTOR_TICK_H_INCLUDED
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//  @warning THE FOLLOWING @INTERFACE BLOCK IS AUTO-GENERATED BY ZPROJECT
+//  @warning Please edit the model at "api/sphactor_tick.api" to make changes.
+//  @interface
+//  This is a stable class, and may not change except for emergencies. It
+//  is provided in stable builds.
+//  Constructor, creates a tick executor which ticks every interval usecs.
+//  Pass 0 to only tick on sphactor_tick_step.
+SPHACTOR_EXPORT sphactor_tick_t *
+    sphactor_tick_new (int64_t interval);
+
+//  Destructor, destroys the tick executor. Destroy its actors before
+//  destroying it.
+SPHACTOR_EXPORT void
+    sphactor_tick_destroy (sphactor_tick_t **self_p);
+
+//  Return the number of actors in the tick executor
+SPHACTOR_EXPORT size_t
+    sphactor_tick_size (sphactor_tick_t *self);
+
+//  Return the number of worker threads
+SPHACTOR_EXPORT size_t
+    sphactor_tick_workers (sphactor_tick_t *self);
+
+//  Run the independent branches of the graph concurrently on a number of
+//  worker threads. Each actor runs as soon as the actors it depends on
+//  finished their run for the tick. Pass 0 to run all actors on the
+//  driver thread, which is the default.
+SPHACTOR_EXPORT void
+    sphactor_tick_set_workers (sphactor_tick_t *self, size_t workers);
+
+//  Return the number of ticks done
+SPHACTOR_EXPORT uint64_t
+    sphactor_tick_ticks (sphactor_tick_t *self);
+
+//  Run a tick now and wait for it to finish
+SPHACTOR_EXPORT void
+    sphactor_tick_step (sphactor_tick_t *self);
+
+//  Return the endpoints of the actors in the order they run in a tick
+//  Caller owns return value and must destroy it when done.
+SPHACTOR_EXPORT zlist_t *
+    sphactor_tick_order (sphactor_tick_t *self);
+
+//  Create a new actor running in the tick executor. Pass the same arguments
+//  as to sphactor_actor_run (a sphactor_shim_t). Returns the pipe to the
+//  actor which behaves like the pipe of a zactor: send it "$TERM" and wait
+//  for its signal to destroy the actor.
+//  Caller owns return value and must destroy it when done.
+SPHACTOR_EXPORT zsock_t *
+    sphactor_tick_spawn (sphactor_tick_t *self, void *args);
+
+//  Set the tick executor sphactor_new creates its actors in. Pass NULL to
+//  run new actors in their own thread again, which is the default.
+SPHACTOR_EXPORT void
+    sphactor_tick_set_default (sphactor_tick_t *tick);
+
+//  Return the tick executor sphactor_new creates its actors in or NULL if
+//  there is none.
+SPHACTOR_EXPORT sphactor_tick_t *
+    sphactor_tick_default (void);
+
+//  Self test of this class.
+SPHACTOR_EXPORT void
+    sphactor_tick_test (bool verbose);
+
+//  @end
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
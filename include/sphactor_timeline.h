@@ -0,0 +1,91 @@
+/*  =========================================================================
+    sphactor_timeline - class description
+
+    Copyright (c) the Contributors as noted in the AUTHORS file.
+
+    This file is part of Sphactor, an open-source framework for high level
+    actor model concurrency --- http://sphactor.org
+
+    This Source Code Form is subject to the terms of the Mozilla Public
+    License, v. 2.0. If a copy of the MPL was not distributed with this
+    file, You can obtain one at http://mozilla.org/MPL/2.0/.
+    =========================================================================
+*/
+
+#ifndef SPHACTOR_TIMELINE_H_INCLUDED
+#define SPHACTOR_TIMELINE_H_INCLUDED
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//  @warning THE FOLLOWING @INTERFACE BLOCK IS AUTO-GENERATED BY ZPROJECT
+//  @warning Please edit the model at "api/sphactor_timeline.api" to make changes.
+//  @interface
+//  This is a stable class, and may not change except for emergencies. It
+//  is provided in stable builds.
+#define SPHACTOR_TIMELINE_EVENTS 1024       // Default events kept per timeline, older events are overwritten
+
+//  Constructor, creates a timeline for the named actor. Destroyed
+//  timelines are kept for the dump until a new timeline takes their
+//  place.
+SPHACTOR_EXPORT sphactor_timeline_t *
+    sphactor_timeline_new (const char *name);
+
+//  Destructor, destroys a timeline.
+SPHACTOR_EXPORT void
+    sphactor_timeline_destroy (sphactor_timeline_t **self_p);
+
+//  Record a handler call for the event type between begin and end
+//  (zclock_usecs). The type must be a string literal. Only one thread
+//  may record into a timeline.
+SPHACTOR_EXPORT void
+    sphactor_timeline_record (sphactor_timeline_t *self, const char *type, uint64_t begin, uint64_t end);
+
+//  Return the number of events in the timeline
+SPHACTOR_EXPORT size_t
+    sphactor_timeline_size (sphactor_timeline_t *self);
+
+//  Set the number of events kept per timeline, rounded up to a power of
+//  two. Only timelines created afterwards use it, so set it before
+//  enabling. The default is SPHACTOR_TIMELINE_EVENTS.
+SPHACTOR_EXPORT void
+    sphactor_timeline_set_capacity (size_t events);
+
+//  Return the number of events kept per new timeline.
+SPHACTOR_EXPORT size_t
+    sphactor_timeline_capacity (void);
+
+//  Start or stop recording handler calls in all actors.
+SPHACTOR_EXPORT void
+    sphactor_timeline_enable (bool enable);
+
+//  Return true if actors record their handler calls.
+SPHACTOR_EXPORT bool
+    sphactor_timeline_enabled (void);
+
+//  Write the events of all timelines to a file as Chrome trace event
+//  JSON. May be called while actors record.
+//  Returns 0 on success, -1 if the file can't be written.
+SPHACTOR_EXPORT int
+    sphactor_timeline_dump (const char *filename);
+
+//  Forget the events of all timelines.
+SPHACTOR_EXPORT void
+    sphactor_timeline_clear (void);
+
+//  Free all timelines, only call this when no actors are running.
+SPHACTOR_EXPORT void
+    sphactor_timeline_dispose (void);
+
+//  Self test of this class.
+SPHACTOR_EXPORT void
+    sphactor_timeline_test (bool verbose);
+
+//  @end
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,117 @@
+/*  =========================================================================
+    sphactor_trace - class description
+
+    Copyright (c) the Contributors as noted in the AUTHORS file.
+
+    This file is part of Sphactor, an open-source framework for high level
+    actor model concurrency --- http://sphactor.org
+
+    This Source Code Form is subject to the terms of the Mozilla Public
+    License, v. 2.0. If a copy of the MPL was not distributed with this
+    file, You can obtain one at http://mozilla.org/MPL/2.0/.
+    =========================================================================
+*/
+
+#ifndef SPHACTOR_TRACE_H_INCLUDED
+#define SPHACTOR_TRACE_H_INCLUDED
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//  @warning THE FOLLOWING @INTERFACE BLOCK IS AUTO-GENERATED BY ZPROJECT
+//  @warning Please edit the model at "api/sphactor_trace.api" to make changes.
+//  @interface
+//  This is a stable class, and may not change except for emergencies. It
+//  is provided in stable builds.
+#define SPHACTOR_TRACE_MAX_HOPS 32          // Hops kept in a trace, later hops aren't added
+
+//  Constructor, creates a trace for the message with the given
+//  sequence number published by the origin actor.
+SPHACTOR_EXPORT sphactor_trace_t *
+    sphactor_trace_new (zuuid_t *origin, uint64_t sequence);
+
+//  Create a trace from a trace frame, returns NULL if the frame isn't
+//  a trace frame.
+SPHACTOR_EXPORT sphactor_trace_t *
+    sphactor_trace_decode (zframe_t *frame);
+
+//  Destructor, destroys a trace.
+SPHACTOR_EXPORT void
+    sphactor_trace_destroy (sphactor_trace_t **self_p);
+
+//  Return a copy of the trace.
+//  Caller owns return value and must destroy it when done.
+SPHACTOR_EXPORT sphactor_trace_t *
+    sphactor_trace_dup (sphactor_trace_t *self);
+
+//  Return true if the frame is a trace frame.
+SPHACTOR_EXPORT bool
+    sphactor_trace_is (zframe_t *frame);
+
+//  Return the trace as a frame to append to a message.
+//  Caller owns return value and must destroy it when done.
+SPHACTOR_EXPORT zframe_t *
+    sphactor_trace_encode (sphactor_trace_t *self);
+
+//  Return the uuid of the actor that started the trace.
+SPHACTOR_EXPORT const char *
+    sphactor_trace_origin (sphactor_trace_t *self);
+
+//  Return the sequence number of the trace at its origin.
+SPHACTOR_EXPORT uint64_t
+    sphactor_trace_sequence (sphactor_trace_t *self);
+
+//  Return the number of hops, every actor that published the message
+//  adds one.
+SPHACTOR_EXPORT size_t
+    sphactor_trace_hops (sphactor_trace_t *self);
+
+//  Return the uuid of the actor publishing at the given hop.
+SPHACTOR_EXPORT const char *
+    sphactor_trace_hop_actor (sphactor_trace_t *self, size_t hop);
+
+//  Return when the message was published at the given hop
+//  (zclock_usecs).
+SPHACTOR_EXPORT int64_t
+    sphactor_trace_hop_sent (sphactor_trace_t *self, size_t hop);
+
+//  Return when the message published at the given hop was received
+//  (zclock_usecs), 0 if it wasn't yet.
+SPHACTOR_EXPORT int64_t
+    sphactor_trace_hop_received (sphactor_trace_t *self, size_t hop);
+
+//  Return the microseconds the message took to get from the actor
+//  publishing at the given hop to the next actor.
+SPHACTOR_EXPORT int64_t
+    sphactor_trace_hop_latency (sphactor_trace_t *self, size_t hop);
+
+//  Return the microseconds between the origin publishing the message
+//  and the last actor receiving it.
+SPHACTOR_EXPORT int64_t
+    sphactor_trace_latency (sphactor_trace_t *self);
+
+//  Add a hop for the actor publishing the message, unless the trace
+//  has max hops already.
+SPHACTOR_EXPORT void
+    sphactor_trace_add_hop (sphactor_trace_t *self, zuuid_t *actor, int64_t sent);
+
+//  Set when the message published at the last hop was received.
+SPHACTOR_EXPORT void
+    sphactor_trace_set_received (sphactor_trace_t *self, int64_t received);
+
+//  Log the latency of every hop.
+SPHACTOR_EXPORT void
+    sphactor_trace_print (sphactor_trace_t *self);
+
+//  Self test of this class.
+SPHACTOR_EXPORT void
+    sphactor_trace_test (bool verbose);
+
+//  @end
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
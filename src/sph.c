@@ -23,10 +23,24 @@
 #include "sph_stock.h"
 #include <stdio.h>
 #include <stdlib.h>
+#if defined (__UNIX__)
+#include <signal.h>
+#endif
 //#include <dlfcn.h>
 
-//  (forward declare)
-void sphactor_actor_run(zsock_t *pipe, void *args);
+//  Where we write the timeline of handler calls if not given
+#define SPH_TRACE_FILE "sph_trace.json"
+
+#if defined (__UNIX__)
+//  Set by SIGUSR1, we start or stop recording the timeline
+static volatile sig_atomic_t s_trace_toggle = 0;
+
+static void
+s_sigusr1 (int signum)
+{
+    s_trace_toggle = 1;
+}
+#endif
 
 static int
 print_help()
@@ -34,6 +48,12 @@ print_help()
     puts ("sph [options] <config file>");
     puts ("  --verbose / -v         verbose output");
     puts ("  --help / -h            this information");
+    puts ("  --workers <n>          run the actors on n worker threads instead of");
+    puts ("                         a thread per actor (0 for one per core)");
+    puts ("  --trace <file>         record the actors' handler calls and write them");
+    puts ("                         to file on exit, for chrome://tracing or Perfetto.");
+    puts ("                         SIGUSR1 stops recording and writes the file, or");
+    puts ("                         starts recording again (default " SPH_TRACE_FILE ")");
     puts ("  <config file>          stage config file to load");
     return 0;
 }
@@ -99,6 +119,25 @@ s_self_switch (zsock_t *input, zsock_t *output)
     }
 }
 
+//  Start recording the timeline, or stop and write it
+
+static void
+s_trace_toggle_timeline (const char *filename)
+{
+    if ( sphactor_timeline_enabled() )
+    {
+        sphactor_timeline_enable(false);
+        if ( sphactor_timeline_dump(filename) == 0 )
+            zsys_info("wrote trace to %s", filename);
+    }
+    else
+    {
+        sphactor_timeline_clear();
+        sphactor_timeline_enable(true);
+        zsys_info("recording trace");
+    }
+}
+
 static int
 s_run_actor_by_type(const char *actor_type, zsock_t *pipe, const char *name, zuuid_t *uuid)
 {
@@ -169,13 +208,43 @@ int main (int argc, char *argv [])
 
         const char *conffile = zargs_first(args);
 
+        sphactor_pool_t *pool = NULL;
+        const char *workers = zargs_get(args, "--workers");
+        if ( workers )
+        {
+            pool = sphactor_pool_new( (size_t)atoi(workers) );
+            sphactor_pool_set_default(pool);
+            if (verbose)
+                zsys_info ("running actors on %zu workers", sphactor_pool_workers(pool));
+        }
+
+        const char *tracefile = zargs_get(args, "--trace");
+        if ( tracefile )
+            sphactor_timeline_enable(true);
+        else
+            tracefile = SPH_TRACE_FILE;
+#if defined (__UNIX__)
+        signal(SIGUSR1, s_sigusr1);
+#endif
+
         sph_stage_t *stage = sph_stage_load(conffile);
         assert(stage);
         while (!zsys_interrupted)
         {
             zclock_sleep(300);
+#if defined (__UNIX__)
+            if ( s_trace_toggle )
+            {
+                s_trace_toggle = 0;
+                s_trace_toggle_timeline(tracefile);
+            }
+#endif
         }
         sph_stage_clear(stage);
+        //  the timeline ends with the actors stopping
+        if ( sphactor_timeline_enabled() )
+            s_trace_toggle_timeline(tracefile);
+        sphactor_pool_destroy(&pool);
         zsys_info("EXIT");
         zargs_destroy(&args);
     }
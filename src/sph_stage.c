@@ -23,14 +23,29 @@
 #ifdef __UNIX__
 #include <libgen.h>
 #endif
+
 //  Structure of our class
 
 struct _sph_stage_t {
     char*           name;       //  Stage name
     char*           config_path;//  Stage file config path
     zhash_t*        actors;     //  Loaded actors
+    zhash_t*        endpoints;  //  Loaded actors by endpoint
+    zhash_t*        names;      //  Lists of loaded actors by name
+    zhash_t*        named;      //  Name each actor is in names under, by uuid
+    zhash_t*        saved;      //  Serialized actors by uuid, as saved last
+    bool            dirty;      //  Actors were added or removed since saving
+    time_t          saved_time; //  Modification time of the file we saved last
+    bool            binary;     //  The stage file is a snapshot
 };
 
+//  Serialized form of an actor as we saved it last
+typedef struct {
+    uint64_t    revision;       //  Revision of the actor when serialized
+    char        *actor;         //  Its actor section
+    char        *connections;   //  Its con entries
+} stage_saved_t;
+
 
 //  --------------------------------------------------------------------------
 //  Create a new sph_stage
@@ -45,6 +60,12 @@ sph_stage_new (const char *stage_name)
     self->config_path = NULL;
     self->actors = zhash_new();
     assert(self->actors);
+    self->endpoints = zhash_new();
+    self->names = zhash_new();
+    self->named = zhash_new();
+    zhash_autofree(self->named);
+    self->saved = zhash_new();
+    self->dirty = true;
     return self;
 }
 
@@ -63,82 +84,310 @@ sph_stage_destroy (sph_stage_t **self_p)
         if (self->config_path) zstr_free(&self->config_path);
         sph_stage_clear(self);
         zhash_destroy(&self->actors);
+        zhash_destroy(&self->endpoints);
+        zhash_destroy(&self->names);
+        zhash_destroy(&self->named);
+        zhash_destroy(&self->saved);
         //  Free object itself
         free (self);
         *self_p = NULL;
     }
 }
 
-int
-sph_stage_cnf_load(sph_stage_t *self, const zconfig_t *cnf)
+static void
+s_stage_names_free (void *data)
 {
-    assert(cnf);
+    zlist_t *list = (zlist_t *) data;
+    zlist_destroy(&list);
+}
 
-    // TODO: retrieve stage name???
+//  Add the actor to the actors with its current name. Names need not be
+//  unique so we keep a list of actors per name.
+
+static void
+s_stage_index_name (sph_stage_t *self, sphactor_t *actor)
+{
+    const char *name = sphactor_ask_name(actor);
+    zlist_t *list = (zlist_t *) zhash_lookup(self->names, name);
+    if (list == NULL)
+    {
+        list = zlist_new();
+        zhash_insert(self->names, name, list);
+        zhash_freefn(self->names, name, s_stage_names_free);
+    }
+    zlist_append(list, actor);
+    zhash_update(self->named, zuuid_str(sphactor_ask_uuid(actor)), (void *) name);
+}
+
+//  Remove the actor from the actors with the name we indexed it with, it
+//  may have been renamed since
+
+static void
+s_stage_unindex_name (sph_stage_t *self, sphactor_t *actor)
+{
+    const char *uuid = zuuid_str(sphactor_ask_uuid(actor));
+    const char *name = (const char *) zhash_lookup(self->named, uuid);
+    if (name == NULL)
+        return;
+    zlist_t *list = (zlist_t *) zhash_lookup(self->names, name);
+    if (list)
+    {
+        zlist_remove(list, actor);
+        if (zlist_size(list) == 0)
+            zhash_delete(self->names, name);
+    }
+    zhash_delete(self->named, uuid);
+}
+
+//  Move a renamed actor to its new name, see sphactor_set_rename_fn
+
+static void
+s_stage_renamed (sphactor_t *actor, void *args)
+{
+    sph_stage_t *self = (sph_stage_t *) args;
+    s_stage_unindex_name(self, actor);
+    s_stage_index_name(self, actor);
+}
+
+//  Add the actor to our endpoint and name indexes, and keep its name up
+//  to date when it is renamed
+
+static void
+s_stage_index (sph_stage_t *self, sphactor_t *actor)
+{
+    zhash_insert(self->endpoints, sphactor_ask_endpoint(actor), actor);
+    s_stage_index_name(self, actor);
+    sphactor_set_rename_fn(actor, s_stage_renamed, self);
+}
+
+static void
+s_stage_unindex (sph_stage_t *self, sphactor_t *actor)
+{
+    sphactor_set_rename_fn(actor, NULL, NULL);
+    const char *endpoint = sphactor_ask_endpoint(actor);
+    if (zhash_lookup(self->endpoints, endpoint) == actor)
+        zhash_delete(self->endpoints, endpoint);
+    s_stage_unindex_name(self, actor);
+}
+
+//  Actors are started by a few threads at once, most of the time goes to
+//  waiting for the actor threads to start
+#define SPH_STAGE_LOADERS 8
+
+typedef struct {
+    zconfig_t  **configs;       //  Actor configs to load
+    void       **prepared;      //  Their types, see sphactor_load_prepare
+    sphactor_t **actors;        //  The loaded actors, NULL on failure
+    size_t     count;           //  Number of actors
+    size_t     offset;          //  First actor for this loader
+    size_t     stride;          //  Number of loaders
+} stage_loader_t;
+
+static void
+s_stage_loader (zsock_t *pipe, void *args)
+{
+    stage_loader_t *loader = (stage_loader_t *) args;
+    zsock_signal(pipe, 0);
+    size_t index;
+    for (index = loader->offset; index < loader->count; index += loader->stride)
+        loader->actors[index] = sphactor_load_prepared(loader->configs[index],
+                                                       loader->prepared[index]);
+    zsock_signal(pipe, 0);
+    //  wait for zactor_destroy
+    char *command = zstr_recv(pipe);
+    zstr_free(&command);
+}
+
+//  Load all actors, starting them concurrently. The types are looked up
+//  and the constructors run here, one at a time, as sphactor_load does:
+//  neither the register nor the constructors are thread safe. With a
+//  sphactor_pool the actors start in the pool so there's nothing to wait
+//  for and we start them here too.
+
+static void
+s_stage_load_actors (zconfig_t **configs, sphactor_t **actors, size_t count)
+{
+    void **prepared = (void **) zmalloc((count ? count : 1) * sizeof(void *));
+    assert(prepared);
+    size_t index;
+    for (index = 0; index < count; index++)
+        prepared[index] = sphactor_load_prepare(configs[index]);
+
+    size_t loaders = count < SPH_STAGE_LOADERS ? count : SPH_STAGE_LOADERS;
+    if ( sphactor_pool_default() || sphactor_tick_default() || loaders < 2 )
+    {
+        for (index = 0; index < count; index++)
+            actors[index] = sphactor_load_prepared(configs[index], prepared[index]);
+        free(prepared);
+        return;
+    }
+    stage_loader_t loader[SPH_STAGE_LOADERS];
+    zactor_t *threads[SPH_STAGE_LOADERS];
+    for (index = 0; index < loaders; index++)
+    {
+        stage_loader_t item = { configs, prepared, actors, count, index, loaders };
+        loader[index] = item;
+        threads[index] = zactor_new(s_stage_loader, &loader[index]);
+        assert(threads[index]);
+    }
+    for (index = 0; index < loaders; index++)
+    {
+        zsock_wait(threads[index]);
+        zactor_destroy(&threads[index]);
+    }
+    free(prepared);
+}
+
+//  Load the actors of their configs and connect them, froms[i] connects
+//  to tos[i]. Returns the number of actors in the stage.
+
+static int
+s_stage_build(sph_stage_t *self, zconfig_t **configs, size_t count,
+              const char **froms, const char **tos, size_t edges)
+{
+    int64_t start = zclock_usecs();
 
-    zconfig_t* actors_conf = zconfig_locate((zconfig_t *)cnf, "actors");
-    assert(actors_conf);
-    zconfig_t* actor_conf = zconfig_locate(actors_conf, "actor");
-    assert(actor_conf);
     // create actors
-    while( actor_conf != NULL )
+    sphactor_t **actors = (sphactor_t **) zmalloc((count ? count : 1) * sizeof(sphactor_t *));
+    assert(actors);
+    s_stage_load_actors(configs, actors, count);
+    int64_t created = zclock_usecs();
+
+    // save actors and index them, asking all for their endpoint and name
+    // at once
+    zlist_t *futures = zlist_new();
+    size_t index;
+    for (index = 0; index < count; index++)
     {
-        sphactor_t *new_actor =  sphactor_load(actor_conf);
+        sphactor_t *new_actor = actors[index];
         if (new_actor)
         {
             // save actor
             int rc = zhash_insert(self->actors, zuuid_str(sphactor_ask_uuid(new_actor)), new_actor);
             assert( rc == 0);
-
-            // load settings for actor
-            //sph_deserialise_actor_data(new_actor, actor_conf);
+            zlist_append(futures, sphactor_ask_endpoint_async(new_actor));
+            zlist_append(futures, sphactor_ask_name_async(new_actor));
         }
-
-        actor_conf = zconfig_next(actor_conf);
     }
+    int rc = sphactor_future_wait_all(futures, -1);
+    assert(rc == 0);
+    for (index = 0; index < count; index++)
+        if (actors[index])
+            s_stage_index(self, actors[index]);
+    sphactor_future_t *future;
+    while ( (future = (sphactor_future_t *) zlist_pop(futures)) )
+        sphactor_future_destroy(&future);
+    int64_t indexed = zclock_usecs();
+
     // handle connections
+    for (index = 0; index < edges; index++)
+    {
+        // Find the output actor, we're the output side so we recreate the connection
+        sphactor_t *actor = sph_stage_find_actor_by_endpoint(self, froms[index]);
+        if (actor)
+            zlist_append(futures, sphactor_ask_connect_async(actor, tos[index]));
+    }
+    rc = sphactor_future_wait_all(futures, -1);
+    assert(rc == 0);
+    while ( (future = (sphactor_future_t *) zlist_pop(futures)) )
+    {
+        zframe_t *result = zmsg_last(sphactor_future_reply(future));
+        assert(result && zframe_streq(result, "0"));
+        sphactor_future_destroy(&future);
+    }
+    int64_t connected = zclock_usecs();
+    self->dirty = true;
+    zsys_info("sph_stage: loaded %zu actors, create %.1f ms, index %.1f ms, connect %.1f ms",
+              zhash_size(self->actors), (created - start) / 1000.0,
+              (indexed - created) / 1000.0, (connected - indexed) / 1000.0);
+
+    zlist_destroy(&futures);
+    free(actors);
+    return zhash_size(self->actors);
+}
+
+int
+sph_stage_cnf_load(sph_stage_t *self, const zconfig_t *cnf)
+{
+    assert(cnf);
+
+    // TODO: retrieve stage name???
+
+    zconfig_t* actors_conf = zconfig_locate((zconfig_t *)cnf, "actors");
+    assert(actors_conf);
+    zconfig_t* actor_conf = zconfig_locate(actors_conf, "actor");
+    assert(actor_conf);
+
+    size_t count = 0;
+    zconfig_t *it;
+    for (it = actor_conf; it != NULL; it = zconfig_next(it))
+        count++;
+    zconfig_t **configs = (zconfig_t **) zmalloc(count * sizeof(zconfig_t *));
+    assert(configs);
+    size_t index = 0;
+    for (it = actor_conf; it != NULL; it = zconfig_next(it))
+        configs[index++] = it;
+
+    // split the connections, "from,to,type"
     zconfig_t* connections = zconfig_locate((zconfig_t *)cnf, "connections");
     zconfig_t* con = zconfig_locate( connections, "con");
-    while( con != NULL ) {
-        char* conVal = strdup(zconfig_value(con)); // strok modifies the string and this messes up the config so dup it
+    size_t edges = 0;
+    for (it = con; it != NULL; it = zconfig_next(it))
+        edges++;
+    char **values = (char **) zmalloc((edges ? edges : 1) * sizeof(char *));
+    const char **froms = (const char **) zmalloc((edges ? edges : 1) * sizeof(char *));
+    const char **tos = (const char **) zmalloc((edges ? edges : 1) * sizeof(char *));
+    assert(values && froms && tos);
+    for (index = 0, it = con; it != NULL; it = zconfig_next(it), index++)
+    {
+        values[index] = strdup(zconfig_value(it));
+        char *to = strchr(values[index], ',');
+        assert(to);
+        *to++ = 0;
+        char *type = strchr(to, ',');
+        assert(type);
+        *type = 0;
+        froms[index] = values[index];
+        tos[index] = to;
+    }
 
-        // Parse comma separated connection string to get the two endpoints
-        int i;
-        for( i = 0; conVal[i] != '\0'; ++i ) {
-            if ( conVal[i] == ',' ) break;
-        }
+    int rc = s_stage_build(self, configs, count, froms, tos, edges);
+    for (index = 0; index < edges; index++)
+        zstr_free(&values[index]);
+    free(values);
+    free(froms);
+    free(tos);
+    free(configs);
+    return rc;
+}
 
-        char output[256];// = (char *)malloc(i+1);//new char[i+1];
-        char input[256];// = (char *)malloc((strlen(conVal) + 4) - i);
-        char type[64];// = malloc(64);
-
-        char *pch = strtok (conVal, ",");
-        assert(pch);
-        sprintf(input, "%s", pch);
-        pch = strtok (NULL, ",");
-        assert(pch);
-        sprintf(output, "%s", pch);
-        pch = strtok(NULL, ",");
-        assert(pch);
-        sprintf(type, "%s", pch);
-
-        // Loop actors and find output actor
-        for ( sphactor_t *actor = (sphactor_t *)zhash_first(self->actors); actor != NULL; actor = (sphactor_t *)zhash_next(self->actors) )
-        {
-            // We're the output side, so we recreate the connection
-            const char *endpoint = sphactor_ask_endpoint(actor);
-            if (streq(endpoint, input))
-            {
-                int rc = sphactor_ask_connect( actor, output );
-                assert(rc == 0);
-                break;
-            }
-        }
+//  Load the stage of a snapshot, its actor configs are built straight from
+//  the records and its edges are used in place
 
-        con = zconfig_next(con);
-        free(conVal);
+static int
+s_stage_snapshot_load(sph_stage_t *self, sph_stage_snapshot_t *snapshot)
+{
+    size_t count = sph_stage_snapshot_actors(snapshot);
+    size_t edges = sph_stage_snapshot_edges(snapshot);
+    zconfig_t *root = zconfig_new("actors", NULL);
+    zconfig_t **configs = (zconfig_t **) zmalloc((count ? count : 1) * sizeof(zconfig_t *));
+    const char **froms = (const char **) zmalloc((edges ? edges : 1) * sizeof(char *));
+    const char **tos = (const char **) zmalloc((edges ? edges : 1) * sizeof(char *));
+    assert(configs && froms && tos);
+    size_t index;
+    for (index = 0; index < count; index++)
+        configs[index] = sph_stage_snapshot_actor(snapshot, index, root);
+    for (index = 0; index < edges; index++)
+    {
+        froms[index] = sph_stage_snapshot_edge_from(snapshot, index);
+        tos[index] = sph_stage_snapshot_edge_to(snapshot, index);
     }
-    return zhash_size(self->actors);
+    int rc = s_stage_build(self, configs, count, froms, tos, edges);
+    free(tos);
+    free(froms);
+    free(configs);
+    zconfig_destroy(&root);
+    return rc;
 }
 
 static bool
@@ -154,14 +403,20 @@ sph_stage_t *
 sph_stage_load(const char *config_path)
 {
     assert(config_path);
-    zconfig_t* root = zconfig_load(config_path);
-    if ( root == NULL )
+    // a snapshot maps straight into actor configs, else parse the text
+    sph_stage_snapshot_t *snapshot = sph_stage_snapshot_new(config_path);
+    zconfig_t* root = NULL;
+    if ( snapshot == NULL )
     {
-        zsys_error("Error loading %s", config_path);
-        return NULL;
+        root = zconfig_load(config_path);
+        if ( root == NULL )
+        {
+            zsys_error("Error loading %s", config_path);
+            return NULL;
+        }
     }
     sph_stage_t *self = NULL;
-    if ( s_validate_stage_config(root) )
+    if ( snapshot || s_validate_stage_config(root) )
     {
         // set working directory to stage config path
 #ifdef __WINDOWS__
@@ -186,16 +441,113 @@ sph_stage_load(const char *config_path)
 #endif
         assert(self);
         self->config_path = strdup(config_path);
-        int rc = sph_stage_cnf_load(self, root);
+        self->binary = snapshot != NULL;
+        if ( snapshot )
+            s_stage_snapshot_load(self, snapshot);
+        else
+            sph_stage_cnf_load(self, root);
     }
+    sph_stage_snapshot_destroy(&snapshot);
     zconfig_destroy(&root);
     return self;
 }
 
+//  Return the msecs left until the deadline, -1 if there is none
+
+static int
+s_stage_remaining (int64_t deadline)
+{
+    if (deadline < 0)
+        return -1;
+    int64_t remaining = deadline - zclock_mono();
+    return remaining > 0 ? (int) remaining : 0;
+}
+
+//  Let the actors handle the messages in flight between them. Every round
+//  moves messages at least one actor further, so a chain is flushed after
+//  as many rounds as it has actors.
+
+static void
+s_stage_drain (sph_stage_t *self, int64_t deadline)
+{
+    size_t rounds = zhash_size(self->actors) + 1;
+    zlist_t *futures = zlist_new();
+    while ( rounds-- > 0 )
+    {
+        int remaining = s_stage_remaining(deadline);
+        for (sphactor_t *it = (sphactor_t *)zhash_first(self->actors); it != NULL; it = (sphactor_t *)zhash_next( self->actors ) )
+            zlist_append(futures, sphactor_ask_drain_async(it, remaining));
+        // the actors stop draining at the deadline themselves
+        int rc = sphactor_future_wait_all(futures, -1);
+        assert(rc == 0);
+        int64_t drained = 0;
+        sphactor_future_t *future;
+        while ( (future = (sphactor_future_t *) zlist_pop(futures)) )
+        {
+            zframe_t *frame = zmsg_first(sphactor_future_reply(future));
+            if ( frame && zframe_size(frame) == sizeof(int64_t) )
+                drained += *(int64_t *) zframe_data(frame);
+            sphactor_future_destroy(&future);
+        }
+        if ( drained == 0 || s_stage_remaining(deadline) == 0 )
+            break;
+    }
+    zlist_destroy(&futures);
+}
+
+//  Tell all actors to terminate at once, so they stop concurrently, and
+//  wait for them until the deadline. Returns the number of actors which
+//  did not terminate in time.
+
+static size_t
+s_stage_terminate (sph_stage_t *self, int64_t deadline)
+{
+    zpoller_t *poller = zpoller_new(NULL);
+    size_t waiting = 0;
+    for (sphactor_t *it = (sphactor_t *)zhash_first(self->actors); it != NULL; it = (sphactor_t *)zhash_next( self->actors ) )
+    {
+        sphactor_ask_terminate(it);
+        zpoller_add(poller, sphactor_socket(it));
+        waiting++;
+    }
+    // an actor's socket is readable once it signalled its exit, we leave
+    // the signal for sphactor_destroy
+    while ( waiting > 0 )
+    {
+        void *which = zpoller_wait(poller, s_stage_remaining(deadline));
+        if ( which == NULL )
+            break;
+        zpoller_remove(poller, which);
+        waiting--;
+    }
+    zpoller_destroy(&poller);
+    return waiting;
+}
+
+int
+sph_stage_shutdown(sph_stage_t *self, int timeout, bool drain)
+{
+    assert(self);
+    int64_t start = zclock_mono();
+    int64_t deadline = timeout >= 0 ? start + timeout : -1;
+    size_t count = zhash_size(self->actors);
+    if ( drain )
+        s_stage_drain(self, deadline);
+    size_t late = s_stage_terminate(self, deadline);
+    if ( late )
+        zsys_warning("sph_stage: %zu of %zu actors did not stop within %d ms, waiting for them",
+                     late, count, timeout);
+    sph_stage_clear(self);
+    zsys_info("sph_stage: shut down %zu actors in %" PRId64 " ms", count, zclock_mono() - start);
+    return (int) late;
+}
+
 int
 sph_stage_clear(sph_stage_t* self)
 {
     assert(self);
+    // all actors stop at once, then we destroy them
+    s_stage_terminate(self, -1);
     for ( sphactor_t *actor = (sphactor_t *)zhash_first(self->actors); actor != NULL; actor = (sphactor_t *)zhash_next(self->actors) )
     {
         if (actor)
@@ -205,6 +557,11 @@ sph_stage_clear(sph_stage_t* self)
     zhash_destroy(&self->actors);
     assert(self->actors == NULL);
     self->actors = zhash_new();
+    zhash_purge(self->endpoints);
+    zhash_purge(self->names);
+    zhash_purge(self->named);
+    zhash_purge(self->saved);
+    self->dirty = true;
     return 0;
 }
 
@@ -238,22 +595,370 @@ sph_stage_save(sph_stage_t *self)
 {
     assert(self);
     assert(self->config_path);
+    if (self->binary)
+        return sph_stage_save_snapshot(self, self->config_path);
     return sph_stage_save_as(self, self->config_path);
 }
 
+static void
+s_stage_saved_free (void *data)
+{
+    stage_saved_t *saved = (stage_saved_t *) data;
+    zstr_free(&saved->actor);
+    zstr_free(&saved->connections);
+    free(saved);
+}
+
+//  Return the text zconfig_save writes for a root holding a single section,
+//  without the line of the section itself
+
+static char *
+s_stage_section_text (zconfig_t *root)
+{
+    char *text = zconfig_str_save(root);
+    char *body = text ? strchr(text, '\n') : NULL;
+    char *section = strdup(body ? body + 1 : "");
+    zstr_free(&text);
+    return section;
+}
+
+//  Return the serialized form of the actor, serializing it again only if
+//  it changed since the last time
+
+static stage_saved_t *
+s_stage_saved (sph_stage_t *self, sphactor_t *actor, bool *changed)
+{
+    const char *uuid = zuuid_str(sphactor_ask_uuid(actor));
+    stage_saved_t *saved = (stage_saved_t *) zhash_lookup(self->saved, uuid);
+    if (saved && saved->revision == sphactor_revision(actor))
+        return saved;
+    if (saved == NULL)
+    {
+        saved = (stage_saved_t *) zmalloc(sizeof(stage_saved_t));
+        assert(saved);
+        zhash_insert(self->saved, uuid, saved);
+        zhash_freefn(self->saved, uuid, s_stage_saved_free);
+    }
+    zstr_free(&saved->actor);
+    zstr_free(&saved->connections);
+    saved->revision = sphactor_revision(actor);
+
+    zconfig_t *root = zconfig_new("root", NULL);
+    sphactor_save(actor, zconfig_new("actors", root));
+    saved->actor = s_stage_section_text(root);
+    zconfig_destroy(&root);
+
+    root = zconfig_new("root", NULL);
+    zconfig_t *connections = zconfig_new("connections", root);
+    for (char *c = (char *)zlist_first(sphactor_connections(actor)); c != (char *)NULL; c = (char *)zlist_next(sphactor_connections(actor)) )
+    {
+        zconfig_t* item = zconfig_new( "con", connections );
+        assert( item );
+        zconfig_set_value(item,"%s,%s,%s", sphactor_ask_endpoint(actor), c, "OSC" );
+    }
+    saved->connections = s_stage_section_text(root);
+    zconfig_destroy(&root);
+    *changed = true;
+    return saved;
+}
+
+//  Rename the file written next to its destination into place, so the
+//  destination always holds a complete stage. Drops the file if writing
+//  it failed, rc is the result of writing it.
+
+static int
+s_stage_replace (const char *tmp_path, const char *config_path, int rc)
+{
+    if (rc == 0)
+    {
+#if defined (__WINDOWS__)
+        rc = MoveFileExA(tmp_path, config_path, MOVEFILE_REPLACE_EXISTING) ? 0 : -1;
+#else
+        rc = rename(tmp_path, config_path);
+#endif
+    }
+    if (rc != 0)
+    {
+        zsys_error("Error writing %s", config_path);
+        zsys_file_delete(tmp_path);
+    }
+    return rc;
+}
+
+//  Write the text file next to its destination and move it into place
+
+static int
+s_stage_write (sph_stage_t *self, const char *config_path)
+{
+    char *tmp_path = zsys_sprintf("%s.tmp", config_path);
+    FILE *file = fopen(tmp_path, "w");
+    if (file == NULL)
+    {
+        zsys_error("Error writing %s", tmp_path);
+        zstr_free(&tmp_path);
+        return -1;
+    }
+    fputs("actors\n", file);
+    for (sphactor_t *it = (sphactor_t *)zhash_first(self->actors); it != NULL; it = (sphactor_t *)zhash_next( self->actors ) )
+        fputs(((stage_saved_t *) zhash_lookup(self->saved, zhash_cursor(self->actors)))->actor, file);
+    if (zhash_size(self->actors))
+    {
+        fputs("connections\n", file);
+        for (sphactor_t *it = (sphactor_t *)zhash_first(self->actors); it != NULL; it = (sphactor_t *)zhash_next( self->actors ) )
+            fputs(((stage_saved_t *) zhash_lookup(self->saved, zhash_cursor(self->actors)))->connections, file);
+    }
+    int rc = fflush(file) == 0 && !ferror(file) ? 0 : -1;
+#if defined (__UNIX__)
+    if (rc == 0)
+        rc = fsync(fileno(file));
+#endif
+    fclose(file);
+    rc = s_stage_replace(tmp_path, config_path, rc);
+    zstr_free(&tmp_path);
+    return rc;
+}
+
 int
 sph_stage_save_as(sph_stage_t *self, const char *config_path)
 {
     assert(self);
     assert(config_path);
-    zconfig_t* config = s_sph_stage_save_zconfig(self);
-    int rc = zconfig_save(config, config_path);
-    assert(rc == 0);
-    zstr_free(&self->config_path);
-    self->config_path = strdup(config_path);
+    //  only actors which changed since the last save are serialized again,
+    //  the file is written when any did or it isn't the file we wrote
+    bool changed = self->dirty
+                || self->binary
+                || self->config_path == NULL
+                || !streq(self->config_path, config_path)
+                || !zsys_file_exists(config_path)
+                || zsys_file_modified(config_path) != self->saved_time;
+    for (sphactor_t *it = (sphactor_t *)zhash_first(self->actors); it != NULL; it = (sphactor_t *)zhash_next( self->actors ) )
+        s_stage_saved(self, it, &changed);
+    //  nothing to do if the file already holds this stage
+    if (!changed)
+        return 0;
+    int rc = s_stage_write(self, config_path);
+    if (rc == 0)
+    {
+        self->dirty = false;
+        self->binary = false;
+        self->saved_time = zsys_file_modified(config_path);
+        if (self->config_path != config_path)
+        {
+            zstr_free(&self->config_path);
+            self->config_path = strdup(config_path);
+        }
+    }
+    return rc;
+}
+
+int
+sph_stage_save_snapshot(sph_stage_t *self, const char *config_path)
+{
+    assert(self);
+    assert(config_path);
+    zconfig_t *config = s_sph_stage_save_zconfig(self);
+    char *tmp_path = zsys_sprintf("%s.tmp", config_path);
+    int rc = sph_stage_snapshot_save(config, tmp_path);
+    rc = s_stage_replace(tmp_path, config_path, rc);
+    zstr_free(&tmp_path);
+    zconfig_destroy(&config);
+    if (rc == 0)
+    {
+        self->binary = true;
+        if (self->config_path != config_path)
+        {
+            zstr_free(&self->config_path);
+            self->config_path = strdup(config_path);
+        }
+    }
+    return rc;
+}
+
+int
+sph_stage_convert(const char *source, const char *destination)
+{
+    assert(source);
+    assert(destination);
+    char *tmp_path = zsys_sprintf("%s.tmp", destination);
+    sph_stage_snapshot_t *snapshot = sph_stage_snapshot_new(source);
+    int rc;
+    if (snapshot)
+    {
+        zconfig_t *config = sph_stage_snapshot_zconfig(snapshot);
+        rc = zconfig_save(config, tmp_path);
+        zconfig_destroy(&config);
+        sph_stage_snapshot_destroy(&snapshot);
+    }
+    else
+    {
+        zconfig_t *config = zconfig_load(source);
+        if (config == NULL)
+        {
+            zsys_error("Error loading %s", source);
+            zstr_free(&tmp_path);
+            return -1;
+        }
+        rc = sph_stage_snapshot_save(config, tmp_path);
+        zconfig_destroy(&config);
+    }
+    rc = s_stage_replace(tmp_path, destination, rc);
+    zstr_free(&tmp_path);
     return rc;
 }
 
+//  Apply the changes of an actor config to a running actor: its name,
+//  position and capability values
+
+static void
+s_stage_update_actor(sph_stage_t *self, sphactor_t *actor, zconfig_t *config)
+{
+    zconfig_t *current = sphactor_save(actor, NULL);
+    const char *name = zconfig_get(config, "name", "");
+    if ( !streq(name, zconfig_get(current, "name", "")) )
+    {
+        sphactor_ask_set_name(actor, name);
+    }
+    const char *xpos = zconfig_get(config, "xpos", "0");
+    const char *ypos = zconfig_get(config, "ypos", "0");
+    if ( !streq(xpos, zconfig_get(current, "xpos", ""))
+    ||   !streq(ypos, zconfig_get(current, "ypos", "")) )
+        sphactor_set_position(actor, atof(xpos), atof(ypos));
+    // the values follow the position, as in sphactor_load
+    zconfig_t *value = zconfig_next(zconfig_locate(config, "ypos"));
+    while ( value )
+    {
+        const char *was = zconfig_get(current, zconfig_name(value), NULL);
+        if ( was == NULL || !streq(was, zconfig_value(value)) )
+            sphactor_set_value(actor, zconfig_name(value), zconfig_value(value));
+        value = zconfig_next(value);
+    }
+    zconfig_destroy(&current);
+}
+
+int
+sph_stage_reload(sph_stage_t *self, const char *config_path)
+{
+    assert(self);
+    assert(config_path);
+    sph_stage_snapshot_t *snapshot = sph_stage_snapshot_new(config_path);
+    zconfig_t *root = NULL;
+    if ( snapshot )
+        root = sph_stage_snapshot_zconfig(snapshot);
+    else
+        root = zconfig_load(config_path);
+    if ( root == NULL || !s_validate_stage_config(root) )
+    {
+        zsys_error("Error loading %s", config_path);
+        zconfig_destroy(&root);
+        return -1;
+    }
+    bool binary = snapshot != NULL;
+    sph_stage_snapshot_destroy(&snapshot);
+
+    // the actors we want by uuid
+    zhash_t *wanted = zhash_new();
+    zconfig_t *config = zconfig_locate(root, "actors/actor");
+    for (; config != NULL; config = zconfig_next(config))
+        zhash_insert(wanted, zconfig_get(config, "uuid", ""), config);
+
+    // destroy removed actors, and those which changed type as they are
+    // created again
+    zlist_t *removed = zlist_new();
+    zlist_autofree(removed);
+    for (sphactor_t *it = (sphactor_t *)zhash_first(self->actors); it != NULL; it = (sphactor_t *)zhash_next( self->actors ) )
+    {
+        config = (zconfig_t *) zhash_lookup(wanted, zhash_cursor(self->actors));
+        if ( config == NULL || !streq(zconfig_get(config, "type", ""), sphactor_ask_actor_type(it)) )
+            zlist_append(removed, (void *) zhash_cursor(self->actors));
+    }
+    for (char *uuid = (char *)zlist_first(removed); uuid != NULL; uuid = (char *)zlist_next(removed))
+        sph_stage_remove_actor(self, uuid);
+
+    // update the running actors, collect the new ones
+    size_t count = 0;
+    zconfig_t **added = (zconfig_t **) zmalloc((zhash_size(wanted) + 1) * sizeof(zconfig_t *));
+    assert(added);
+    for (config = (zconfig_t *)zhash_first(wanted); config != NULL; config = (zconfig_t *)zhash_next(wanted))
+    {
+        sphactor_t *actor = sph_stage_find_actor(self, zhash_cursor(wanted));
+        if ( actor )
+            s_stage_update_actor(self, actor, config);
+        else
+            added[count++] = config;
+    }
+    if ( count )
+        s_stage_build(self, added, count, NULL, NULL, 0);
+
+    // the connections we want as "from,to"
+    zhash_t *edges = zhash_new();
+    zconfig_t *con = zconfig_locate(root, "connections/con");
+    for (; con != NULL; con = zconfig_next(con))
+    {
+        char *edge = strdup(zconfig_value(con));
+        char *type = strrchr(edge, ',');
+        if ( type && type != strchr(edge, ',') )
+        {
+            *type = 0;
+            zhash_insert(edges, edge, con);
+        }
+        zstr_free(&edge);
+    }
+    // disconnect the edges we don't want, those we keep are done
+    for (sphactor_t *it = (sphactor_t *)zhash_first(self->actors); it != NULL; it = (sphactor_t *)zhash_next( self->actors ) )
+    {
+        zlist_t *gone = zlist_new();
+        zlist_autofree(gone);
+        for (char *c = (char *)zlist_first(sphactor_connections(it)); c != (char *)NULL; c = (char *)zlist_next(sphactor_connections(it)) )
+        {
+            char *edge = zsys_sprintf("%s,%s", sphactor_ask_endpoint(it), c);
+            if ( zhash_lookup(edges, edge) )
+                zhash_delete(edges, edge);
+            else
+                zlist_append(gone, c);
+            zstr_free(&edge);
+        }
+        for (char *c = (char *)zlist_first(gone); c != (char *)NULL; c = (char *)zlist_next(gone) )
+            sphactor_ask_disconnect(it, c);
+        zlist_destroy(&gone);
+    }
+    // connect the new edges
+    zlist_t *futures = zlist_new();
+    for (void *it = zhash_first(edges); it != NULL; it = zhash_next(edges))
+    {
+        char *from = strdup(zhash_cursor(edges));
+        char *to = strchr(from, ',');
+        *to++ = 0;
+        sphactor_t *actor = sph_stage_find_actor_by_endpoint(self, from);
+        if ( actor )
+            zlist_append(futures, sphactor_ask_connect_async(actor, to));
+        zstr_free(&from);
+    }
+    int rc = sphactor_future_wait_all(futures, -1);
+    assert(rc == 0);
+    sphactor_future_t *future;
+    while ( (future = (sphactor_future_t *) zlist_pop(futures)) )
+        sphactor_future_destroy(&future);
+    zsys_info("sph_stage: reloaded %s, %zu actors removed, %zu added",
+              config_path, zlist_size(removed), count);
+
+    // the stage mirrors this file now
+    if ( self->config_path != config_path )
+    {
+        zstr_free(&self->config_path);
+        self->config_path = strdup(config_path);
+    }
+    self->binary = binary;
+    self->dirty = true;
+
+    zlist_destroy(&futures);
+    zhash_destroy(&edges);
+    free(added);
+    zlist_destroy(&removed);
+    zhash_destroy(&wanted);
+    zconfig_destroy(&root);
+    return zhash_size(self->actors);
+}
+
 const zhash_t *
 sph_stage_actors(sph_stage_t *self)
 {
@@ -270,6 +975,24 @@ sph_stage_find_actor (sph_stage_t *self, const char *id)
     return actor;
 }
 
+sphactor_t *
+sph_stage_find_actor_by_endpoint (sph_stage_t *self, const char *endpoint)
+{
+    assert(self);
+    assert(endpoint);
+    return (sphactor_t *)zhash_lookup(self->endpoints, endpoint);
+}
+
+sphactor_t *
+sph_stage_find_actor_by_name (sph_stage_t *self, const char *name)
+{
+    assert(self);
+    assert(name);
+    //  renames move actors in the index as they happen
+    zlist_t *list = (zlist_t *)zhash_lookup(self->names, name);
+    return list ? (sphactor_t *)zlist_head(list) : NULL;
+}
+
 int
 sph_stage_add_actor(sph_stage_t *self, sphactor_t *actor)
 {
@@ -277,6 +1000,11 @@ sph_stage_add_actor(sph_stage_t *self, sphactor_t *actor)
     assert(actor);
 
     int rc = zhash_insert(self->actors, zuuid_str(sphactor_ask_uuid(actor)), actor);
+    if (rc == 0)
+    {
+        s_stage_index(self, actor);
+        self->dirty = true;
+    }
     return rc;
 }
 
@@ -290,6 +1018,9 @@ sph_stage_remove_actor(sph_stage_t *self, const char *actor_id)
     if (actor)
     {
         zhash_delete(self->actors, actor_id);
+        s_stage_unindex(self, actor);
+        zhash_delete(self->saved, actor_id);
+        self->dirty = true;
         sphactor_destroy(&actor);
         return 0;
     }
@@ -341,7 +1072,7 @@ sph_stage_test (bool verbose)
     "        endpoint = \"inproc://2A7110DFC47C4DF19EB1D17E390CF86B\"\n"
     "        xpos = \"34.500000\"\n"
     "        ypos = \"426.000000\"\n"
-    "        timeout = \"1000\"\n"
+    "        timeout = \"500\"\n"
     "        someFloat = \"1.0\"\n"
     "        someText = \"Hello world!\"\n"
     "connections\n"
@@ -370,6 +1101,13 @@ sph_stage_test (bool verbose)
     assert(pulseact);
     assert( streq( zuuid_str(sphactor_ask_uuid(pulseact)), "2A7110DFC47C4DF19EB1D17E390CF86B" ));
     assert( streq( sphactor_ask_actor_type(pulseact), "Pulse"));
+    //  the capability values arrived in their batch
+    assert( sphactor_ask_timeout(pulseact) == 500 );
+    assert( zlist_size(sphactor_connections(pulseact)) == 1 );
+    assert( sph_stage_find_actor_by_endpoint(stage2, "inproc://2A7110DFC47C4DF19EB1D17E390CF86B") == pulseact );
+    assert( sph_stage_find_actor_by_name(stage2, "2A7110") == pulseact );
+    assert( sph_stage_find_actor_by_name(stage2, "8FADA7") != NULL );
+    assert( streq( (char *) zlist_first(sphactor_connections(pulseact)), "inproc://7B21D87CB6B04FC5801A5B396269876D" ));
     // save stage
     zconfig_t *testsave = s_sph_stage_save_zconfig(stage2);
     assert(testsave);
@@ -410,13 +1148,152 @@ sph_stage_test (bool verbose)
     assert(testkey);
     zconfig_destroy(&testsave);
 
+    // save to a file, only changes are written
+    char *filename = zsys_sprintf ("%s/%s", SELFTEST_DIR_RW, "test_stage.txt");
+    assert (filename);
+    rc = sph_stage_save_as(stage2, filename);
+    assert( rc == 0 );
+    zconfig_t *saved = zconfig_load(filename);
+    assert( saved );
+    assert( zconfig_locate(saved, "actors/actor/uuid") );
+    assert( zconfig_locate(saved, "connections/con") );
+    zconfig_destroy(&saved);
+    zsys_file_delete(filename);
+    rc = sph_stage_save(stage2);
+    assert( rc == 0 );
+    assert( zsys_file_exists(filename) );   // unchanged but missing
+    sphactor_set_position(pulseact, 1.f, 2.f);
+    rc = sph_stage_save(stage2);
+    assert( rc == 0 );
+    saved = zconfig_load(filename);
+    assert( saved );
+    zconfig_t *savedact = zconfig_locate(saved, "actors/actor");
+    while ( savedact && !streq(zconfig_get(savedact, "name", ""), "2A7110") )
+        savedact = zconfig_next(savedact);
+    assert( savedact );
+    assert( streq(zconfig_get(savedact, "xpos", ""), "1.000000") );
+    assert( streq(zconfig_get(savedact, "timeout", ""), "500") );
+    zconfig_destroy(&saved);
+    zsys_file_delete(filename);
+
+    // a snapshot keeps its format when saved
+    rc = sph_stage_save_snapshot(stage2, filename);
+    assert( rc == 0 );
+    assert( stage2->binary );
+    sphactor_set_position(pulseact, 3.f, 2.f);
+    rc = sph_stage_save(stage2);
+    assert( rc == 0 );
+    sph_stage_snapshot_t *snapshot = sph_stage_snapshot_new(filename);
+    assert( snapshot );
+    assert( sph_stage_snapshot_actors(snapshot) == 2 );
+    assert( sph_stage_snapshot_edges(snapshot) == 1 );
+    sph_stage_snapshot_destroy(&snapshot);
+
+    // convert it to text and back
+    char *textname = zsys_sprintf ("%s/%s", SELFTEST_DIR_RW, "test_stage_text.txt");
+    rc = sph_stage_convert(filename, textname);
+    assert( rc == 0 );
+    saved = zconfig_load(textname);
+    assert( saved );
+    assert( zconfig_locate(saved, "connections/con") );
+    zconfig_destroy(&saved);
+    zsys_file_delete(filename);
+    rc = sph_stage_convert(textname, filename);
+    assert( rc == 0 );
+    zsys_file_delete(textname);
+    zstr_free(&textname);
+
+    // names follow renames the stage didn't make and need not be unique
+    sphactor_t *otheract = sph_stage_find_actor_by_name(stage2, "8FADA7");
+    assert( otheract );
+    sphactor_ask_set_name(otheract, "2A7110");
+    assert( sph_stage_find_actor_by_name(stage2, "8FADA7") == NULL );
+    assert( sph_stage_find_actor_by_name(stage2, "2A7110") == pulseact );
+
     // remove test
     sph_stage_remove_actor( stage2, "2A7110DFC47C4DF19EB1D17E390CF86B" );
     pulseact = sph_stage_find_actor(stage2, "2A7110DFC47C4DF19EB1D17E390CF86B");
     assert(pulseact == NULL);
+    assert( sph_stage_find_actor_by_endpoint(stage2, "inproc://2A7110DFC47C4DF19EB1D17E390CF86B") == NULL );
+    //  the other actor with the name is still found
+    assert( sph_stage_find_actor_by_name(stage2, "2A7110") == otheract );
+    sph_stage_remove_actor( stage2, zuuid_str(sphactor_ask_uuid(otheract)) );
+    assert( sph_stage_find_actor_by_name(stage2, "2A7110") == NULL );
     sph_stage_destroy(&stage2);
     zconfig_destroy( &root );
 
+    // the snapshot loads the same stage
+    snapshot = sph_stage_snapshot_new(filename);
+    assert( snapshot );
+    sph_stage_t *snapstage = sph_stage_new("test_snapshot");
+    rc = s_stage_snapshot_load(snapstage, snapshot);
+    assert( rc == 2 );
+    sph_stage_snapshot_destroy(&snapshot);
+    pulseact = sph_stage_find_actor_by_name(snapstage, "2A7110");
+    assert( pulseact );
+    assert( sphactor_ask_timeout(pulseact) == 500 );
+    assert( sphactor_position_x(pulseact) == 3.f );
+    assert( zlist_size(sphactor_connections(pulseact)) == 1 );
+    sph_stage_destroy(&snapstage);
+    zsys_file_delete(filename);
+    zstr_free(&filename);
+
+    // reload only touches what changed
+    root = zconfig_str_load (cnfstr);
+    sph_stage_t *stage4 = sph_stage_new("test_reload");
+    rc = sph_stage_cnf_load(stage4, root);
+    assert( rc == 2 );
+    zconfig_destroy( &root );
+    pulseact = sph_stage_find_actor_by_name(stage4, "2A7110");
+    assert( pulseact );
+    char *reloadstr =
+    "actors\n"
+    "    actor\n"
+    "        uuid = \"2A7110DFC47C4DF19EB1D17E390CF86B\"\n"
+    "        type = \"Pulse\"\n"
+    "        name = \"2A7110\"\n"
+    "        endpoint = \"inproc://2A7110DFC47C4DF19EB1D17E390CF86B\"\n"
+    "        xpos = \"40.000000\"\n"
+    "        ypos = \"426.000000\"\n"
+    "        timeout = \"250\"\n"
+    "    actor\n"
+    "        uuid = \"5C3E0D9A2F7B4E8C9D1A6B3F2E4D5C6B\"\n"
+    "        type = \"Log\"\n"
+    "        name = \"5C3E0D\"\n"
+    "        endpoint = \"inproc://5C3E0D9A2F7B4E8C9D1A6B3F2E4D5C6B\"\n"
+    "        xpos = \"600.000000\"\n"
+    "        ypos = \"312.000000\"\n"
+    "connections\n"
+    "    con = \"inproc://2A7110DFC47C4DF19EB1D17E390CF86B,inproc://5C3E0D9A2F7B4E8C9D1A6B3F2E4D5C6B,OSC\"\n";
+    root = zconfig_str_load (reloadstr);
+    filename = zsys_sprintf ("%s/%s", SELFTEST_DIR_RW, "test_reload.txt");
+    rc = zconfig_save(root, filename);
+    assert( rc == 0 );
+    zconfig_destroy( &root );
+    rc = sph_stage_reload(stage4, filename);
+    assert( rc == 2 );
+    assert( sph_stage_find_actor_by_name(stage4, "2A7110") == pulseact );
+    assert( sph_stage_find_actor_by_name(stage4, "8FADA7") == NULL );
+    assert( sph_stage_find_actor_by_name(stage4, "5C3E0D") != NULL );
+    assert( sphactor_ask_timeout(pulseact) == 250 );
+    assert( sphactor_position_x(pulseact) == 40.f );
+    assert( zlist_size(sphactor_connections(pulseact)) == 1 );
+    assert( streq( (char *) zlist_first(sphactor_connections(pulseact)), "inproc://5C3E0D9A2F7B4E8C9D1A6B3F2E4D5C6B" ));
+    // reloading the same file changes nothing
+    rc = sph_stage_reload(stage4, filename);
+    assert( rc == 2 );
+    assert( sph_stage_find_actor_by_name(stage4, "2A7110") == pulseact );
+    assert( zlist_size(sphactor_connections(pulseact)) == 1 );
+    // all actors stop at once, after handling what is in flight
+    rc = sph_stage_shutdown(stage4, 1000, true);
+    assert( rc == 0 );
+    assert( zhash_size((zhash_t *)sph_stage_actors(stage4)) == 0 );
+    rc = sph_stage_shutdown(stage4, 0, false);
+    assert( rc == 0 );
+    sph_stage_destroy(&stage4);
+    zsys_file_delete(filename);
+    zstr_free(&filename);
+
     sph_stage_t *stage3 = sph_stage_new("test_add");
     assert(stage3);
     sphactor_t *testact = sphactor_new_by_type("Log", NULL, NULL);
@@ -428,6 +1305,7 @@ sph_stage_test (bool verbose)
     assert( zhash_size((zhash_t *)actors) == 1);
     const sphactor_t *act2 =  (const sphactor_t *)zhash_first((zhash_t *)actors);
     assert( testact == (sphactor_t *)act2 );
+    assert( sph_stage_find_actor_by_endpoint(stage3, sphactor_ask_endpoint(testact)) == testact );
     rc = sph_stage_remove_actor(stage3, zuuid_str( sphactor_ask_uuid(testact)) );
     assert( rc == 0 );
     assert( zhash_size((zhash_t *)actors) == 0 );
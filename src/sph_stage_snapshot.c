@@ -0,0 +1,571 @@
+/*  =========================================================================
+    sph_stage_snapshot - class description
+
+    Copyright (c) the Contributors as noted in the AUTHORS file.
+
+    This file is part of Sphactor, an open-source framework for high level
+    actor model concurrency --- http://sphactor.org
+
+    This Source Code Form is subject to the terms of the Mozilla Public
+    License, v. 2.0. If a copy of the MPL was not distributed with this
+    file, You can obtain one at http://mozilla.org/MPL/2.0/.
+    =========================================================================
+*/
+
+/*
+@header
+    sph_stage_snapshot - binary stage file, mapped into memory
+@discuss
+    Loading a text stage means tokenizing the whole file and splitting the
+    connection strings, which dominates cold start of large stages. A
+    snapshot holds the same stage in records which are read in place.
+
+    All numbers are little endian uint32_t:
+
+        header      "SPHSTAGE", version, strings, actors, values, edges,
+                    size of the string blob
+        offsets     one per string, into the blob
+        blob        NUL terminated strings, padded to 4 bytes
+        actors      uuid, type, name, endpoint, xpos, ypos, first value,
+                    number of values
+        values      name, value
+        edges       from, to, type
+
+    Everything but the counts refers to strings by their index, a string
+    is stored once however often it occurs. Positions are kept as the
+    strings the text format holds so both formats convert without loss.
+    The whole file is validated when it is mapped, after that the records
+    are read without checks.
+@end
+*/
+
+#include "sphactor_classes.h"
+#if defined (__UNIX__)
+#include <sys/mman.h>
+#endif
+
+#define SNAPSHOT_MAGIC      "SPHSTAGE"
+#define SNAPSHOT_VERSION    1
+#define SNAPSHOT_HEADER     32          //  Magic and six counts
+#define SNAPSHOT_ACTOR      8           //  Fields of an actor record
+#define SNAPSHOT_VALUE      2           //  Fields of a value record
+#define SNAPSHOT_EDGE       3           //  Fields of an edge record
+
+//  Actor config entries which are not capability values
+static const char *s_actor_fields [] = {
+    "uuid", "type", "name", "endpoint", "xpos", "ypos"
+};
+#define SNAPSHOT_FIELDS     6
+
+//  Structure of our class
+
+struct _sph_stage_snapshot_t {
+    byte    *data;              //  Contents of the file
+    size_t  size;               //  Size of the file
+    bool    mapped;             //  Data is mapped, else allocated
+    uint32_t strings;           //  Number of strings
+    uint32_t actors;            //  Number of actors
+    uint32_t values;            //  Number of values
+    uint32_t edges;             //  Number of edges
+    byte    *offsets;           //  String offsets
+    char    *blob;              //  Strings
+    byte    *actor_table;       //  Actor records
+    byte    *value_table;       //  Value records
+    byte    *edge_table;        //  Edge records
+};
+
+static uint32_t
+s_get_u32 (const byte *data)
+{
+    return (uint32_t) data [0]
+        | ((uint32_t) data [1] << 8)
+        | ((uint32_t) data [2] << 16)
+        | ((uint32_t) data [3] << 24);
+}
+
+//  Return field of record index in a table of records with fields each
+
+static uint32_t
+s_field (const byte *table, size_t fields, size_t index, size_t field)
+{
+    return s_get_u32 (table + (index * fields + field) * 4);
+}
+
+static const char *
+s_string (sph_stage_snapshot_t *self, uint32_t id)
+{
+    return self->blob + s_get_u32 (self->offsets + id * 4);
+}
+
+//  Read the file into data, mapping it where we can
+
+static int
+s_snapshot_map (sph_stage_snapshot_t *self, const char *path)
+{
+#if defined (__UNIX__)
+    int fd = open (path, O_RDONLY);
+    if (fd == -1)
+        return -1;
+    struct stat stat_buf;
+    if (fstat (fd, &stat_buf) == -1 || stat_buf.st_size < SNAPSHOT_HEADER) {
+        close (fd);
+        return -1;
+    }
+    self->size = (size_t) stat_buf.st_size;
+    void *data = mmap (NULL, self->size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close (fd);
+    if (data == MAP_FAILED)
+        return -1;
+    self->data = (byte *) data;
+    self->mapped = true;
+    return 0;
+#else
+    FILE *file = fopen (path, "rb");
+    if (file == NULL)
+        return -1;
+    fseek (file, 0, SEEK_END);
+    long size = ftell (file);
+    fseek (file, 0, SEEK_SET);
+    if (size < SNAPSHOT_HEADER) {
+        fclose (file);
+        return -1;
+    }
+    self->size = (size_t) size;
+    self->data = (byte *) malloc (self->size);
+    assert (self->data);
+    size_t read = fread (self->data, 1, self->size, file);
+    fclose (file);
+    return read == self->size ? 0 : -1;
+#endif
+}
+
+//  Check the header and every reference in the records, so reading them
+//  later can't go outside the file
+
+static int
+s_snapshot_validate (sph_stage_snapshot_t *self)
+{
+    if (memcmp (self->data, SNAPSHOT_MAGIC, 8) != 0
+    ||  s_get_u32 (self->data + 8) != SNAPSHOT_VERSION)
+        return -1;
+    self->strings = s_get_u32 (self->data + 12);
+    self->actors = s_get_u32 (self->data + 16);
+    self->values = s_get_u32 (self->data + 20);
+    self->edges = s_get_u32 (self->data + 24);
+    uint32_t blob_size = s_get_u32 (self->data + 28);
+
+    uint64_t size = SNAPSHOT_HEADER
+                  + (uint64_t) self->strings * 4
+                  + blob_size
+                  + (uint64_t) self->actors * SNAPSHOT_ACTOR * 4
+                  + (uint64_t) self->values * SNAPSHOT_VALUE * 4
+                  + (uint64_t) self->edges * SNAPSHOT_EDGE * 4;
+    if (size != self->size)
+        return -1;
+    self->offsets = self->data + SNAPSHOT_HEADER;
+    self->blob = (char *) self->offsets + self->strings * 4;
+    self->actor_table = (byte *) self->blob + blob_size;
+    self->value_table = self->actor_table + self->actors * SNAPSHOT_ACTOR * 4;
+    self->edge_table = self->value_table + self->values * SNAPSHOT_VALUE * 4;
+
+    //  the last string ends the blob, so every string is terminated
+    if (self->strings && (blob_size == 0 || self->blob [blob_size - 1] != 0))
+        return -1;
+    uint32_t index;
+    for (index = 0; index < self->strings; index++)
+        if (s_get_u32 (self->offsets + index * 4) >= blob_size)
+            return -1;
+    size_t field;
+    for (index = 0; index < self->actors; index++) {
+        for (field = 0; field < SNAPSHOT_FIELDS; field++)
+            if (s_field (self->actor_table, SNAPSHOT_ACTOR, index, field) >= self->strings)
+                return -1;
+        uint64_t last = (uint64_t) s_field (self->actor_table, SNAPSHOT_ACTOR, index, 6)
+                      + s_field (self->actor_table, SNAPSHOT_ACTOR, index, 7);
+        if (last > self->values)
+            return -1;
+    }
+    for (index = 0; index < self->values; index++)
+        for (field = 0; field < SNAPSHOT_VALUE; field++)
+            if (s_field (self->value_table, SNAPSHOT_VALUE, index, field) >= self->strings)
+                return -1;
+    for (index = 0; index < self->edges; index++)
+        for (field = 0; field < SNAPSHOT_EDGE; field++)
+            if (s_field (self->edge_table, SNAPSHOT_EDGE, index, field) >= self->strings)
+                return -1;
+    return 0;
+}
+
+//  --------------------------------------------------------------------------
+//  Create a new sph_stage_snapshot
+
+sph_stage_snapshot_t *
+sph_stage_snapshot_new (const char *path)
+{
+    assert (path);
+    sph_stage_snapshot_t *self = (sph_stage_snapshot_t *) zmalloc (sizeof (sph_stage_snapshot_t));
+    assert (self);
+    if (s_snapshot_map (self, path) == -1
+    ||  s_snapshot_validate (self) == -1)
+        sph_stage_snapshot_destroy (&self);
+    return self;
+}
+
+
+//  --------------------------------------------------------------------------
+//  Destroy the sph_stage_snapshot
+
+void
+sph_stage_snapshot_destroy (sph_stage_snapshot_t **self_p)
+{
+    assert (self_p);
+    if (*self_p) {
+        sph_stage_snapshot_t *self = *self_p;
+#if defined (__UNIX__)
+        if (self->mapped)
+            munmap (self->data, self->size);
+        else
+#endif
+            free (self->data);
+        free (self);
+        *self_p = NULL;
+    }
+}
+
+size_t
+sph_stage_snapshot_actors (sph_stage_snapshot_t *self)
+{
+    assert (self);
+    return self->actors;
+}
+
+zconfig_t *
+sph_stage_snapshot_actor (sph_stage_snapshot_t *self, size_t index, zconfig_t *parent)
+{
+    assert (self);
+    assert (index < self->actors);
+    zconfig_t *actor = zconfig_new ("actor", parent);
+    size_t field;
+    for (field = 0; field < SNAPSHOT_FIELDS; field++) {
+        zconfig_t *item = zconfig_new (s_actor_fields [field], actor);
+        zconfig_set_value (item, "%s", s_string (self, s_field (self->actor_table, SNAPSHOT_ACTOR, index, field)));
+    }
+    uint32_t first = s_field (self->actor_table, SNAPSHOT_ACTOR, index, 6);
+    uint32_t last = first + s_field (self->actor_table, SNAPSHOT_ACTOR, index, 7);
+    uint32_t value;
+    for (value = first; value < last; value++) {
+        zconfig_t *item = zconfig_new (s_string (self, s_field (self->value_table, SNAPSHOT_VALUE, value, 0)), actor);
+        zconfig_set_value (item, "%s", s_string (self, s_field (self->value_table, SNAPSHOT_VALUE, value, 1)));
+    }
+    return actor;
+}
+
+size_t
+sph_stage_snapshot_edges (sph_stage_snapshot_t *self)
+{
+    assert (self);
+    return self->edges;
+}
+
+const char *
+sph_stage_snapshot_edge_from (sph_stage_snapshot_t *self, size_t index)
+{
+    assert (self);
+    assert (index < self->edges);
+    return s_string (self, s_field (self->edge_table, SNAPSHOT_EDGE, index, 0));
+}
+
+const char *
+sph_stage_snapshot_edge_to (sph_stage_snapshot_t *self, size_t index)
+{
+    assert (self);
+    assert (index < self->edges);
+    return s_string (self, s_field (self->edge_table, SNAPSHOT_EDGE, index, 1));
+}
+
+const char *
+sph_stage_snapshot_edge_type (sph_stage_snapshot_t *self, size_t index)
+{
+    assert (self);
+    assert (index < self->edges);
+    return s_string (self, s_field (self->edge_table, SNAPSHOT_EDGE, index, 2));
+}
+
+zconfig_t *
+sph_stage_snapshot_zconfig (sph_stage_snapshot_t *self)
+{
+    assert (self);
+    zconfig_t *root = sphactor_zconfig_new ("root");
+    zconfig_t *actors = zconfig_new ("actors", root);
+    size_t index;
+    for (index = 0; index < self->actors; index++)
+        sph_stage_snapshot_actor (self, index, actors);
+    if (self->edges) {
+        zconfig_t *connections = zconfig_new ("connections", root);
+        for (index = 0; index < self->edges; index++) {
+            zconfig_t *item = zconfig_new ("con", connections);
+            zconfig_set_value (item, "%s,%s,%s",
+                               sph_stage_snapshot_edge_from (self, index),
+                               sph_stage_snapshot_edge_to (self, index),
+                               sph_stage_snapshot_edge_type (self, index));
+        }
+    }
+    return root;
+}
+
+//  Growing table of uint32_t while writing a snapshot
+
+typedef struct {
+    uint32_t *data;
+    size_t  size;
+    size_t  max;
+} snapshot_table_t;
+
+static void
+s_table_add (snapshot_table_t *table, uint32_t value)
+{
+    if (table->size == table->max) {
+        table->max = table->max ? table->max * 2 : 64;
+        table->data = (uint32_t *) realloc (table->data, table->max * sizeof (uint32_t));
+        assert (table->data);
+    }
+    table->data [table->size++] = value;
+}
+
+static void
+s_put_u32 (FILE *file, uint32_t value)
+{
+    byte data [4] = {
+        (byte) value, (byte) (value >> 8), (byte) (value >> 16), (byte) (value >> 24)
+    };
+    fwrite (data, 1, sizeof (data), file);
+}
+
+static void
+s_put_table (FILE *file, snapshot_table_t *table)
+{
+    size_t index;
+    for (index = 0; index < table->size; index++)
+        s_put_u32 (file, table->data [index]);
+}
+
+//  Strings of a snapshot being written, each stored once
+
+typedef struct {
+    zhash_t *index;             //  Index + 1 of each string
+    snapshot_table_t offsets;   //  Offsets in the blob
+    zlist_t *strings;           //  Strings in order of their index
+    uint32_t blob_size;         //  Size of the blob so far
+} snapshot_strings_t;
+
+static uint32_t
+s_intern (snapshot_strings_t *strings, const char *string)
+{
+    if (string == NULL)
+        string = "";
+    size_t id = (size_t) zhash_lookup (strings->index, string);
+    if (id)
+        return (uint32_t) (id - 1);
+    id = strings->offsets.size;
+    zhash_insert (strings->index, string, (void *) (id + 1));
+    s_table_add (&strings->offsets, strings->blob_size);
+    zlist_append (strings->strings, (void *) string);
+    strings->blob_size += (uint32_t) strlen (string) + 1;
+    return (uint32_t) id;
+}
+
+static bool
+s_actor_field (const char *name)
+{
+    size_t field;
+    for (field = 0; field < SNAPSHOT_FIELDS; field++)
+        if (streq (s_actor_fields [field], name))
+            return true;
+    return false;
+}
+
+int
+sph_stage_snapshot_save (zconfig_t *config, const char *path)
+{
+    assert (config);
+    assert (path);
+    snapshot_strings_t strings = { zhash_new (), { NULL, 0, 0 }, zlist_new (), 0 };
+    snapshot_table_t actors = { NULL, 0, 0 };
+    snapshot_table_t values = { NULL, 0, 0 };
+    snapshot_table_t edges = { NULL, 0, 0 };
+    //  connection strings are split in place, so keep them until written
+    zlist_t *splits = zlist_new ();
+    zlist_autofree (splits);
+    int rc = 0;
+
+    zconfig_t *actor = zconfig_locate (config, "actors/actor");
+    while (actor) {
+        size_t field;
+        for (field = 0; field < SNAPSHOT_FIELDS; field++)
+            s_table_add (&actors, s_intern (&strings, zconfig_get (actor, s_actor_fields [field], "")));
+        s_table_add (&actors, (uint32_t) (values.size / SNAPSHOT_VALUE));
+        uint32_t count = 0;
+        zconfig_t *item;
+        for (item = zconfig_child (actor); item; item = zconfig_next (item)) {
+            if (s_actor_field (zconfig_name (item)))
+                continue;
+            s_table_add (&values, s_intern (&strings, zconfig_name (item)));
+            s_table_add (&values, s_intern (&strings, zconfig_value (item)));
+            count++;
+        }
+        s_table_add (&actors, count);
+        actor = zconfig_next (actor);
+    }
+    zconfig_t *con = zconfig_locate (config, "connections/con");
+    while (con && rc == 0) {
+        //  from,to,type
+        char *from = strdup (zconfig_value (con));
+        zlist_append (splits, from);
+        char *to = strchr (from, ',');
+        char *type = to ? strchr (to + 1, ',') : NULL;
+        if (type == NULL) {
+            zsys_error ("sph_stage_snapshot: invalid connection %s", zconfig_value (con));
+            rc = -1;
+            break;
+        }
+        *to++ = 0;
+        *type++ = 0;
+        s_table_add (&edges, s_intern (&strings, from));
+        s_table_add (&edges, s_intern (&strings, to));
+        s_table_add (&edges, s_intern (&strings, type));
+        con = zconfig_next (con);
+    }
+
+    FILE *file = rc == 0 ? fopen (path, "wb") : NULL;
+    if (file) {
+        uint32_t blob_size = (strings.blob_size + 3) & ~3U;
+        fwrite (SNAPSHOT_MAGIC, 1, 8, file);
+        s_put_u32 (file, SNAPSHOT_VERSION);
+        s_put_u32 (file, (uint32_t) strings.offsets.size);
+        s_put_u32 (file, (uint32_t) (actors.size / SNAPSHOT_ACTOR));
+        s_put_u32 (file, (uint32_t) (values.size / SNAPSHOT_VALUE));
+        s_put_u32 (file, (uint32_t) (edges.size / SNAPSHOT_EDGE));
+        s_put_u32 (file, blob_size);
+        s_put_table (file, &strings.offsets);
+        const char *string = (const char *) zlist_first (strings.strings);
+        while (string) {
+            fwrite (string, 1, strlen (string) + 1, file);
+            string = (const char *) zlist_next (strings.strings);
+        }
+        const byte padding [3] = { 0, 0, 0 };
+        fwrite (padding, 1, blob_size - strings.blob_size, file);
+        s_put_table (file, &actors);
+        s_put_table (file, &values);
+        s_put_table (file, &edges);
+        rc = fflush (file) == 0 && !ferror (file) ? 0 : -1;
+#if defined (__UNIX__)
+        if (rc == 0)
+            rc = fsync (fileno (file));
+#endif
+        fclose (file);
+    }
+    else
+    if (rc == 0)
+        rc = -1;
+    if (rc == -1)
+        zsys_error ("sph_stage_snapshot: error writing %s", path);
+
+    zlist_destroy (&splits);
+    zlist_destroy (&strings.strings);
+    zhash_destroy (&strings.index);
+    free (strings.offsets.data);
+    free (actors.data);
+    free (values.data);
+    free (edges.data);
+    return rc;
+}
+
+//  --------------------------------------------------------------------------
+//  Self test of this class
+
+// If your selftest reads SCMed fixture data, please keep it in
+// src/selftest-ro; if your test creates filesystem objects, please
+// do so under src/selftest-rw.
+// The following pattern is suggested for C selftest code:
+//    char *filename = NULL;
+//    filename = zsys_sprintf ("%s/%s", SELFTEST_DIR_RO, "mytemplate.file");
+//    assert (filename);
+//    ... use the "filename" for I/O ...
+//    zstr_free (&filename);
+// This way the same "filename" variable can be reused for many subtests.
+#define SELFTEST_DIR_RO "src/selftest-ro"
+#define SELFTEST_DIR_RW "src/selftest-rw"
+
+void
+sph_stage_snapshot_test (bool verbose)
+{
+    printf (" * sph_stage_snapshot: ");
+
+    //  @selftest
+    char *cnfstr =
+    "actors\n"
+    "    actor\n"
+    "        uuid = \"7B21D87CB6B04FC5801A5B396269876D\"\n"
+    "        type = \"Log\"\n"
+    "        name = \"8FADA7\"\n"
+    "        endpoint = \"inproc://7B21D87CB6B04FC5801A5B396269876D\"\n"
+    "        xpos = \"502.500000\"\n"
+    "        ypos = \"312.000000\"\n"
+    "    actor\n"
+    "        uuid = \"2A7110DFC47C4DF19EB1D17E390CF86B\"\n"
+    "        type = \"Pulse\"\n"
+    "        name = \"2A7110\"\n"
+    "        endpoint = \"inproc://2A7110DFC47C4DF19EB1D17E390CF86B\"\n"
+    "        xpos = \"34.500000\"\n"
+    "        ypos = \"312.000000\"\n"
+    "        timeout = \"500\"\n"
+    "connections\n"
+    "    con = \"inproc://2A7110DFC47C4DF19EB1D17E390CF86B,inproc://7B21D87CB6B04FC5801A5B396269876D,OSC\"\n";
+    zconfig_t *root = zconfig_str_load (cnfstr);
+    assert (root);
+    char *filename = zsys_sprintf ("%s/%s", SELFTEST_DIR_RW, "test_snapshot.bin");
+    assert (filename);
+    int rc = sph_stage_snapshot_save (root, filename);
+    assert (rc == 0);
+
+    sph_stage_snapshot_t *self = sph_stage_snapshot_new (filename);
+    assert (self);
+    assert (sph_stage_snapshot_actors (self) == 2);
+    assert (sph_stage_snapshot_edges (self) == 1);
+    assert (streq (sph_stage_snapshot_edge_from (self, 0), "inproc://2A7110DFC47C4DF19EB1D17E390CF86B"));
+    assert (streq (sph_stage_snapshot_edge_to (self, 0), "inproc://7B21D87CB6B04FC5801A5B396269876D"));
+    assert (streq (sph_stage_snapshot_edge_type (self, 0), "OSC"));
+    zconfig_t *actor = sph_stage_snapshot_actor (self, 1, NULL);
+    assert (streq (zconfig_get (actor, "type", ""), "Pulse"));
+    assert (streq (zconfig_get (actor, "ypos", ""), "312.000000"));
+    //  values follow the position, as sphactor_load expects
+    zconfig_t *value = zconfig_next (zconfig_locate (actor, "ypos"));
+    assert (value);
+    assert (streq (zconfig_name (value), "timeout"));
+    assert (streq (zconfig_value (value), "500"));
+    zconfig_destroy (&actor);
+
+    //  converting back gives the same stage
+    zconfig_t *copy = sph_stage_snapshot_zconfig (self);
+    assert (copy);
+    char *text = zconfig_str_save (root);
+    char *copy_text = zconfig_str_save (copy);
+    assert (streq (text, copy_text));
+    zstr_free (&text);
+    zstr_free (&copy_text);
+    zconfig_destroy (&copy);
+    sph_stage_snapshot_destroy (&self);
+
+    //  text files and missing files are no snapshots
+    rc = zconfig_save (root, filename);
+    assert (rc == 0);
+    self = sph_stage_snapshot_new (filename);
+    assert (self == NULL);
+    zsys_file_delete (filename);
+    self = sph_stage_snapshot_new (filename);
+    assert (self == NULL);
+    zstr_free (&filename);
+    zconfig_destroy (&root);
+    //  @end
+    printf ("OK\n");
+}
@@ -0,0 +1,81 @@
+/*  =========================================================================
+    sph_stage_snapshot - class description
+
+    Copyright (c) the Contributors as noted in the AUTHORS file.
+
+    This file is part of Sphactor, an open-source framework for high level
+    actor model concurrency --- http://sphactor.org
+
+    This Source Code Form is subject to the terms of the Mozilla Public
+    License, v. 2.0. If a copy of the MPL was not distributed with this
+    file, You can obtain one at http://mozilla.org/MPL/2.0/.
+    =========================================================================
+*/
+
+#ifndef SPH_STAGE_SNAPSHOT_H_INCLUDED
+#define SPH_STAGE_SNAPSHOT_H_INCLUDED
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//  @warning THE FOLLOWING @INTERFACE BLOCK IS AUTO-GENERATED BY ZPROJECT
+//  @warning Please edit the model at "api/sph_stage_snapshot.api" to make changes.
+//  @interface
+//  This is a stable class, and may not change except for emergencies. It
+//  is provided in stable builds.
+//  Map a stage snapshot. Returns NULL if the file can't be read or
+//  isn't a valid snapshot.
+SPHACTOR_PRIVATE sph_stage_snapshot_t *
+    sph_stage_snapshot_new (const char *path);
+
+//  Unmap the stage snapshot.
+SPHACTOR_PRIVATE void
+    sph_stage_snapshot_destroy (sph_stage_snapshot_t **self_p);
+
+//  Return the number of actors
+SPHACTOR_PRIVATE size_t
+    sph_stage_snapshot_actors (sph_stage_snapshot_t *self);
+
+//  Add the config of an actor to parent, as sphactor_load expects it,
+//  and return it.
+SPHACTOR_PRIVATE zconfig_t *
+    sph_stage_snapshot_actor (sph_stage_snapshot_t *self, size_t index, zconfig_t *parent);
+
+//  Return the number of connections
+SPHACTOR_PRIVATE size_t
+    sph_stage_snapshot_edges (sph_stage_snapshot_t *self);
+
+//  Return the endpoint of the actor which connects
+SPHACTOR_PRIVATE const char *
+    sph_stage_snapshot_edge_from (sph_stage_snapshot_t *self, size_t index);
+
+//  Return the endpoint the actor connects to
+SPHACTOR_PRIVATE const char *
+    sph_stage_snapshot_edge_to (sph_stage_snapshot_t *self, size_t index);
+
+//  Return the type of the connection
+SPHACTOR_PRIVATE const char *
+    sph_stage_snapshot_edge_type (sph_stage_snapshot_t *self, size_t index);
+
+//  Return the stage as a config, in the shape of the text format
+//  Caller owns return value and must destroy it when done.
+SPHACTOR_PRIVATE zconfig_t *
+    sph_stage_snapshot_zconfig (sph_stage_snapshot_t *self);
+
+//  Write a stage config to a snapshot file. Returns 0 on success, -1
+//  on failure.
+SPHACTOR_PRIVATE int
+    sph_stage_snapshot_save (zconfig_t *config, const char *path);
+
+//  Self test of this class.
+SPHACTOR_PRIVATE void
+    sph_stage_snapshot_test (bool verbose);
+
+//  @end
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -29,11 +29,11 @@ const char * logCapabilities = "inputs\n"
 zmsg_t *
 sph_stock_log_actor( sphactor_event_t *ev, void* args )
 {
-    if ( streq(ev->type, "INIT")) {
+    switch ( ev->kind ) {
+    case SPHACTOR_EVENT_INIT:
         sphactor_actor_set_capability((sphactor_actor_t*)ev->actor, zconfig_str_load(logCapabilities));
-    }
-    else
-    if ( streq(ev->type, "SOCK")) {
+        break;
+    case SPHACTOR_EVENT_SOCK: {
         if ( ev->msg == NULL ) return NULL;
 
         zframe_t* frame = NULL;
@@ -60,6 +60,9 @@ sph_stock_log_actor( sphactor_event_t *ev, void* args )
 
         return NULL;
     }
+    default:
+        break;
+    }
 
     return ev->msg;
 }
@@ -76,11 +79,11 @@ zmsg_t *
 sph_stock_count_actor( sphactor_event_t *ev, void* args )
 {
     static int sph_stock_count_actor_count = 0;
-    if ( streq(ev->type, "INIT")) {
+    switch ( ev->kind ) {
+    case SPHACTOR_EVENT_INIT:
         sphactor_actor_set_capability((sphactor_actor_t*)ev->actor, zconfig_str_load(countCapabilities));
-    }
-    else
-    if ( streq(ev->type, "SOCK")) {
+        break;
+    case SPHACTOR_EVENT_SOCK: {
         sph_stock_count_actor_count++; // increment counter
 
         // set custom report
@@ -88,6 +91,10 @@ sph_stock_count_actor( sphactor_event_t *ev, void* args )
                                    "counter", (int32_t)sph_stock_count_actor_count);
 
         sphactor_actor_set_custom_report_data( (sphactor_actor_t*)ev->actor, msg );
+        break;
+    }
+    default:
+        break;
     }
     return ev->msg;
 }
@@ -112,12 +119,11 @@ zmsg_t *
 sph_stock_pulse_actor( sphactor_event_t *ev, void* args )
 {
     static int sph_stock_count_actor_count = 0;
-    if ( streq(ev->type, "INIT")) {
+    switch ( ev->kind ) {
+    case SPHACTOR_EVENT_INIT:
         sphactor_actor_set_capability((sphactor_actor_t*)ev->actor, zconfig_str_load(pulseCapabilities));
-    }
-    else
-    if ( streq(ev->type, "TIME")) {
-
+        break;
+    case SPHACTOR_EVENT_TIME: {
         zosc_t * osc = zosc_create("/pulse", "s", "PULSE");
 
         zmsg_t *msg = zmsg_new();
@@ -132,6 +138,9 @@ sph_stock_pulse_actor( sphactor_event_t *ev, void* args )
         // publish new msg
         return msg;
     }
+    default:
+        break;
+    }
     zmsg_destroy(&ev->msg);
     return NULL;
 }
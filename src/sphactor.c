@@ -29,17 +29,26 @@
 
 struct _sphactor_t {
     zactor_t *actor;            //  A Sphactor instance wraps a zactor
+    void    *pipe;              //  Pipe to our actor, the zactor or our end of
+                                //  the pipe if the actor runs in a sphactor_pool,
+                                //  a sphactor_tick or is fused to another actor
     char    *name;              //  Copy of our actor's name
     zuuid_t *uuid;              //  Copy of our actor's uuid
     char    *endpoint;          //  Copy of our actor's endpoint
     char    *type;              //  Copy of our actor's type name
     zlist_t *subscriptions;     //  Copy of our actor's (incoming) connections
+    zlist_t *pending;           //  Futures of the requests in flight on our pipe
     zconfig_t *capability;      //  Capability of this actor
     zhash_t *values_cache;      //  Cached values from the capabilities
+    zmsg_t  *batch;             //  API calls to send at once, if batching
+    uint64_t revision;          //  Changes whenever our saved state changes
+    bool    terminating;        //  $TERM was sent, waiting for the actor to exit
     float   posx;               //  XY position is used when visualising actors
     float   posy;
     sphactor_report_t *latest_report;   //  The latest report acquired from the actor
     sphactor_actor_t  *_sph_act;        //  pointer to the actor in the thread, internal use only!
+    void    (*rename_fn) (sphactor_t *self, void *args);    //  Called when our name changes
+    void    *rename_args;               //  Arguments of rename_fn
 };
 
 //  Hash table for the actor_type register of actors
@@ -47,13 +56,20 @@ static zhash_t *actors_reg = NULL;
 static zlist_t *actors_keys = NULL;
 
 //  (forward declare)
-void sphactor_actor_run(zsock_t *pipe, void *args);
+static sphactor_future_t *
+    s_future_new (sphactor_t *self, zmsg_t *request, sphactor_future_fn *handler);
+static void
+    s_pending_wait (sphactor_t *self);
+static void
+    s_batch_begin (sphactor_t *self);
+static int
+    s_batch_end (sphactor_t *self);
 
 //  --------------------------------------------------------------------------
 //  Create a new sphactor. Pass a name and uuid. If your specify NULL
 //  a uuid will be generated and the first 6 chars will be used as a name
-sphactor_t *
-sphactor_new (sphactor_handler_fn handler, void *args, const char *name, zuuid_t *uuid)
+static sphactor_t *
+s_new (sphactor_handler_fn handler, void *args, const char *name, zuuid_t *uuid, sphactor_t *upstream)
 {
     sphactor_t *self = (sphactor_t *) zmalloc (sizeof (sphactor_t));
     assert (self);
@@ -62,7 +78,59 @@ sphactor_new (sphactor_handler_fn handler, void *args, const char *name, zuuid_t
         self->uuid = zuuid_dup(uuid);
 
     sphactor_shim_t shim = { handler, args, uuid, name };
-    self->actor = zactor_new( sphactor_actor_run, &shim);
+    sphactor_tick_t *tick = sphactor_tick_default ();
+    sphactor_pool_t *pool = sphactor_pool_default ();
+    if (upstream)
+    {
+        //  Create and start the actor in our thread like the zactor does in
+        //  its thread, from then on the thread of upstream runs the actor.
+        zsock_t *backend = NULL;
+        zsock_t *frontend = zsys_create_pipe (&backend);
+        assert (frontend);
+        sphactor_actor_t *actor = sphactor_actor_new (backend, &shim);
+        assert (actor);
+        sphactor_actor_set_pooled (actor, true);
+        sphactor_actor_start (actor);
+        zsock_wait (frontend);
+        zmsg_t *request = sphactor_command_new (SPHACTOR_COMMAND_FUSE);
+        zmsg_addmem (request, &actor, sizeof (void *));
+        sphactor_future_t *future = s_future_new (upstream, request, NULL);
+        int rc = sphactor_future_wait (future, -1);
+        zmsg_t *reply = rc == 0 ? sphactor_future_reply (future) : NULL;
+        if (reply == NULL || !zframe_streq (zmsg_last (reply), "0"))
+            rc = -1;
+        sphactor_future_destroy (&future);
+        if (rc == -1)
+        {
+            //  upstream won't run it, e.g. because a sphactor_tick does
+            sphactor_actor_stop (actor);
+            sphactor_actor_destroy (&actor);
+            zsock_destroy (&backend);
+            zsock_destroy (&frontend);
+            zuuid_destroy (&self->uuid);
+            free (self);
+            return NULL;
+        }
+        self->actor = NULL;
+        self->pipe = frontend;
+    }
+    else
+    if (tick)
+    {
+        self->actor = NULL;
+        self->pipe = sphactor_tick_spawn (tick, &shim);
+    }
+    else
+    if (pool)
+    {
+        self->actor = NULL;
+        self->pipe = sphactor_pool_spawn (pool, &shim);
+    }
+    else
+    {
+        self->actor = zactor_new( sphactor_actor_run, &shim);
+        self->pipe = self->actor;
+    }
     self->latest_report = NULL;
     self->_sph_act = NULL;
     if (name)
@@ -73,6 +141,7 @@ sphactor_new (sphactor_handler_fn handler, void *args, const char *name, zuuid_t
     self->type = NULL;
     self->endpoint = NULL;
     self->subscriptions = zlist_new();
+    self->pending = zlist_new();
     self->capability = NULL;
     self->values_cache = zhash_new();
     zhash_autofree(self->values_cache); // we're using strings for now
@@ -83,6 +152,19 @@ sphactor_new (sphactor_handler_fn handler, void *args, const char *name, zuuid_t
     return self;
 }
 
+sphactor_t *
+sphactor_new (sphactor_handler_fn handler, void *args, const char *name, zuuid_t *uuid)
+{
+    return s_new (handler, args, name, uuid, NULL);
+}
+
+sphactor_t *
+sphactor_new_fused (sphactor_handler_fn handler, void *args, const char *name, zuuid_t *uuid, sphactor_t *upstream)
+{
+    assert (upstream);
+    return s_new (handler, args, name, uuid, upstream);
+}
+
 sphactor_t *
 sphactor_new_proc(const char *type, const char *name, zuuid_t *uuid)
 {
@@ -131,8 +213,18 @@ sphactor_new_proc(const char *type, const char *name, zuuid_t *uuid)
     return NULL;
 }
 
-sphactor_t *
-sphactor_new_by_type (const char *actor_type, const char *name, zuuid_t *uuid)
+//  A registered actor type looked up and constructed, ready to create the
+//  actor. Only this part touches the register and runs the constructor.
+
+typedef struct {
+    char    *type;                      //  The actor type
+    sphactor_handler_fn *handler;       //  Handler of the type
+    void    *instance;                  //  What its constructor returned
+    zconfig_t *capability;              //  Copy of its capability, if any
+} sphactor_prepared_t;
+
+static sphactor_prepared_t *
+s_prepare (const char *actor_type)
 {
     assert(actors_reg); // make sure something has ever been registered
     sphactor_funcs_t *funcs = (sphactor_funcs_t *)zhash_lookup( actors_reg, actor_type);
@@ -141,23 +233,83 @@ sphactor_new_by_type (const char *actor_type, const char *name, zuuid_t *uuid)
         zsys_error("%s type does not exist as a registered actor type", actor_type);
         return NULL;
     }
+    sphactor_prepared_t *prepared = (sphactor_prepared_t *) zmalloc (sizeof (sphactor_prepared_t));
+    assert( prepared );
+    prepared->type = strdup(actor_type);
+    prepared->handler = funcs->handler;
     // run constructor if any
-    void *instance = NULL;
     if ( funcs->constructor )
-        instance = funcs->constructor(funcs->constructor_args);
-    sphactor_t *self = sphactor_new( funcs->handler, instance, name, uuid);
+        prepared->instance = funcs->constructor(funcs->constructor_args);
+    if ( funcs->capability )
+        prepared->capability = zconfig_dup(funcs->capability);
+    return prepared;
+}
+
+//  Create the actor of a prepared type, its capability's API calls are
+//  left in an open batch. Touches nothing shared so any thread can do it.
+
+static sphactor_t *
+s_new_prepared (sphactor_prepared_t **prepared_p, const char *name, zuuid_t *uuid)
+{
+    sphactor_prepared_t *prepared = *prepared_p;
+    *prepared_p = NULL;
+    sphactor_t *self = sphactor_new( prepared->handler, prepared->instance, name, uuid);
     assert( self );
-    if (funcs->capability)
-    {
-        zconfig_t *capability = zconfig_dup(funcs->capability);
-        sphactor_set_capability(self, capability);
-    }
-    sphactor_ask_set_actor_type(self, actor_type);
+    sphactor_ask_set_actor_type(self, prepared->type);
+    s_batch_begin(self);
+    if (prepared->capability)
+        sphactor_set_capability(self, prepared->capability);
+    zstr_free(&prepared->type);
+    free(prepared);
+    return self;
+}
+
+//  Create an actor of a registered type, its capability's API calls are
+//  left in an open batch
+
+static sphactor_t *
+s_new_by_type (const char *actor_type, const char *name, zuuid_t *uuid)
+{
+    sphactor_prepared_t *prepared = s_prepare(actor_type);
+    if ( prepared == NULL )
+        return NULL;
+    return s_new_prepared(&prepared, name, uuid);
+}
+
+sphactor_t *
+sphactor_new_by_type (const char *actor_type, const char *name, zuuid_t *uuid)
+{
+    sphactor_t *self = s_new_by_type(actor_type, name, uuid);
+    if ( self )
+        s_batch_end(self);
     return self;
 }
 
 sphactor_t *
 sphactor_load(const zconfig_t *config)
+{
+    return sphactor_load_prepared(config, sphactor_load_prepare(config));
+}
+
+//  Look up the type of an actor config and run its constructor, the part
+//  of sphactor_load which has to run on the thread calling sphactor_load:
+//  the register isn't thread safe and constructors needn't be either.
+//  Returns what sphactor_load_prepared takes, NULL if the type isn't
+//  registered. Used by sph_stage to start actors from several threads.
+
+void *
+sphactor_load_prepare(const zconfig_t *config)
+{
+    assert( config );
+    zconfig_t* type = zconfig_locate((zconfig_t *)config, "type");
+    return s_prepare(zconfig_value(type));
+}
+
+//  Create the actor of a config prepared by sphactor_load_prepare, from
+//  any thread
+
+sphactor_t *
+sphactor_load_prepared(const zconfig_t *config, void *prepared)
 {
     assert( config );
     zconfig_t* uuid = zconfig_locate((zconfig_t *)config, "uuid");
@@ -174,15 +326,16 @@ sphactor_load(const zconfig_t *config)
     char *xposStr = zconfig_value(xpos);
     char *yposStr = zconfig_value(ypos);
 
-    zuuid_t *uid = zuuid_new();
-    zuuid_set_str(uid, uuidStr);
-    // create actor
-    sphactor_t* new_actor = sphactor_new_by_type(typeStr, nameStr, uid);
-    if ( new_actor == NULL)
+    if ( prepared == NULL )
     {
         zsys_error("Failed to create actor type %s", typeStr);
         return NULL;
     }
+    zuuid_t *uid = zuuid_new();
+    zuuid_set_str(uid, uuidStr);
+    // create actor, its API calls are sent in one batch
+    sphactor_prepared_t *item = (sphactor_prepared_t *) prepared;
+    sphactor_t* new_actor = s_new_prepared(&item, nameStr, uid);
 
     // set position
     sphactor_set_position( new_actor, atof(xposStr), atof(yposStr) );
@@ -191,44 +344,12 @@ sphactor_load(const zconfig_t *config)
     //  We're assuming the ypos is the last thing added by the sphactor serialization
     //  from there we ready until we receive null and send that to the high-level actor
     //sph_deserialise_actor_data(new_actor, config);
-    zconfig_t *capability = sphactor_capability(new_actor);
-    if ( capability )
+    if ( sphactor_capability(new_actor) )
     {
         zconfig_t *cnf = zconfig_next(ypos);
         while ( cnf != NULL )
         {
-            char *cnfStr = zconfig_value(cnf);
-            char *cnfNme = zconfig_name(cnf);
-
-            zconfig_t *root = zconfig_locate(capability, "capabilities");
-            //  here we have to lookup cnfNme in the capabilities to see if it matches
-            //  in order to find the api_call key of the capability with its optional format
-            if ( root ) {
-                zconfig_t *data = zconfig_locate(root, "data");
-                while ( data ) {
-                    zconfig_t *name = zconfig_locate(data, "name");
-                    zconfig_t *type = zconfig_locate(data, "type");
-                    if (name && streq(zconfig_value(name), cnfNme) && !streq(zconfig_value(type), "trigger") )
-                    {
-                        // TODO: here's the value is set in the capability, this is not safe!!!
-                        zconfig_t *value = zconfig_locate(data, "value");
-                        if ( value )
-                        {
-                            zconfig_set_value(value, "%s", cnfStr);
-                        }
-                        zconfig_t *zapic = zconfig_locate(data, "api_call");
-                        if (zapic)
-                        {
-                            zconfig_t *zapiv = zconfig_locate(data, "api_value");
-                            if (zapiv)
-                                sphactor_ask_api(new_actor, zconfig_value(zapic), zconfig_value(zapiv), cnfStr);
-                            else
-                                sphactor_ask_api(new_actor, zconfig_value(zapic), "", cnfStr);
-                        }
-                    }
-                    data = zconfig_next(data);
-                }
-            }
+            sphactor_set_value(new_actor, zconfig_name(cnf), zconfig_value(cnf));
             cnf = zconfig_next(cnf);
         }
     }
@@ -236,6 +357,7 @@ sphactor_load(const zconfig_t *config)
     {
         zsys_warning("No capability for this actor, thus no automatic API calls!");
     }
+    s_batch_end(new_actor);
 
     //free(uuidStr);
     //free(typeStr);
@@ -254,7 +376,22 @@ sphactor_destroy (sphactor_t **self_p)
     if (*self_p) {
         sphactor_t *self = *self_p;
         //  Free class properties here
-        zactor_destroy (&self->actor);
+        s_pending_wait (self);
+        //  if we were told to terminate already zactor_destroy sends a
+        //  second $TERM which the actor never reads, the signal it sent
+        //  on exit is still ours to wait for
+        if (self->actor)
+            zactor_destroy (&self->actor);
+        else
+        {
+            //  our actor runs in a pool, same protocol as zactor_destroy
+            zsock_t *pipe = (zsock_t *) self->pipe;
+            zsock_set_sndtimeo (pipe, 0);
+            if (self->terminating || zstr_send (pipe, "$TERM") == 0)
+                zsock_wait (pipe);
+            zsock_destroy (&pipe);
+        }
+        self->pipe = NULL;
         zstr_free( &self->name);
         if (self->uuid) zuuid_destroy(&self->uuid);
         zstr_free(&self->endpoint);
@@ -263,11 +400,13 @@ sphactor_destroy (sphactor_t **self_p)
         if (self->capability)
             zconfig_destroy(&self->capability);
         zhash_destroy(&self->values_cache);
+        zmsg_destroy(&self->batch);
         // free the report cache
         if ( self->latest_report ) sphactor_report_destroy(&self->latest_report);
         self->latest_report = NULL;
         self->_sph_act = NULL;   //  we don't own the pointer!!
         zlist_destroy(&self->subscriptions);  // the list uses autofree!
+        zlist_destroy(&self->pending);
         //  Free object itself
         free (self);
         *self_p = NULL;
@@ -293,6 +432,7 @@ sphactor_set_capability(sphactor_t *self, zconfig_t *capability)
         return -1;
     }
     self->capability = capability;
+    self->revision++;
     zconfig_t *capitem = zconfig_locate(self->capability, "capabilities/data");
     int rc = -1;
     while (capitem != NULL)
@@ -325,13 +465,11 @@ sphactor_ask_uuid (sphactor_t *self)
     assert(self);
     if (self->uuid == NULL )
     {
-        // I'm not sure if this is safe if there's already a queue
-        // on the actor's pipe???
-        zstr_send(self->actor, "UUID");
-        //self->uuid = zuuid_new(); // or just malloc it?
-        int rc = zsock_recv( self->actor, "U", &self->uuid );
+        sphactor_future_t *future = sphactor_ask_uuid_async(self);
+        int rc = sphactor_future_wait(future, -1);
         assert ( rc==0 );
         assert ( self->uuid );
+        sphactor_future_destroy(&future);
     }
     return self->uuid;
 }
@@ -342,8 +480,9 @@ sphactor_ask_name (sphactor_t *self)
     assert(self);
     if ( self->name == NULL )
     {
-        zstr_send(self->actor, "NAME");
-        self->name = zstr_recv( self->actor );
+        sphactor_future_t *future = sphactor_ask_name_async(self);
+        sphactor_future_wait(future, -1);
+        sphactor_future_destroy(&future);
     }
     return self->name;
 }
@@ -354,8 +493,9 @@ sphactor_ask_actor_type (sphactor_t *self)
     assert(self);
     if ( self->type == NULL )
     {
-        zstr_send(self->actor, "TYPE");
-        self->type = zstr_recv( self->actor );
+        s_pending_wait(self);
+        zstr_send(self->pipe, "TYPE");
+        self->type = zstr_recv( self->pipe );
     }
     return self->type;
 }
@@ -366,19 +506,181 @@ sphactor_ask_endpoint (sphactor_t *self)
     assert(self);
     if ( self->endpoint == NULL )
     {
-        zstr_send(self->actor, "ENDPOINT");
-        self->endpoint = zstr_recv( self->actor );
+        sphactor_future_t *future = sphactor_ask_endpoint_async(self);
+        sphactor_future_wait(future, -1);
+        sphactor_future_destroy(&future);
     }
     return self->endpoint;
 }
 
+//  Wait for the replies still in flight on our pipe, before a blocking call
+//  reads from it
+
+static void
+s_pending_wait (sphactor_t *self)
+{
+    sphactor_future_t *last = (sphactor_future_t *) zlist_tail(self->pending);
+    if (last)
+        sphactor_future_wait(last, -1);
+}
+
+//  Fill our caches from replies
+
+static void
+s_future_uuid (sphactor_future_t *future, zmsg_t *reply, void *args)
+{
+    sphactor_t *self = (sphactor_t *) args;
+    zframe_t *frame = zmsg_first(reply);
+    if ( self->uuid == NULL && frame && zframe_size(frame) == ZUUID_LEN )
+        self->uuid = zuuid_new_from(zframe_data(frame));
+}
+
+static void
+s_future_name (sphactor_future_t *future, zmsg_t *reply, void *args)
+{
+    sphactor_t *self = (sphactor_t *) args;
+    if ( self->name == NULL && zmsg_first(reply) )
+        self->name = zframe_strdup(zmsg_first(reply));
+}
+
+static void
+s_future_endpoint (sphactor_future_t *future, zmsg_t *reply, void *args)
+{
+    sphactor_t *self = (sphactor_t *) args;
+    if ( self->endpoint == NULL && zmsg_first(reply) )
+        self->endpoint = zframe_strdup(zmsg_first(reply));
+}
+
+static void
+s_future_connect (sphactor_future_t *future, zmsg_t *reply, void *args)
+{
+    sphactor_t *self = (sphactor_t *) args;
+    zframe_t *cmd = zmsg_first(reply);
+    zframe_t *dest = zmsg_next(reply);
+    zframe_t *rc = zmsg_next(reply);
+    assert( cmd && zframe_streq(cmd, "CONNECTED") );
+    if ( dest == NULL || rc == NULL || !zframe_streq(rc, "0") )
+        return;
+    // save our connection
+    char *endpoint = zframe_strdup(dest);
+    if ( zlist_exists(self->subscriptions, endpoint) )
+        zsys_warning("Connection %s already exists", endpoint);
+    else
+        zlist_append(self->subscriptions, endpoint); // list uses auto free so endpoint will be duped
+    zstr_free(&endpoint);
+    self->revision++;
+}
+
+//  Send a request on our pipe and return the future of its reply
+
+static sphactor_future_t *
+s_future_new (sphactor_t *self, zmsg_t *request, sphactor_future_fn *handler)
+{
+    sphactor_future_t *future = sphactor_future_new((zsock_t *) self->pipe, self->pending, &request);
+    if (handler)
+        sphactor_future_set_handler(future, handler, self);
+    return future;
+}
+
+//  Return a future which is ready with a cached string
+
+static sphactor_future_t *
+s_future_cached (const char *value)
+{
+    zmsg_t *reply = zmsg_new();
+    zmsg_addstr(reply, value);
+    return sphactor_future_new_ready(&reply);
+}
+
+sphactor_future_t *
+sphactor_ask_uuid_async (sphactor_t *self)
+{
+    assert(self);
+    if ( self->uuid )
+    {
+        zmsg_t *reply = zmsg_new();
+        zmsg_addmem(reply, zuuid_data(self->uuid), zuuid_size(self->uuid));
+        return sphactor_future_new_ready(&reply);
+    }
+    return s_future_new(self, sphactor_command_new(SPHACTOR_COMMAND_UUID), s_future_uuid);
+}
+
+sphactor_future_t *
+sphactor_ask_name_async (sphactor_t *self)
+{
+    assert(self);
+    if ( self->name )
+        return s_future_cached(self->name);
+    return s_future_new(self, sphactor_command_new(SPHACTOR_COMMAND_NAME), s_future_name);
+}
+
+sphactor_future_t *
+sphactor_ask_endpoint_async (sphactor_t *self)
+{
+    assert(self);
+    if ( self->endpoint )
+        return s_future_cached(self->endpoint);
+    return s_future_new(self, sphactor_command_new(SPHACTOR_COMMAND_ENDPOINT), s_future_endpoint);
+}
+
+sphactor_future_t *
+sphactor_ask_timeout_async (sphactor_t *self)
+{
+    assert(self);
+    return s_future_new(self, sphactor_command_new(SPHACTOR_COMMAND_TIMEOUT), NULL);
+}
+
+sphactor_future_t *
+sphactor_ask_connect_async (sphactor_t *self, const char *endpoint)
+{
+    assert(self);
+    assert(endpoint);
+    zmsg_t *request = sphactor_command_new(SPHACTOR_COMMAND_CONNECT);
+    zmsg_addstr(request, endpoint);
+    return s_future_new(self, request, s_future_connect);
+}
+
+sphactor_future_t *
+sphactor_ask_drain_async (sphactor_t *self, int64_t timeout)
+{
+    assert(self);
+    zmsg_t *request = sphactor_command_new(SPHACTOR_COMMAND_DRAIN);
+    sphactor_command_add_int(request, timeout);
+    return s_future_new(self, request, NULL);
+}
+
+sphactor_future_t *
+sphactor_ask_filters_async (sphactor_t *self)
+{
+    assert(self);
+    return s_future_new(self, sphactor_command_new(SPHACTOR_COMMAND_FILTERS), NULL);
+}
+
 
 void
 sphactor_ask_set_name (sphactor_t *self, const char *name)
 {
     assert (self);
     assert (name);
-    zstr_sendx (self->actor, "SET NAME", name, NULL);
+    zstr_sendx (self->pipe, "SET NAME", name, NULL);
+    //  cache it, the actor will have this name from now on
+    char *cached = strdup(name);
+    zstr_free(&self->name);
+    self->name = cached;
+    self->revision++;
+    if ( self->rename_fn )
+        self->rename_fn(self, self->rename_args);
+}
+
+//  Call rename_fn with args whenever our name is set, pass NULL to stop.
+//  The sph_stage holding us keeps its name index up to date with it.
+
+void
+sphactor_set_rename_fn (sphactor_t *self, void (*rename_fn) (sphactor_t *self, void *args), void *args)
+{
+    assert(self);
+    self->rename_fn = rename_fn;
+    self->rename_args = args;
 }
 
 void
@@ -389,7 +691,8 @@ sphactor_ask_set_actor_type (sphactor_t *self, const char *actor_type)
     if (self->type)
         zstr_free(&self->type);
     self->type = strdup(actor_type);  // cache immediatelly
-    zstr_sendx (self->actor, "SET TYPE", actor_type, NULL);
+    self->revision++;
+    zstr_sendx (self->pipe, "SET TYPE", actor_type, NULL);
 }
 
 //  Set the timeout of this Sphactor's actor. This is used for the timeout
@@ -402,8 +705,9 @@ sphactor_ask_set_timeout (sphactor_t *self, int64_t timeout)
 {
     assert (self);
     assert (timeout);
-    zstr_sendm(self->actor, "SET TIMEOUT");
-    zstr_sendf(self->actor, "%li", timeout);
+    zmsg_t *msg = sphactor_command_new (SPHACTOR_COMMAND_SET_TIMEOUT);
+    sphactor_command_add_int (msg, timeout);
+    zmsg_send (&msg, self->pipe);
 }
 
 //  Return the current timeout of this sphactor actor's poller. By default
@@ -413,46 +717,45 @@ int64_t
 sphactor_ask_timeout (sphactor_t *self)
 {
     assert (self);
-    zstr_send(self->actor, "TIMEOUT");
-    zmsg_t *response = zmsg_recv( self->actor );
-    char *cmd = zmsg_popstr( response );
-    assert( strlen( cmd ) );
-    int64_t ret = atoll( cmd );
-    zmsg_destroy( &response );
-    zstr_free( &cmd );
+    sphactor_future_t *future = sphactor_ask_timeout_async( self );
+    sphactor_future_wait( future, -1 );
+    zframe_t *frame = zmsg_first( sphactor_future_reply( future ) );
+    assert( frame && zframe_size( frame ) == sizeof(int64_t) );
+    int64_t ret;
+    memcpy( &ret, zframe_data( frame ), sizeof(int64_t) );
+    sphactor_future_destroy( &future );
     return ret;
 }
 
+//  Have this Sphactor's actor handle a TIME event every interval usecs, 0
+//  to stop. Unlike the timeout this runs on a timerfd on Linux so it
+//  keeps periods below a millisecond. The report holds how late the
+//  events fired.
+void
+sphactor_ask_set_interval (sphactor_t *self, int64_t interval)
+{
+    assert (self);
+    zmsg_t *msg = sphactor_command_new (SPHACTOR_COMMAND_SET_INTERVAL);
+    sphactor_command_add_int (msg, interval);
+    zmsg_send (&msg, self->pipe);
+}
+
 int
 sphactor_ask_connect (sphactor_t *self, const char *endpoint)
 {
     assert(self);
     assert(endpoint);
-    zstr_sendx( self->actor, "CONNECT", endpoint, NULL );
-    zmsg_t *response = zmsg_recv( self->actor );
-    char *cmd = zmsg_popstr( response );
-    assert( streq( cmd, "CONNECTED"));
-    char *dest = zmsg_popstr(response);
-    assert(streq(dest, endpoint));
-    char *rc = zmsg_popstr(response);
-    assert ( streq(rc, "0") );
-    int rci = streq(rc, "0") ? 0 : -1;
-    
-    // save our connection
-    if ( zlist_exists(self->subscriptions, dest) )
-    {
-        zsys_warning("Connection %s already exists", dest);
-        zstr_free(&dest);
-    }
-    else
-    {
-        zlist_append(self->subscriptions, dest); // list uses auto free so dest will be duped
-    }
-
-    zstr_free(&cmd);
-    zstr_free(&dest);
-    zstr_free(&rc);
-    zmsg_destroy(&response);
+    //  the reply saves our connection
+    sphactor_future_t *future = sphactor_ask_connect_async( self, endpoint );
+    sphactor_future_wait( future, -1 );
+    zmsg_t *response = sphactor_future_reply( future );
+    zframe_t *cmd = zmsg_first( response );
+    assert( zframe_streq( cmd, "CONNECTED"));
+    zframe_t *dest = zmsg_next( response );
+    assert( zframe_streq( dest, endpoint ));
+    zframe_t *rc = zmsg_next( response );
+    int rci = zframe_streq(rc, "0") ? 0 : -1;
+    sphactor_future_destroy( &future );
 
     return rci;
 }
@@ -462,9 +765,10 @@ sphactor_ask_disconnect (sphactor_t *self, const char *endpoint)
 {
     assert(self);
     assert(endpoint);
-    int rc = zstr_sendx( self->actor, "DISCONNECT", endpoint, NULL );
+    s_pending_wait(self);
+    int rc = zstr_sendx( self->pipe, "DISCONNECT", endpoint, NULL );
     assert( rc == 0);
-    zmsg_t *response = zmsg_recv( self->actor );
+    zmsg_t *response = zmsg_recv( self->pipe );
     char *cmd = zmsg_popstr( response );
     assert( streq( cmd, "DISCONNECTED"));
     char *dest = zmsg_popstr(response);
@@ -475,6 +779,7 @@ sphactor_ask_disconnect (sphactor_t *self, const char *endpoint)
 
     // this does nothing if the endpoint is not in the list
     zlist_remove(self->subscriptions, dest);
+    self->revision++;
 
     zstr_free(&cmd);
     zstr_free(&dest);
@@ -495,9 +800,9 @@ zlist_t *
 sphactor_ask_filters (sphactor_t *self)
 {
     assert(self);
-    int rc = zstr_sendx( self->actor, "FILTERS", NULL );
-    assert( rc == 0);
-    zmsg_t *response = zmsg_recv( self->actor );
+    sphactor_future_t *future = sphactor_ask_filters_async( self );
+    sphactor_future_wait( future, -1 );
+    zmsg_t *response = sphactor_future_reply( future );
     assert(response);
     char* filter = zmsg_popstr(response);
     assert(filter);
@@ -518,7 +823,7 @@ sphactor_ask_filters (sphactor_t *self)
     else
         zstr_free(&filter);
 
-    zmsg_destroy(&response);
+    sphactor_future_destroy(&future);
     return filters;
 }
 
@@ -527,7 +832,7 @@ sphactor_ask_add_filter(sphactor_t *self, const char *filter)
 {
     assert(self);
     assert(filter);
-    int rc = zstr_sendx( self->actor, "FILTER ADD", filter, NULL );
+    int rc = zstr_sendx( self->pipe, "FILTER ADD", filter, NULL );
     assert( rc == 0);
 }
 
@@ -536,30 +841,83 @@ sphactor_ask_remove_filter(sphactor_t *self, const char *filter)
 {
     assert(self);
     assert(filter);
-    int rc = zstr_sendx( self->actor, "FILTER REMOVE", filter, NULL );
+    int rc = zstr_sendx( self->pipe, "FILTER REMOVE", filter, NULL );
     assert( rc == 0);
 }
 
+void
+sphactor_ask_terminate (sphactor_t *self)
+{
+    assert (self);
+    if (self->terminating)
+        return;
+    s_pending_wait (self);
+    //  same protocol as zactor_destroy, sphactor_destroy waits for the
+    //  signal so we leave it on the pipe
+    zsock_t *pipe = (zsock_t *) zsock_resolve (self->pipe);
+    zsock_set_sndtimeo (pipe, 0);
+    self->terminating = zstr_send (pipe, "$TERM") == 0;
+}
+
 zsock_t *
 sphactor_socket(sphactor_t *self)
 {
-    return (zsock_t*)zactor_resolve(self->actor);
+    return (zsock_t*)zsock_resolve(self->pipe);
 }
 
 void
 sphactor_ask_set_verbose (sphactor_t *self, bool on)
 {
     assert (self);
-    zstr_sendm (self->actor, "SET VERBOSE");
-    zstr_send( self->actor, on ? "TRUE" : "FALSE");
+    zmsg_t *msg = sphactor_command_new (SPHACTOR_COMMAND_SET_VERBOSE);
+    sphactor_command_add_bool (msg, on);
+    zmsg_send (&msg, self->pipe);
 }
 
 void
 sphactor_ask_set_reporting (sphactor_t *self, bool on)
 {
     assert (self);
-    zstr_sendm (self->actor, "SET REPORTING");
-    zstr_send( self->actor, on ? "TRUE" : "FALSE");
+    zmsg_t *msg = sphactor_command_new (SPHACTOR_COMMAND_SET_REPORTING);
+    sphactor_command_add_bool (msg, on);
+    zmsg_send (&msg, self->pipe);
+}
+
+void
+sphactor_ask_set_multicast (sphactor_t *self, const char *policy)
+{
+    assert (self);
+    assert (policy);
+    zmsg_t *msg = sphactor_command_new (SPHACTOR_COMMAND_SET_MULTICAST);
+    zmsg_addstr (msg, policy);
+    zmsg_send (&msg, self->pipe);
+}
+
+void
+sphactor_ask_set_batch (sphactor_t *self, size_t size, bool events)
+{
+    assert (self);
+    zmsg_t *msg = sphactor_command_new (SPHACTOR_COMMAND_SET_BATCH);
+    sphactor_command_add_int (msg, (int64_t) size);
+    sphactor_command_add_bool (msg, events);
+    zmsg_send (&msg, self->pipe);
+}
+
+void
+sphactor_ask_reset_latency (sphactor_t *self)
+{
+    assert (self);
+    zmsg_t *msg = sphactor_command_new (SPHACTOR_COMMAND_RESET_LATENCY);
+    zmsg_send (&msg, self->pipe);
+}
+
+void
+sphactor_ask_set_tracing (sphactor_t *self, bool tracing)
+{
+    assert (self);
+    zmsg_t *msg = sphactor_command_new (SPHACTOR_COMMAND_SET_TRACING);
+    sphactor_command_add_bool (msg, tracing);
+    zmsg_send (&msg, self->pipe);
 }
 
 static int
@@ -575,6 +933,44 @@ sphactor_ask_api_native(sphactor_t *self, const char *api_format, ...)
     return rc;
 }
 
+//  Send an API call, or add it to the batch if there is one open
+
+static int
+s_ask_send (sphactor_t *self, zmsg_t **msg_p)
+{
+    if ( self->batch == NULL )
+        return zmsg_send(msg_p, self->pipe);
+    //  each call in the batch is preceded by its number of frames
+    zmsg_t *msg = *msg_p;
+    sphactor_command_add_int(self->batch, (int64_t) zmsg_size(msg));
+    zframe_t *frame;
+    while ( (frame = zmsg_pop(msg)) )
+        zmsg_append(self->batch, &frame);
+    zmsg_destroy(msg_p);
+    return 0;
+}
+
+static void
+s_batch_begin (sphactor_t *self)
+{
+    assert( self->batch == NULL );
+    self->batch = sphactor_command_new(SPHACTOR_COMMAND_BATCH);
+}
+
+//  Send the API calls of the batch in one message
+
+static int
+s_batch_end (sphactor_t *self)
+{
+    assert( self->batch );
+    if ( zmsg_size(self->batch) == 1 )
+    {
+        zmsg_destroy(&self->batch);     //  nothing to send
+        return 0;
+    }
+    return zmsg_send(&self->batch, self->pipe);
+}
+
 int
 sphactor_ask_api(sphactor_t *self, const char *api_call, const char *api_format, const char *value)
 {
@@ -582,12 +978,10 @@ sphactor_ask_api(sphactor_t *self, const char *api_call, const char *api_format,
     assert(strlen(api_call));
     assert(api_format);
     int rc = 0;
+    zmsg_t *msg = NULL;
     // this is still somewhat narrow but works for now
     if ( strlen(api_format) == 1 )
     {
-        char *fmt = (char *)malloc(3); //strlen(api_format) + 2); // +2 starting s and for the null-terminator
-        strcpy(fmt, "s");
-        strcat(fmt, api_format);
         char type = api_format[0];
         switch( type )
         {
@@ -603,42 +997,109 @@ sphactor_ask_api(sphactor_t *self, const char *api_call, const char *api_format,
                 zsys_error("Unsupprted 'b' format char in sphactor_ask_api");
             } break;
             case 'i': {
-                rc = zsock_send( sphactor_socket(self), fmt, api_call, atoi(value));
+                //  built-in commands take the value natively, handlers
+                //  keep getting it as a string
+                int opcode = sphactor_command_lookup(api_call);
+                if ( opcode )
+                {
+                    msg = sphactor_command_new(opcode);
+                    sphactor_command_add_int(msg, (int64_t) atoll(value));
+                }
+                else
+                {
+                    //  handlers get the text and the native value, see
+                    //  sphactor_actor_pop_int
+                    msg = zmsg_new();
+                    zmsg_addstr(msg, api_call);
+                    sphactor_command_add_int_value(msg, value ? (int64_t) atoll(value) : 0);
+                }
             } break;
             case 'f': {
-                // this is a workaround for supporting floats, 
-                // we change the 'f' value in fmt to 's'
-                // float is send as a string
-                fmt[1] = 's';
-                rc = zsock_send( sphactor_socket(self), fmt, api_call, value);
+                //  only handlers take floats, they get the text and the
+                //  native value, see sphactor_actor_pop_double
+                msg = zmsg_new();
+                zmsg_addstr(msg, api_call);
+                sphactor_command_add_double_value(msg, value ? atof(value) : 0);
             } break;
             case 's': {
-                rc = zsock_send( sphactor_socket(self), fmt, api_call, value);
+                msg = zmsg_new();
+                zmsg_addstr(msg, api_call);
+                zmsg_addstr(msg, value ? value : "");
             } break;
             default: {
                 zsys_error("Unsupported sphactor_ask_api call: api_call: %s, api_format: %s, value: %s", api_call, api_format, value);
                 rc = -1;
             } break;
         }
-        free(fmt);
     }
     else
-        rc = zsock_send( sphactor_socket(self), "ss", api_call, value);
+    {
+        msg = zmsg_new();
+        zmsg_addstr(msg, api_call);
+        zmsg_addstr(msg, value ? value : "");
+    }
+    if ( msg )
+        rc = s_ask_send(self, &msg);
 
     if (rc == 0)
     {
         zhash_update(self->values_cache, api_call, (void *)value);
+        self->revision++;
     }
 
     return rc;
 }
 
+int
+sphactor_set_value (sphactor_t *self, const char *name, const char *value)
+{
+    assert(self);
+    assert(name);
+    zconfig_t *root = self->capability ? zconfig_locate(self->capability, "capabilities") : NULL;
+    //  here we have to lookup name in the capabilities to see if it matches
+    //  in order to find the api_call key of the capability with its optional format
+    zconfig_t *data = root ? zconfig_locate(root, "data") : NULL;
+    while ( data ) {
+        zconfig_t *dname = zconfig_locate(data, "name");
+        zconfig_t *type = zconfig_locate(data, "type");
+        if (dname && streq(zconfig_value(dname), name) && !streq(zconfig_value(type), "trigger") )
+        {
+            // TODO: here's the value is set in the capability, this is not safe!!!
+            zconfig_t *zvalue = zconfig_locate(data, "value");
+            if ( zvalue )
+            {
+                zconfig_set_value(zvalue, "%s", value);
+            }
+            zconfig_t *zapic = zconfig_locate(data, "api_call");
+            if (zapic)
+            {
+                zconfig_t *zapiv = zconfig_locate(data, "api_value");
+                if (zapiv)
+                    return sphactor_ask_api(self, zconfig_value(zapic), zconfig_value(zapiv), value);
+                else
+                    return sphactor_ask_api(self, zconfig_value(zapic), "", value);
+            }
+            return 0;
+        }
+        data = zconfig_next(data);
+    }
+    return -1;
+}
+
 void
 sphactor_set_position (sphactor_t *self, float x, float y)
 {
     assert (self);
     self->posx = x;
     self->posy = y;
+    self->revision++;
+}
+
+uint64_t
+sphactor_revision (sphactor_t *self)
+{
+    assert (self);
+    return self->revision;
 }
 
 float
@@ -773,10 +1234,11 @@ sphactor_report(sphactor_t *self)
 {
     if ( self->_sph_act == NULL )
     {
-        int rc = zstr_send( self->actor, "INSTANCE" );
+        s_pending_wait(self);
+        int rc = zstr_send( self->pipe, "INSTANCE" );
         assert( rc == 0);
 
-        rc = zsock_recv (self->actor, "p", &self->_sph_act);
+        rc = zsock_recv (self->pipe, "p", &self->_sph_act);
         assert( rc == 0 );
         if (  self->_sph_act == NULL )
         {
@@ -784,17 +1246,24 @@ sphactor_report(sphactor_t *self)
             return NULL;
         }
     }
-    // swap the report pointer atomically with NULL
-    sphactor_report_t *report = sphactor_actor_atomic_report( self->_sph_act );
-    // if we receive a NULL report this means there's no update in the status
-    // the latest report is then still valid.
-    if ( report == NULL ) return self->latest_report;
-    // we now save the report as the latest report and destroy the old one
-    // if the old one is not NULL
-    if ( self->latest_report ) sphactor_report_destroy(&self->latest_report);
-    self->latest_report = report;
-    // we now own report so the caller must destroy when finished with it
-    // unless it's null of course
+    // copy the actor's report into our own, this doesn't allocate
+    // unless the custom report changed
+    if ( self->latest_report == NULL )
+        self->latest_report = sphactor_report_new();
+    if ( sphactor_actor_report_snapshot( self->_sph_act, self->latest_report ) == -1 )
+        return NULL;
+    // we keep owning the report, it is valid until the next call
+    return self->latest_report;
+}
+
+sphactor_report_t *
+sphactor_latency(sphactor_t *self)
+{
+    // the report fetches our instance pointer and fails like it does
+    if ( sphactor_report(self) == NULL )
+        return NULL;
+    if ( sphactor_actor_latency_snapshot( self->_sph_act, self->latest_report ) == -1 )
+        return NULL;
     return self->latest_report;
 }
 
@@ -872,6 +1341,7 @@ sphactor_dispose ()
         it = zhash_next(actors_reg);
     }
     zhash_destroy(&actors_reg);
+    sphactor_timeline_dispose();
 }
 
 
@@ -1001,6 +1471,119 @@ api_sphactor(sphactor_event_t *ev, void *args)
     return NULL;
 }
 
+typedef struct {
+    int64_t count;
+    double speed;
+    char *fuse;
+} values_test_t;
+
+static zmsg_t *
+values_sphactor(sphactor_event_t *ev, void *args)
+{
+    if ( ev->msg == NULL ) return NULL;
+    //  keep the values of our API commands
+    values_test_t *test = (values_test_t *)args;
+    if ( ev->kind == SPHACTOR_EVENT_API )
+    {
+        char *cmd = zmsg_popstr(ev->msg);
+        if ( streq(cmd, "COUNT") )
+            test->count = sphactor_actor_pop_int(ev->msg, -1);
+        else if ( streq(cmd, "SPEED") )
+            test->speed = sphactor_actor_pop_double(ev->msg, -1);
+        else if ( streq(cmd, "FUSE") )
+            test->fuse = zmsg_popstr(ev->msg);
+        zstr_free(&cmd);
+    }
+    zmsg_destroy(&ev->msg);
+    return NULL;
+}
+
+static zmsg_t *
+count_sphactor(sphactor_event_t *ev, void *args)
+{
+    if ( ev->msg == NULL ) return NULL;
+    //  count the messages we receive
+    int *count = (int *)args;
+    (*count)++;
+    zmsg_destroy(&ev->msg);
+    return NULL;
+}
+
+typedef struct {
+    int count;
+    sphactor_atomic_int_t held;       //  the handler holds the first message
+    sphactor_atomic_int_t released;   //  the test lets it go on
+} hold_test_t;
+
+static zmsg_t *
+hold_sphactor(sphactor_event_t *ev, void *args)
+{
+    if ( ev->msg == NULL ) return NULL;
+    //  count the messages we receive, hold on to the first until released
+    //  so the next ones queue up
+    hold_test_t *test = (hold_test_t *)args;
+    if ( ++test->count == 1 )
+    {
+        sphactor_atomic_store(&test->held, 1);
+        while ( !sphactor_atomic_load(&test->released) )
+            zclock_sleep(1);
+    }
+    zmsg_destroy(&ev->msg);
+    return NULL;
+}
+
+static zmsg_t *
+batch_sphactor(sphactor_event_t *ev, void *args)
+{
+    if ( ev->msg == NULL ) return NULL;
+    //  count the messages in args[0] and the batches in args[1]
+    int *counts = (int *)args;
+    assert( streq(ev->type, "SOCKBATCH") );
+    zframe_t *frame = zmsg_first(ev->msg);
+    zmsg_t **msgs = (zmsg_t **) zframe_data(frame);
+    size_t size = zframe_size(frame) / sizeof(zmsg_t *);
+    assert( size > 0 && size <= 16 );
+    for (size_t i = 0; i < size; i++)
+    {
+        assert( zframe_streq(zmsg_first(msgs[i]), "TESTAPI") );
+        zmsg_destroy(&msgs[i]);
+        counts[0]++;
+    }
+    counts[1]++;
+    zmsg_destroy(&ev->msg);
+    return NULL;
+}
+
+static zmsg_t *
+forward_sphactor(sphactor_event_t *ev, void *args)
+{
+    //  pass on what we receive
+    return ev->msg;
+}
+
+typedef struct {
+    const char *origin;     //  uuid of the actor starting the traces
+    int     count;          //  traced messages received
+} trace_test_t;
+
+static zmsg_t *
+trace_sphactor(sphactor_event_t *ev, void *args)
+{
+    if ( ev->msg == NULL ) return NULL;
+    //  the trace frame is gone, the trace went through two actors
+    trace_test_t *test = (trace_test_t *)args;
+    assert( zmsg_size(ev->msg) == 1 );
+    assert( zframe_streq(zmsg_first(ev->msg), "TESTAPI") );
+    sphactor_trace_t *trace = sphactor_actor_trace((sphactor_actor_t *)ev->actor);
+    assert( trace );
+    assert( streq(sphactor_trace_origin(trace), test->origin) );
+    assert( sphactor_trace_hops(trace) == 2 );
+    assert( sphactor_trace_latency(trace) >= sphactor_trace_hop_latency(trace, 1) );
+    test->count++;
+    zmsg_destroy(&ev->msg);
+    return NULL;
+}
+
 typedef struct {
     char * name;
 } regtest_actor;
@@ -1132,10 +1715,12 @@ sphactor_test (bool verbose)
     assert (self);
     const zuuid_t *uuidtest = sphactor_ask_uuid(self);
     assert(uuidtest);
-    // position test
+    // position test, changes the revision
+    uint64_t revision = sphactor_revision(self);
     sphactor_set_position(self, 23.f, 24.f);
     assert( sphactor_position_x(self) == 23.f );
     assert( sphactor_position_y(self) == 24.f );
+    assert( sphactor_revision(self) != revision );
     //  name should be the first 6 chars from the uuid
     const char *name = sphactor_ask_name( self );
     char *name2 = (char *) zmalloc (7);
@@ -1161,8 +1746,70 @@ sphactor_test (bool verbose)
     //  test timeout setting and getting
     sphactor_ask_set_timeout(self, 1000);
     assert( sphactor_ask_timeout( self ) == 1000);
+    //  the string form of the command still works
+    zstr_sendx(self->pipe, "SET TIMEOUT", "500", NULL);
+    assert( sphactor_ask_timeout( self ) == 500);
+    zstr_send(self->pipe, "TIMEOUT");
+    char *timeout = zstr_recv(self->pipe);
+    assert( streq( timeout, "500" ));
+    zstr_free(&timeout);
+    //  as do built-in commands through the generic api call
+    sphactor_ask_api(self, "SET TIMEOUT", "i", "250");
+    assert( sphactor_ask_timeout( self ) == 250);
+    //  the report measures how late our interval fires
+    sphactor_ask_set_interval(self, 500);
+    zclock_sleep(20);
+    sphactor_report_t *jitter_report = sphactor_latency( self );
+    assert( sphactor_histogram_count( sphactor_report_timer_jitter( jitter_report ) ) > 0 );
+    assert( sphactor_report_jitter_latency( jitter_report, 100.0 ) >= sphactor_report_jitter_latency( jitter_report, 50.0 ) );
+    sphactor_ask_set_interval(self, 0);
+    //  the interval runs next to our timeout, it leaves it alone
+    assert( sphactor_ask_timeout( self ) == 250);
     sphactor_destroy (&self);
 
+    //  Pipelined asks to many actors complete with a single poll
+    {
+        sphactor_t *actors[4];
+        zlist_t *futures = zlist_new();
+        sphactor_future_t *future;
+        int i;
+        for (i = 0; i < 4; i++)
+        {
+            actors[i] = sphactor_new ( NULL, NULL, NULL, NULL);
+            zlist_append(futures, sphactor_ask_name_async(actors[i]));
+            zlist_append(futures, sphactor_ask_endpoint_async(actors[i]));
+            zlist_append(futures, sphactor_ask_timeout_async(actors[i]));
+        }
+        assert( sphactor_future_wait_all(futures, -1) == 0 );
+        //  the replies filled the caches
+        for (i = 0; i < 4; i++)
+        {
+            assert( actors[i]->name && actors[i]->endpoint );
+            assert( strlen( sphactor_ask_name(actors[i]) ) == 6 );
+        }
+        while ( (future = (sphactor_future_t *) zlist_pop(futures)) )
+        {
+            assert( sphactor_future_ready(future) );
+            sphactor_future_destroy(&future);
+        }
+        //  connect each actor to the previous one
+        for (i = 1; i < 4; i++)
+            zlist_append(futures, sphactor_ask_connect_async(actors[i], sphactor_ask_endpoint(actors[i-1])));
+        //  a blocking ask waits for the replies in flight first
+        assert( sphactor_ask_timeout(actors[3]) == -1 );
+        assert( sphactor_future_wait_all(futures, 1000) == 0 );
+        for (i = 1; i < 4; i++)
+        {
+            assert( zlist_size( sphactor_connections(actors[i]) ) == 1 );
+            assert( streq( (char *) zlist_first( sphactor_connections(actors[i]) ), sphactor_ask_endpoint(actors[i-1]) ) );
+        }
+        while ( (future = (sphactor_future_t *) zlist_pop(futures)) )
+            sphactor_future_destroy(&future);
+        zlist_destroy(&futures);
+        for (i = 0; i < 4; i++)
+            sphactor_destroy(&actors[i]);
+    }
+
     //  Simple create/destroy/connect/disconnect test
     sphactor_t *pub = sphactor_new ( hello_sphactor, NULL, NULL, NULL);
     sphactor_t *sub = sphactor_new ( hello_sphactor, NULL, NULL, NULL);
@@ -1199,12 +1846,12 @@ sphactor_test (bool verbose)
     sphactor_t *hello2 = sphactor_new ( hello_sphactor2, NULL, NULL, NULL);
     sphactor_ask_connect(hello1, sphactor_ask_endpoint(hello2));
     sphactor_ask_connect(hello2, sphactor_ask_endpoint(hello1));
-    zstr_sendm(hello1->actor, "SEND");
-    zstr_sendm(hello1->actor, "HELLO");
-    zstr_sendm(hello1->actor, "WORLD");
-    zstr_sendm(hello1->actor, "AND");
-    zstr_sendm(hello1->actor, "ALIEN");
-    zstr_send(hello1->actor, "SPACELINGS");
+    zstr_sendm(hello1->pipe, "SEND");
+    zstr_sendm(hello1->pipe, "HELLO");
+    zstr_sendm(hello1->pipe, "WORLD");
+    zstr_sendm(hello1->pipe, "AND");
+    zstr_sendm(hello1->pipe, "ALIEN");
+    zstr_send(hello1->pipe, "SPACELINGS");
     zclock_sleep(10); //  give some time for the test to complete, since it's threaded
     sphactor_destroy (&hello1);
     sphactor_destroy (&hello2);
@@ -1256,8 +1903,8 @@ sphactor_test (bool verbose)
     int64_t end = zclock_usecs();
     zsys_info("%i Actors spawned in %d microseconds (%.6f ms)", limit, end-start, (end-start)/1000.f);
     zclock_sleep(2000);
-    zstr_sendm(prev->actor, "SEND");
-    zstr_sendf(prev->actor, "HELLO from %s", sphactor_ask_name(prev));
+    zstr_sendm(prev->pipe, "SEND");
+    zstr_sendf(prev->pipe, "HELLO from %s", sphactor_ask_name(prev));
     zclock_sleep(200);
     while (zlist_size(spawned_actors) > 0)
     {
@@ -1320,8 +1967,8 @@ sphactor_test (bool verbose)
         
         // Have them send a message to each other
         const char* msg12 = "1 talking to 2";
-        zstr_sendm(sender->actor, "SEND");
-        zstr_send(sender->actor, msg12);
+        zstr_sendm(sender->pipe, "SEND");
+        zstr_send(sender->pipe, msg12);
 
         zclock_sleep(100);
 
@@ -1350,8 +1997,8 @@ sphactor_test (bool verbose)
         }
         
         // Send a message to clear the report
-        zstr_sendm(sender->actor, "SEND");
-        zstr_send(sender->actor, "CLEAR");
+        zstr_sendm(sender->pipe, "SEND");
+        zstr_send(sender->pipe, "CLEAR");
 
         zclock_sleep(100);
         
@@ -1457,6 +2104,21 @@ sphactor_test (bool verbose)
     zclock_sleep(10);
     sphactor_destroy(&apiact);
 
+    // handlers get native values, and the names of built-in commands
+    // without a string form
+    values_test_t values = { 0, 0, NULL };
+    sphactor_t *valact = sphactor_new ( values_sphactor, &values, NULL, NULL);
+    assert(valact);
+    sphactor_ask_api(valact, "COUNT", "i", "42");
+    sphactor_ask_api(valact, "SPEED", "f", "1.5");
+    sphactor_ask_api(valact, "FUSE", "s", "ABCDEFGH");
+    sphactor_ask_timeout(valact);   // the commands before it are handled
+    assert(values.count == 42);
+    assert(values.speed == 1.5);
+    assert(values.fuse && streq(values.fuse, "ABCDEFGH"));
+    zstr_free(&values.fuse);
+    sphactor_destroy(&valact);
+
     // sphactor_load test
     zconfig_t *root = zconfig_str_load (
     "actors\n"
@@ -1539,6 +2201,237 @@ sphactor_test (bool verbose)
         sphactor_destroy(&senderact);
     }
 
+    // drain an actor connected by a plain sub socket, it has no rings
+    {
+        hold_test_t hold;
+        memset(&hold, 0, sizeof(hold));
+        sphactor_t *senderact = sphactor_new(api_sphactor, NULL, NULL, NULL);
+        sphactor_t *subact = sphactor_new(hold_sphactor, &hold, NULL, NULL);
+        rc = sphactor_ask_connect(subact, sphactor_ask_endpoint(senderact));
+        assert(rc == 0);
+        zclock_sleep(10); // give the subscription some time
+        // the first message keeps the actor busy
+        sphactor_ask_api(senderact, "SEND", "s", "TESTAPI");
+        int64_t deadline = zclock_mono() + 5000;
+        while ( !sphactor_atomic_load(&hold.held) && zclock_mono() < deadline )
+            zclock_sleep(1);
+        assert( sphactor_atomic_load(&hold.held) );
+        // the next ones wait in its socket, the drain request in its pipe
+        int i;
+        for (i = 0; i < 5; i++)
+            sphactor_ask_api(senderact, "SEND", "s", "TESTAPI");
+        zclock_sleep(50); // give them time to arrive
+        sphactor_future_t *future = sphactor_ask_drain_async(subact, 1000);
+        // the pipe is polled first, so the drain handles all five
+        sphactor_atomic_store(&hold.released, 1);
+        rc = sphactor_future_wait(future, -1);
+        assert(rc == 0);
+        zframe_t *frame = zmsg_first(sphactor_future_reply(future));
+        assert(frame && zframe_size(frame) == sizeof(int64_t));
+        int64_t drained;
+        memcpy(&drained, zframe_data(frame), sizeof(drained));
+        assert(drained == 5);
+        assert(hold.count == 6);
+        sphactor_future_destroy(&future);
+        sphactor_destroy(&subact);
+        sphactor_destroy(&senderact);
+        assert(hold.count == 6);
+    }
+
+    // queue times are measured on the default socket connection too
+    {
+        int count = 0;
+        sphactor_t *senderact = sphactor_new(api_sphactor, NULL, NULL, NULL);
+        sphactor_t *subact = sphactor_new(count_sphactor, &count, NULL, NULL);
+        rc = sphactor_ask_connect(subact, sphactor_ask_endpoint(senderact));
+        assert(rc == 0);
+        zclock_sleep(10); // give the subscription some time
+        sphactor_ask_api(senderact, "SEND", "s", "TESTAPI");
+        sphactor_ask_api(senderact, "SEND", "s", "TESTAPI");
+        int64_t deadline = zclock_mono() + 5000;
+        sphactor_report_t *rep = sphactor_latency(subact);
+        while ( sphactor_histogram_count(sphactor_report_queue_time(rep)) < 2
+                && zclock_mono() < deadline )
+        {
+            zclock_sleep(1);
+            rep = sphactor_latency(subact);
+        }
+        assert(sphactor_histogram_count(sphactor_report_queue_time(rep)) == 2);
+        sphactor_destroy(&subact);
+        sphactor_destroy(&senderact);
+        assert(count == 2);
+    }
+
+    // ring connection tests
+    {
+        if (verbose)
+            zsys_info("Ring tests:");
+        int count = 0;
+        sphactor_t *senderact = sphactor_new(api_sphactor, NULL, NULL, NULL);
+        sphactor_t *ringact = sphactor_new(count_sphactor, &count, NULL, NULL);
+        assert(senderact);
+        assert(ringact);
+        char *ringendp = zsys_sprintf("ring+%s", sphactor_ask_endpoint(senderact));
+        rc = sphactor_ask_connect(ringact, ringendp);
+        assert(rc == 0);
+        assert( zlist_exists(sphactor_connections(ringact), ringendp) );
+        sphactor_ask_add_filter(ringact, "TEST"); // filters apply to rings as well
+        sphactor_ask_api(senderact, "SEND", "s", "TESTAPI");
+        sphactor_ask_api(senderact, "SEND", "s", "BLAA");
+        sphactor_ask_api(senderact, "SEND", "s", "TESTAPI");
+        zclock_sleep(10); // give some time for messages to travel
+
+        rc = sphactor_ask_disconnect(ringact, ringendp);
+        assert(rc == 0);
+        sphactor_ask_api(senderact, "SEND", "s", "TESTAPI"); // not received anymore
+        zclock_sleep(10);
+
+        sphactor_destroy(&ringact);
+        assert(count == 2);
+
+        // multicast: every reader gets every message, written once
+        int counts[3] = { 0, 0, 0 };
+        sphactor_t *readers[3];
+        sphactor_ask_set_multicast(senderact, "BLOCK");
+        for (int i = 0; i < 3; i++)
+        {
+            readers[i] = sphactor_new(count_sphactor, &counts[i], NULL, NULL);
+            rc = sphactor_ask_connect(readers[i], ringendp);
+            assert(rc == 0);
+        }
+        sphactor_ask_api(senderact, "SEND", "s", "TESTAPI");
+        sphactor_ask_api(senderact, "SEND", "s", "TESTAPI");
+        zclock_sleep(10);
+        sphactor_report_t *rep = sphactor_report(senderact);
+        assert(sphactor_report_readers(rep) == 3);
+        // the readers measured how long the messages waited for them
+        rep = sphactor_report(readers[0]);
+        assert(sphactor_histogram_count(sphactor_report_queue_time(rep)) == 0);   // not copied
+        rep = sphactor_latency(readers[0]);
+        assert(sphactor_histogram_count(sphactor_report_queue_time(rep)) == 2);
+        assert(sphactor_histogram_count(sphactor_report_handler_time(rep)) >= 2);
+        assert(sphactor_report_queue_latency(rep, 100.0) >= sphactor_report_queue_latency(rep, 50.0));
+        sphactor_ask_reset_latency(readers[0]);
+        zclock_sleep(10);
+        rep = sphactor_latency(readers[0]);
+        assert(sphactor_histogram_count(sphactor_report_queue_time(rep)) == 0);
+        for (int i = 0; i < 3; i++)
+        {
+            sphactor_destroy(&readers[i]);
+            assert(counts[i] == 2);
+        }
+        sphactor_destroy(&senderact);
+        zstr_free(&ringendp);
+    }
+
+    // batch tests: messages come in batches of at most 16
+    {
+        if (verbose)
+            zsys_info("Batch tests:");
+        int subcounts[2] = { 0, 0 };
+        int ringcounts[2] = { 0, 0 };
+        sphactor_t *senderact = sphactor_new(api_sphactor, NULL, NULL, NULL);
+        sphactor_t *subact = sphactor_new(batch_sphactor, subcounts, NULL, NULL);
+        sphactor_t *ringact = sphactor_new(batch_sphactor, ringcounts, NULL, NULL);
+        sphactor_ask_set_batch(subact, 16, true);
+        sphactor_ask_set_batch(ringact, 16, true);
+        rc = sphactor_ask_connect(subact, sphactor_ask_endpoint(senderact));
+        assert(rc == 0);
+        char *ringendp = zsys_sprintf("ring+%s", sphactor_ask_endpoint(senderact));
+        rc = sphactor_ask_connect(ringact, ringendp);
+        assert(rc == 0);
+        zclock_sleep(10); // give the sub socket time to connect
+        for (int i = 0; i < 100; i++)
+            sphactor_ask_api(senderact, "SEND", "s", "TESTAPI");
+        zclock_sleep(100);
+        sphactor_destroy(&subact);
+        sphactor_destroy(&ringact);
+        sphactor_destroy(&senderact);
+        zstr_free(&ringendp);
+        if (verbose)
+            zsys_info("%d messages in %d batches, %d in %d through a ring",
+                      subcounts[0], subcounts[1], ringcounts[0], ringcounts[1]);
+        assert(subcounts[0] == 100);
+        assert(ringcounts[0] == 100);
+        assert(subcounts[1] >= 7 && ringcounts[1] >= 7);
+    }
+
+    // trace tests: a trace started by the sender passes through the
+    // forwarder, over a socket and a ring, to the sink
+    {
+        if (verbose)
+            zsys_info("Trace tests:");
+        sphactor_t *senderact = sphactor_new(api_sphactor, NULL, NULL, NULL);
+        sphactor_t *fwdact = sphactor_new(forward_sphactor, NULL, NULL, NULL);
+        trace_test_t test = { zuuid_str(sphactor_ask_uuid(senderact)), 0 };
+        sphactor_t *sinkact = sphactor_new(trace_sphactor, &test, NULL, NULL);
+        sphactor_ask_set_tracing(senderact, true);
+        rc = sphactor_ask_connect(fwdact, sphactor_ask_endpoint(senderact));
+        assert(rc == 0);
+        char *ringendp = zsys_sprintf("ring+%s", sphactor_ask_endpoint(fwdact));
+        rc = sphactor_ask_connect(sinkact, ringendp);
+        assert(rc == 0);
+        zclock_sleep(10); // give the sub socket time to connect
+        for (int i = 0; i < 10; i++)
+            sphactor_ask_api(senderact, "SEND", "s", "TESTAPI");
+        zclock_sleep(100);
+        sphactor_destroy(&sinkact);
+        sphactor_destroy(&fwdact);
+        sphactor_destroy(&senderact);
+        zstr_free(&ringendp);
+        assert(test.count == 10);
+    }
+
+    // fusion tests: a chain fused to the sender gets what it publishes
+    // without a socket, the fused actors keep their own api and report
+    {
+        if (verbose)
+            zsys_info("Fusion tests:");
+        int count = 0;
+        sphactor_t *senderact = sphactor_new(api_sphactor, NULL, NULL, NULL);
+        sphactor_t *fwdact = sphactor_new_fused(forward_sphactor, NULL, "fwd", NULL, senderact);
+        sphactor_t *countact = sphactor_new_fused(count_sphactor, &count, "count", NULL, fwdact);
+        assert(streq(sphactor_ask_name(fwdact), "fwd"));
+        assert(streq(sphactor_ask_name(countact), "count"));
+        sphactor_ask_set_reporting(countact, true);
+        for (int i = 0; i < 10; i++)
+            sphactor_ask_api(senderact, "SEND", "s", "TESTAPI");
+        zclock_sleep(100);
+        assert(count == 10);
+        sphactor_report_t *report = sphactor_report(countact);
+        assert(report);
+        assert(sphactor_report_iterations(report) == 10);
+        //  the end of the chain goes first, the rest goes with the sender
+        sphactor_destroy(&countact);
+        sphactor_ask_api(senderact, "SEND", "s", "TESTAPI");
+        zclock_sleep(10);
+        assert(count == 10);
+        sphactor_destroy(&senderact);
+        sphactor_destroy(&fwdact);
+    }
+
+    // a fused chain carries traces on like sockets do, fused actors have
+    // no sockets or timers of their own to connect
+    {
+        sphactor_t *senderact = sphactor_new(api_sphactor, NULL, NULL, NULL);
+        sphactor_t *otheract = sphactor_new(api_sphactor, NULL, NULL, NULL);
+        sphactor_t *fwdact = sphactor_new_fused(forward_sphactor, NULL, NULL, NULL, senderact);
+        trace_test_t test = { zuuid_str(sphactor_ask_uuid(senderact)), 0 };
+        sphactor_t *sinkact = sphactor_new_fused(trace_sphactor, &test, NULL, NULL, fwdact);
+        sphactor_ask_set_tracing(senderact, true);
+        rc = sphactor_ask_connect(fwdact, sphactor_ask_endpoint(otheract));
+        assert(rc == -1);
+        assert(zlist_size(sphactor_connections(fwdact)) == 0);
+        for (int i = 0; i < 10; i++)
+            sphactor_ask_api(senderact, "SEND", "s", "TESTAPI");
+        zclock_sleep(100);
+        assert(test.count == 10);
+        sphactor_destroy(&sinkact);
+        sphactor_destroy(&fwdact);
+        sphactor_destroy(&senderact);
+        sphactor_destroy(&otheract);
+    }
+
     zsys_shutdown();  //  needed by Windows: https://github.com/zeromq/czmq/issues/1751
     //  @end
     printf ("OK\n");
@@ -27,12 +27,62 @@
 #else
 #include <stdatomic.h>
 #endif
+#if defined (__UTYPE_LINUX)
+#include <sys/timerfd.h>
+#endif
+
+//  Most messages handled per poll in batch mode
+#define SPHACTOR_BATCH_MAX 256
+
+//  Spins of a report snapshot waiting for the actor before it yields
+#define SPHACTOR_REPORT_SPINS 100
+
+//  While we report, messages on our pub socket end in a stamp frame with
+//  the time we published them: the magic and an int64_t (zclock_usecs).
+//  Actors reading them take it off and time how long they waited.
+#define SPHACTOR_STAMP_MAGIC "SPHSTAMP"
+#define SPHACTOR_STAMP_SIZE  (8 + sizeof (int64_t))
+
+//  Custom report data, the actor fills the buffer the controller isn't
+//  reading. A buffer is replaced by a larger one instead of growing so its
+//  capacity never changes while the controller copies it.
+
+typedef struct {
+    size_t  capacity;               //  Allocated size of data
+    sphactor_atomic_int_t size;     //  Size of the OSC message
+    byte    data [1];               //  OSC message
+} report_custom_t;
+
+//  Our status report, updated without allocating. It is a seqlock: the
+//  actor makes seq odd while it writes, the controller copies the report
+//  and tries again if seq changed meanwhile.
+
+typedef struct {
+    sphactor_atomic_int_t seq;          //  Odd while the actor writes
+    sphactor_atomic_int_t status;       //  sphactor_report_status constant
+    sphactor_atomic_int_t iterations;   //  Number of iterations
+    sphactor_atomic_int_t recv_time;    //  Time of last receive
+    sphactor_atomic_int_t send_time;    //  Time of last send
+    sphactor_atomic_int_t custom_version;   //  Changes with the custom data
+    sphactor_atomic_int_t custom_current;   //  Buffer holding the custom
+                                            //  data, -1 if there is none
+    sphactor_atomic_ptr_t custom [2];   //  Custom data buffers, report_custom_t
+    zlist_t *retired;                   //  Outgrown buffers, the controller
+                                        //  might still be copying them
+} report_state_t;
 
 //  Structure of our class
 
 struct _sphactor_actor_t {
     zsock_t *pipe;                //  Actor command pipe
     zpoller_t *poller;            //  Socket poller
+    zlist_t *readers;             //  Readers in our poller, used when pooled
+    bool pooled;                  //  Are we run by a sphactor_pool?
+    bool ticked;                  //  Are we run by a sphactor_tick?
+    zlist_t *fused;               //  Actors fused to us, we call their handlers directly
+    zlist_t *hosted;              //  Fused actors our thread runs
+    sphactor_actor_t *fused_to;   //  Actor we are fused to
+    sphactor_actor_t *host;       //  Actor whose thread runs us when fused
     bool terminated;              //  Did caller ask us to quit?
     bool verbose;                 //  Verbose logging enabled?
     bool reporting;                  //  Enable reporting (sphactor_report)
@@ -44,10 +94,15 @@ struct _sphactor_actor_t {
     char        *name;            //  Our name (defaults to first 6 chars of our uuid)
     char        *actor_type;      //  Our actors typename (defaults to NULL)
     zhash_t     *subs;            //  a list of our subscription sockets
+    zlist_t     *connections;     //  endpoints we are connected to
     zlist_t     *sub_filters;     //  list of subscribe filters (native zmq subscribe filters)
     zloop_t     *loop;            //  perhaps we'll use zloop instead of poller
     int64_t     timeout;          //  timeout to wait on polling. Indirect rate for calling the handler
     int64_t     time_next;        //  timestamp for our next iteration
+    sphactor_wheel_t *timers;     //  our timers, created when the first is added
+    int64_t     interval;         //  period of our high resolution TIME events in usecs, 0 if none
+    int64_t     interval_next;    //  deadline of our next interval TIME event in usecs
+    int         timerfd;          //  timerfd firing our interval on Linux, -1 if none
     int64_t     time_till_next;   //  time till our next iteration
     sphactor_handler_fn *handler; //  the handler to call on events
     void        *handler_args;    //  the arguments to the handler
@@ -56,19 +111,186 @@ struct _sphactor_actor_t {
     int64_t     send_time;        //  time of last send on socket
     int         status;           //  sphactor_report_status constant, see sphactor_report.h
     zconfig_t   *capability;      //  The capability zconfig describing parameters (ie. for generating UI)
-    zosc_t      *reportMsg;       //  the report message containing the actor's state
-    _Atomic     (void*) atomic_report;  // atomic pointer to report data
+    report_state_t report;        //  the report containing the actor's state
+    sphactor_atomic_int_t report_taken; //  seq of the last report taken by sphactor_actor_atomic_report
+    sphactor_histogram_t *handler_time;   //  time spent in the handler
+    sphactor_histogram_t *queue_time;     //  time messages waited for us
+    sphactor_histogram_t *timer_jitter;   //  how late our interval TIME events fired
+    sphactor_timeline_t *timeline;        //  our handler calls, see sphactor_timeline
+    sphactor_atomic_ptr_t rings_out;  //  ring_list_t of rings we publish into
+    sphactor_atomic_ptr_t mcast;  //  multicast ring we publish into, if any
+    zhash_t     *rings_in;        //  ring_in_t we consume, by "ring+" endpoint
+    size_t      batch;            //  max messages handled per poll of a socket or ring
+    bool        batch_events;     //  hand batches to the handler as one SOCKBATCH event
+    zmsg_t      *batch_msgs [SPHACTOR_BATCH_MAX];  //  the batch being handled
+    sphactor_trace_t *batch_traces [SPHACTOR_BATCH_MAX];  //  and their traces
+    bool        tracing;          //  start a trace for every message we publish
+    uint64_t    trace_seq;        //  sequence number of our last trace
+    sphactor_trace_t *trace;      //  trace of the message being handled, if any
 };
 
+//  Rings an actor publishes into. Connecting actors replace the list instead
+//  of changing it so the actor can walk it without taking a lock.
+
+typedef struct _ring_list_t {
+    struct _ring_list_t *retired;   //  Replaced list, the actor might still
+                                    //  be walking it so free it last
+    size_t  size;                   //  Number of rings
+    sphactor_ring_t *rings [1];     //  The rings, we hold a reference to each
+} ring_list_t;
+
+//  A ring we consume: our own ring from an actor, or our reader on an
+//  actor's multicast ring
+
+typedef struct {
+    sphactor_ring_t  *ring;         //  Ring the actor pushes into, or
+    sphactor_mcast_t *mcast;        //  multicast ring of the actor
+    void    *reader;                //  and our reader on it
+} ring_in_t;
+
+//  Actors in this process by endpoint, so "ring+" connections can find the
+//  actor to attach their ring to. Only used to connect, never to publish.
+static zhash_t *s_actors = NULL;
+static sphactor_atomic_int_t s_actors_locked;
+
+//  Endpoints with this prefix are connected through a sphactor_ring
+#define SPHACTOR_RING_PREFIX "ring+"
+
+//  Did any actor in this process start tracing? Until then messages can't
+//  carry a trace and we don't look for one. It stays set as traced
+//  messages may still be on their way when tracing stops.
+static sphactor_atomic_int_t s_traced;
+
+
+//  Forward declarations
+static void
+    s_report_init (report_state_t *state);
+static void
+    s_report_term (report_state_t *state);
+static void
+    s_report_store (report_state_t *state, int status, uint64_t iterations, int64_t recv_time, int64_t send_time);
+static void
+    s_report_write (sphactor_actor_t *self);
+static void
+    s_actors_insert (sphactor_actor_t *self);
+static void
+    s_actors_remove (sphactor_actor_t *self);
+static int
+    s_ring_connect (sphactor_actor_t *self, const char *dest);
+static int
+    s_ring_disconnect (sphactor_actor_t *self, const char *dest);
+static void
+    s_rings_prune (sphactor_actor_t *self);
+static void
+    s_rings_destroy (sphactor_actor_t *self);
+static ring_in_t *
+    s_ring_lookup (sphactor_actor_t *self, void *handle);
+static zmsg_t *
+    s_ring_pop (sphactor_actor_t *self, ring_in_t *in);
+static zmsg_t *
+    s_handler_call (sphactor_actor_t *self, sphactor_event_t *ev);
+static bool
+    s_filters_match (sphactor_actor_t *self, zmsg_t *msg);
+static bool
+    s_handle_api_msg (sphactor_actor_t *self, zmsg_t **msg_p);
+static sphactor_trace_t *
+    s_trace_take (sphactor_actor_t *self, zmsg_t *msg);
+static void
+    s_trace_append (sphactor_actor_t *self, zmsg_t *msg);
+static void
+    s_stamp_take (sphactor_actor_t *self, zmsg_t *msg);
+static void
+    s_handle_sock_msg (sphactor_actor_t *self, zmsg_t *msg, ring_in_t *ring);
+static void
+    s_handle_sock_batch (sphactor_actor_t *self, zmsg_t *msg, ring_in_t *ring);
+
 
 static int
 s_publish_msg(sphactor_actor_t *self, zmsg_t *msg)
 {
+    //  carry on the trace of the message we're handling, or start one
+    if ( self->trace || self->tracing )
+        s_trace_append(self, msg);
+
+    //  call the handlers of the actors fused to us straight away, they
+    //  publish their replies for whoever else is connected to them
+    sphactor_actor_t *fused = (sphactor_actor_t *) zlist_first(self->fused);
+    while ( fused )
+    {
+        zmsg_t *reply = sphactor_actor_handle(fused, sphactor_payload_msg_dup(msg));
+        if ( reply )
+            s_publish_msg(fused, reply);
+        sphactor_trace_destroy(&fused->trace);
+        fused = (sphactor_actor_t *) zlist_next(self->fused);
+    }
+
+    //  hand a copy to every actor connected through a ring, a full ring
+    //  drops the message like the pub socket does at its high water mark
+    ring_list_t *rings = (ring_list_t *) sphactor_atomic_load_ptr (&self->rings_out);
+    if ( rings )
+    {
+        bool closed = false;
+        size_t i;
+        for (i = 0; i < rings->size; i++)
+        {
+            zmsg_t *copy = sphactor_payload_msg_dup(msg);
+            if ( sphactor_ring_push(rings->rings[i], &copy) == -1 )
+            {
+                closed = closed || sphactor_ring_closed(rings->rings[i]);
+                if ( self->verbose && ! closed )
+                    zsys_warning("sphactor_actor: %s, ring is full, dropping message", self->name);
+                zmsg_destroy(&copy);
+            }
+        }
+        if ( closed )
+            s_rings_prune(self);
+    }
+    //  a multicast ring shares the frames of the message with all its readers
+    sphactor_mcast_t *mcast = (sphactor_mcast_t *) sphactor_atomic_load_ptr (&self->mcast);
+    if ( mcast && sphactor_mcast_publish(mcast, msg) == -1 && self->verbose )
+        zsys_warning("sphactor_actor: %s, multicast ring is full, dropping message", self->name);
+    //  the rings timed the message themselves, stamp it for our socket
+    if ( self->reporting )
+    {
+        byte stamp [SPHACTOR_STAMP_SIZE];
+        int64_t now = zclock_usecs();
+        memcpy(stamp, SPHACTOR_STAMP_MAGIC, 8);
+        memcpy(stamp + 8, &now, sizeof(now));
+        zmsg_addmem(msg, stamp, sizeof(stamp));
+    }
     int rc = zmsg_send(&msg, self->pub);
     self->send_time = zclock_mono();
     return rc;
 }
 
+//  Destroy an actor fused to us the way sphactor_actor_run ends when its
+//  thread returns: signal its pipe and destroy our end.
+
+static void
+s_fused_finish (sphactor_actor_t *self, sphactor_actor_t *fused)
+{
+    assert(fused->host == self);
+    int rc = zpoller_remove(self->poller, fused->pipe);
+    assert(rc == 0);
+    zlist_remove(self->readers, fused->pipe);
+    zlist_remove(self->hosted, fused);
+    if ( fused->fused_to )
+        zlist_remove(fused->fused_to->fused, fused);
+    //  the actors fused to it keep running but get nothing anymore
+    sphactor_actor_t *orphan = (sphactor_actor_t *) zlist_first(fused->fused);
+    while ( orphan )
+    {
+        orphan->fused_to = NULL;
+        orphan = (sphactor_actor_t *) zlist_next(fused->fused);
+    }
+    zsock_t *pipe = fused->pipe;
+    sphactor_actor_stop(fused);
+    sphactor_actor_destroy(&fused);
+    zsock_set_sndtimeo(pipe, 0);
+    zsock_signal(pipe, 0);
+    zsock_destroy(&pipe);
+}
+
 //  --------------------------------------------------------------------------
 //  Create a new sphactor_actor
 
@@ -85,28 +307,23 @@ sphactor_actor_new (zsock_t *pipe, void *args)
     self->uuid = shim->uuid;
     self->actor_type = NULL;
     self->timeout = -1;
+    self->interval = 0;
+    self->interval_next = 0;
+    self->timerfd = -1;
     self->sub_filters = NULL;
+    self->batch = 1;
     self->capability = NULL;
     // initialise the status report
     self->iterations = 0;
     self->recv_time = 0;
     self->send_time = 0;
     self->status = SPHACTOR_REPORT_INIT;
-    self->reportMsg = NULL;
-    // don't use set_report as it will try to free random memory
-#if defined(__WINDOWS__)
-    InterlockedExchangePointer( (void **)(&self->atomic_report), sphactor_report_construct( self->status,
-                                                                                            self->iterations,
-                                                                                            self->recv_time,
-                                                                                            self->send_time,
-                                                                                            NULL ) );
-#else
-    atomic_store( &self->atomic_report, sphactor_report_construct( self->status,
-                                                                   self->iterations,
-                                                                   self->recv_time,
-                                                                   self->send_time,
-                                                                   NULL ) );
-#endif
+    s_report_init(&self->report);
+    self->handler_time = sphactor_histogram_new();
+    self->queue_time = sphactor_histogram_new();
+    self->timer_jitter = sphactor_histogram_new();
+    sphactor_atomic_store(&self->report_taken, -1);
+    s_report_write(self);
     if ( self->uuid == NULL)
     {
         self->uuid = zuuid_new ();
@@ -141,6 +358,9 @@ sphactor_actor_new (zsock_t *pipe, void *args)
     // create an empty list for our subscriptions
     self->subs = zhash_new();
     assert(self->subs);
+    self->connections = zlist_new();
+    zlist_autofree(self->connections);
+    zlist_comparefn(self->connections, (zlist_compare_fn *) strcmp);
 
     self->pipe = pipe;
     self->terminated = false;
@@ -148,6 +368,20 @@ sphactor_actor_new (zsock_t *pipe, void *args)
     self->poller = zpoller_new (self->pipe, NULL);
     rc = zpoller_add(self->poller, self->sub);
     assert ( rc == 0 );
+    // a pool polls our readers on our behalf so keep a copy of them
+    self->readers = zlist_new();
+    zlist_append(self->readers, self->pipe);
+    zlist_append(self->readers, self->sub);
+    self->pooled = false;
+    self->ticked = false;
+    self->fused = zlist_new();
+    self->hosted = zlist_new();
+    self->fused_to = NULL;
+    self->host = NULL;
+    sphactor_atomic_store_ptr(&self->rings_out, NULL);
+    sphactor_atomic_store_ptr(&self->mcast, NULL);
+    self->rings_in = NULL;
+    s_actors_insert(self);
 
     return self;
 }
@@ -162,28 +396,41 @@ sphactor_actor_destroy (sphactor_actor_t **self_p)
     assert (self_p);
     if (*self_p) {
         sphactor_actor_t *self = *self_p;
+        //  nobody can connect a ring to us anymore
+        s_actors_remove(self);
+
+        //  the actors fused to us can't run without our thread
+        sphactor_actor_t *hosted = (sphactor_actor_t *) zlist_first(self->hosted);
+        while ( hosted )
+        {
+            zsys_warning("sphactor_actor: destroying actor %s still fused to %s",
+                         hosted->name, self->name);
+            s_fused_finish(self, hosted);
+            hosted = (sphactor_actor_t *) zlist_first(self->hosted);
+        }
+        zlist_destroy(&self->hosted);
+        zlist_destroy(&self->fused);
+        sphactor_wheel_destroy(&self->timers);
+        sphactor_actor_set_interval(self, 0);
 
         if ( self->reporting )
         {
             self->status = SPHACTOR_REPORT_DESTROY;
-            sphactor_actor_atomic_set_report(self, sphactor_report_construct(self->status,
-                                                                             self->iterations,
-                                                                             self->recv_time,
-                                                                             self->send_time,
-                                                                             zosc_dup(self->reportMsg)));
+            s_report_write(self);
         }
 
         // signal upstream we are destroying
-        sphactor_event_t ev = { NULL, "DESTROY", self->name, zuuid_str(self->uuid), self };
+        sphactor_event_t ev = { NULL, "DESTROY", self->name, zuuid_str(self->uuid), self, SPHACTOR_EVENT_DESTROY };
         if ( self->handler )
         {
-            zmsg_t *retmsg = self->handler(&ev, self->handler_args);
+            zmsg_t *retmsg = s_handler_call(self, &ev);
             if (retmsg)
             {
                 zmsg_destroy( &retmsg );
             }
         }
         zpoller_destroy (&self->poller);
+        zlist_destroy (&self->readers);
         zuuid_destroy(&self->uuid);
         zstr_free(&self->name);
         if ( self->actor_type )
@@ -199,6 +446,12 @@ sphactor_actor_destroy (sphactor_actor_t **self_p)
             itr = (zsock_t *)zhash_next( self->subs );
         }
         zhash_destroy(&self->subs);
+        zlist_destroy(&self->connections);
+        zhash_destroy(&self->rings_in);
+        s_rings_destroy(self);
+        sphactor_mcast_t *mcast = (sphactor_mcast_t *) sphactor_atomic_load_ptr(&self->mcast);
+        sphactor_mcast_destroy(&mcast);   //  our readers hold their own reference
+        sphactor_atomic_store_ptr(&self->mcast, NULL);
 
         if (self->sub_filters)
             zlist_destroy(&self->sub_filters);
@@ -207,12 +460,12 @@ sphactor_actor_destroy (sphactor_actor_t **self_p)
         {
             zconfig_destroy(&self->capability);
         }
-        // free the atomic report
-        sphactor_report_t *rep = sphactor_actor_atomic_report(self);
-        if ( rep )
-            sphactor_report_destroy(&rep);
-
-        zosc_destroy(&self->reportMsg);
+        s_report_term(&self->report);
+        sphactor_histogram_destroy(&self->handler_time);
+        sphactor_histogram_destroy(&self->queue_time);
+        sphactor_histogram_destroy(&self->timer_jitter);
+        sphactor_trace_destroy(&self->trace);
+        sphactor_timeline_destroy(&self->timeline);
 
         //  Free object itself
         free (self);
@@ -231,10 +484,10 @@ sphactor_actor_start (sphactor_actor_t *self)
     //  Signal actor successfully initiated
     zsock_signal (self->pipe, 0);
     //  Signal handler we're initiated
-    sphactor_event_t ev = { NULL, "INIT", self->name, zuuid_str(self->uuid), self };
+    sphactor_event_t ev = { NULL, "INIT", self->name, zuuid_str(self->uuid), self, SPHACTOR_EVENT_INIT };
     if ( self->handler)
     {
-        zmsg_t *initretmsg = self->handler(&ev, self->handler_args);
+        zmsg_t *initretmsg = s_handler_call(self, &ev);
         if (initretmsg) zmsg_destroy(&initretmsg);
     }
 
@@ -260,17 +513,13 @@ sphactor_actor_stop (sphactor_actor_t *self)
     // signal our handler we're stopping
     if ( self->handler)
     {
-        sphactor_event_t ev = { NULL, "STOP", self->name, zuuid_str(self->uuid), self };
+        sphactor_event_t ev = { NULL, "STOP", self->name, zuuid_str(self->uuid), self, SPHACTOR_EVENT_STOP };
 
         self->status = SPHACTOR_REPORT_STOP;
         if ( self->reporting )
-            sphactor_actor_atomic_set_report(self, sphactor_report_construct(self->status,
-                                                                             self->iterations,
-                                                                             self->recv_time,
-                                                                             self->send_time,
-                                                                             zosc_dup(self->reportMsg)));
+            s_report_write(self);
 
-        zmsg_t *destrretmsg = self->handler(&ev, self->handler_args);
+        zmsg_t *destrretmsg = s_handler_call(self, &ev);
         if (destrretmsg) zmsg_destroy(&destrretmsg);
     }
 
@@ -286,8 +535,22 @@ sphactor_actor_connect (sphactor_actor_t *self, const char *dest)
     assert ( self);
     assert ( dest );
     assert( streq(dest, self->endpoint) == 0 );  //  endpoint should not be ours
-    int rc = zsock_connect(self->sub, "%s", dest);
-    assert(rc == 0);
+    //  our host's thread only polls its own sockets and rings
+    if ( self->host )
+    {
+        zsys_error("sphactor_actor: %s, a fused actor can't connect to %s", self->name, dest);
+        return -1;
+    }
+    int rc;
+    if ( strncmp(dest, SPHACTOR_RING_PREFIX, strlen(SPHACTOR_RING_PREFIX)) == 0 )
+        rc = s_ring_connect(self, dest);
+    else
+    {
+        rc = zsock_connect(self->sub, "%s", dest);
+        assert(rc == 0);
+    }
+    if ( rc == 0 && !zlist_exists(self->connections, (void *) dest) )
+        zlist_append(self->connections, (void *) dest);
     return rc;
 }
 
@@ -352,11 +615,317 @@ sphactor_actor_disconnect (sphactor_actor_t *self, const char *dest)
 {
     assert (self);
     assert ( self->sub );
+    zlist_remove(self->connections, (void *) dest);
+    if ( strncmp(dest, SPHACTOR_RING_PREFIX, strlen(SPHACTOR_RING_PREFIX)) == 0 )
+        return s_ring_disconnect(self, dest);
     int rc = zsock_disconnect (self->sub, "%s", dest);
     assert ( rc == 0 );
     return 0;
 }
 
+//  --------------------------------------------------------------------------
+//  Connecting through rings. An actor connecting to "ring+<endpoint>"
+//  creates a ring and attaches it to the actor bound to <endpoint>, which
+//  then pushes a copy of everything it publishes into the ring. The pub
+//  socket still sends as well for any actors connected the normal way.
+
+static void
+s_actors_lock (void)
+{
+    while ( ! sphactor_atomic_cas(&s_actors_locked, 0, 1) )
+        zclock_sleep(0);
+}
+
+static void
+s_actors_unlock (void)
+{
+    sphactor_atomic_store(&s_actors_locked, 0);
+}
+
+static void
+s_actors_insert (sphactor_actor_t *self)
+{
+    s_actors_lock();
+    if ( s_actors == NULL )
+    {
+        s_actors = zhash_new();
+        assert(s_actors);
+    }
+    int rc = zhash_insert(s_actors, self->endpoint, self);
+    assert( rc == 0 );
+    s_actors_unlock();
+}
+
+static void
+s_actors_remove (sphactor_actor_t *self)
+{
+    s_actors_lock();
+    zhash_delete(s_actors, self->endpoint);
+    if ( zhash_size(s_actors) == 0 )
+        zhash_destroy(&s_actors);
+    s_actors_unlock();
+}
+
+//  Replace the rings of an actor, call with the actors lock held
+
+static void
+s_rings_replace (sphactor_actor_t *self, ring_list_t *rings)
+{
+    rings->retired = (ring_list_t *) sphactor_atomic_load_ptr(&self->rings_out);
+    sphactor_atomic_store_ptr(&self->rings_out, rings);
+}
+
+static ring_list_t *
+s_ring_list_new (size_t size)
+{
+    ring_list_t *rings = (ring_list_t *) zmalloc(sizeof(ring_list_t) + size * sizeof(sphactor_ring_t *));
+    assert(rings);
+    return rings;
+}
+
+//  Attach to the actor bound to endpoint: a reader on its multicast ring if
+//  it has one, our own ring otherwise. Returns -1 if there is no such actor
+//  in this process.
+
+static int
+s_ring_attach (const char *endpoint, ring_in_t *in)
+{
+    s_actors_lock();
+    sphactor_actor_t *producer = s_actors ? (sphactor_actor_t *) zhash_lookup(s_actors, endpoint) : NULL;
+    if ( producer == NULL )
+    {
+        s_actors_unlock();
+        return -1;
+    }
+    in->mcast = (sphactor_mcast_t *) sphactor_atomic_load_ptr(&producer->mcast);
+    if ( in->mcast )
+    {
+        in->reader = sphactor_mcast_attach(in->mcast);
+        s_actors_unlock();
+        return 0;
+    }
+    sphactor_ring_t *ring = sphactor_ring_new(0);
+    in->ring = ring;
+    ring_list_t *old = (ring_list_t *) sphactor_atomic_load_ptr(&producer->rings_out);
+    size_t size = old ? old->size : 0;
+    ring_list_t *rings = s_ring_list_new(size + 1);
+    if ( size )
+        memcpy(rings->rings, old->rings, size * sizeof(sphactor_ring_t *));
+    sphactor_ring_ref(ring);
+    rings->rings[size] = ring;
+    rings->size = size + 1;
+    s_rings_replace(producer, rings);
+    s_actors_unlock();
+    return 0;
+}
+
+//  Drop the rings closed by the actors consuming them
+
+static void
+s_rings_prune (sphactor_actor_t *self)
+{
+    s_actors_lock();
+    ring_list_t *old = (ring_list_t *) sphactor_atomic_load_ptr(&self->rings_out);
+    ring_list_t *rings = s_ring_list_new(old->size);
+    size_t i;
+    for (i = 0; i < old->size; i++)
+    {
+        if ( sphactor_ring_closed(old->rings[i]) )
+        {
+            sphactor_ring_t *ring = old->rings[i];
+            sphactor_ring_destroy(&ring);
+        }
+        else
+            rings->rings[rings->size++] = old->rings[i];
+    }
+    s_rings_replace(self, rings);
+    s_actors_unlock();
+}
+
+//  Close and release our rings, nobody can attach anymore
+
+static void
+s_rings_destroy (sphactor_actor_t *self)
+{
+    ring_list_t *rings = (ring_list_t *) sphactor_atomic_load_ptr(&self->rings_out);
+    size_t i;
+    for (i = 0; rings && i < rings->size; i++)
+    {
+        sphactor_ring_close(rings->rings[i]);
+        sphactor_ring_destroy(&rings->rings[i]);
+    }
+    while ( rings )
+    {
+        ring_list_t *retired = rings->retired;
+        free(rings);
+        rings = retired;
+    }
+    sphactor_atomic_store_ptr(&self->rings_out, NULL);
+}
+
+//  Set the policy of our multicast ring, creating it the first time. Actors
+//  connecting to us through "ring+" from then on read from it.
+
+static void
+s_mcast_set (sphactor_actor_t *self, const char *policy)
+{
+    int mcast_policy;
+    if ( policy && streq(policy, "BLOCK") )
+        mcast_policy = SPHACTOR_MCAST_BLOCK;
+    else
+    if ( policy && streq(policy, "OVERWRITE") )
+        mcast_policy = SPHACTOR_MCAST_OVERWRITE;
+    else
+    if ( policy && streq(policy, "DROP") )
+        mcast_policy = SPHACTOR_MCAST_DROP;
+    else
+    {
+        zsys_error("sphactor_actor: %s, unknown multicast policy %s", self->name, policy ? policy : "(null)");
+        return;
+    }
+    sphactor_mcast_t *mcast = (sphactor_mcast_t *) sphactor_atomic_load_ptr(&self->mcast);
+    if ( mcast )
+        sphactor_mcast_set_policy(mcast, mcast_policy);
+    else
+    {
+        s_actors_lock();
+        sphactor_atomic_store_ptr(&self->mcast, sphactor_mcast_new(0, mcast_policy));
+        s_actors_unlock();
+    }
+}
+
+static void
+s_ring_release (void *data)
+{
+    ring_in_t *in = (ring_in_t *) data;
+    if ( in->ring )
+    {
+        sphactor_ring_close(in->ring);
+        sphactor_ring_destroy(&in->ring);
+    }
+    else
+    {
+        sphactor_mcast_detach(in->mcast, in->reader);
+        sphactor_mcast_destroy(&in->mcast);
+    }
+    free(in);
+}
+
+static void *
+s_ring_handle (ring_in_t *in)
+{
+    if ( in->ring )
+        return sphactor_ring_handle(in->ring);
+    return sphactor_mcast_handle(in->mcast, in->reader);
+}
+
+static zmsg_t *
+s_ring_pop (sphactor_actor_t *self, ring_in_t *in)
+{
+    zmsg_t *msg = NULL;
+    int64_t sent = 0;
+    if ( in->ring )
+    {
+        msg = sphactor_ring_pop(in->ring);
+        sent = msg ? sphactor_ring_time(in->ring) : 0;
+    }
+    else
+    {
+        msg = sphactor_mcast_pop(in->mcast, in->reader);
+        sent = msg ? sphactor_mcast_time(in->mcast, in->reader) : 0;
+    }
+    if ( msg && self->reporting )
+    {
+        int64_t waited = zclock_usecs() - sent;
+        sphactor_histogram_record(self->queue_time, waited > 0 ? (uint64_t) waited : 0);
+    }
+    return msg;
+}
+
+static int
+s_ring_connect (sphactor_actor_t *self, const char *dest)
+{
+    const char *endpoint = dest + strlen(SPHACTOR_RING_PREFIX);
+    assert( streq(endpoint, self->endpoint) == 0 );  //  endpoint should not be ours
+    if ( self->rings_in && zhash_lookup(self->rings_in, dest) )
+        return 0;   //  already connected
+
+    ring_in_t *in = (ring_in_t *) zmalloc(sizeof(ring_in_t));
+    assert(in);
+    if ( s_ring_attach(endpoint, in) == -1 )
+    {
+        //  not an actor in this process, connect the normal way
+        free(in);
+        zsys_warning("sphactor_actor: %s, no actor at %s to connect a ring to, using its socket", self->name, endpoint);
+        int rc = zsock_connect(self->sub, "%s", endpoint);
+        assert(rc == 0);
+        return rc;
+    }
+    if ( self->rings_in == NULL )
+    {
+        self->rings_in = zhash_new();
+        assert(self->rings_in);
+    }
+    int rc = zhash_insert(self->rings_in, dest, in);
+    assert( rc == 0 );
+    zhash_freefn(self->rings_in, dest, s_ring_release);
+    sphactor_actor_poller_add(self, s_ring_handle(in));
+    return 0;
+}
+
+static int
+s_ring_disconnect (sphactor_actor_t *self, const char *dest)
+{
+    ring_in_t *in = self->rings_in ? (ring_in_t *) zhash_lookup(self->rings_in, dest) : NULL;
+    if ( in == NULL )
+    {
+        //  we fell back to the socket when connecting
+        int rc = zsock_disconnect(self->sub, "%s", dest + strlen(SPHACTOR_RING_PREFIX));
+        assert ( rc == 0 );
+        return 0;
+    }
+    sphactor_actor_poller_remove(self, s_ring_handle(in));
+    zhash_delete(self->rings_in, dest);
+    return 0;
+}
+
+//  Return the ring we consume with this poller handle, or NULL
+
+static ring_in_t *
+s_ring_lookup (sphactor_actor_t *self, void *handle)
+{
+    if ( self->rings_in == NULL )
+        return NULL;
+    ring_in_t *in = (ring_in_t *) zhash_first(self->rings_in);
+    while ( in )
+    {
+        if ( s_ring_handle(in) == handle )
+            return in;
+        in = (ring_in_t *) zhash_next(self->rings_in);
+    }
+    return NULL;
+}
+
+//  Rings don't filter like the sub socket so match our filters here
+
+static bool
+s_filters_match (sphactor_actor_t *self, zmsg_t *msg)
+{
+    if ( self->sub_filters == NULL )
+        return true;
+    zframe_t *frame = zmsg_first(msg);
+    size_t size = frame ? zframe_size(frame) : 0;
+    char *filter = (char *) zlist_first(self->sub_filters);
+    while ( filter )
+    {
+        size_t len = strlen(filter);
+        if ( len <= size && memcmp(zframe_data(frame), filter, len) == 0 )
+            return true;
+        filter = (char *) zlist_next(self->sub_filters);
+    }
+    return false;
+}
+
 //  Return our sphactor_actor's UUID string
 //
 //  Note: sphactor_actor methods can only be called from within its instance!
@@ -384,12 +953,118 @@ sphactor_actor_timeout (sphactor_actor_t *self)
     return self->timeout;
 }
 
-void
+int
 sphactor_actor_set_timeout (sphactor_actor_t *self, int64_t timeout)
 {
+    //  our host's thread only wakes up for its own timeout
+    if ( self->host && timeout >= 0 )
+    {
+        zsys_error("sphactor_actor: %s, a fused actor has no timeout", self->name);
+        return -1;
+    }
     self->timeout = timeout;
     if (self->timeout >= 0 ) self->time_next = zclock_mono() + self->timeout;
     else self->time_next = INT64_MAX;
+    return 0;
+}
+
+//  Return the current time of the clock our timerfd uses in usecs
+
+static int64_t
+s_interval_clock (void)
+{
+#if defined (__UTYPE_LINUX)
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t) ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+#else
+    return zclock_mono() * 1000;
+#endif
+}
+
+int64_t
+sphactor_actor_interval (sphactor_actor_t *self)
+{
+    assert(self);
+    return self->interval;
+}
+
+int
+sphactor_actor_set_interval (sphactor_actor_t *self, int64_t interval)
+{
+    assert(self);
+    if ( self->host && interval > 0 )
+    {
+        zsys_error("sphactor_actor: %s, a fused actor has no interval", self->name);
+        return -1;
+    }
+    if ( self->timerfd != -1 )
+    {
+        sphactor_actor_poller_remove(self, &self->timerfd);
+        close(self->timerfd);
+        self->timerfd = -1;
+    }
+    self->interval = interval > 0 ? interval : 0;
+    if ( self->interval == 0 )
+        return 0;
+
+    self->interval_next = s_interval_clock() + self->interval;
+#if defined (__UTYPE_LINUX)
+    //  the timerfd fires on absolute deadlines so our handler's run time
+    //  doesn't add up to drift, the poller wakes us when it is readable
+    self->timerfd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    assert(self->timerfd != -1);
+    struct itimerspec spec;
+    spec.it_value.tv_sec = (time_t) (self->interval_next / 1000000);
+    spec.it_value.tv_nsec = (long) (self->interval_next % 1000000) * 1000;
+    spec.it_interval.tv_sec = (time_t) (self->interval / 1000000);
+    spec.it_interval.tv_nsec = (long) (self->interval % 1000000) * 1000;
+    int rc = timerfd_settime(self->timerfd, TFD_TIMER_ABSTIME, &spec, NULL);
+    assert(rc == 0);
+    sphactor_actor_poller_add(self, &self->timerfd);
+#endif
+    return 0;
+}
+
+int
+sphactor_actor_timer_add (sphactor_actor_t *self, int64_t delay, int64_t interval)
+{
+    assert(self);
+    assert(delay >= 0 && interval >= 0);
+    if ( self->host )
+    {
+        zsys_error("sphactor_actor: %s, a fused actor has no timers", self->name);
+        return -1;
+    }
+    int64_t now = zclock_mono();
+    if ( self->timers == NULL )
+        self->timers = sphactor_wheel_new(now);
+    return sphactor_wheel_add(self->timers, now + delay, interval);
+}
+
+int
+sphactor_actor_timer_cancel (sphactor_actor_t *self, int id)
+{
+    assert(self);
+    if ( self->timers == NULL )
+        return -1;
+    return sphactor_wheel_cancel(self->timers, id);
+}
+
+//  Return when we need to wake up next, for our timeout or our timers
+
+static int64_t
+s_time_next (sphactor_actor_t *self)
+{
+    int64_t wheel_next = self->timers ? sphactor_wheel_next(self->timers) : INT64_MAX;
+    int64_t next = wheel_next < self->time_next ? wheel_next : self->time_next;
+#if !defined (__UTYPE_LINUX)
+    //  without a timerfd we wake up for our interval ourselves, the poller
+    //  only waits in msecs so round its deadline up
+    if ( self->interval > 0 && (self->interval_next + 999) / 1000 < next )
+        next = (self->interval_next + 999) / 1000;
+#endif
+    return next;
 }
 
 int
@@ -399,6 +1074,7 @@ sphactor_actor_poller_add (sphactor_actor_t *self, void *sockfd)
     assert(sockfd);
     int rc = zpoller_add(self->poller, sockfd);
     assert(rc == 0);
+    zlist_append(self->readers, sockfd);
     return rc;
 }
 
@@ -408,6 +1084,8 @@ sphactor_actor_poller_remove (sphactor_actor_t *self, void * sockfd)
     assert(self);
     assert(sockfd);
     int rc = zpoller_remove(self->poller, sockfd);
+    if ( rc == 0 )
+        zlist_remove(self->readers, sockfd);
     return rc;
 }
 
@@ -431,44 +1109,217 @@ sphactor_actor_set_capability (sphactor_actor_t *self, zconfig_t *capability)
 void
 sphactor_actor_atomic_set_report( sphactor_actor_t *self, sphactor_report_t *report)
 {
-    // swap the report pointer atomically
-#if defined(__WINDOWS__)
-    sphactor_report_t *prev = (sphactor_report_t *)InterlockedExchangePointer( (void **)(&self->atomic_report), (void *)report);
-#else
-    sphactor_report_t *prev = (sphactor_report_t *)atomic_exchange( &self->atomic_report, (void *)report);
-#endif
-    
-    // if prev is not NULL we need to destroy it
-    if ( prev != (sphactor_report_t *)NULL )
-    {
-        // destroy the memory it is pointing to
-        sphactor_report_destroy( &prev );
-    }
-    // TODO: for memory efficiency we could reuse the report object?
+    assert(report);
+    s_report_store(&self->report, sphactor_report_status(report),
+                                  sphactor_report_iterations(report),
+                                  sphactor_report_recv_time(report),
+                                  sphactor_report_send_time(report));
+    zosc_t *custom = sphactor_report_custom(report);
+    sphactor_actor_set_custom_report_data(self, custom ? zosc_dup(custom) : NULL);
+    sphactor_report_destroy(&report);
 }
 
 sphactor_report_t *
 sphactor_actor_atomic_report(sphactor_actor_t *self)
 {
     if ( !self->reporting ) return NULL;   // reporting is disabled
-    // swap the report pointer atomically with NULL
-#if defined(__WINDOWS__)
-    sphactor_report_t *report = (sphactor_report_t *)InterlockedExchangePointer( (void **)(&self->atomic_report), (void *)NULL );
-#else
-    sphactor_report_t *report = (sphactor_report_t *)atomic_exchange( &self->atomic_report, (void *)NULL );
-#endif
-    // we now own report so the caller must destroy when finished with it
-    // unless it's null of course
+    // only return a report if it changed since one was last taken, and
+    // only to one caller if several take it at once
+    int64_t seq = sphactor_atomic_load(&self->report.seq);
+    int64_t taken = sphactor_atomic_load(&self->report_taken);
+    if ( seq == taken || ! sphactor_atomic_cas(&self->report_taken, taken, seq) )
+        return NULL;
+    // the caller owns the report and must destroy it when finished with it,
+    // use sphactor_actor_report_snapshot to reuse a report instead
+    sphactor_report_t *report = sphactor_report_new();
+    sphactor_actor_report_snapshot(self, report);
     return report;
 }
 
+int
+sphactor_actor_report_snapshot(sphactor_actor_t *self, sphactor_report_t *report)
+{
+    assert(self);
+    assert(report);
+    if ( !self->reporting ) return -1;   // reporting is disabled
+
+    report_state_t *state = &self->report;
+    int64_t status, iterations, recv_time, send_time, version, current;
+    char *custom = NULL;        // copy of the custom data if it changed
+    size_t custom_size = 0;
+    size_t custom_max = 0;      // allocated size of our copy
+    int spins = 0;
+    while (true)
+    {
+        int64_t seq = sphactor_atomic_load(&state->seq);
+        if ( seq & 1 )
+        {
+            // the actor is writing, it won't take long unless it was
+            // preempted, then let it run
+            if ( ++spins > SPHACTOR_REPORT_SPINS )
+                zclock_sleep(0);
+            else
+                sphactor_atomic_pause();
+            continue;
+        }
+        status = sphactor_atomic_load_relaxed(&state->status);
+        iterations = sphactor_atomic_load_relaxed(&state->iterations);
+        recv_time = sphactor_atomic_load_relaxed(&state->recv_time);
+        send_time = sphactor_atomic_load_relaxed(&state->send_time);
+        version = sphactor_atomic_load_relaxed(&state->custom_version);
+        current = sphactor_atomic_load_relaxed(&state->custom_current);
+        custom_size = 0;
+        size_t needed = 0;
+        if ( (uint64_t) version != sphactor_report_custom_version(report) && current >= 0 )
+        {
+            //  the buffer stays allocated even if the actor outgrows it,
+            //  a size beyond its capacity is torn and seq will have changed
+            report_custom_t *buffer = (report_custom_t *) sphactor_atomic_load_ptr(&state->custom[current]);
+            needed = buffer ? (size_t) sphactor_atomic_load_relaxed(&buffer->size) : 0;
+            if ( buffer && needed > buffer->capacity )
+                needed = buffer->capacity;
+            if ( needed > 0 && needed <= custom_max )
+            {
+                memcpy(custom, buffer->data, needed);
+                custom_size = needed;
+            }
+        }
+        sphactor_atomic_fence();
+        if ( sphactor_atomic_load_relaxed(&state->seq) != seq )
+            continue;
+        if ( needed <= custom_max )
+            break;
+        //  grow our copy outside of the copying and try again
+        custom = (char *) realloc(custom, needed);
+        assert(custom);
+        custom_max = needed;
+    }
+    sphactor_report_set_status(report, (int) status);
+    sphactor_report_set_iterations(report, (uint64_t) iterations);
+    sphactor_report_set_recv_time(report, recv_time);
+    sphactor_report_set_send_time(report, send_time);
+    if ( (uint64_t) version != sphactor_report_custom_version(report) )
+    {
+        // zosc takes ownership of our copy
+        if ( current == -1 )
+            zstr_free(&custom);
+        sphactor_report_set_custom(report, custom ? zosc_frommem(custom, custom_size) : NULL);
+        sphactor_report_set_custom_version(report, (uint64_t) version);
+    }
+    else
+        zstr_free(&custom);
+
+    // add how far behind the readers of our multicast ring are
+    sphactor_mcast_t *mcast = (sphactor_mcast_t *) sphactor_atomic_load_ptr(&self->mcast);
+    size_t readers = mcast ? sphactor_mcast_readers(mcast) : 0;
+    sphactor_report_set_readers(report, readers);
+    size_t reader;
+    for (reader = 0; reader < readers; reader++)
+        sphactor_report_set_lag(report, reader, sphactor_mcast_reader_lag(mcast, reader));
+    return 0;
+}
+
+int
+sphactor_actor_latency_snapshot(sphactor_actor_t *self, sphactor_report_t *report)
+{
+    assert(self);
+    assert(report);
+    if ( sphactor_actor_report_snapshot(self, report) == -1 )
+        return -1;
+    sphactor_histogram_copy(self->handler_time, sphactor_report_handler_time(report));
+    sphactor_histogram_copy(self->queue_time, sphactor_report_queue_time(report));
+    sphactor_histogram_copy(self->timer_jitter, sphactor_report_timer_jitter(report));
+    return 0;
+}
+
 // Stores an osc message that becomes the report_custom
 void sphactor_actor_set_custom_report_data(sphactor_actor_t *self, zosc_t* message )
 {
-    zosc_t *prev = self->reportMsg;
-    self->reportMsg = message;
-    if ( prev != NULL)
-        zosc_destroy(&prev);
+    report_state_t *state = &self->report;
+    int64_t current = sphactor_atomic_load_relaxed(&state->custom_current);
+    int64_t next = -1;
+    if ( message == NULL && current == -1 )
+        return;     //  we had no custom data either
+
+    int64_t seq = sphactor_atomic_load_relaxed(&state->seq);
+    sphactor_atomic_store_relaxed(&state->seq, seq + 1);
+    sphactor_atomic_fence();    //  odd before the buffers change
+    if ( message )
+    {
+        //  fill the buffer the controller isn't reading, it only reads this
+        //  one if it is slow and then finds seq changed when done
+        next = current == 0 ? 1 : 0;
+        report_custom_t *buffer = (report_custom_t *) sphactor_atomic_load_ptr_relaxed(&state->custom[next]);
+        size_t size = zosc_size(message);
+        if ( buffer == NULL || size > buffer->capacity )
+        {
+            if ( buffer )
+                zlist_append(state->retired, buffer);
+            size_t capacity = size * 2;
+            buffer = (report_custom_t *) zmalloc(sizeof(report_custom_t) + capacity);
+            assert(buffer);
+            buffer->capacity = capacity;
+            sphactor_atomic_store_ptr(&state->custom[next], buffer);
+        }
+        memcpy(buffer->data, zosc_data(message), size);
+        sphactor_atomic_store_relaxed(&buffer->size, (int64_t) size);
+        zosc_destroy(&message);
+    }
+    sphactor_atomic_store_relaxed(&state->custom_current, next);
+    sphactor_atomic_store_relaxed(&state->custom_version, sphactor_atomic_load_relaxed(&state->custom_version) + 1);
+    sphactor_atomic_store(&state->seq, seq + 2);
+}
+
+static void
+s_report_init (report_state_t *state)
+{
+    memset(state, 0, sizeof(report_state_t));
+    sphactor_atomic_store(&state->seq, 0);
+    sphactor_atomic_store(&state->custom_version, 0);
+    sphactor_atomic_store(&state->custom_current, -1);
+    int i;
+    for (i = 0; i < 2; i++)
+        sphactor_atomic_store_ptr(&state->custom[i], NULL);
+    state->retired = zlist_new();
+    assert(state->retired);
+}
+
+static void
+s_report_term (report_state_t *state)
+{
+    int i;
+    for (i = 0; i < 2; i++)
+        free(sphactor_atomic_load_ptr(&state->custom[i]));
+    void *retired = zlist_pop(state->retired);
+    while ( retired )
+    {
+        free(retired);
+        retired = zlist_pop(state->retired);
+    }
+    zlist_destroy(&state->retired);
+}
+
+//  Store a new report, only the actor's thread may call this
+
+static void
+s_report_store (report_state_t *state, int status, uint64_t iterations, int64_t recv_time, int64_t send_time)
+{
+    int64_t seq = sphactor_atomic_load_relaxed(&state->seq);
+    sphactor_atomic_store_relaxed(&state->seq, seq + 1);
+    sphactor_atomic_fence();    //  odd before the report changes
+    sphactor_atomic_store_relaxed(&state->status, status);
+    sphactor_atomic_store_relaxed(&state->iterations, (int64_t) iterations);
+    sphactor_atomic_store_relaxed(&state->recv_time, recv_time);
+    sphactor_atomic_store_relaxed(&state->send_time, send_time);
+    sphactor_atomic_store(&state->seq, seq + 2);
+}
+
+//  Report our current state
+
+static void
+s_report_write (sphactor_actor_t *self)
+{
+    s_report_store(&self->report, self->status, self->iterations, self->recv_time, self->send_time);
 }
 
 // The actor can receive API messages through non pipe sockets
@@ -485,215 +1336,495 @@ s_sphactor_actor_is_api_msg( zmsg_t *msg)
     return -1;
 }
 
-//  Here we handle incoming (API) messages from the pipe from the controller (main thread)
-static zmsg_t *
-sphactor_actor_recv_api (sphactor_actor_t *self, zmsg_t **request_p)
+//  Pop an integer argument, a native int64_t frame in a binary command or
+//  a decimal string otherwise. Returns the fallback if there is none.
+static int64_t
+s_api_pop_int (zmsg_t *request, bool binary, int64_t fallback)
 {
-    //  update our status report 7=API
-    zmsg_t *request = *request_p;
-    assert(request);
-    self->status = SPHACTOR_REPORT_API;
-    if ( self->reporting )
-        sphactor_actor_atomic_set_report(self, sphactor_report_construct(self->status,
-                                                                           self->iterations,
-                                                                           self->recv_time,
-                                                                           self->send_time,
-                                                                           zosc_dup(self->reportMsg)));
-    zmsg_t *retmsg = NULL; // our message to return
-    char *command = zmsg_popstr (request);
-    if (self->verbose ) zsys_info("command: %s", command);
-    if (streq (command, "START"))
-        sphactor_actor_start (self);
-    else
-    if (streq (command, "STOP"))
-        sphactor_actor_stop (self);
-    else
-    if (streq (command, "INSTANCE"))
+    int64_t value = fallback;
+    if (binary)
     {
-        // Danger: this method will send the 'self' pointer
-        // over the pipe, internal use only!
-        retmsg = zmsg_new();
-        zmsg_addmem(retmsg, &self, sizeof(void *));
+        zframe_t *frame = zmsg_pop (request);
+        if (frame && zframe_size (frame) == sizeof (int64_t))
+            memcpy (&value, zframe_data (frame), sizeof (int64_t));
+        zframe_destroy (&frame);
     }
     else
-    if (streq (command, "CONNECT"))
     {
-        char *dest = zmsg_popstr (request);
-        int rc = sphactor_actor_connect (self, dest);
-        assert( rc == 0 );
-        retmsg = zmsg_new();
-        zmsg_addstr(retmsg, "CONNECTED");
-        zmsg_addstr(retmsg, dest);
-        zmsg_addstrf(retmsg, "%i", rc);
-        zstr_free(&dest);
+        char *str = zmsg_popstr (request);
+        if (str)
+            value = (int64_t) atoll (str);
+        zstr_free (&str);
     }
-    else
-    if (streq (command, "DISCONNECT"))
+    return value;
+}
+
+//  Pop a boolean argument, a single byte in a binary command or a string
+//  which is true unless it says "FALSE". Returns the fallback if there is
+//  none.
+static bool
+s_api_pop_bool (zmsg_t *request, bool binary, bool fallback)
+{
+    bool value = fallback;
+    if (binary)
     {
-        char *dest = zmsg_popstr (request);
-        int rc = sphactor_actor_disconnect (self, dest);
-        retmsg = zmsg_new();
-        zmsg_addstr(retmsg, "DISCONNECTED");
-        zmsg_addstr(retmsg, dest);
-        zmsg_addstrf(retmsg, "%i", rc);
-        zstr_free(&dest);
+        zframe_t *frame = zmsg_pop (request);
+        if (frame && zframe_size (frame) == 1)
+            value = zframe_data (frame) [0] != 0;
+        zframe_destroy (&frame);
     }
     else
-    if (streq (command, "FILTERS"))
     {
-        zlist_t *filters = sphactor_actor_filters(self);
-        retmsg = zmsg_new();
-        if (filters)
-        {
-            char *f = (char *)zlist_first(filters);
-            while(f != NULL)
-            {
-                zmsg_addstr(retmsg, f);
-                f = (char *)zlist_next(filters);
-            }
-        }
-        else
+        char *str = zmsg_popstr (request);
+        if (str)
+            value = !streq (str, "FALSE");
+        zstr_free (&str);
+    }
+    return value;
+}
+
+//  Built-in commands, each handler gets the request without its command
+//  frame and returns the reply or NULL.
+
+static zmsg_t *
+s_api_start (sphactor_actor_t *self, zmsg_t *request, bool binary)
+{
+    sphactor_actor_start (self);
+    return NULL;
+}
+
+static zmsg_t *
+s_api_stop (sphactor_actor_t *self, zmsg_t *request, bool binary)
+{
+    sphactor_actor_stop (self);
+    return NULL;
+}
+
+static zmsg_t *
+s_api_instance (sphactor_actor_t *self, zmsg_t *request, bool binary)
+{
+    // Danger: this method will send the 'self' pointer
+    // over the pipe, internal use only!
+    zmsg_t *retmsg = zmsg_new();
+    zmsg_addmem(retmsg, &self, sizeof(void *));
+    return retmsg;
+}
+
+static zmsg_t *
+s_api_connect (sphactor_actor_t *self, zmsg_t *request, bool binary)
+{
+    char *dest = zmsg_popstr (request);
+    int rc = sphactor_actor_connect (self, dest);
+    zmsg_t *retmsg = zmsg_new();
+    zmsg_addstr(retmsg, "CONNECTED");
+    zmsg_addstr(retmsg, dest);
+    zmsg_addstrf(retmsg, "%i", rc);
+    zstr_free(&dest);
+    return retmsg;
+}
+
+static zmsg_t *
+s_api_disconnect (sphactor_actor_t *self, zmsg_t *request, bool binary)
+{
+    char *dest = zmsg_popstr (request);
+    int rc = sphactor_actor_disconnect (self, dest);
+    zmsg_t *retmsg = zmsg_new();
+    zmsg_addstr(retmsg, "DISCONNECTED");
+    zmsg_addstr(retmsg, dest);
+    zmsg_addstrf(retmsg, "%i", rc);
+    zstr_free(&dest);
+    return retmsg;
+}
+
+static zmsg_t *
+s_api_filters (sphactor_actor_t *self, zmsg_t *request, bool binary)
+{
+    zlist_t *filters = sphactor_actor_filters(self);
+    zmsg_t *retmsg = zmsg_new();
+    if (filters)
+    {
+        char *f = (char *)zlist_first(filters);
+        while(f != NULL)
         {
-            zframe_t *f = zframe_new_empty();
-            zmsg_append(retmsg, &f);
+            zmsg_addstr(retmsg, f);
+            f = (char *)zlist_next(filters);
         }
     }
     else
-    if (streq (command, "FILTER ADD"))
     {
-        char *filter = zmsg_popstr (request);
-        assert(filter);
-        sphactor_actor_filter_add(self, filter);
-        zstr_free(&filter);
+        zframe_t *f = zframe_new_empty();
+        zmsg_append(retmsg, &f);
     }
+    return retmsg;
+}
+
+static zmsg_t *
+s_api_filter_add (sphactor_actor_t *self, zmsg_t *request, bool binary)
+{
+    char *filter = zmsg_popstr (request);
+    assert(filter);
+    sphactor_actor_filter_add(self, filter);
+    zstr_free(&filter);
+    return NULL;
+}
+
+static zmsg_t *
+s_api_filter_remove (sphactor_actor_t *self, zmsg_t *request, bool binary)
+{
+    char *filter = zmsg_popstr (request);
+    assert(filter);
+    sphactor_actor_filter_remove(self, filter);
+    zstr_free(&filter);
+    return NULL;
+}
+
+static zmsg_t *
+s_api_uuid (sphactor_actor_t *self, zmsg_t *request, bool binary)
+{
+    zmsg_t *retmsg = zmsg_new();
+    zmsg_addmem (retmsg, zuuid_data (self->uuid), zuuid_size (self->uuid));
+    return retmsg;
+}
+
+static zmsg_t *
+s_api_name (sphactor_actor_t *self, zmsg_t *request, bool binary)
+{
+    zmsg_t *retmsg = zmsg_new();
+    zmsg_addstr( retmsg, self->name );
+    return retmsg;
+}
+
+static zmsg_t *
+s_api_type (sphactor_actor_t *self, zmsg_t *request, bool binary)
+{
+    zmsg_t *retmsg = zmsg_new();
+    zmsg_addstr( retmsg, self->actor_type ? self->actor_type : "" );
+    return retmsg;
+}
+
+static zmsg_t *
+s_api_endpoint (sphactor_actor_t *self, zmsg_t *request, bool binary)
+{
+    zmsg_t *retmsg = zmsg_new();
+    zmsg_addstr( retmsg, self->endpoint );
+    return retmsg;
+}
+
+static zmsg_t *
+s_api_send (sphactor_actor_t *self, zmsg_t *request, bool binary)
+{
+    zmsg_t *msg = NULL;
+    if (zmsg_size(request) > 0 )
+        msg = sphactor_payload_msg_dup(request);
     else
-    if (streq (command, "FILTER REMOVE"))
     {
-        char *filter = zmsg_popstr (request);
-        assert(filter);
-        sphactor_actor_filter_remove(self, filter);
-        zstr_free(&filter);
+        msg = zmsg_new();
+        zmsg_addstr(msg, self->name);
     }
-    else
-    if (streq (command, "UUID"))
+    s_publish_msg(self, msg);
+    return NULL;
+}
+
+static zmsg_t *
+s_api_trigger (sphactor_actor_t *self, zmsg_t *request, bool binary)
+{
+    //  trigger the actor to run its callback
+    sphactor_event_t ev = { NULL, "SOCK", self->name, zuuid_str(self->uuid), self, SPHACTOR_EVENT_SOCK };
+    zmsg_t *pubmsg = s_handler_call(self, &ev);
+    if (pubmsg)
     {
-        retmsg = zmsg_new();
-        zmsg_addmem (retmsg, zuuid_data (self->uuid), zuuid_size (self->uuid));
+        // publish the msg
+        s_publish_msg(self, pubmsg);
     }
-    else
-    if (streq (command, "NAME"))
-    {
-        retmsg = zmsg_new();
-        zmsg_addstr( retmsg, self->name );
+    zmsg_destroy( &pubmsg );
+    return NULL;
+}
+
+static zmsg_t *
+s_api_set_name (sphactor_actor_t *self, zmsg_t *request, bool binary)
+{
+    //TODO: There are two cases here, if it was set from a string literal, this crashes
+    //  if it was allocated, and we skip this, it leaks
+    if ( self->name != NULL ) {
+        zstr_free(&self->name);
     }
-    else
-    if (streq (command, "TYPE"))
-    {
-        retmsg = zmsg_new();
-        zmsg_addstr( retmsg, self->actor_type ? self->actor_type : "" );
+    self->name = zmsg_popstr(request);
+    assert(self->name);
+    return NULL;
+}
+
+static zmsg_t *
+s_api_set_type (sphactor_actor_t *self, zmsg_t *request, bool binary)
+{
+    if ( self->actor_type != NULL ) {
+        zstr_free(&self->actor_type);
     }
-    else
-    if (streq (command, "ENDPOINT"))
+    self->actor_type = zmsg_popstr(request);
+    assert(self->actor_type);
+    return NULL;
+}
+
+static zmsg_t *
+s_api_set_verbose (sphactor_actor_t *self, zmsg_t *request, bool binary)
+{
+    self->verbose = s_api_pop_bool(request, binary, false);
+    return NULL;
+}
+
+static zmsg_t *
+s_api_set_reporting (sphactor_actor_t *self, zmsg_t *request, bool binary)
+{
+    self->reporting = s_api_pop_bool(request, binary, true);
+    return NULL;
+}
+
+static zmsg_t *
+s_api_set_multicast (sphactor_actor_t *self, zmsg_t *request, bool binary)
+{
+    char *policy = zmsg_popstr(request);
+    s_mcast_set(self, policy);
+    zstr_free(&policy);
+    return NULL;
+}
+
+static zmsg_t *
+s_api_reset_latency (sphactor_actor_t *self, zmsg_t *request, bool binary)
+{
+    sphactor_histogram_reset(self->handler_time);
+    sphactor_histogram_reset(self->queue_time);
+    sphactor_histogram_reset(self->timer_jitter);
+    return NULL;
+}
+
+static zmsg_t *
+s_api_set_batch (sphactor_actor_t *self, zmsg_t *request, bool binary)
+{
+    int64_t batch = s_api_pop_int(request, binary, 1);
+    if ( batch < 1 )
+        batch = 1;
+    if ( batch > SPHACTOR_BATCH_MAX )
     {
-        retmsg = zmsg_new();
-        zmsg_addstr( retmsg, self->endpoint );
+        zsys_warning("sphactor_actor: %s, batch size %d exceeds %d", self->name, (int) batch, SPHACTOR_BATCH_MAX);
+        batch = SPHACTOR_BATCH_MAX;
     }
+    self->batch = (size_t) batch;
+    self->batch_events = s_api_pop_bool(request, binary, false);
+    return NULL;
+}
+
+static zmsg_t *
+s_api_set_tracing (sphactor_actor_t *self, zmsg_t *request, bool binary)
+{
+    self->tracing = s_api_pop_bool(request, binary, false);
+    if ( self->tracing )
+        sphactor_atomic_store(&s_traced, 1);
+    return NULL;
+}
+
+static zmsg_t *
+s_api_set_timeout (sphactor_actor_t *self, zmsg_t *request, bool binary)
+{
+    sphactor_actor_set_timeout( self, s_api_pop_int(request, binary, -1) );
+    return NULL;
+}
+
+static zmsg_t *
+s_api_timeout (sphactor_actor_t *self, zmsg_t *request, bool binary)
+{
+    zmsg_t *retmsg = zmsg_new();
+    if (binary)
+        zmsg_addmem( retmsg, &self->timeout, sizeof(self->timeout) );
     else
-    if (streq (command, "SEND"))
+        zmsg_addstrf( retmsg, "%" PRId64, self->timeout);
+    return retmsg;
+}
+
+static zmsg_t *
+s_api_capability (sphactor_actor_t *self, zmsg_t *request, bool binary)
+{
+    // Danger: this method will send the 'self' pointer
+    // over the pipe, internal use only!
+    zmsg_t *retmsg = zmsg_new();
+    zmsg_addmem(retmsg, &self->capability, sizeof(void *));
+    return retmsg;
+}
+
+static zmsg_t *
+    sphactor_actor_recv_api (sphactor_actor_t *self, zmsg_t **request_p);
+
+static zmsg_t *
+s_api_batch (sphactor_actor_t *self, zmsg_t *request, bool binary)
+{
+    assert(binary);     //  there is no string form, see sphactor_command.h
+    //  each command is preceded by its number of frames
+    while ( zmsg_size(request) > 0 )
     {
-        if (zmsg_size(request) > 0 )
+        int64_t frames = s_api_pop_int(request, true, 0);
+        zmsg_t *command = zmsg_new();
+        while ( frames-- > 0 && zmsg_size(request) > 0 )
         {
-            zmsg_t *dup = zmsg_dup(request);
-            zmsg_send(&dup, self->pub);
+            zframe_t *frame = zmsg_pop(request);
+            zmsg_append(command, &frame);
         }
-        else
-            zstr_send ( self->pub, self->name );
-        self->send_time = zclock_mono();
-    }
-    else
-    if (streq (command, "TRIGGER"))     //  trigger the actor to run its callback
-    {
-        sphactor_event_t ev = { NULL, "SOCK", self->name, zuuid_str(self->uuid) };
-        zmsg_t *pubmsg = self->handler( &ev, self->handler_args);
-        if (pubmsg)
+        if ( zmsg_size(command) == 0 )
         {
-            // publish the msg
-            s_publish_msg(self, pubmsg);
+            zmsg_destroy(&command);
+            continue;
         }
-        zmsg_destroy( &pubmsg );
+        //  the handler owns the command if it is passed on to it
+        zmsg_t *reply = sphactor_actor_recv_api(self, &command);
+        zmsg_destroy(&reply);
     }
-    else
-    if (streq (command, "SET NAME"))
-    {
-        //TODO: There are two cases here, if it was set from a string literal, this crashes
-        //  if it was allocated, and we skip this, it leaks
-        if ( self->name != NULL ) {
-            zstr_free(&self->name);
-        }
-        self->name = zmsg_popstr(request);
-        assert(self->name);
-    }
-    else
-    if (streq (command, "SET TYPE"))
-    {
-        if ( self->actor_type != NULL ) {
-            zstr_free(&self->actor_type);
-        }
-        self->actor_type = zmsg_popstr(request);
-        assert(self->actor_type);
-    }
-    else
-    if (streq (command, "SET VERBOSE"))
+    return NULL;
+}
+
+//  Handle the messages waiting on our sub socket and rings, until there are
+//  none or the timeout in msecs passed. Replies the number handled.
+
+static zmsg_t *
+s_api_drain (sphactor_actor_t *self, zmsg_t *request, bool binary)
+{
+    int64_t timeout = s_api_pop_int(request, binary, 0);
+    int64_t deadline = timeout >= 0 ? zclock_mono() + timeout : INT64_MAX;
+    int64_t drained = 0;
+    while ( zclock_mono() < deadline )
     {
-        char *cmd = zmsg_popstr(request);
-        if ( cmd )
-        {
-            if ( streq(cmd, "FALSE" ) )
-                self->verbose = false;
-            else
-                self->verbose = true;
-            zstr_free( &cmd );
-        }
+        zmsg_t *msg = NULL;
+        ring_in_t *ring = NULL;
+        if ( zsock_events(self->sub) & ZMQ_POLLIN )
+            msg = zmsg_recv(self->sub);
         else
-            self->verbose = false;
-    }
-    else
-    if (streq (command, "SET REPORTING" ))  // Toggle report
-    {
-        char *cmd = zmsg_popstr(request);
-        if ( cmd )
         {
-            if ( streq(cmd, "FALSE" ) )
-                self->reporting = false;
-            else
-                self->reporting = true;
-            zstr_free( &cmd );
+            ring = self->rings_in ? (ring_in_t *) zhash_first(self->rings_in) : NULL;
+            while ( ring && (msg = s_ring_pop(self, ring)) == NULL )
+                ring = (ring_in_t *) zhash_next(self->rings_in);
         }
+        if ( msg == NULL )
+            break;
+        if ( ring && !s_filters_match(self, msg) )
+            zmsg_destroy(&msg);
         else
-            self->reporting = true;
+            s_handle_sock_msg(self, msg, ring);
+        drained++;
     }
+    zmsg_t *retmsg = zmsg_new();
+    if (binary)
+        zmsg_addmem( retmsg, &drained, sizeof(drained) );
     else
-    if (streq (command, "SET TIMEOUT"))
+        zmsg_addstrf( retmsg, "%" PRId64, drained);
+    return retmsg;
+}
+
+//  Run the actor in the request in our thread and call its handler with
+//  every message we publish. It has been started without a thread of its
+//  own, see sphactor_new_fused. A sphactor_tick runs the handlers of its
+//  actors itself and never polls their readers, so we refuse it then.
+
+static zmsg_t *
+s_api_fuse (sphactor_actor_t *self, zmsg_t *request, bool binary)
+{
+    assert(binary);     //  there is no string form, see sphactor_command.h
+    zframe_t *frame = zmsg_pop(request);
+    assert(frame && zframe_size(frame) == sizeof(void *));
+    sphactor_actor_t *fused = *(sphactor_actor_t **) zframe_data(frame);
+    zframe_destroy(&frame);
+    assert(fused && fused != self);
+    assert(fused->host == NULL);
+    //  an actor fused to a fused actor runs in the thread of the chain
+    sphactor_actor_t *host = self->host ? self->host : self;
+    zmsg_t *retmsg = zmsg_new();
+    zmsg_addstr(retmsg, "FUSED");
+    if ( host->ticked )
     {
-        char *rate =  zmsg_popstr(request);
-        //  rate is per second, timeout is in ms
-        sphactor_actor_set_timeout( self, (int64_t) atol(rate) );
-        zstr_free(&rate);
+        zmsg_addstr(retmsg, "-1");
+        return retmsg;
     }
-    else
-    if (streq (command, "TIMEOUT"))
+    fused->host = host;
+    fused->fused_to = self;
+    zlist_append(self->fused, fused);
+    zlist_append(host->hosted, fused);
+    int rc = sphactor_actor_poller_add(host, fused->pipe);
+    zmsg_addstrf(retmsg, "%i", rc);
+    return retmsg;
+}
+
+static zmsg_t *
+s_api_set_interval (sphactor_actor_t *self, zmsg_t *request, bool binary)
+{
+    sphactor_actor_set_interval( self, s_api_pop_int(request, binary, 0) );
+    return NULL;
+}
+
+//  Command handlers indexed by opcode, see sphactor_command.h for the
+//  opcodes. Keep both in the same order!
+typedef zmsg_t * (s_api_fn) (sphactor_actor_t *self, zmsg_t *request, bool binary);
+
+static s_api_fn *s_api_commands [SPHACTOR_COMMAND_COUNT] = {
+    NULL,
+    s_api_start,            //  SPHACTOR_COMMAND_START
+    s_api_stop,             //  SPHACTOR_COMMAND_STOP
+    s_api_instance,         //  SPHACTOR_COMMAND_INSTANCE
+    s_api_connect,          //  SPHACTOR_COMMAND_CONNECT
+    s_api_disconnect,       //  SPHACTOR_COMMAND_DISCONNECT
+    s_api_filters,          //  SPHACTOR_COMMAND_FILTERS
+    s_api_filter_add,       //  SPHACTOR_COMMAND_FILTER_ADD
+    s_api_filter_remove,    //  SPHACTOR_COMMAND_FILTER_REMOVE
+    s_api_uuid,             //  SPHACTOR_COMMAND_UUID
+    s_api_name,             //  SPHACTOR_COMMAND_NAME
+    s_api_type,             //  SPHACTOR_COMMAND_TYPE
+    s_api_endpoint,         //  SPHACTOR_COMMAND_ENDPOINT
+    s_api_send,             //  SPHACTOR_COMMAND_SEND
+    s_api_trigger,          //  SPHACTOR_COMMAND_TRIGGER
+    s_api_set_name,         //  SPHACTOR_COMMAND_SET_NAME
+    s_api_set_type,         //  SPHACTOR_COMMAND_SET_TYPE
+    s_api_set_verbose,      //  SPHACTOR_COMMAND_SET_VERBOSE
+    s_api_set_reporting,    //  SPHACTOR_COMMAND_SET_REPORTING
+    s_api_set_multicast,    //  SPHACTOR_COMMAND_SET_MULTICAST
+    s_api_reset_latency,    //  SPHACTOR_COMMAND_RESET_LATENCY
+    s_api_set_batch,        //  SPHACTOR_COMMAND_SET_BATCH
+    s_api_set_tracing,      //  SPHACTOR_COMMAND_SET_TRACING
+    s_api_set_timeout,      //  SPHACTOR_COMMAND_SET_TIMEOUT
+    s_api_timeout,          //  SPHACTOR_COMMAND_TIMEOUT
+    s_api_capability,       //  SPHACTOR_COMMAND_CAPABILITY
+    s_api_batch,            //  SPHACTOR_COMMAND_BATCH
+    s_api_drain,            //  SPHACTOR_COMMAND_DRAIN
+    s_api_fuse,             //  SPHACTOR_COMMAND_FUSE
+    s_api_set_interval      //  SPHACTOR_COMMAND_SET_INTERVAL
+};
+
+//  Here we handle incoming (API) messages from the pipe from the controller (main thread)
+static zmsg_t *
+sphactor_actor_recv_api (sphactor_actor_t *self, zmsg_t **request_p)
+{
+    //  update our status report 7=API
+    zmsg_t *request = *request_p;
+    assert(request);
+    self->status = SPHACTOR_REPORT_API;
+    if ( self->reporting )
+        s_report_write(self);
+    zmsg_t *retmsg = NULL; // our message to return
+    char *command = NULL;
+    //  binary commands are looked up by their opcode, string commands
+    //  by their name
+    int opcode = sphactor_command_opcode (zmsg_first (request));
+    if (opcode)
     {
-        retmsg = zmsg_new();
-        zmsg_addstrf( retmsg, "%li", self->timeout);
+        zframe_t *header = zmsg_pop (request);
+        zframe_destroy (&header);
     }
     else
-    if (streq (command, "CAPABILITY"))
     {
-        // Danger: this method will send the 'self' pointer
-        // over the pipe, internal use only!
-        retmsg = zmsg_new();
-        zmsg_addmem(retmsg, &self->capability, sizeof(void *));
+        command = zmsg_popstr (request);
+        if (command == NULL)
+        {
+            zmsg_destroy(request_p);
+            return NULL;
+        }
+        opcode = sphactor_command_lookup (command);
     }
+    if (self->verbose ) zsys_info("command: %s", opcode ? sphactor_command_name (opcode) : command);
+    if (opcode)
+        retmsg = s_api_commands [opcode] (self, request, command == NULL);
     else
     if (streq (command, "$TERM"))
         //  The $TERM command is send by zactor_destroy() method
@@ -706,8 +1837,8 @@ sphactor_actor_recv_api (sphactor_actor_t *self, zmsg_t **request_p)
         int rc = zmsg_pushstr(request, command);
         assert(rc == 0);
         zstr_free(&command);
-        sphactor_event_t ev = { request, "API", self->name, zuuid_str(self->uuid), self };
-        retmsg = self->handler(&ev, self->handler_args); // actor should destroy the message!
+        sphactor_event_t ev = { request, "API", self->name, zuuid_str(self->uuid), self, SPHACTOR_EVENT_API };
+        retmsg = s_handler_call(self, &ev); // actor should destroy the message!
         return retmsg;
     }
     zstr_free (&command);
@@ -777,6 +1908,83 @@ sph_actor_rate_test(sphactor_event_t *ev, void *args)
     return NULL;
 }
 
+#define TIMER_TEST_MANY 1000
+
+typedef struct {
+    int fast, slow, once, cancelled;    //  timer ids
+    //  counted by the actor, polled by the test
+    sphactor_atomic_int_t fast_count, slow_count, once_count, many_count, timeout_count;
+} timer_test_t;
+
+static zmsg_t *
+sph_actor_timers(sphactor_event_t *ev, void *args)
+{
+    timer_test_t *test = (timer_test_t *) args;
+    sphactor_actor_t *actor = (sphactor_actor_t *) ev->actor;
+    if ( ev->kind == SPHACTOR_EVENT_INIT )
+    {
+        //  a fast and a slow periodic timer next to our timeout
+        test->fast = sphactor_actor_timer_add(actor, 5, 5);
+        test->slow = sphactor_actor_timer_add(actor, 50, 50);
+        test->once = sphactor_actor_timer_add(actor, 20, 0);
+        test->cancelled = sphactor_actor_timer_add(actor, 10, 0);
+        assert( sphactor_actor_timer_cancel(actor, test->cancelled) == 0 );
+        assert( sphactor_actor_timer_cancel(actor, test->cancelled) == -1 );
+        int i;
+        for (i = 0; i < TIMER_TEST_MANY; i++)
+            assert( sphactor_actor_timer_add(actor, i % 100, 0) > 0 );
+        sphactor_actor_set_timeout(actor, 30);
+    }
+    else if ( ev->kind == SPHACTOR_EVENT_TIME )
+    {
+        assert( ev->timer != test->cancelled );
+        if ( ev->timer == SPHACTOR_TIMER_TIMEOUT )
+            sphactor_atomic_add(&test->timeout_count, 1);
+        else if ( ev->timer == test->fast )
+            sphactor_atomic_add(&test->fast_count, 1);
+        else if ( ev->timer == test->slow )
+            sphactor_atomic_add(&test->slow_count, 1);
+        else if ( ev->timer == test->once )
+            sphactor_atomic_add(&test->once_count, 1);
+        else
+            sphactor_atomic_add(&test->many_count, 1);
+    }
+    if ( ev->msg )
+        zmsg_destroy(&ev->msg);
+    return NULL;
+}
+
+typedef struct {
+    //  counted by the actor, polled by the test
+    sphactor_atomic_int_t time_count;
+    sphactor_atomic_int_t jitter_count;
+    sphactor_atomic_int_t timeout_count;
+} interval_test_t;
+
+static zmsg_t *
+sph_actor_interval(sphactor_event_t *ev, void *args)
+{
+    interval_test_t *test = (interval_test_t *) args;
+    sphactor_actor_t *actor = (sphactor_actor_t *) ev->actor;
+    if ( ev->kind == SPHACTOR_EVENT_INIT )
+    {
+        sphactor_actor_set_interval(actor, 500);
+        assert( sphactor_actor_interval(actor) == 500 );
+        sphactor_actor_set_timeout(actor, 20);
+    }
+    else if ( ev->kind == SPHACTOR_EVENT_TIME && ev->timer == SPHACTOR_TIMER_TIMEOUT )
+        sphactor_atomic_add(&test->timeout_count, 1);
+    else if ( ev->kind == SPHACTOR_EVENT_TIME )
+    {
+        assert( ev->timer == SPHACTOR_TIMER_INTERVAL );
+        sphactor_atomic_add(&test->time_count, 1);
+        sphactor_atomic_store(&test->jitter_count, (int64_t) sphactor_histogram_count(actor->timer_jitter));
+    }
+    if ( ev->msg )
+        zmsg_destroy(&ev->msg);
+    return NULL;
+}
+
 static zmsg_t *
 sph_actor_lifecycle(sphactor_event_t *ev, void *args)
 {
@@ -826,6 +2034,13 @@ sph_actor_reportertest(sphactor_event_t *ev, void *args)
         // assure our status is TIME
         assert( ev->actor->status == SPHACTOR_REPORT_TIME );
         assert( ev->msg == NULL );
+        // a custom report growing and shrinking while it is being read
+        char text [256];
+        size_t size = (size_t) (ev->actor->iterations % 255);
+        memset( text, 'x', size );
+        text[size] = 0;
+        sphactor_actor_set_custom_report_data( (sphactor_actor_t *)ev->actor,
+                                               zosc_create("/report", "s", text) );
     }
     return NULL;
 }
@@ -896,9 +2111,387 @@ sphactor_actor_send(sphactor_actor_t *self, zmsg_t *message)
     return s_publish_msg(self, message);
 }
 
+sphactor_trace_t *
+sphactor_actor_trace(sphactor_actor_t *self)
+{
+    assert(self);
+    return self->trace;
+}
+
+int64_t
+sphactor_actor_pop_int(zmsg_t *message, int64_t fallback)
+{
+    assert(message);
+    zframe_t *frame = zmsg_pop(message);
+    if ( frame == NULL )
+        return fallback;
+    int64_t value = fallback;
+    double real;
+    byte type = sphactor_command_value_type(frame, &value);
+    if ( type == 'd' )
+    {
+        memcpy(&real, &value, sizeof(real));
+        value = (int64_t) real;
+    }
+    else if ( type == 0 )
+    {
+        char *str = zframe_strdup(frame);
+        value = (int64_t) atoll(str);
+        zstr_free(&str);
+    }
+    zframe_destroy(&frame);
+    return value;
+}
+
+double
+sphactor_actor_pop_double(zmsg_t *message, double fallback)
+{
+    assert(message);
+    zframe_t *frame = zmsg_pop(message);
+    if ( frame == NULL )
+        return fallback;
+    double value = fallback;
+    int64_t native;
+    byte type = sphactor_command_value_type(frame, &native);
+    if ( type == 'd' )
+        memcpy(&value, &native, sizeof(value));
+    else if ( type == 'i' )
+        value = (double) native;
+    else
+    {
+        char *str = zframe_strdup(frame);
+        value = atof(str);
+        zstr_free(&str);
+    }
+    zframe_destroy(&frame);
+    return value;
+}
+
+//  Call our handler, timing it when we're reporting or recording our
+//  timeline
+
+static zmsg_t *
+s_handler_call (sphactor_actor_t *self, sphactor_event_t *ev)
+{
+    bool timeline = sphactor_timeline_enabled();
+    if ( ! self->reporting && ! timeline )
+        return self->handler(ev, self->handler_args);
+    const char *type = ev->type;  //  the handler may change the event
+    int64_t start = zclock_usecs();
+    zmsg_t *retmsg = self->handler(ev, self->handler_args);
+    int64_t end = zclock_usecs();
+    if ( self->reporting )
+        sphactor_histogram_record(self->handler_time, (uint64_t) (end - start));
+    if ( timeline )
+    {
+        if ( self->timeline == NULL )
+            self->timeline = sphactor_timeline_new(self->name);
+        sphactor_timeline_record(self->timeline, type, (uint64_t) start, (uint64_t) end);
+    }
+    return retmsg;
+}
+
+//  Handle the message if it is an API message from an actor we're
+//  connected to, returns true if it was
+
+static bool
+s_handle_api_msg (sphactor_actor_t *self, zmsg_t **msg_p)
+{
+    zmsg_t *msg = *msg_p;
+    if ( s_sphactor_actor_is_api_msg(msg) <= 0 )
+        return false;
+
+    zframe_t *sigf = zmsg_pop(msg); // pop the signal msg identifier
+    zframe_destroy(&sigf);
+    if ( ! zframe_streq(zmsg_first(msg), "$TERM" ) ) // filter $TERM signal as precaution
+    {
+        zmsg_t *answer = sphactor_actor_recv_api(self, msg_p);
+        if (answer) // we never answer through the pub socket https://github.com/hku-ect/libsphactor/pull/100#issuecomment-1829326648
+            zmsg_destroy(&answer); // zmsg_send(&answer, self->pub);
+    }
+    else
+        zmsg_destroy(msg_p);
+    return true;
+}
+
+//  Handle a message from an actor we're connected to
+
+static void
+s_handle_sock_msg (sphactor_actor_t *self, zmsg_t *msg, ring_in_t *ring)
+{
+    if ( ring == NULL )
+        s_stamp_take(self, msg);
+    sphactor_trace_t *trace = s_trace_take(self, msg);
+    //  we can receive API messages so check this first as these are special messages
+    if ( s_handle_api_msg(self, &msg) )
+    {
+        sphactor_trace_destroy(&trace);
+        return;
+    }
+
+    //  handle the message on the socket
+    //  first update our status report 4=SOCK
+    self->status = SPHACTOR_REPORT_SOCK;
+    self->recv_time = zclock_mono();
+    if ( self->reporting )
+        s_report_write(self);
+
+    self->trace = trace;
+    sphactor_event_t ev = { msg, "SOCK", self->name, zuuid_str(self->uuid), self, SPHACTOR_EVENT_SOCK };
+    zmsg_t *retmsg = s_handler_call(self, &ev);
+    if (retmsg)
+    {
+        // publish the msg
+        s_publish_msg(self, retmsg);
+
+        // delete message if we have no connections (otherwise it leaks)
+        if ( zsock_endpoint(self->pub) == NULL )
+            zmsg_destroy(&retmsg);
+    }
+    sphactor_trace_destroy(&self->trace);
+}
+
+//  Handle the message and the messages waiting behind it on the sub socket
+//  or ring, up to our batch size. The report and clock are updated once
+//  for the whole batch.
+
+static void
+s_handle_sock_batch (sphactor_actor_t *self, zmsg_t *msg, ring_in_t *ring)
+{
+    size_t count = 0;
+    while ( msg )
+    {
+        if ( ring && ! s_filters_match(self, msg) )
+            zmsg_destroy(&msg);
+        else
+        {
+            if ( ring == NULL )
+                s_stamp_take(self, msg);
+            sphactor_trace_t *trace = s_trace_take(self, msg);
+            if ( s_handle_api_msg(self, &msg) )
+            {
+                sphactor_trace_destroy(&trace);
+                break;  //  it might have changed our connections or batch size
+            }
+            self->batch_traces[count] = trace;
+            self->batch_msgs[count++] = msg;
+        }
+        if ( count == self->batch )
+            break;
+        if ( ring )
+            msg = s_ring_pop(self, ring);
+        else
+            msg = ( zsock_events(self->sub) & ZMQ_POLLIN ) ? zmsg_recv(self->sub) : NULL;
+    }
+    if ( count == 0 )
+        return;
+
+    self->status = SPHACTOR_REPORT_SOCK;
+    self->recv_time = zclock_mono();
+    if ( self->reporting )
+        s_report_write(self);
+
+    size_t i;
+    if ( self->batch_events )
+    {
+        //  the trace of the last traced message carries on
+        for (i = 0; i < count; i++)
+        {
+            if ( self->batch_traces[i] )
+            {
+                sphactor_trace_destroy(&self->trace);
+                self->trace = self->batch_traces[i];
+                self->batch_traces[i] = NULL;
+            }
+        }
+        //  the handler owns the event message and the messages in it
+        zmsg_t *batchm = zmsg_new();
+        zmsg_addmem(batchm, self->batch_msgs, count * sizeof( zmsg_t *));
+        sphactor_event_t ev = { batchm, "SOCKBATCH", self->name, zuuid_str(self->uuid), self, SPHACTOR_EVENT_SOCKBATCH };
+        zmsg_t *retmsg = s_handler_call(self, &ev);
+        if (retmsg)
+        {
+            // publish the msg
+            s_publish_msg(self, retmsg);
+
+            // delete message if we have no connections (otherwise it leaks)
+            if ( zsock_endpoint(self->pub) == NULL )
+                zmsg_destroy(&retmsg);
+        }
+        sphactor_trace_destroy(&self->trace);
+        return;
+    }
+
+    for (i = 0; i < count; i++)
+    {
+        sphactor_event_t ev = { self->batch_msgs[i], "SOCK", self->name, zuuid_str(self->uuid), self, SPHACTOR_EVENT_SOCK };
+        self->batch_msgs[i] = NULL;
+        self->trace = self->batch_traces[i];
+        self->batch_traces[i] = NULL;
+        zmsg_t *retmsg = s_handler_call(self, &ev);
+        if (retmsg)
+        {
+            // publish the msg
+            s_publish_msg(self, retmsg);
+
+            // delete message if we have no connections (otherwise it leaks)
+            if ( zsock_endpoint(self->pub) == NULL )
+                zmsg_destroy(&retmsg);
+        }
+        sphactor_trace_destroy(&self->trace);
+    }
+}
+
+//  Take the trace frame off the end of the message and note when we
+//  received it. Returns the trace or NULL if the message isn't traced.
+//  Doesn't touch the message unless an actor started tracing.
+
+static sphactor_trace_t *
+s_trace_take (sphactor_actor_t *self, zmsg_t *msg)
+{
+    if ( ! sphactor_atomic_load_relaxed(&s_traced) )
+        return NULL;
+    zframe_t *frame = zmsg_last(msg);
+    if ( frame == NULL || ! sphactor_trace_is(frame) )
+        return NULL;
+    zmsg_remove(msg, frame);
+    sphactor_trace_t *trace = sphactor_trace_decode(frame);
+    zframe_destroy(&frame);
+    sphactor_trace_set_received(trace, zclock_usecs());
+    return trace;
+}
+
+//  Take the stamp frame off the end of a message from our sub socket and
+//  time how long it waited, s_ring_pop times the messages from rings
+
+static void
+s_stamp_take (sphactor_actor_t *self, zmsg_t *msg)
+{
+    zframe_t *frame = zmsg_last(msg);
+    if ( frame == NULL || zframe_size(frame) != SPHACTOR_STAMP_SIZE
+    ||   memcmp(zframe_data(frame), SPHACTOR_STAMP_MAGIC, 8) != 0 )
+        return;
+    int64_t sent;
+    memcpy(&sent, zframe_data(frame) + 8, sizeof(sent));
+    zmsg_remove(msg, frame);
+    zframe_destroy(&frame);
+    if ( self->reporting )
+    {
+        int64_t waited = zclock_usecs() - sent;
+        sphactor_histogram_record(self->queue_time, waited > 0 ? (uint64_t) waited : 0);
+    }
+}
+
+//  Append the trace of the message we're handling, or a new one, with
+//  a hop for us to a message we publish
+
+static void
+s_trace_append (sphactor_actor_t *self, zmsg_t *msg)
+{
+    sphactor_trace_t *trace = self->trace
+                            ? sphactor_trace_dup(self->trace)
+                            : sphactor_trace_new(self->uuid, ++self->trace_seq);
+    sphactor_trace_add_hop(trace, self->uuid, zclock_usecs());
+    zframe_t *frame = sphactor_trace_encode(trace);
+    zmsg_append(msg, &frame);
+    sphactor_trace_destroy(&trace);
+}
+
+int
+    sphactor_actor_recv_pipe (sphactor_actor_t *self);
+
+//  Call our handler with the TIME event of a timer, 0 for our timeout
+
+static void
+s_handle_time (sphactor_actor_t *self, int timer)
+{
+    //  timed events don't carry a message instead NULL is passed
+    //  update our status report 5=TIME
+    self->status = SPHACTOR_REPORT_TIME;
+    if ( self->reporting )
+        s_report_write(self);
+
+    // do we have a handler? TODO: we should never have a NULL handler???
+    if ( self->handler )
+    {
+        sphactor_event_t ev = { NULL, "TIME", self->name, zuuid_str(self->uuid), self, SPHACTOR_EVENT_TIME, timer };
+        zmsg_t *retmsg = s_handler_call(self, &ev);
+        if (retmsg)
+        {
+            // publish the msg
+            s_publish_msg(self, retmsg);
+
+            // delete message if we have no connections (otherwise it leaks)
+            if ( zsock_endpoint(self->pub) == NULL ) {
+                zmsg_destroy(&retmsg);
+            }
+        }
+    }
+}
+
+//  Call our handler for each of our timers which is due
+
+static void
+s_timers_fire (sphactor_actor_t *self)
+{
+    int64_t now = zclock_mono();
+    int timer = sphactor_wheel_pop(self->timers, now);
+    while ( timer )
+    {
+        s_handle_time(self, timer);
+        timer = sphactor_wheel_pop(self->timers, now);
+    }
+}
+
+//  Record how late our interval fired, for the report, and call our handler
+//  with its TIME event. The timerfd counts the periods since we last read
+//  it so we never fire twice for a period we fell behind on. Without a
+//  timerfd we count them from our clock.
+
+static void
+s_interval_fire (sphactor_actor_t *self)
+{
+    int64_t now = s_interval_clock();
+#if defined (__UTYPE_LINUX)
+    uint64_t expirations = 0;
+    if ( read(self->timerfd, &expirations, sizeof(expirations)) != sizeof(expirations) )
+        return;     //  not due yet, a pool can run us for our other readers
+#else
+    if ( self->interval == 0 || now < self->interval_next )
+        return;
+    uint64_t expirations = (uint64_t) ((now - self->interval_next) / self->interval) + 1;
+#endif
+    int64_t late = now - self->interval_next;
+    sphactor_histogram_record(self->timer_jitter, (uint64_t) (late > 0 ? late : 0));
+    self->interval_next += (int64_t) expirations * self->interval;
+    s_handle_time(self, SPHACTOR_TIMER_INTERVAL);
+}
+
+//  Return the fused actor our thread runs with the pipe, if any
+
+static sphactor_actor_t *
+s_fused_lookup (sphactor_actor_t *self, void *pipe)
+{
+    sphactor_actor_t *fused = (sphactor_actor_t *) zlist_first(self->hosted);
+    while ( fused && fused->pipe != pipe )
+        fused = (sphactor_actor_t *) zlist_next(self->hosted);
+    return fused;
+}
+
 int
 sphactor_actor_run_once(sphactor_actor_t *self)
 {
+    void *which = NULL;
+    if ( self->pooled )
+    {
+        //  a pool only runs us when one of our readers is ready or our
+        //  timer is due, so never block and skip if there is nothing to do
+        which = zpoller_wait (self->poller, 0);
+        if ( which == NULL && s_time_next(self) > zclock_mono() )
+            return 0;
+        goto run_once_poll_end;
+    }
+
     //  determine poller timeout
     if ( zclock_mono() > self->time_next )
     {
@@ -907,73 +2500,65 @@ sphactor_actor_run_once(sphactor_actor_t *self)
     }
     else
     {
-        self->time_till_next = self->time_next - zclock_mono();
+        self->time_till_next = s_time_next(self) - zclock_mono();
+        if ( self->time_till_next < 0 )
+            self->time_till_next = 0;   //  one of our timers is due
         // if time_till_next will be 0 the poller we return immediatelly
         // so we only set a report when that is not the case
         self->status = SPHACTOR_REPORT_IDLE;
         if ( self->reporting )
-            sphactor_actor_atomic_set_report(self, sphactor_report_construct(self->status,
-                                                                             self->iterations,
-                                                                             self->recv_time,
-                                                                             self->send_time,
-                                                                             zosc_dup(self->reportMsg)));
+            s_report_write(self);
     }
 
 
-    void *which = (void *) zpoller_wait (self->poller, (int)self->time_till_next );
+    which = (void *) zpoller_wait (self->poller, (int)self->time_till_next );
 
+  run_once_poll_end:;
     bool skipped = ( self->time_next - zclock_mono() <= 0 );
+    bool timers_due = self->timers && sphactor_wheel_next(self->timers) <= zclock_mono();
+    //  without a timerfd nothing wakes the poller for our interval
+    bool interval_due = self->timerfd == -1 && self->interval > 0
+                        && s_interval_clock() >= self->interval_next;
     if ( self->timeout > 0 ) {
         while( self->time_next <= zclock_mono() ) {
             self->time_next += self->timeout;
         }
     }
 
+    //  our timers get a TIME event each, before anything else
+    if ( timers_due )
+        s_timers_fire(self);
+    if ( interval_due )
+        s_interval_fire(self);
+
+    ring_in_t *ring = which ? s_ring_lookup(self, which) : NULL;
     if ( which == NULL || skipped ) {  // timer events and interrupted
         if ( zsys_is_interrupted() )
             return -1; // exiting
 
-        //  timed events don't carry a message instead NULL is passed
-        //  update our status report 5=TIME
-        self->status = SPHACTOR_REPORT_TIME;
-        if ( self->reporting )
-            sphactor_actor_atomic_set_report(self, sphactor_report_construct(self->status,
-                                                                             self->iterations,
-                                                                             self->recv_time,
-                                                                             self->send_time,
-                                                                             zosc_dup(self->reportMsg)));
-
-        // do we have a handler? TODO: we should never have a NULL handler???
-        if ( self->handler )
-        {
-            sphactor_event_t ev = { NULL, "TIME", self->name, zuuid_str(self->uuid), self };
-            zmsg_t *retmsg = self->handler(&ev, self->handler_args);
-            if (retmsg)
-            {
-                // publish the msg
-                s_publish_msg(self, retmsg);
-
-                // delete message if we have no connections (otherwise it leaks)
-                if ( zsock_endpoint(self->pub) == NULL ) {
-                    zmsg_destroy(&retmsg);
-                }
-            }
-        }
+        //  a wakeup for our timers or interval only isn't a timeout
+        if ( skipped || !(timers_due || interval_due) )
+            s_handle_time(self, SPHACTOR_TIMER_TIMEOUT);
+    }
+    else if ( which == &self->timerfd )  // our high resolution interval
+        s_interval_fire(self);
+    else if ( ring )  // ring events
+    {
+        zmsg_t *msg = s_ring_pop(self, ring);
+        //  the ring can wake us once more after we emptied it
+        if ( msg && self->batch > 1 )
+            s_handle_sock_batch(self, msg, ring);
+        else if ( msg && s_filters_match(self, msg) )
+            s_handle_sock_msg(self, msg, ring);
+        else
+            zmsg_destroy(&msg);
     }
     else if ( zsock_is(which) )  // zsock events
     {
         if (which == self->pipe)
         {
-            // our pipe only holds API messages
-            zmsg_t *apimsg = zmsg_recv(which);
-            if (!apimsg)
-            {
+            if ( sphactor_actor_recv_pipe(self) == -1 )
                 return -1; //  interrupted
-            }
-
-            zmsg_t *answer = sphactor_actor_recv_api(self, &apimsg);
-            if (answer)
-                zmsg_send(&answer, self->pipe);
         }
         //  if a sub socket then process actor
         else if ( which == self->sub ) {
@@ -982,42 +2567,19 @@ sphactor_actor_run_once(sphactor_actor_t *self)
             {
                 return -1; //  interrupted
             }
-            //  we can receive API messages so check this first as these are special messages
-            if ( s_sphactor_actor_is_api_msg(msg) > 0 )
-            {
-                zframe_t *sigf = zmsg_pop(msg); // pop the signal msg identifier
-                zframe_destroy(&sigf);
-                if ( ! zframe_streq(zmsg_first(msg), "$TERM" ) ) // filter $TERM signal as precaution
-                {
-                    zmsg_t *answer = sphactor_actor_recv_api(self, &msg);
-                    if (answer) // we never answer through the pub socket https://github.com/hku-ect/libsphactor/pull/100#issuecomment-1829326648
-                        zmsg_destroy(&answer); // zmsg_send(&answer, self->pub);
-                }
-                goto run_once_end;
-            }
-
-            //  handle the message on the socket
-            //  first update our status report 4=SOCK
-            self->status = SPHACTOR_REPORT_SOCK;
-            if ( self->reporting )
-                self->recv_time = zclock_mono();
-                sphactor_actor_atomic_set_report(self, sphactor_report_construct(self->status,
-                                                                                 self->iterations,
-                                                                                 self->recv_time,
-                                                                                 self->send_time,
-                                                                                 zosc_dup(self->reportMsg)));
-
-            sphactor_event_t ev = { msg, "SOCK", self->name, zuuid_str(self->uuid), self };
-            zmsg_t *retmsg = self->handler(&ev, self->handler_args);
-            if (retmsg)
-            {
-                // publish the msg
-                s_publish_msg(self, retmsg);
-
-                // delete message if we have no connections (otherwise it leaks)
-                if ( zsock_endpoint(self->pub) == NULL )
-                    zmsg_destroy(&retmsg);
-            }
+            if ( self->batch > 1 )
+                s_handle_sock_batch(self, msg, NULL);
+            else
+                s_handle_sock_msg(self, msg, NULL);
+        }
+        else if ( s_fused_lookup(self, which) )
+        {
+            //  commands for an actor fused to us
+            sphactor_actor_t *fused = s_fused_lookup(self, which);
+            if ( sphactor_actor_recv_pipe(fused) == -1 )
+                return -1; //  interrupted
+            if ( fused->terminated )
+                s_fused_finish(self, fused);
         }
         else  // custom zsock event (FDSOCK)
         {
@@ -1026,16 +2588,12 @@ sphactor_actor_run_once(sphactor_actor_t *self)
             self->status = SPHACTOR_REPORT_FDSOCK;
             if ( self->reporting )
                 // TODO: should we set recv time? Or do we do this only on the sub socket?
-                sphactor_actor_atomic_set_report(self, sphactor_report_construct(self->status,
-                                                                                 self->iterations,
-                                                                                 self->recv_time,
-                                                                                 self->send_time,
-                                                                                 zosc_dup(self->reportMsg)));
+                s_report_write(self);
 
             zmsg_t *sockfdm = zmsg_new();
             zmsg_addmem(sockfdm, &which, sizeof( void *));
-            sphactor_event_t ev = { sockfdm, "FDSOCK", self->name, zuuid_str(self->uuid), self };
-            zmsg_t *retmsg = self->handler(&ev, self->handler_args);
+            sphactor_event_t ev = { sockfdm, "FDSOCK", self->name, zuuid_str(self->uuid), self, SPHACTOR_EVENT_FDSOCK };
+            zmsg_t *retmsg = s_handler_call(self, &ev);
             if (retmsg)
             {
                 // publish the msg
@@ -1053,16 +2611,12 @@ sphactor_actor_run_once(sphactor_actor_t *self)
         self->status = SPHACTOR_REPORT_FDSOCK;
         if ( self->reporting )
             // TODO: should we set recv time? Or do we do this only on the sub socket?
-            sphactor_actor_atomic_set_report(self, sphactor_report_construct(self->status,
-                                                                             self->iterations,
-                                                                             self->recv_time,
-                                                                             self->send_time,
-                                                                             zosc_dup(self->reportMsg)));
+            s_report_write(self);
 
         zmsg_t *sockfdm = zmsg_new();
         zmsg_addmem(sockfdm, &which, sizeof( void *));
-        sphactor_event_t ev = { sockfdm, "FDSOCK", self->name, zuuid_str(self->uuid), self };
-        zmsg_t *retmsg = self->handler(&ev, self->handler_args);
+        sphactor_event_t ev = { sockfdm, "FDSOCK", self->name, zuuid_str(self->uuid), self, SPHACTOR_EVENT_FDSOCK };
+        zmsg_t *retmsg = s_handler_call(self, &ev);
         if (retmsg)
         {
             // publish the msg
@@ -1073,11 +2627,125 @@ sphactor_actor_run_once(sphactor_actor_t *self)
                 zmsg_destroy(&retmsg);
         }
     }
-  run_once_end:
     self->iterations++;
+    if ( self->pooled )
+    {
+        //  we won't return to idle on our own as the pool waits for us
+        self->status = SPHACTOR_REPORT_IDLE;
+        if ( self->reporting )
+            s_report_write(self);
+    }
+    return 0;
+}
+
+//  --------------------------------------------------------------------------
+//  Internal methods for running the actor in a sphactor_pool instead of its
+//  own thread. Only the pool may call these and only while the actor is not
+//  running!
+
+void
+sphactor_actor_set_pooled (sphactor_actor_t *self, bool pooled)
+{
+    assert(self);
+    self->pooled = pooled;
+}
+
+void
+sphactor_actor_set_ticked (sphactor_actor_t *self, bool ticked)
+{
+    assert(self);
+    self->ticked = ticked;
+}
+
+zlist_t *
+sphactor_actor_readers (sphactor_actor_t *self)
+{
+    assert(self);
+    return self->readers;
+}
+
+int64_t
+sphactor_actor_time_next (sphactor_actor_t *self)
+{
+    assert(self);
+    return s_time_next(self);
+}
+
+bool
+sphactor_actor_terminated (sphactor_actor_t *self)
+{
+    assert(self);
+    return self->terminated;
+}
+
+//  Handle a command waiting on our pipe. Returns -1 if interrupted.
+
+int
+sphactor_actor_recv_pipe (sphactor_actor_t *self)
+{
+    assert(self);
+    // our pipe only holds API messages
+    zmsg_t *apimsg = zmsg_recv(self->pipe);
+    if (!apimsg)
+        return -1;
+    zmsg_t *answer = sphactor_actor_recv_api(self, &apimsg);
+    if (answer)
+        zmsg_send(&answer, self->pipe);
     return 0;
 }
 
+const char *
+sphactor_actor_endpoint (sphactor_actor_t *self)
+{
+    assert(self);
+    return self->endpoint;
+}
+
+zlist_t *
+sphactor_actor_connections (sphactor_actor_t *self)
+{
+    assert(self);
+    return self->connections;
+}
+
+//  Call our handler with a message from an actor upstream, or without one
+//  as a timer event, and return its reply instead of publishing it. Used
+//  by whoever passes messages between actors directly.
+
+zmsg_t *
+sphactor_actor_handle (sphactor_actor_t *self, zmsg_t *msg)
+{
+    assert(self);
+    if ( msg && !s_filters_match(self, msg) )
+    {
+        zmsg_destroy(&msg);
+        return NULL;
+    }
+    if ( self->handler == NULL )
+    {
+        zmsg_destroy(&msg);
+        return NULL;
+    }
+    //  the message may carry the trace of whoever published it, take it
+    //  off so our handler gets the frames it was sent and our replies
+    //  carry the trace on
+    sphactor_trace_destroy(&self->trace);
+    if ( msg )
+        self->trace = s_trace_take(self, msg);
+    self->status = msg ? SPHACTOR_REPORT_SOCK : SPHACTOR_REPORT_TIME;
+    if ( msg )
+        self->recv_time = zclock_mono();
+    if ( self->reporting )
+        s_report_write(self);
+    sphactor_event_t ev = { msg, msg ? "SOCK" : "TIME", self->name, zuuid_str(self->uuid), self,
+                            msg ? SPHACTOR_EVENT_SOCK : SPHACTOR_EVENT_TIME };
+    zmsg_t *retmsg = s_handler_call(self, &ev);
+    if ( retmsg )
+        self->send_time = zclock_mono();
+    self->iterations++;
+    return retmsg;
+}
+
 //  --------------------------------------------------------------------------
 //  This is the actor which runs in its own thread.
 
@@ -1126,6 +2794,22 @@ sphactor_actor_test (bool verbose)
 {
     printf (" * sphactor_actor: ");
     //  @selftest
+    //  every opcode has a handler and maps back from its name
+    int opcode;
+    for (opcode = 1; opcode < SPHACTOR_COMMAND_COUNT; opcode++)
+    {
+        assert (s_api_commands [opcode]);
+        if (sphactor_command_has_string (opcode))
+            assert (sphactor_command_lookup (sphactor_command_name (opcode)) == opcode);
+        else
+            assert (sphactor_command_lookup (sphactor_command_name (opcode)) == 0);
+    }
+    assert (sphactor_command_lookup ("$TERM") == 0);
+    assert (sphactor_command_lookup ("SET NAMES") == 0);
+    assert (sphactor_command_lookup ("STOPS") == 0);
+    assert (sphactor_command_lookup ("SET TIMEOUX") == 0);
+    assert (sphactor_command_lookup ("") == 0);
+
     //  Simple create/destroy test
     sphactor_shim_t consumer = { &sph_actor_consumer, NULL, NULL, NULL };
     zactor_t *sphactor_actor = zactor_new (sphactor_actor_run, &consumer);
@@ -1250,6 +2934,58 @@ sphactor_actor_test (bool verbose)
     zclock_sleep(1000/60);
     zactor_destroy (&sphactor_rate_tester);
 
+    // timers test: timer events carry the id of their timer, the timeout
+    // keeps working next to them
+    timer_test_t timer_test;
+    memset(&timer_test, 0, sizeof(timer_test));
+    sphactor_shim_t timer_tester = { &sph_actor_timers, &timer_test, NULL, NULL };
+    zactor_t *sphactor_timer_tester = zactor_new (sphactor_actor_run, &timer_tester);
+    assert(sphactor_timer_tester);
+    //  wait until every timer fired often enough, a loaded machine may
+    //  take a lot longer than the periods add up to
+    int64_t deadline = zclock_mono() + 5000;
+    while ( (   sphactor_atomic_load(&timer_test.slow_count) < 2
+             || sphactor_atomic_load(&timer_test.once_count) < 1
+             || sphactor_atomic_load(&timer_test.many_count) < TIMER_TEST_MANY
+             || sphactor_atomic_load(&timer_test.timeout_count) < 3 )
+            && zclock_mono() < deadline )
+        zclock_sleep(5);
+    zactor_destroy (&sphactor_timer_tester);
+    int64_t fast_count = sphactor_atomic_load(&timer_test.fast_count);
+    int64_t slow_count = sphactor_atomic_load(&timer_test.slow_count);
+    if (verbose)
+        zsys_info("timers: fast %d, slow %d, once %d, many %d, timeout %d",
+                  (int) fast_count, (int) slow_count,
+                  (int) sphactor_atomic_load(&timer_test.once_count),
+                  (int) sphactor_atomic_load(&timer_test.many_count),
+                  (int) sphactor_atomic_load(&timer_test.timeout_count));
+    assert( fast_count > slow_count );
+    assert( slow_count >= 2 );
+    assert( sphactor_atomic_load(&timer_test.once_count) == 1 );
+    assert( sphactor_atomic_load(&timer_test.many_count) == TIMER_TEST_MANY );
+    assert( sphactor_atomic_load(&timer_test.timeout_count) >= 3 );
+
+    // interval test: a 500 usecs interval fires faster than any timeout,
+    // the events of both tell which they are
+    interval_test_t interval_test;
+    memset(&interval_test, 0, sizeof(interval_test));
+    sphactor_shim_t interval_tester = { &sph_actor_interval, &interval_test, NULL, NULL };
+    zactor_t *sphactor_interval_tester = zactor_new (sphactor_actor_run, &interval_tester);
+    assert(sphactor_interval_tester);
+    //  a 500 usecs interval fires 200 times in 100 msecs, wait for that many
+    //  with a generous deadline as a loaded machine falls behind
+    deadline = zclock_mono() + 5000;
+    while ( (   sphactor_atomic_load(&interval_test.time_count) < 200
+             || sphactor_atomic_load(&interval_test.timeout_count) < 1 )
+            && zclock_mono() < deadline )
+        zclock_sleep(5);
+    zactor_destroy (&sphactor_interval_tester);
+    if (verbose)
+        zsys_info("interval: %d time events", (int) sphactor_atomic_load(&interval_test.time_count));
+    assert( sphactor_atomic_load(&interval_test.time_count) >= 200 );
+    assert( sphactor_atomic_load(&interval_test.jitter_count) > 0 );
+    assert( sphactor_atomic_load(&interval_test.timeout_count) > 0 );
+
     // lifecycle test
     sphactor_shim_t lifecycle_tester = { &sph_actor_lifecycle, NULL, NULL, "lifecycle_tester" };
     zactor_t *sphactor_lifecycle_tester = zactor_new (sphactor_actor_run, &lifecycle_tester);
@@ -1288,8 +3024,30 @@ sphactor_actor_test (bool verbose)
             r = sphactor_actor_atomic_report(repact);
         }
         if (verbose ) zsys_info("status: %i, iterations: %i, tried requests: %i", sphactor_report_status(r), sphactor_report_iterations(r), count );
+        //  the report is ours
         sphactor_report_destroy(&r);
     }
+    // snapshots reuse the same report and see the iterations go up
+    sphactor_report_t *snapshot = sphactor_report_new();
+    uint64_t iterations = 0;
+    for (int i=0; i<1000;i++)
+    {
+        rc = sphactor_actor_report_snapshot(repact, snapshot);
+        assert( rc == 0 );
+        assert( sphactor_report_iterations(snapshot) >= iterations );
+        iterations = sphactor_report_iterations(snapshot);
+        zosc_t *custom = sphactor_report_custom(snapshot);
+        if ( custom )
+        {
+            assert( streq( zosc_address(custom), "/report" ) );
+            char *text = NULL;
+            rc = zosc_retr(custom, "s", &text);
+            assert( rc == 0 );
+            assert( strspn(text, "x") == strlen(text) );
+            zstr_free(&text);
+        }
+    }
+    sphactor_report_destroy(&snapshot);
     zactor_destroy( &sphactor_reportertest );
 
     // zpoller add / remove test
@@ -0,0 +1,221 @@
+/*  =========================================================================
+    sphactor_atomic - portable atomic operations
+
+    Copyright (c) the Contributors as noted in the AUTHORS file.
+
+    This file is part of Sphactor, an open-source framework for high level
+    actor model concurrency --- http://sphactor.org
+
+    This Source Code Form is subject to the terms of the Mozilla Public
+    License, v. 2.0. If a copy of the MPL was not distributed with this
+    file, You can obtain one at http://mozilla.org/MPL/2.0/.
+    =========================================================================
+*/
+
+/*
+    Minimal set of atomic operations on 64 bit integers and pointers for the
+    lock-free parts of sphactor. Uses C11 stdatomic and the Interlocked
+    functions on Windows (MSVC compiles us as C++). Unless _relaxed the
+    operations are sequentially consistent.
+*/
+
+#ifndef SPHACTOR_ATOMIC_H_INCLUDED
+#define SPHACTOR_ATOMIC_H_INCLUDED
+
+#if defined(__WINDOWS__)
+#include <winnt.h>
+
+typedef volatile LONG64 sphactor_atomic_int_t;
+typedef void * volatile sphactor_atomic_ptr_t;
+
+static inline int64_t
+sphactor_atomic_load (sphactor_atomic_int_t *a)
+{
+    return InterlockedCompareExchange64 (a, 0, 0);
+}
+
+static inline int64_t
+sphactor_atomic_load_relaxed (sphactor_atomic_int_t *a)
+{
+    return *a;
+}
+
+static inline void
+sphactor_atomic_store (sphactor_atomic_int_t *a, int64_t value)
+{
+    InterlockedExchange64 (a, value);
+}
+
+static inline void
+sphactor_atomic_store_relaxed (sphactor_atomic_int_t *a, int64_t value)
+{
+    *a = value;
+}
+
+//  Add value and return the previous value
+static inline int64_t
+sphactor_atomic_add (sphactor_atomic_int_t *a, int64_t value)
+{
+    return InterlockedExchangeAdd64 (a, value);
+}
+
+//  Set to desired if it equals expected, return true if it did
+static inline bool
+sphactor_atomic_cas (sphactor_atomic_int_t *a, int64_t expected, int64_t desired)
+{
+    return InterlockedCompareExchange64 (a, desired, expected) == expected;
+}
+
+static inline void *
+sphactor_atomic_load_ptr (sphactor_atomic_ptr_t *a)
+{
+    return InterlockedCompareExchangePointer ((void **) a, NULL, NULL);
+}
+
+static inline void *
+sphactor_atomic_load_ptr_relaxed (sphactor_atomic_ptr_t *a)
+{
+    return *a;
+}
+
+static inline void
+sphactor_atomic_store_ptr (sphactor_atomic_ptr_t *a, void *value)
+{
+    InterlockedExchangePointer ((void **) a, value);
+}
+
+static inline void
+sphactor_atomic_store_ptr_relaxed (sphactor_atomic_ptr_t *a, void *value)
+{
+    *a = value;
+}
+
+//  Set and return the previous value
+static inline void *
+sphactor_atomic_exchange_ptr (sphactor_atomic_ptr_t *a, void *value)
+{
+    return InterlockedExchangePointer ((void **) a, value);
+}
+
+static inline bool
+sphactor_atomic_cas_ptr (sphactor_atomic_ptr_t *a, void *expected, void *desired)
+{
+    return InterlockedCompareExchangePointer ((void **) a, desired, expected) == expected;
+}
+
+static inline void
+sphactor_atomic_fence (void)
+{
+    MemoryBarrier ();
+}
+
+//  Tell the cpu we're spinning on a value another thread changes
+
+static inline void
+sphactor_atomic_pause (void)
+{
+    YieldProcessor ();
+}
+
+#else
+#include <stdatomic.h>
+
+typedef _Atomic int64_t sphactor_atomic_int_t;
+typedef _Atomic (void *) sphactor_atomic_ptr_t;
+
+static inline int64_t
+sphactor_atomic_load (sphactor_atomic_int_t *a)
+{
+    return atomic_load (a);
+}
+
+static inline int64_t
+sphactor_atomic_load_relaxed (sphactor_atomic_int_t *a)
+{
+    return atomic_load_explicit (a, memory_order_relaxed);
+}
+
+static inline void
+sphactor_atomic_store (sphactor_atomic_int_t *a, int64_t value)
+{
+    atomic_store (a, value);
+}
+
+static inline void
+sphactor_atomic_store_relaxed (sphactor_atomic_int_t *a, int64_t value)
+{
+    atomic_store_explicit (a, value, memory_order_relaxed);
+}
+
+//  Add value and return the previous value
+static inline int64_t
+sphactor_atomic_add (sphactor_atomic_int_t *a, int64_t value)
+{
+    return atomic_fetch_add (a, value);
+}
+
+//  Set to desired if it equals expected, return true if it did
+static inline bool
+sphactor_atomic_cas (sphactor_atomic_int_t *a, int64_t expected, int64_t desired)
+{
+    return atomic_compare_exchange_strong (a, &expected, desired);
+}
+
+static inline void *
+sphactor_atomic_load_ptr (sphactor_atomic_ptr_t *a)
+{
+    return atomic_load (a);
+}
+
+static inline void *
+sphactor_atomic_load_ptr_relaxed (sphactor_atomic_ptr_t *a)
+{
+    return atomic_load_explicit (a, memory_order_relaxed);
+}
+
+static inline void
+sphactor_atomic_store_ptr (sphactor_atomic_ptr_t *a, void *value)
+{
+    atomic_store (a, value);
+}
+
+static inline void
+sphactor_atomic_store_ptr_relaxed (sphactor_atomic_ptr_t *a, void *value)
+{
+    atomic_store_explicit (a, value, memory_order_relaxed);
+}
+
+//  Set and return the previous value
+static inline void *
+sphactor_atomic_exchange_ptr (sphactor_atomic_ptr_t *a, void *value)
+{
+    return atomic_exchange (a, value);
+}
+
+static inline bool
+sphactor_atomic_cas_ptr (sphactor_atomic_ptr_t *a, void *expected, void *desired)
+{
+    return atomic_compare_exchange_strong (a, &expected, desired);
+}
+
+static inline void
+sphactor_atomic_fence (void)
+{
+    atomic_thread_fence (memory_order_seq_cst);
+}
+
+//  Tell the cpu we're spinning on a value another thread changes
+
+static inline void
+sphactor_atomic_pause (void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause ();
+#elif defined(__aarch64__)
+    __asm__ __volatile__ ("yield");
+#endif
+}
+
+#endif
+
+#endif
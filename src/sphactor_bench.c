@@ -0,0 +1,518 @@
+/*  =========================================================================
+    sphactor_bench - throughput and latency of actor graphs
+
+    Copyright (c) the Contributors as noted in the AUTHORS file.
+
+    This file is part of Sphactor, an open-source framework for high level
+    actor model concurrency --- http://sphactor.org
+
+    This Source Code Form is subject to the terms of the Mozilla Public
+    License, v. 2.0. If a copy of the MPL was not distributed with this
+    file, You can obtain one at http://mozilla.org/MPL/2.0/.
+    =========================================================================
+*/
+
+/*
+@header
+    sphactor_bench - throughput and latency of actor graphs
+@discuss
+    Runs messages through a few typical graphs and reports messages per
+    second, the latency from sending a message to its last receiver, the
+    process's CPU time per message and its resident memory with the
+    scenario's actors running, and how much that grew over before the
+    scenario (Linux only, -1 elsewhere):
+
+        chain       a source, forwarders and a sink in a line of n actors
+        fanout      a source publishing to n sinks
+        fanin       n sources publishing to one sink
+        pingpong    two actors passing one message back and forth
+        pulse       n actors publishing on a timer to one sink
+
+    Sources keep at most --window messages underway so a slow graph isn't
+    measured by the messages it drops. Run the same options before and
+    after a change and compare the JSON output.
+@end
+*/
+
+#include "sphactor_classes.h"
+#if defined (__UNIX__)
+#include <sys/resource.h>
+#endif
+
+//  Most actors in a scenario
+#define BENCH_MAX_ACTORS 64
+//  Give up waiting for messages after this many msecs
+#define BENCH_TIMEOUT 60000
+
+//  Shared by the actors of a scenario
+
+typedef struct {
+    int64_t messages;                   //  Messages each source sends
+    int64_t window;                     //  Messages underway per source
+    size_t  size;                       //  Bytes of data per message
+    byte    *data;                      //  The data
+    size_t  sinks;                      //  Number of sinks
+    sphactor_atomic_int_t sent;         //  Messages sent by all sources
+    sphactor_atomic_int_t received [BENCH_MAX_ACTORS];  //  per sink
+    sphactor_atomic_int_t last;         //  When a sink last received
+    sphactor_histogram_t *latency [BENCH_MAX_ACTORS];   //  per sink
+} bench_t;
+
+//  What a sink handler gets
+
+typedef struct {
+    bench_t *bench;
+    size_t  index;                      //  Our sink number
+} bench_sink_t;
+
+//  Result of a scenario
+
+typedef struct {
+    const char *scenario;
+    size_t  actors;
+    int64_t messages;                   //  Messages received by all sinks
+    int64_t usecs;                      //  From start to last message
+    uint64_t p50;                       //  Latency percentiles in usecs
+    uint64_t p99;
+    uint64_t max;
+    int64_t cpu;                        //  CPU usecs, -1 if unknown
+    int64_t rss;                        //  RSS in kB while running, -1 if unknown
+    int64_t rss_delta;                  //  RSS growth in kB by the scenario
+    bool    complete;                   //  Did all messages arrive?
+} bench_result_t;
+
+//  Options of the run
+
+typedef struct {
+    size_t  actors;
+    int64_t messages;
+    int64_t window;
+    size_t  size;
+    int64_t interval;
+    bool    ring;
+    bool    json;
+} bench_options_t;
+
+
+static int
+s_print_help (void)
+{
+    puts ("sphactor_bench [scenario ...] [options]");
+    puts ("  scenarios: chain fanout fanin pingpong pulse (default all)");
+    puts ("  --actors <n>           actors in a scenario (default 8)");
+    puts ("  --messages <n>         messages per scenario (default 100000)");
+    puts ("  --window <n>           messages a source keeps underway (default 500)");
+    puts ("  --size <n>             bytes of data per message (default 16)");
+    puts ("  --interval <ms>        timer interval of pulse actors (default 1)");
+    puts ("  --ring                 connect actors through rings instead of sockets");
+    puts ("  --workers <n>          run the actors on n worker threads instead of");
+    puts ("                         a thread per actor (0 for one per core). Sources");
+    puts ("                         hold on to their worker, so use more workers");
+    puts ("                         than a scenario has sources");
+    puts ("  --json                 print the results as JSON");
+    puts ("  --help / -h            this information");
+    return 0;
+}
+
+static int64_t
+s_cpu_usecs (void)
+{
+#if defined (__UNIX__)
+    struct rusage usage;
+    if (getrusage (RUSAGE_SELF, &usage) == 0)
+        return (int64_t) usage.ru_utime.tv_sec * 1000000 + usage.ru_utime.tv_usec
+             + (int64_t) usage.ru_stime.tv_sec * 1000000 + usage.ru_stime.tv_usec;
+#endif
+    return -1;
+}
+
+//  Return our current resident memory in kB, -1 if unknown. Not the peak,
+//  which a larger scenario run before would set for all following ones.
+
+static int64_t
+s_rss_kb (void)
+{
+#if defined (__UTYPE_LINUX)
+    FILE *file = fopen ("/proc/self/statm", "r");
+    if (file) {
+        long size, resident;
+        int fields = fscanf (file, "%ld %ld", &size, &resident);
+        fclose (file);
+        if (fields == 2)
+            return (int64_t) resident * (int64_t) (sysconf (_SC_PAGESIZE) / 1024);
+    }
+#endif
+    return -1;
+}
+
+//  A message holding the time it was sent and the data
+
+static zmsg_t *
+s_bench_msg (bench_t *bench)
+{
+    zmsg_t *msg = zmsg_new ();
+    int64_t now = zclock_usecs ();
+    zmsg_addmem (msg, &now, sizeof (now));
+    zmsg_addmem (msg, bench->data, bench->size);
+    return msg;
+}
+
+//  Least number of messages received by a sink
+
+static int64_t
+s_received_min (bench_t *bench)
+{
+    int64_t least = INT64_MAX;
+    size_t index;
+    for (index = 0; index < bench->sinks; index++) {
+        int64_t received = sphactor_atomic_load (&bench->received [index]);
+        if (received < least)
+            least = received;
+    }
+    return least;
+}
+
+//  Sends its messages when asked to through the API
+
+static zmsg_t *
+s_source_handler (sphactor_event_t *ev, void *args)
+{
+    if (ev->msg)
+        zmsg_destroy (&ev->msg);
+    if (!streq (ev->type, "API"))
+        return NULL;
+    bench_t *bench = (bench_t *) args;
+    int64_t count;
+    for (count = 0; count < bench->messages; count++) {
+        while (sphactor_atomic_load (&bench->sent) - s_received_min (bench) >= bench->window)
+            zclock_sleep (0);
+        sphactor_atomic_add (&bench->sent, 1);
+        sphactor_actor_send ((sphactor_actor_t *) ev->actor, s_bench_msg (bench));
+    }
+    return NULL;
+}
+
+static zmsg_t *
+s_forward_handler (sphactor_event_t *ev, void *args)
+{
+    if (ev->msg && streq (ev->type, "SOCK"))
+        return ev->msg;
+    if (ev->msg)
+        zmsg_destroy (&ev->msg);
+    return NULL;
+}
+
+static zmsg_t *
+s_sink_handler (sphactor_event_t *ev, void *args)
+{
+    if (ev->msg == NULL)
+        return NULL;
+    if (streq (ev->type, "SOCK")) {
+        bench_sink_t *sink = (bench_sink_t *) args;
+        int64_t now = zclock_usecs ();
+        int64_t sent;
+        memcpy (&sent, zframe_data (zmsg_first (ev->msg)), sizeof (sent));
+        sphactor_histogram_record (sink->bench->latency [sink->index], (uint64_t) (now - sent));
+        sphactor_atomic_store (&sink->bench->last, now);
+        sphactor_atomic_add (&sink->bench->received [sink->index], 1);
+    }
+    zmsg_destroy (&ev->msg);
+    return NULL;
+}
+
+//  Starts a round trip when asked to through the API, and the next one
+//  when the message comes back
+
+static zmsg_t *
+s_ping_handler (sphactor_event_t *ev, void *args)
+{
+    bench_sink_t *sink = (bench_sink_t *) args;
+    bench_t *bench = sink->bench;
+    if (ev->msg && streq (ev->type, "SOCK")) {
+        int64_t now = zclock_usecs ();
+        int64_t sent;
+        memcpy (&sent, zframe_data (zmsg_first (ev->msg)), sizeof (sent));
+        sphactor_histogram_record (bench->latency [0], (uint64_t) (now - sent));
+        sphactor_atomic_store (&bench->last, now);
+        if (sphactor_atomic_add (&bench->received [0], 1) + 1 >= bench->messages) {
+            zmsg_destroy (&ev->msg);
+            return NULL;
+        }
+    }
+    else
+    if (!streq (ev->type, "API")) {
+        if (ev->msg)
+            zmsg_destroy (&ev->msg);
+        return NULL;
+    }
+    if (ev->msg)
+        zmsg_destroy (&ev->msg);
+    return s_bench_msg (bench);
+}
+
+//  Publishes a message on every timer event until all are sent
+
+static zmsg_t *
+s_pulse_handler (sphactor_event_t *ev, void *args)
+{
+    if (ev->msg)
+        zmsg_destroy (&ev->msg);
+    bench_t *bench = (bench_t *) args;
+    if (!streq (ev->type, "TIME")
+    ||  sphactor_atomic_add (&bench->sent, 1) >= bench->messages)
+        return NULL;
+    return s_bench_msg (bench);
+}
+
+static void
+s_connect (sphactor_t *self, sphactor_t *dest, bool ring)
+{
+    char *endpoint = ring ? zsys_sprintf ("ring+%s", sphactor_ask_endpoint (dest))
+                          : strdup (sphactor_ask_endpoint (dest));
+    int rc = sphactor_ask_connect (self, endpoint);
+    assert (rc == 0);
+    zstr_free (&endpoint);
+}
+
+//  Wait for every sink to receive the expected number of messages,
+//  returns false if they didn't in time
+
+static bool
+s_wait (bench_t *bench, int64_t expected)
+{
+    int64_t deadline = zclock_mono () + BENCH_TIMEOUT;
+    while (s_received_min (bench) < expected) {
+        if (zclock_mono () > deadline || zsys_interrupted)
+            return false;
+        zclock_sleep (1);
+    }
+    return true;
+}
+
+//  Run a scenario and fill in the result
+
+static void
+s_run (const char *scenario, bench_options_t *options, bench_result_t *result)
+{
+    size_t actors = options->actors;
+    if (streq (scenario, "pingpong"))
+        actors = 2;
+    int64_t rss = s_rss_kb ();
+    bench_t bench;
+    memset (&bench, 0, sizeof (bench));
+    bench.messages = options->messages;
+    bench.window = options->window;
+    bench.size = options->size;
+    bench.data = (byte *) zmalloc (options->size + 1);
+    assert (bench.data);
+    bench.sinks = 1;
+    if (streq (scenario, "fanout"))
+        bench.sinks = actors - 1;
+    else
+    if (streq (scenario, "fanin"))
+        bench.messages = options->messages / (actors - 1);
+    size_t index;
+    for (index = 0; index < bench.sinks; index++)
+        bench.latency [index] = sphactor_histogram_new ();
+
+    sphactor_t *actor [BENCH_MAX_ACTORS];
+    bench_sink_t sinks [BENCH_MAX_ACTORS];
+    for (index = 0; index < BENCH_MAX_ACTORS; index++) {
+        sinks [index].bench = &bench;
+        sinks [index].index = index;
+    }
+    sphactor_t *sources [BENCH_MAX_ACTORS];
+    size_t source_count = 0;
+    int64_t expected = bench.messages;
+
+    if (streq (scenario, "chain")) {
+        //  actor 0 sends, the last one receives
+        actor [0] = sources [source_count++] = sphactor_new (s_source_handler, &bench, NULL, NULL);
+        for (index = 1; index < actors - 1; index++)
+            actor [index] = sphactor_new (s_forward_handler, NULL, NULL, NULL);
+        actor [actors - 1] = sphactor_new (s_sink_handler, &sinks [0], NULL, NULL);
+        for (index = 1; index < actors; index++)
+            s_connect (actor [index], actor [index - 1], options->ring);
+    }
+    else
+    if (streq (scenario, "fanout")) {
+        actor [0] = sources [source_count++] = sphactor_new (s_source_handler, &bench, NULL, NULL);
+        for (index = 1; index < actors; index++) {
+            actor [index] = sphactor_new (s_sink_handler, &sinks [index - 1], NULL, NULL);
+            s_connect (actor [index], actor [0], options->ring);
+        }
+    }
+    else
+    if (streq (scenario, "fanin")) {
+        actor [0] = sphactor_new (s_sink_handler, &sinks [0], NULL, NULL);
+        for (index = 1; index < actors; index++) {
+            actor [index] = sources [source_count++] = sphactor_new (s_source_handler, &bench, NULL, NULL);
+            s_connect (actor [0], actor [index], options->ring);
+        }
+        expected = bench.messages * (int64_t) (actors - 1);
+    }
+    else
+    if (streq (scenario, "pingpong")) {
+        actor [0] = sources [source_count++] = sphactor_new (s_ping_handler, &sinks [0], NULL, NULL);
+        actor [1] = sphactor_new (s_forward_handler, NULL, NULL, NULL);
+        s_connect (actor [0], actor [1], options->ring);
+        s_connect (actor [1], actor [0], options->ring);
+    }
+    else {
+        assert (streq (scenario, "pulse"));
+        actor [0] = sphactor_new (s_sink_handler, &sinks [0], NULL, NULL);
+        for (index = 1; index < actors; index++) {
+            actor [index] = sphactor_new (s_pulse_handler, &bench, NULL, NULL);
+            s_connect (actor [0], actor [index], options->ring);
+        }
+    }
+    zclock_sleep (50);          //  give the sockets time to connect
+
+    int64_t cpu = s_cpu_usecs ();
+    int64_t start = zclock_usecs ();
+    for (index = 0; index < source_count; index++)
+        zstr_send (sphactor_socket (sources [index]), "BENCH");
+    if (streq (scenario, "pulse"))
+        for (index = 1; index < actors; index++)
+            sphactor_ask_set_timeout (actor [index], options->interval);
+    result->complete = s_wait (&bench, expected);
+    int64_t end = sphactor_atomic_load (&bench.last);
+    if (cpu != -1)
+        cpu = s_cpu_usecs () - cpu;
+    result->rss = s_rss_kb ();
+    result->rss_delta = rss != -1 && result->rss != -1 ? result->rss - rss : -1;
+
+    for (index = 0; index < actors; index++)
+        sphactor_destroy (&actor [index]);
+
+    result->scenario = scenario;
+    result->actors = actors;
+    result->messages = 0;
+    result->usecs = end > start ? end - start : 0;
+    result->p50 = result->p99 = result->max = 0;
+    //  report the slowest sink
+    for (index = 0; index < bench.sinks; index++) {
+        sphactor_histogram_t *latency = bench.latency [index];
+        result->messages += (int64_t) sphactor_histogram_count (latency);
+        uint64_t p50 = sphactor_histogram_percentile (latency, 50.0);
+        uint64_t p99 = sphactor_histogram_percentile (latency, 99.0);
+        uint64_t max = sphactor_histogram_max (latency);
+        result->p50 = p50 > result->p50 ? p50 : result->p50;
+        result->p99 = p99 > result->p99 ? p99 : result->p99;
+        result->max = max > result->max ? max : result->max;
+        sphactor_histogram_destroy (&bench.latency [index]);
+    }
+    result->cpu = cpu;
+    free (bench.data);
+}
+
+static void
+s_print_result (bench_result_t *result, bool json, bool first)
+{
+    double seconds = (double) result->usecs / 1000000.0;
+    double rate = seconds > 0 ? (double) result->messages / seconds : 0;
+    double cpu = result->cpu >= 0 && result->messages > 0
+               ? (double) result->cpu / (double) result->messages : -1;
+    if (json)
+        printf ("%s\n    {\"scenario\":\"%s\",\"actors\":%zu,\"messages\":%" PRId64
+                ",\"complete\":%s,\"seconds\":%.6f,\"msgs_per_sec\":%.0f"
+                ",\"p50_usecs\":%" PRIu64 ",\"p99_usecs\":%" PRIu64 ",\"max_usecs\":%" PRIu64
+                ",\"cpu_usecs_per_msg\":%.3f,\"rss_kb\":%" PRId64 ",\"rss_delta_kb\":%" PRId64 "}",
+                first ? "" : ",", result->scenario, result->actors, result->messages,
+                result->complete ? "true" : "false", seconds, rate,
+                result->p50, result->p99, result->max, cpu, result->rss, result->rss_delta);
+    else
+        printf ("%-9s %3zu actors %9" PRId64 " msgs %10.0f msgs/s  p50 %6" PRIu64
+                " us  p99 %6" PRIu64 " us  cpu %7.3f us/msg  rss %6" PRId64 " kB (+%" PRId64 ")%s\n",
+                result->scenario, result->actors, result->messages, rate,
+                result->p50, result->p99, cpu, result->rss, result->rss_delta,
+                result->complete ? "" : "  INCOMPLETE");
+}
+
+int main (int argc, char *argv [])
+{
+    zargs_t *args = zargs_new (argc, argv);
+    assert (args);
+    zsys_init ();
+    if (zargs_hasx (args, "--help", "-h", NULL)) {
+        zargs_destroy (&args);
+        return s_print_help ();
+    }
+
+    bench_options_t options = { 8, 100000, 500, 16, 1, false, false };
+    const char *value;
+    if ((value = zargs_get (args, "--actors")))
+        options.actors = (size_t) atoi (value);
+    if ((value = zargs_get (args, "--messages")))
+        options.messages = atoll (value);
+    if ((value = zargs_get (args, "--window")))
+        options.window = atoll (value);
+    if ((value = zargs_get (args, "--size")))
+        options.size = (size_t) atoi (value);
+    if ((value = zargs_get (args, "--interval")))
+        options.interval = atoll (value);
+    options.ring = zargs_has (args, "--ring");
+    options.json = zargs_has (args, "--json");
+    if (options.actors < 2 || options.actors > BENCH_MAX_ACTORS
+    ||  options.messages < 1 || options.window < 1 || options.interval < 1) {
+        zsys_error ("sphactor_bench: actors must be 2..%d, messages, window and interval positive",
+                    BENCH_MAX_ACTORS);
+        zargs_destroy (&args);
+        return 1;
+    }
+
+    sphactor_pool_t *pool = NULL;
+    if ((value = zargs_get (args, "--workers"))) {
+        pool = sphactor_pool_new ((size_t) atoi (value));
+        sphactor_pool_set_default (pool);
+    }
+
+    const char *all [] = { "chain", "fanout", "fanin", "pingpong", "pulse", NULL };
+    zlist_t *scenarios = zlist_new ();
+    const char *scenario = zargs_first (args);
+    while (scenario) {
+        zlist_append (scenarios, (void *) scenario);
+        scenario = zargs_next (args);
+    }
+    if (zlist_size (scenarios) == 0) {
+        int index;
+        for (index = 0; all [index]; index++)
+            zlist_append (scenarios, (void *) all [index]);
+    }
+
+    int rc = 0;
+    if (options.json)
+        printf ("{\"actors\":%zu,\"messages\":%" PRId64 ",\"window\":%" PRId64 ",\"size\":%zu"
+                ",\"interval\":%" PRId64 ",\"transport\":\"%s\",\"workers\":%zu,\"results\":[",
+                options.actors, options.messages, options.window, options.size,
+                options.interval, options.ring ? "ring" : "socket",
+                pool ? sphactor_pool_workers (pool) : 0);
+    bool first = true;
+    scenario = (const char *) zlist_first (scenarios);
+    while (scenario && !zsys_interrupted) {
+        int index;
+        for (index = 0; all [index] && !streq (all [index], scenario); index++) ;
+        if (all [index] == NULL) {
+            zsys_error ("sphactor_bench: unknown scenario %s", scenario);
+            rc = 1;
+        }
+        else {
+            bench_result_t result;
+            s_run (all [index], &options, &result);
+            s_print_result (&result, options.json, first);
+            first = false;
+            if (!result.complete)
+                rc = 1;
+        }
+        fflush (stdout);
+        scenario = (const char *) zlist_next (scenarios);
+    }
+    if (options.json)
+        printf ("\n]}\n");
+
+    zlist_destroy (&scenarios);
+    sphactor_pool_destroy (&pool);
+    zargs_destroy (&args);
+    sphactor_dispose ();
+    return rc;
+}
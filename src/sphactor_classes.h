@@ -38,11 +38,39 @@
 //  Private external dependencies
 
 //  Opaque class structures to allow forward references
+#ifndef SPHACTOR_WHEEL_T_DEFINED
+typedef struct _sphactor_wheel_t sphactor_wheel_t;
+#define SPHACTOR_WHEEL_T_DEFINED
+#endif
+#ifndef SPH_STAGE_SNAPSHOT_T_DEFINED
+typedef struct _sph_stage_snapshot_t sph_stage_snapshot_t;
+#define SPH_STAGE_SNAPSHOT_T_DEFINED
+#endif
+#ifndef SPHACTOR_MCAST_T_DEFINED
+typedef struct _sphactor_mcast_t sphactor_mcast_t;
+#define SPHACTOR_MCAST_T_DEFINED
+#endif
+#ifndef SPHACTOR_RING_T_DEFINED
+typedef struct _sphactor_ring_t sphactor_ring_t;
+#define SPHACTOR_RING_T_DEFINED
+#endif
 
 //  Extra headers
+#include "sphactor_atomic.h"
+#include "sphactor_doorbell.h"
+#include "sphactor_command.h"
+#include "sphactor_internal.h"
 
 //  Internal API
 
+#include "sphactor_wheel.h"
+
+#include "sph_stage_snapshot.h"
+
+#include "sphactor_mcast.h"
+
+#include "sphactor_ring.h"
+
 
 //  *** To avoid double-definitions, only define if building without draft ***
 #ifndef SPHACTOR_BUILD_DRAFT_API
@@ -0,0 +1,257 @@
+/*  =========================================================================
+    sphactor_command - binary control commands for actors
+
+    Copyright (c) the Contributors as noted in the AUTHORS file.
+
+    This file is part of Sphactor, an open-source framework for high level
+    actor model concurrency --- http://sphactor.org
+
+    This Source Code Form is subject to the terms of the Mozilla Public
+    License, v. 2.0. If a copy of the MPL was not distributed with this
+    file, You can obtain one at http://mozilla.org/MPL/2.0/.
+    =========================================================================
+*/
+
+/*
+    Actors understand their built-in commands in two forms. The string form
+    ("SET TIMEOUT", "100") is what handlers and older controllers send. The
+    binary form starts with a two byte frame: a zero byte, which no string
+    command starts with, followed by the opcode. Its values follow as native
+    frames: an int64_t or a single byte for booleans. Strings stay strings.
+    The actor indexes its command table by the opcode so the binary form
+    needs no string compares and no number parsing.
+
+    Only the commands actors knew before the binary form have a string
+    form. Every other name, also those of the newer built-in commands,
+    reaches the handler as an API event, so handlers keep their own
+    commands. Every string command is looked up though, so the lookup
+    rejects a name on its length and a character or two before a single
+    compare.
+
+    Commands of handlers start with their name as a string. An int or
+    float value follows as its text, a zero byte, a type byte and the
+    native value. Handlers popping the value as a string get the text,
+    sphactor_actor_pop_int and sphactor_actor_pop_double get the native
+    value without parsing it.
+
+    A BATCH command carries several commands in one message, each preceded
+    by its number of frames as an int64_t. The actor runs them in order and
+    drops their replies.
+
+    A DRAIN command makes the actor handle the messages waiting on its
+    inputs, for at most the given msecs, before it is told to terminate.
+
+    A FUSE command hands the actor a pointer to an actor without a thread.
+    The actor runs it from then on and passes it what it publishes. Like
+    BATCH it only exists in the binary form, a string can't carry a
+    pointer we may trust.
+*/
+
+#ifndef SPHACTOR_COMMAND_H_INCLUDED
+#define SPHACTOR_COMMAND_H_INCLUDED
+
+#define SPHACTOR_COMMAND_START          1
+#define SPHACTOR_COMMAND_STOP           2
+#define SPHACTOR_COMMAND_INSTANCE       3
+#define SPHACTOR_COMMAND_CONNECT        4
+#define SPHACTOR_COMMAND_DISCONNECT     5
+#define SPHACTOR_COMMAND_FILTERS        6
+#define SPHACTOR_COMMAND_FILTER_ADD     7
+#define SPHACTOR_COMMAND_FILTER_REMOVE  8
+#define SPHACTOR_COMMAND_UUID           9
+#define SPHACTOR_COMMAND_NAME           10
+#define SPHACTOR_COMMAND_TYPE           11
+#define SPHACTOR_COMMAND_ENDPOINT       12
+#define SPHACTOR_COMMAND_SEND           13
+#define SPHACTOR_COMMAND_TRIGGER        14
+#define SPHACTOR_COMMAND_SET_NAME       15
+#define SPHACTOR_COMMAND_SET_TYPE       16
+#define SPHACTOR_COMMAND_SET_VERBOSE    17
+#define SPHACTOR_COMMAND_SET_REPORTING  18
+#define SPHACTOR_COMMAND_SET_MULTICAST  19
+#define SPHACTOR_COMMAND_RESET_LATENCY  20
+#define SPHACTOR_COMMAND_SET_BATCH      21
+#define SPHACTOR_COMMAND_SET_TRACING    22
+#define SPHACTOR_COMMAND_SET_TIMEOUT    23
+#define SPHACTOR_COMMAND_TIMEOUT        24
+#define SPHACTOR_COMMAND_CAPABILITY     25
+#define SPHACTOR_COMMAND_BATCH          26
+#define SPHACTOR_COMMAND_DRAIN          27
+#define SPHACTOR_COMMAND_FUSE           28
+#define SPHACTOR_COMMAND_SET_INTERVAL   29
+#define SPHACTOR_COMMAND_COUNT          30  //  Highest opcode + 1
+
+//  Return the string form of an opcode, or NULL if there is none
+
+static inline const char *
+sphactor_command_name (int opcode)
+{
+    static const char *names [SPHACTOR_COMMAND_COUNT] = {
+        NULL,
+        "START", "STOP", "INSTANCE", "CONNECT", "DISCONNECT", "FILTERS",
+        "FILTER ADD", "FILTER REMOVE", "UUID", "NAME", "TYPE", "ENDPOINT",
+        "SEND", "TRIGGER", "SET NAME", "SET TYPE", "SET VERBOSE",
+        "SET REPORTING", "SET MULTICAST", "RESET LATENCY", "SET BATCH",
+        "SET TRACING", "SET TIMEOUT", "TIMEOUT", "CAPABILITY", "BATCH",
+        "DRAIN", "FUSE", "SET INTERVAL"
+    };
+    if (opcode < 1 || opcode >= SPHACTOR_COMMAND_COUNT)
+        return NULL;
+    return names [opcode];
+}
+
+//  Return true if the opcode has a string form, only the commands from
+//  before the binary form have one
+
+static inline bool
+sphactor_command_has_string (int opcode)
+{
+    return (opcode >= SPHACTOR_COMMAND_START && opcode <= SPHACTOR_COMMAND_SET_REPORTING)
+        || (opcode >= SPHACTOR_COMMAND_SET_TIMEOUT && opcode <= SPHACTOR_COMMAND_CAPABILITY);
+}
+
+//  Return the opcode of a built-in string command, or 0 if it is not one.
+//  The selftest of sphactor_actor checks every name with a string form
+//  maps back to its opcode, and the others don't.
+
+static inline int
+sphactor_command_lookup (const char *name)
+{
+    if (name == NULL)
+        return 0;
+    //  Only look at characters within the name, then compare it once
+    int opcode = 0;
+    switch (strlen (name)) {
+        case 4:
+            switch (name [0]) {
+                case 'S': opcode = name [1] == 'T' ? SPHACTOR_COMMAND_STOP : SPHACTOR_COMMAND_SEND; break;
+                case 'U': opcode = SPHACTOR_COMMAND_UUID; break;
+                case 'N': opcode = SPHACTOR_COMMAND_NAME; break;
+                case 'T': opcode = SPHACTOR_COMMAND_TYPE; break;
+            }
+            break;
+        case 5:
+            opcode = SPHACTOR_COMMAND_START;
+            break;
+        case 7:
+            switch (name [0]) {
+                case 'C': opcode = SPHACTOR_COMMAND_CONNECT; break;
+                case 'F': opcode = SPHACTOR_COMMAND_FILTERS; break;
+                case 'T': opcode = name [1] == 'R' ? SPHACTOR_COMMAND_TRIGGER : SPHACTOR_COMMAND_TIMEOUT; break;
+            }
+            break;
+        case 8:
+            switch (name [0]) {
+                case 'I': opcode = SPHACTOR_COMMAND_INSTANCE; break;
+                case 'E': opcode = SPHACTOR_COMMAND_ENDPOINT; break;
+                case 'S': opcode = name [4] == 'N' ? SPHACTOR_COMMAND_SET_NAME : SPHACTOR_COMMAND_SET_TYPE; break;
+            }
+            break;
+        case 10:
+            switch (name [0]) {
+                case 'D': opcode = SPHACTOR_COMMAND_DISCONNECT; break;
+                case 'F': opcode = SPHACTOR_COMMAND_FILTER_ADD; break;
+                case 'C': opcode = SPHACTOR_COMMAND_CAPABILITY; break;
+            }
+            break;
+        case 11:
+            opcode = name [4] == 'V' ? SPHACTOR_COMMAND_SET_VERBOSE : SPHACTOR_COMMAND_SET_TIMEOUT;
+            break;
+        case 13:
+            opcode = name [0] == 'F' ? SPHACTOR_COMMAND_FILTER_REMOVE : SPHACTOR_COMMAND_SET_REPORTING;
+            break;
+    }
+    if (opcode && streq (sphactor_command_name (opcode), name))
+        return opcode;
+    return 0;
+}
+
+//  Return the opcode if the frame starts a binary command, else 0
+
+static inline int
+sphactor_command_opcode (zframe_t *frame)
+{
+    if (frame == NULL || zframe_size (frame) != 2 || zframe_data (frame) [0] != 0)
+        return 0;
+    int opcode = zframe_data (frame) [1];
+    return opcode < SPHACTOR_COMMAND_COUNT ? opcode : 0;
+}
+
+//  Create a binary command message holding just the opcode
+
+static inline zmsg_t *
+sphactor_command_new (int opcode)
+{
+    assert (opcode > 0 && opcode < SPHACTOR_COMMAND_COUNT);
+    byte header [2] = { 0, (byte) opcode };
+    zmsg_t *msg = zmsg_new ();
+    zmsg_addmem (msg, header, sizeof (header));
+    return msg;
+}
+
+//  Append a native value to a binary command
+
+static inline void
+sphactor_command_add_int (zmsg_t *msg, int64_t value)
+{
+    zmsg_addmem (msg, &value, sizeof (value));
+}
+
+static inline void
+sphactor_command_add_bool (zmsg_t *msg, bool value)
+{
+    byte on = value ? 1 : 0;
+    zmsg_addmem (msg, &on, sizeof (on));
+}
+
+//  Append a value for a handler: its text, a zero byte, the type and the
+//  native value, see sphactor_actor_pop_int and sphactor_actor_pop_double
+
+#define SPHACTOR_COMMAND_VALUE_TAIL     (2 + sizeof (int64_t))
+
+static inline void
+sphactor_command_add_value (zmsg_t *msg, const char *text, byte type, const void *value)
+{
+    size_t length = strlen (text);
+    zframe_t *frame = zframe_new (NULL, length + SPHACTOR_COMMAND_VALUE_TAIL);
+    byte *data = zframe_data (frame);
+    memcpy (data, text, length);
+    data [length] = 0;
+    data [length + 1] = type;
+    memcpy (data + length + 2, value, sizeof (int64_t));
+    zmsg_append (msg, &frame);
+}
+
+static inline void
+sphactor_command_add_int_value (zmsg_t *msg, int64_t value)
+{
+    char text [24];
+    snprintf (text, sizeof (text), "%" PRId64, value);
+    sphactor_command_add_value (msg, text, 'i', &value);
+}
+
+static inline void
+sphactor_command_add_double_value (zmsg_t *msg, double value)
+{
+    char text [32];
+    snprintf (text, sizeof (text), "%.17g", value);
+    sphactor_command_add_value (msg, text, 'd', &value);
+}
+
+//  Return the type of a value frame, 'i' or 'd', or 0 if it holds text.
+//  Copies the native value to value.
+
+static inline byte
+sphactor_command_value_type (zframe_t *frame, void *value)
+{
+    size_t size = frame ? zframe_size (frame) : 0;
+    if (size < SPHACTOR_COMMAND_VALUE_TAIL)
+        return 0;
+    byte *tail = zframe_data (frame) + size - SPHACTOR_COMMAND_VALUE_TAIL;
+    if (tail [0] != 0 || (tail [1] != 'i' && tail [1] != 'd'))
+        return 0;
+    memcpy (value, tail + 2, sizeof (int64_t));
+    return tail [1];
+}
+
+#endif
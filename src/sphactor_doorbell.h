@@ -0,0 +1,134 @@
+/*  =========================================================================
+    sphactor_doorbell - pollable wakeup for the lock-free queues
+
+    Copyright (c) the Contributors as noted in the AUTHORS file.
+
+    This file is part of Sphactor, an open-source framework for high level
+    actor model concurrency --- http://sphactor.org
+
+    This Source Code Form is subject to the terms of the Mozilla Public
+    License, v. 2.0. If a copy of the MPL was not distributed with this
+    file, You can obtain one at http://mozilla.org/MPL/2.0/.
+    =========================================================================
+*/
+
+/*
+    A doorbell is something a zpoller can wait on and any thread can make
+    readable: an eventfd on Linux, a pipe on other UNIX systems and a PAIR
+    socket pair on Windows. It stays readable until it is silenced. The
+    queues only ring it when their reader said it is waiting so a burst of
+    messages costs a single system call.
+*/
+
+#ifndef SPHACTOR_DOORBELL_H_INCLUDED
+#define SPHACTOR_DOORBELL_H_INCLUDED
+
+#if defined (__UTYPE_LINUX)
+#include <sys/eventfd.h>
+#endif
+
+typedef struct {
+#if defined (__WINDOWS__)
+    zsock_t *reader;            //  Polled by the reader
+    zsock_t *writer;            //  Rings the doorbell
+    sphactor_atomic_int_t lock; //  Serializes the threads using the writer
+#else
+    int     fds [2];            //  Read and write end, the same eventfd on Linux
+#endif
+} sphactor_doorbell_t;
+
+static inline void
+sphactor_doorbell_init (sphactor_doorbell_t *self)
+{
+#if defined (__WINDOWS__)
+    self->reader = zsys_create_pipe (&self->writer);
+    assert (self->reader);
+    zsock_set_rcvtimeo (self->reader, 0);
+    sphactor_atomic_store (&self->lock, 0);
+#elif defined (__UTYPE_LINUX)
+    self->fds [0] = eventfd (0, EFD_NONBLOCK | EFD_CLOEXEC);
+    assert (self->fds [0] != -1);
+    self->fds [1] = self->fds [0];
+#else
+    int rc = pipe (self->fds);
+    assert (rc == 0);
+    int i;
+    for (i = 0; i < 2; i++) {
+        rc = fcntl (self->fds [i], F_SETFL, O_NONBLOCK);
+        assert (rc == 0);
+        rc = fcntl (self->fds [i], F_SETFD, FD_CLOEXEC);
+        assert (rc == 0);
+    }
+#endif
+}
+
+static inline void
+sphactor_doorbell_term (sphactor_doorbell_t *self)
+{
+#if defined (__WINDOWS__)
+    zsock_destroy (&self->writer);
+    zsock_destroy (&self->reader);
+#else
+    close (self->fds [0]);
+    if (self->fds [1] != self->fds [0])
+        close (self->fds [1]);
+#endif
+}
+
+//  Return the handle to add to a zpoller
+
+static inline void *
+sphactor_doorbell_handle (sphactor_doorbell_t *self)
+{
+#if defined (__WINDOWS__)
+    return self->reader;
+#else
+    return &self->fds [0];
+#endif
+}
+
+//  Make the doorbell readable, may be called from any thread
+
+static inline void
+sphactor_doorbell_ring (sphactor_doorbell_t *self)
+{
+#if defined (__WINDOWS__)
+    //  libzmq sockets may change threads with a full fence in between
+    while (!sphactor_atomic_cas (&self->lock, 0, 1))
+        ;
+    zsock_signal (self->writer, 0);
+    sphactor_atomic_store (&self->lock, 0);
+#elif defined (__UTYPE_LINUX)
+    uint64_t one = 1;
+    ssize_t rc = write (self->fds [1], &one, sizeof (one));
+    assert (rc == sizeof (one));
+#else
+    char one = 1;
+    ssize_t rc = write (self->fds [1], &one, sizeof (one));
+    assert (rc == sizeof (one));
+#endif
+}
+
+//  Make the doorbell unreadable, reader only
+
+static inline void
+sphactor_doorbell_silence (sphactor_doorbell_t *self)
+{
+#if defined (__WINDOWS__)
+    zframe_t *frame = zframe_recv (self->reader);
+    while (frame) {
+        zframe_destroy (&frame);
+        frame = zframe_recv (self->reader);
+    }
+#elif defined (__UTYPE_LINUX)
+    uint64_t count;
+    ssize_t rc = read (self->fds [0], &count, sizeof (count));
+    assert (rc == sizeof (count) || errno == EAGAIN);
+#else
+    char buffer [16];
+    while (read (self->fds [0], buffer, sizeof (buffer)) > 0)
+        ;
+#endif
+}
+
+#endif
@@ -0,0 +1,394 @@
+/*  =========================================================================
+    sphactor_future - class description
+
+    Copyright (c) the Contributors as noted in the AUTHORS file.
+
+    This file is part of Sphactor, an open-source framework for high level
+    actor model concurrency --- http://sphactor.org
+
+    This Source Code Form is subject to the terms of the Mozilla Public
+    License, v. 2.0. If a copy of the MPL was not distributed with this
+    file, You can obtain one at http://mozilla.org/MPL/2.0/.
+    =========================================================================
+*/
+
+/*
+@header
+    sphactor_future - reply to a request which is still in flight
+@discuss
+    Asking an actor something costs a round trip over its pipe. A future
+    lets the controller send its requests to many actors first and collect
+    the replies later, with a single poll over all their pipes.
+
+    An actor answers its requests in order, so the futures of a pipe are
+    queued in a pending list and a reply always completes the head of the
+    list. Whoever reads replies from the pipe must go through the list,
+    blocking calls on the pipe must wait for its pending futures first.
+@end
+*/
+
+#include "sphactor_classes.h"
+
+//  Structure of our class
+
+struct _sphactor_future_t {
+    void    *pipe;                  //  Pipe of the reply, NULL once ready
+    zlist_t *pending;               //  Pending futures of the pipe, NULL once ready
+    zmsg_t  *reply;                 //  The reply, NULL until it arrives
+    sphactor_future_fn *handler;    //  Called when the reply arrives
+    void    *args;                  //  Arguments of the handler
+    bool    abandoned;              //  Destroyed while in flight
+    bool    waited;                 //  Waited for by sphactor_future_wait_all
+};
+
+//  A pipe sphactor_future_wait_all polls
+
+typedef struct {
+    zlist_t *pending;               //  Pending futures of the pipe
+    size_t  waiting;                //  Number of them we wait for
+} future_pipe_t;
+
+//  --------------------------------------------------------------------------
+//  Create a new sphactor_future
+
+sphactor_future_t *
+sphactor_future_new (zsock_t *pipe, zlist_t *pending, zmsg_t **request_p)
+{
+    assert (pipe);
+    assert (pending);
+    assert (request_p && *request_p);
+    sphactor_future_t *self = (sphactor_future_t *) zmalloc (sizeof (sphactor_future_t));
+    assert (self);
+    self->pipe = pipe;
+    self->pending = pending;
+    zlist_append (pending, self);
+    int rc = zmsg_send (request_p, pipe);
+    assert (rc == 0);
+    return self;
+}
+
+sphactor_future_t *
+sphactor_future_new_ready (zmsg_t **reply_p)
+{
+    assert (reply_p && *reply_p);
+    sphactor_future_t *self = (sphactor_future_t *) zmalloc (sizeof (sphactor_future_t));
+    assert (self);
+    self->reply = *reply_p;
+    *reply_p = NULL;
+    return self;
+}
+
+
+//  --------------------------------------------------------------------------
+//  Destroy the sphactor_future
+
+void
+sphactor_future_destroy (sphactor_future_t **self_p)
+{
+    assert (self_p);
+    if (*self_p) {
+        sphactor_future_t *self = *self_p;
+        //  The reply must be taken off the pipe, else the next reply on
+        //  the pipe would complete the wrong future. If we can't wait
+        //  the pending list frees us once it arrives.
+        if (self->reply == NULL && sphactor_future_wait (self, -1) == -1)
+            self->abandoned = true;
+        else
+        {
+            zmsg_destroy (&self->reply);
+            free (self);
+        }
+        *self_p = NULL;
+    }
+}
+
+void
+sphactor_future_set_handler (sphactor_future_t *self, sphactor_future_fn handler, void *args)
+{
+    assert (self);
+    self->handler = handler;
+    self->args = args;
+}
+
+bool
+sphactor_future_ready (sphactor_future_t *self)
+{
+    assert (self);
+    return self->reply != NULL;
+}
+
+zmsg_t *
+sphactor_future_reply (sphactor_future_t *self)
+{
+    assert (self);
+    return self->reply;
+}
+
+//  Receive the next reply on the pipe of the pending list, which belongs
+//  to the head of the list. Returns -1 if interrupted.
+
+static int
+s_future_recv (zlist_t *pending)
+{
+    sphactor_future_t *head = (sphactor_future_t *) zlist_first (pending);
+    assert (head);
+    zmsg_t *reply = zmsg_recv (head->pipe);
+    if (reply == NULL)
+        return -1;
+    zlist_pop (pending);
+    head->reply = reply;
+    head->pipe = NULL;
+    head->pending = NULL;
+    if (head->handler)
+        head->handler (head, reply, head->args);
+    if (head->abandoned)
+    {
+        zmsg_destroy (&head->reply);
+        free (head);
+    }
+    return 0;
+}
+
+//  Return the msecs left until the deadline, -1 if there is none
+
+static int
+s_future_remaining (int64_t deadline)
+{
+    if (deadline < 0)
+        return -1;
+    int64_t remaining = deadline - zclock_mono ();
+    return remaining > 0 ? (int) remaining : 0;
+}
+
+int
+sphactor_future_wait (sphactor_future_t *self, int timeout)
+{
+    assert (self);
+    if (self->reply)
+        return 0;
+    void *pipe = self->pipe;
+    zlist_t *pending = self->pending;
+    int64_t deadline = timeout >= 0 ? zclock_mono () + timeout : -1;
+    zpoller_t *poller = zpoller_new (pipe, NULL);
+    int rc = 0;
+    while (self->reply == NULL)
+    {
+        if (zpoller_wait (poller, s_future_remaining (deadline)) == NULL
+        ||  s_future_recv (pending) == -1)
+        {
+            rc = -1;
+            break;
+        }
+    }
+    zpoller_destroy (&poller);
+    return rc;
+}
+
+//  Return the key of a pipe in the pipes of sphactor_future_wait_all
+
+static char *
+s_future_pipe_key (void *pipe, char *key, size_t size)
+{
+    snprintf (key, size, "%p", pipe);
+    return key;
+}
+
+int
+sphactor_future_wait_all (zlist_t *futures, int timeout)
+{
+    assert (futures);
+    int64_t deadline = timeout >= 0 ? zclock_mono () + timeout : -1;
+    zpoller_t *poller = zpoller_new (NULL);
+    zhash_t *pipes = zhash_new ();
+    char key [32];
+    size_t waiting = 0;
+    sphactor_future_t *future = (sphactor_future_t *) zlist_first (futures);
+    while (future)
+    {
+        if (future->reply == NULL && !future->waited)
+        {
+            future->waited = true;
+            waiting++;
+            s_future_pipe_key (future->pipe, key, sizeof (key));
+            future_pipe_t *pipe = (future_pipe_t *) zhash_lookup (pipes, key);
+            if (pipe == NULL)
+            {
+                pipe = (future_pipe_t *) zmalloc (sizeof (future_pipe_t));
+                assert (pipe);
+                pipe->pending = future->pending;
+                zhash_insert (pipes, key, pipe);
+                zhash_freefn (pipes, key, free);
+                zpoller_add (poller, future->pipe);
+            }
+            pipe->waiting++;
+        }
+        future = (sphactor_future_t *) zlist_next (futures);
+    }
+    int rc = 0;
+    while (waiting > 0)
+    {
+        void *which = zpoller_wait (poller, s_future_remaining (deadline));
+        if (which == NULL)
+        {
+            rc = -1;
+            break;
+        }
+        future_pipe_t *pipe = (future_pipe_t *) zhash_lookup (pipes,
+                              s_future_pipe_key (which, key, sizeof (key)));
+        assert (pipe && pipe->waiting > 0);
+        sphactor_future_t *head = (sphactor_future_t *) zlist_first (pipe->pending);
+        bool ours = head->waited;
+        head->waited = false;
+        if (s_future_recv (pipe->pending) == -1)
+        {
+            rc = -1;
+            break;
+        }
+        if (ours)
+        {
+            waiting--;
+            //  the rest of the replies on this pipe aren't ours
+            if (--pipe->waiting == 0)
+                zpoller_remove (poller, which);
+        }
+    }
+    //  the futures we gave up on can be waited for again
+    future = (sphactor_future_t *) zlist_first (futures);
+    while (future)
+    {
+        future->waited = false;
+        future = (sphactor_future_t *) zlist_next (futures);
+    }
+    zhash_destroy (&pipes);
+    zpoller_destroy (&poller);
+    return rc;
+}
+
+//  --------------------------------------------------------------------------
+//  Self test of this class
+
+//  Replies with a copy of each request after a little while
+static void
+s_echo_actor (zsock_t *pipe, void *args)
+{
+    zsock_signal (pipe, 0);
+    while (true)
+    {
+        zmsg_t *msg = zmsg_recv (pipe);
+        if (!msg)
+            break;
+        char *command = zmsg_popstr (msg);
+        bool term = command && streq (command, "$TERM");
+        zmsg_pushstr (msg, command ? command : "");
+        zstr_free (&command);
+        if (term)
+        {
+            zmsg_destroy (&msg);
+            break;
+        }
+        zclock_sleep (1);
+        zmsg_send (&msg, pipe);
+    }
+}
+
+static void
+s_count_reply (sphactor_future_t *self, zmsg_t *reply, void *args)
+{
+    assert (reply);
+    (*(int *) args)++;
+}
+
+void
+sphactor_future_test (bool verbose)
+{
+    printf (" * sphactor_future: ");
+
+    //  @selftest
+    //  Simple create/destroy test
+    zmsg_t *reply = zmsg_new ();
+    zmsg_addstr (reply, "CACHED");
+    sphactor_future_t *self = sphactor_future_new_ready (&reply);
+    assert (self);
+    assert (reply == NULL);
+    assert (sphactor_future_ready (self));
+    assert (sphactor_future_wait (self, 0) == 0);
+    sphactor_future_destroy (&self);
+
+    //  Requests on a pipe complete in order
+    zactor_t *echo = zactor_new (s_echo_actor, NULL);
+    zlist_t *pending = zlist_new ();
+    int replies = 0;
+    zmsg_t *request = zmsg_new ();
+    zmsg_addstr (request, "FIRST");
+    sphactor_future_t *first = sphactor_future_new ((zsock_t *) echo, pending, &request);
+    sphactor_future_set_handler (first, s_count_reply, &replies);
+    request = zmsg_new ();
+    zmsg_addstr (request, "SECOND");
+    sphactor_future_t *second = sphactor_future_new ((zsock_t *) echo, pending, &request);
+    sphactor_future_set_handler (second, s_count_reply, &replies);
+    assert (!sphactor_future_ready (second));
+    assert (sphactor_future_wait (second, -1) == 0);
+    assert (sphactor_future_ready (first));
+    assert (replies == 2);
+    char *str = zmsg_popstr (sphactor_future_reply (first));
+    assert (streq (str, "FIRST"));
+    zstr_free (&str);
+    str = zmsg_popstr (sphactor_future_reply (second));
+    assert (streq (str, "SECOND"));
+    zstr_free (&str);
+    assert (zlist_size (pending) == 0);
+    sphactor_future_destroy (&first);
+    sphactor_future_destroy (&second);
+
+    //  Destroying a future in flight takes its reply off the pipe
+    request = zmsg_new ();
+    zmsg_addstr (request, "DROPPED");
+    first = sphactor_future_new ((zsock_t *) echo, pending, &request);
+    sphactor_future_destroy (&first);
+    assert (zlist_size (pending) == 0);
+
+    //  Many requests to many actors complete with a single poll
+#define ECHOS 4
+#define REQUESTS 8
+    zactor_t *echos [ECHOS];
+    zlist_t *pendings [ECHOS];
+    zlist_t *futures = zlist_new ();
+    int i, j;
+    for (i = 0; i < ECHOS; i++)
+    {
+        echos [i] = zactor_new (s_echo_actor, NULL);
+        pendings [i] = zlist_new ();
+    }
+    for (j = 0; j < REQUESTS; j++)
+    {
+        for (i = 0; i < ECHOS; i++)
+        {
+            request = zmsg_new ();
+            zmsg_addstrf (request, "%d", j);
+            zlist_append (futures, sphactor_future_new ((zsock_t *) echos [i], pendings [i], &request));
+        }
+    }
+    assert (sphactor_future_wait_all (futures, -1) == 0);
+    j = 0;
+    sphactor_future_t *future = (sphactor_future_t *) zlist_first (futures);
+    while (future)
+    {
+        assert (sphactor_future_ready (future));
+        str = zmsg_popstr (sphactor_future_reply (future));
+        assert (atoi (str) == j++ / ECHOS);
+        zstr_free (&str);
+        sphactor_future_destroy (&future);
+        future = (sphactor_future_t *) zlist_next (futures);
+    }
+    zlist_destroy (&futures);
+    for (i = 0; i < ECHOS; i++)
+    {
+        assert (zlist_size (pendings [i]) == 0);
+        zlist_destroy (&pendings [i]);
+        zactor_destroy (&echos [i]);
+    }
+    zlist_destroy (&pending);
+    zactor_destroy (&echo);
+    //  @end
+    printf ("OK\n");
+}
@@ -0,0 +1,287 @@
+/*  =========================================================================
+    sphactor_histogram - class description
+
+    Copyright (c) the Contributors as noted in the AUTHORS file.
+
+    This file is part of Sphactor, an open-source framework for high level
+    actor model concurrency --- http://sphactor.org
+
+    This Source Code Form is subject to the terms of the Mozilla Public
+    License, v. 2.0. If a copy of the MPL was not distributed with this
+    file, You can obtain one at http://mozilla.org/MPL/2.0/.
+    =========================================================================
+*/
+
+/*
+@header
+    sphactor_histogram - log-bucketed latency histogram
+@discuss
+    Values below 16 get a bucket each. Above that every power of 2 is
+    split into 16 buckets, so a bucket is never wider than 1/16th of the
+    values it holds. Recording is a few shifts and a store, percentiles
+    walk the buckets.
+
+    The actor records into its own histograms, the controller copies
+    them into its report. Counts are atomics only written by the recording
+    thread so a copy is never torn, though it may miss the values recorded
+    while copying.
+@end
+*/
+
+#include "sphactor_classes.h"
+
+//  Values get 2^SUB_BITS buckets per power of 2
+#define SUB_BITS    4
+#define SUB_COUNT   (1 << SUB_BITS)
+//  Largest power of 2 we keep apart, about 38 hours in microseconds
+#define MAX_BIT     36
+#define MAX_VALUE   ((((uint64_t) 1) << (MAX_BIT + 1)) - 1)
+#define BUCKETS     ((MAX_BIT - SUB_BITS + 2) * SUB_COUNT)
+
+//  Structure of our class
+
+struct _sphactor_histogram_t {
+    sphactor_atomic_int_t count;            //  Number of values
+    sphactor_atomic_int_t max;              //  Largest value
+    sphactor_atomic_int_t buckets [BUCKETS];    //  Number of values per bucket
+};
+
+//  Forward declarations
+static size_t
+    s_bucket (uint64_t value);
+static uint64_t
+    s_bucket_value (size_t bucket);
+
+
+//  --------------------------------------------------------------------------
+//  Constructor, creates an empty histogram.
+
+sphactor_histogram_t *
+sphactor_histogram_new (void)
+{
+    sphactor_histogram_t *self = (sphactor_histogram_t *) zmalloc (sizeof (sphactor_histogram_t));
+    assert (self);
+    sphactor_histogram_reset (self);
+    return self;
+}
+
+
+//  --------------------------------------------------------------------------
+//  Destructor, destroys a histogram.
+
+void
+sphactor_histogram_destroy (sphactor_histogram_t **self_p)
+{
+    assert (self_p);
+    if (*self_p) {
+        sphactor_histogram_t *self = *self_p;
+        free (self);
+        *self_p = NULL;
+    }
+}
+
+
+//  --------------------------------------------------------------------------
+//  Record a value in microseconds. Only one thread may record into a
+//  histogram.
+
+void
+sphactor_histogram_record (sphactor_histogram_t *self, uint64_t value)
+{
+    assert (self);
+    if (value > MAX_VALUE)
+        value = MAX_VALUE;
+    //  We're the only writer so there's no need for atomic increments
+    sphactor_atomic_int_t *bucket = &self->buckets [s_bucket (value)];
+    sphactor_atomic_store_relaxed (bucket, sphactor_atomic_load_relaxed (bucket) + 1);
+    sphactor_atomic_store_relaxed (&self->count, sphactor_atomic_load_relaxed (&self->count) + 1);
+    if ((int64_t) value > sphactor_atomic_load_relaxed (&self->max))
+        sphactor_atomic_store_relaxed (&self->max, (int64_t) value);
+}
+
+
+//  --------------------------------------------------------------------------
+//  Return the number of recorded values
+
+uint64_t
+sphactor_histogram_count (sphactor_histogram_t *self)
+{
+    assert (self);
+    return (uint64_t) sphactor_atomic_load_relaxed (&self->count);
+}
+
+
+//  --------------------------------------------------------------------------
+//  Return the largest recorded value, 0 if there are none
+
+uint64_t
+sphactor_histogram_max (sphactor_histogram_t *self)
+{
+    assert (self);
+    return (uint64_t) sphactor_atomic_load_relaxed (&self->max);
+}
+
+
+//  --------------------------------------------------------------------------
+//  Return the value below which the given percentage of the recorded
+//  values lie, e.g. 99.9 for p999. Returns 0 if there are no values.
+
+uint64_t
+sphactor_histogram_percentile (sphactor_histogram_t *self, double percentile)
+{
+    assert (self);
+    assert (percentile >= 0.0 && percentile <= 100.0);
+    int64_t count = sphactor_atomic_load_relaxed (&self->count);
+    if (count == 0)
+        return 0;
+    int64_t wanted = (int64_t) ceil (percentile / 100.0 * (double) count);
+    if (wanted < 1)
+        wanted = 1;
+    uint64_t max = sphactor_histogram_max (self);
+    int64_t seen = 0;
+    size_t bucket;
+    for (bucket = 0; bucket < BUCKETS; bucket++) {
+        seen += sphactor_atomic_load_relaxed (&self->buckets [bucket]);
+        if (seen >= wanted) {
+            uint64_t value = s_bucket_value (bucket);
+            return value < max ? value : max;
+        }
+    }
+    return max;
+}
+
+
+//  --------------------------------------------------------------------------
+//  Remove all recorded values, only the recording thread may do this.
+
+void
+sphactor_histogram_reset (sphactor_histogram_t *self)
+{
+    assert (self);
+    size_t bucket;
+    for (bucket = 0; bucket < BUCKETS; bucket++)
+        sphactor_atomic_store_relaxed (&self->buckets [bucket], 0);
+    sphactor_atomic_store_relaxed (&self->max, 0);
+    sphactor_atomic_store (&self->count, 0);
+}
+
+
+//  --------------------------------------------------------------------------
+//  Copy the recorded values into dest, may be called while another
+//  thread records into the histogram.
+
+void
+sphactor_histogram_copy (sphactor_histogram_t *self, sphactor_histogram_t *dest)
+{
+    assert (self);
+    assert (dest);
+    //  Count what we copy so the count matches the buckets
+    int64_t count = 0;
+    size_t bucket;
+    for (bucket = 0; bucket < BUCKETS; bucket++) {
+        int64_t value = sphactor_atomic_load_relaxed (&self->buckets [bucket]);
+        sphactor_atomic_store_relaxed (&dest->buckets [bucket], value);
+        count += value;
+    }
+    sphactor_atomic_store_relaxed (&dest->max, sphactor_atomic_load_relaxed (&self->max));
+    sphactor_atomic_store (&dest->count, count);
+}
+
+
+//  Return the bucket holding the value
+
+static size_t
+s_bucket (uint64_t value)
+{
+    if (value < SUB_COUNT)
+        return (size_t) value;
+#if defined (__GNUC__)
+    int bit = 63 - __builtin_clzll (value);
+#elif defined (_MSC_VER)
+    unsigned long bit;
+    _BitScanReverse64 (&bit, value);
+#else
+    int bit = SUB_BITS;
+    while (value >> (bit + 1))
+        bit++;
+#endif
+    return (size_t) ((bit - SUB_BITS + 1) * SUB_COUNT
+                   + ((value >> (bit - SUB_BITS)) & (SUB_COUNT - 1)));
+}
+
+
+//  Return the largest value in the bucket
+
+static uint64_t
+s_bucket_value (size_t bucket)
+{
+    if (bucket < SUB_COUNT)
+        return (uint64_t) bucket;
+    int shift = (int) (bucket / SUB_COUNT) - 1;
+    uint64_t low = (uint64_t) (SUB_COUNT + bucket % SUB_COUNT) << shift;
+    return low + (((uint64_t) 1) << shift) - 1;
+}
+
+
+//  --------------------------------------------------------------------------
+//  Self test of this class
+
+void
+sphactor_histogram_test (bool verbose)
+{
+    printf (" * sphactor_histogram: ");
+
+    //  @selftest
+    //  Simple create/destroy test
+    sphactor_histogram_t *self = sphactor_histogram_new ();
+    assert (self);
+    assert (sphactor_histogram_count (self) == 0);
+    assert (sphactor_histogram_percentile (self, 50.0) == 0);
+
+    //  Small values are exact
+    uint64_t value;
+    for (value = 1; value <= 10; value++)
+        sphactor_histogram_record (self, value);
+    assert (sphactor_histogram_count (self) == 10);
+    assert (sphactor_histogram_max (self) == 10);
+    assert (sphactor_histogram_percentile (self, 50.0) == 5);
+    assert (sphactor_histogram_percentile (self, 100.0) == 10);
+
+    //  Large values are within 1/16th
+    sphactor_histogram_reset (self);
+    assert (sphactor_histogram_count (self) == 0);
+    for (value = 1; value <= 100000; value++)
+        sphactor_histogram_record (self, value);
+    uint64_t p50 = sphactor_histogram_percentile (self, 50.0);
+    uint64_t p99 = sphactor_histogram_percentile (self, 99.0);
+    uint64_t p999 = sphactor_histogram_percentile (self, 99.9);
+    if (verbose)
+        zsys_info ("sphactor_histogram: p50 %" PRIu64 " p99 %" PRIu64 " p999 %" PRIu64,
+                   p50, p99, p999);
+    assert (p50 >= 50000 && p50 <= 50000 + 50000 / 16);
+    assert (p99 >= 99000 && p99 <= 100000);
+    assert (p999 >= 99900 && p999 <= 100000);
+    assert (sphactor_histogram_max (self) == 100000);
+
+    //  Every bucket holds the values that map to it
+    size_t bucket;
+    for (bucket = 1; bucket < BUCKETS; bucket++) {
+        assert (s_bucket (s_bucket_value (bucket)) == bucket);
+        assert (s_bucket (s_bucket_value (bucket - 1) + 1) == bucket);
+    }
+    sphactor_histogram_record (self, UINT64_MAX);
+    assert (sphactor_histogram_max (self) == MAX_VALUE);
+
+    //  A copy has the same percentiles
+    sphactor_histogram_t *copy = sphactor_histogram_new ();
+    sphactor_histogram_copy (self, copy);
+    assert (sphactor_histogram_count (copy) == 100001);
+    assert (sphactor_histogram_percentile (copy, 99.0) == p99);
+    sphactor_histogram_destroy (&copy);
+
+    sphactor_histogram_destroy (&self);
+    assert (self == NULL);
+    //  @end
+
+    printf ("OK\n");
+}
@@ -0,0 +1,86 @@
+/*  =========================================================================
+    sphactor_internal - private methods shared between classes
+
+    Copyright (c) the Contributors as noted in the AUTHORS file.
+
+    This file is part of Sphactor, an open-source framework for high level
+    actor model concurrency --- http://sphactor.org
+
+    This Source Code Form is subject to the terms of the Mozilla Public
+    License, v. 2.0. If a copy of the MPL was not distributed with this
+    file, You can obtain one at http://mozilla.org/MPL/2.0/.
+    =========================================================================
+*/
+
+/*
+    Methods of sphactor_actor and sphactor which other classes of the
+    library call but which aren't part of the API. Declare them here, not
+    in the files calling them, so their signatures can't drift apart.
+*/
+
+#ifndef SPHACTOR_INTERNAL_H_INCLUDED
+#define SPHACTOR_INTERNAL_H_INCLUDED
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//  This is the actor which runs in its own thread, args is a
+//  sphactor_shim_t.
+SPHACTOR_PRIVATE void
+    sphactor_actor_run (zsock_t *pipe, void *args);
+
+//  Running the actor in a sphactor_pool or sphactor_tick instead of its
+//  own thread. Only the pool or tick may call these and only while the
+//  actor is not running!
+SPHACTOR_PRIVATE void
+    sphactor_actor_set_pooled (sphactor_actor_t *self, bool pooled);
+
+SPHACTOR_PRIVATE void
+    sphactor_actor_set_ticked (sphactor_actor_t *self, bool ticked);
+
+SPHACTOR_PRIVATE zlist_t *
+    sphactor_actor_readers (sphactor_actor_t *self);
+
+SPHACTOR_PRIVATE int64_t
+    sphactor_actor_time_next (sphactor_actor_t *self);
+
+SPHACTOR_PRIVATE bool
+    sphactor_actor_terminated (sphactor_actor_t *self);
+
+//  Handle a command waiting on the actor's pipe. Returns -1 if interrupted.
+SPHACTOR_PRIVATE int
+    sphactor_actor_recv_pipe (sphactor_actor_t *self);
+
+SPHACTOR_PRIVATE const char *
+    sphactor_actor_endpoint (sphactor_actor_t *self);
+
+SPHACTOR_PRIVATE zlist_t *
+    sphactor_actor_connections (sphactor_actor_t *self);
+
+//  Call the handler with a message from an actor upstream, or without one
+//  as a timer event, and return its reply instead of publishing it.
+SPHACTOR_PRIVATE zmsg_t *
+    sphactor_actor_handle (sphactor_actor_t *self, zmsg_t *msg);
+
+//  Look up the type of an actor config and run its constructor on the
+//  calling thread. Returns what sphactor_load_prepared takes, NULL if the
+//  type isn't registered.
+SPHACTOR_PRIVATE void *
+    sphactor_load_prepare (const zconfig_t *config);
+
+//  Create the actor of a config prepared by sphactor_load_prepare, from
+//  any thread.
+SPHACTOR_PRIVATE sphactor_t *
+    sphactor_load_prepared (const zconfig_t *config, void *prepared);
+
+//  Call rename_fn with args whenever the name of the actor is set, pass
+//  NULL to stop.
+SPHACTOR_PRIVATE void
+    sphactor_set_rename_fn (sphactor_t *self, void (*rename_fn) (sphactor_t *self, void *args), void *args);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
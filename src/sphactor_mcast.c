@@ -0,0 +1,748 @@
+/*  =========================================================================
+    sphactor_mcast - class description
+
+    Copyright (c) the Contributors as noted in the AUTHORS file.
+
+    This file is part of Sphactor, an open-source framework for high level
+    actor model concurrency --- http://sphactor.org
+
+    This Source Code Form is subject to the terms of the Mozilla Public
+    License, v. 2.0. If a copy of the MPL was not distributed with this
+    file, You can obtain one at http://mozilla.org/MPL/2.0/.
+    =========================================================================
+*/
+
+/*
+@header
+    sphactor_mcast - lock-free multicast ring for actors with many readers
+@discuss
+    A pub socket copies or refcounts every message into the pipe of every
+    subscriber, so an actor feeding many others spends its time on fan-out.
+    A multicast ring is written once per message, in the style of the LMAX
+    disruptor. Every reader has its own cursor into the ring and takes its
+    own copy of a message when it reads it, on its own thread.
+
+    A slot keeps the frames of the published message in an array, so
+    readers never touch the message's frame list, which isn't safe to share
+    between threads. The producer and the readers get frames pointing at
+    the data of those frames (zframe_frommem), each holding a reference to
+    the slot's message, so nothing is copied no matter how many readers
+    there are. The frames of the message are freed once the slot is
+    overwritten and the last of those frames is gone. Frames carrying a
+    payload (see sphactor_payload) keep pointing at the payload.
+
+    When the slowest reader is a whole ring behind the producer either
+    blocks until it catches up, overwrites the oldest message, moving the
+    reader's cursor past it, or drops the new message. A reader copying a
+    message marks it so the producer won't overwrite it under its feet.
+
+    Every reader has its own doorbell (see sphactor_doorbell.h), rung when
+    the reader said it is waiting.
+@end
+*/
+
+#include "sphactor_classes.h"
+
+//  Default number of messages in a multicast ring
+#define SPHACTOR_MCAST_SIZE 1024
+
+//  Spins before a blocked producer starts sleeping
+#define SPHACTOR_MCAST_SPINS 1000
+
+//  The frames of a published message
+
+typedef struct {
+    sphactor_atomic_int_t refs;     //  The slot and the frames sharing ours
+    size_t  size;                   //  Number of frames
+    zframe_t *frames [1];           //  The frames
+} mcast_msg_t;
+
+//  A reader and its cursor
+
+typedef struct {
+    sphactor_atomic_int_t cursor;   //  Next sequence to read
+    sphactor_atomic_int_t reading;  //  Sequence being copied, -1 if none
+    sphactor_atomic_int_t waiting;  //  Is the reader waiting for the doorbell?
+    sphactor_atomic_int_t lost;     //  Messages lost to the overwrite policy
+    sphactor_atomic_int_t detached; //  Was the reader detached?
+    int64_t tail_cache;             //  Reader's copy of tail
+    int64_t time;                   //  When the last popped message was published
+    sphactor_doorbell_t doorbell;   //  Polled by the reader
+    char    pad [64];               //  keep readers off each other's cache line
+} mcast_reader_t;
+
+//  The attached readers. Attaching and detaching replaces the list instead
+//  of changing it so the producer can walk it without a lock.
+
+typedef struct _mcast_readers_t {
+    struct _mcast_readers_t *retired;   //  Replaced list, freed last
+    size_t  size;                       //  Number of readers
+    mcast_reader_t *readers [1];        //  The readers
+} mcast_readers_t;
+
+//  Structure of our class
+
+struct _sphactor_mcast_t {
+    sphactor_atomic_int_t tail; //  Next sequence to publish
+    char    tail_pad [64];      //  keep the producer off the readers' cache line
+    int64_t size;               //  Number of slots, a power of 2
+    mcast_msg_t **slots;        //  The published messages
+    int64_t *times;             //  When the messages were published
+    sphactor_atomic_int_t policy;   //  What to do when the ring is full
+    sphactor_atomic_int_t dropped;  //  Messages dropped by the drop policy
+    sphactor_atomic_ptr_t readers;  //  mcast_readers_t of the attached readers
+    sphactor_atomic_int_t attached; //  Number of attached readers, for any thread
+    zlist_t *detached;          //  Detached readers, the producer might still
+                                //  ring them so free them last
+    sphactor_atomic_int_t locked;   //  Serializes attach and detach
+    sphactor_atomic_int_t refs;     //  Number of references
+};
+
+//  Forward declarations
+static int
+    s_mcast_make_room (sphactor_mcast_t *self, int64_t oldest);
+static void
+    s_mcast_replace (sphactor_mcast_t *self, mcast_reader_t *add, mcast_reader_t *remove);
+static mcast_msg_t *
+    s_mcast_msg_new (zmsg_t *msg);
+static void
+    s_mcast_msg_destroy (mcast_msg_t **self_p);
+static void
+    s_mcast_msg_share (mcast_msg_t *self, zmsg_t *msg);
+
+
+//  --------------------------------------------------------------------------
+//  Create a new multicast ring holding up to size messages, rounded up
+//  to a power of 2. The caller holds the first reference.
+
+sphactor_mcast_t *
+sphactor_mcast_new (size_t size, int policy)
+{
+    assert (policy == SPHACTOR_MCAST_BLOCK
+        ||  policy == SPHACTOR_MCAST_OVERWRITE
+        ||  policy == SPHACTOR_MCAST_DROP);
+    sphactor_mcast_t *self = (sphactor_mcast_t *) zmalloc (sizeof (sphactor_mcast_t));
+    assert (self);
+    if (size == 0)
+        size = SPHACTOR_MCAST_SIZE;
+    //  Overwriting relies on at least two slots
+    self->size = 2;
+    while (self->size < (int64_t) size)
+        self->size <<= 1;
+    self->slots = (mcast_msg_t **) zmalloc (self->size * sizeof (mcast_msg_t *));
+    assert (self->slots);
+    self->times = (int64_t *) zmalloc (self->size * sizeof (int64_t));
+    assert (self->times);
+    self->detached = zlist_new ();
+    assert (self->detached);
+    sphactor_atomic_store (&self->tail, 0);
+    sphactor_atomic_store (&self->policy, policy);
+    sphactor_atomic_store (&self->dropped, 0);
+    sphactor_atomic_store_ptr (&self->readers, zmalloc (sizeof (mcast_readers_t)));
+    sphactor_atomic_store (&self->attached, 0);
+    sphactor_atomic_store (&self->locked, 0);
+    sphactor_atomic_store (&self->refs, 1);
+    return self;
+}
+
+
+//  --------------------------------------------------------------------------
+//  Drop a reference to the multicast ring. The last reference destroys
+//  it, including the readers and the messages still in it.
+
+void
+sphactor_mcast_destroy (sphactor_mcast_t **self_p)
+{
+    assert (self_p);
+    if (*self_p) {
+        sphactor_mcast_t *self = *self_p;
+        *self_p = NULL;
+        if (sphactor_atomic_add (&self->refs, -1) > 1)
+            return;
+
+        mcast_readers_t *readers = (mcast_readers_t *) sphactor_atomic_load_ptr (&self->readers);
+        size_t i;
+        for (i = 0; i < readers->size; i++)
+            zlist_append (self->detached, readers->readers [i]);
+        while (readers) {
+            mcast_readers_t *retired = readers->retired;
+            free (readers);
+            readers = retired;
+        }
+        mcast_reader_t *reader = (mcast_reader_t *) zlist_pop (self->detached);
+        while (reader) {
+            sphactor_doorbell_term (&reader->doorbell);
+            free (reader);
+            reader = (mcast_reader_t *) zlist_pop (self->detached);
+        }
+        zlist_destroy (&self->detached);
+        int64_t slot;
+        for (slot = 0; slot < self->size; slot++)
+            s_mcast_msg_destroy (&self->slots [slot]);
+        free (self->slots);
+        free (self->times);
+        free (self);
+    }
+}
+
+
+//  --------------------------------------------------------------------------
+//  Return the policy for a full ring
+
+int
+sphactor_mcast_policy (sphactor_mcast_t *self)
+{
+    assert (self);
+    return (int) sphactor_atomic_load (&self->policy);
+}
+
+
+//  --------------------------------------------------------------------------
+//  Set the policy for a full ring
+
+void
+sphactor_mcast_set_policy (sphactor_mcast_t *self, int policy)
+{
+    assert (self);
+    assert (policy == SPHACTOR_MCAST_BLOCK
+        ||  policy == SPHACTOR_MCAST_OVERWRITE
+        ||  policy == SPHACTOR_MCAST_DROP);
+    sphactor_atomic_store (&self->policy, policy);
+}
+
+
+//  --------------------------------------------------------------------------
+//  Publish the message to all readers, producer only. The ring keeps the
+//  frames of the message and puts frames sharing their data back in it,
+//  so the data is never copied. Returns 0, or -1 if the message was
+//  dropped, leaving it untouched.
+
+int
+sphactor_mcast_publish (sphactor_mcast_t *self, zmsg_t *msg)
+{
+    assert (self);
+    assert (msg);
+    int64_t tail = sphactor_atomic_load_relaxed (&self->tail);
+    int64_t slot = tail & (self->size - 1);
+    if (tail >= self->size) {
+        //  The slot still holds the message published a ring ago
+        if (s_mcast_make_room (self, tail - self->size) == -1) {
+            sphactor_atomic_add (&self->dropped, 1);
+            return -1;
+        }
+        s_mcast_msg_destroy (&self->slots [slot]);
+    }
+    self->slots [slot] = s_mcast_msg_new (msg);
+    s_mcast_msg_share (self->slots [slot], msg);
+    self->times [slot] = zclock_usecs ();
+    sphactor_atomic_store (&self->tail, tail + 1);
+
+    //  Wake the readers waiting for a message, see sphactor_ring_push
+    mcast_readers_t *readers = (mcast_readers_t *) sphactor_atomic_load_ptr (&self->readers);
+    size_t i;
+    for (i = 0; i < readers->size; i++) {
+        mcast_reader_t *reader = readers->readers [i];
+        if (sphactor_atomic_load (&reader->waiting)
+        &&  sphactor_atomic_cas (&reader->waiting, 1, 0))
+            sphactor_doorbell_ring (&reader->doorbell);
+    }
+    return 0;
+}
+
+
+//  --------------------------------------------------------------------------
+//  Return the number of messages dropped by the drop policy
+
+uint64_t
+sphactor_mcast_dropped (sphactor_mcast_t *self)
+{
+    assert (self);
+    return (uint64_t) sphactor_atomic_load (&self->dropped);
+}
+
+
+//  --------------------------------------------------------------------------
+//  Add a reader receiving the messages published from now on. The
+//  reader holds a reference to the multicast ring, destroy it after
+//  detaching the reader.
+
+void *
+sphactor_mcast_attach (sphactor_mcast_t *self)
+{
+    assert (self);
+    mcast_reader_t *reader = (mcast_reader_t *) zmalloc (sizeof (mcast_reader_t));
+    assert (reader);
+    //  Until we know where to start the producer must leave us alone
+    sphactor_atomic_store (&reader->cursor, INT64_MAX);
+    sphactor_atomic_store (&reader->reading, -1);
+    sphactor_atomic_store (&reader->waiting, 1);
+    sphactor_atomic_store (&reader->lost, 0);
+    sphactor_atomic_store (&reader->detached, 0);
+    sphactor_doorbell_init (&reader->doorbell);
+
+    s_mcast_replace (self, reader, NULL);
+    //  Publishing from here on sees us, so nothing before tail gets
+    //  overwritten while we read it
+    reader->tail_cache = sphactor_atomic_load (&self->tail);
+    sphactor_atomic_store (&reader->cursor, reader->tail_cache);
+    sphactor_atomic_add (&self->refs, 1);
+    return reader;
+}
+
+
+//  --------------------------------------------------------------------------
+//  Remove a reader, it won't receive messages anymore
+
+void
+sphactor_mcast_detach (sphactor_mcast_t *self, void *reader)
+{
+    assert (self);
+    assert (reader);
+    s_mcast_replace (self, NULL, (mcast_reader_t *) reader);
+}
+
+
+//  --------------------------------------------------------------------------
+//  Return the next message for the reader, reader only. Its frames share
+//  the data of the published message. Returns NULL if the reader has
+//  read all messages.
+//  Caller owns return value and must destroy it when done.
+
+zmsg_t *
+sphactor_mcast_pop (sphactor_mcast_t *self, void *reader_p)
+{
+    assert (self);
+    assert (reader_p);
+    mcast_reader_t *reader = (mcast_reader_t *) reader_p;
+    while (true) {
+        int64_t cursor = sphactor_atomic_load (&reader->cursor);
+        if (cursor >= reader->tail_cache) {
+            reader->tail_cache = sphactor_atomic_load (&self->tail);
+            if (cursor >= reader->tail_cache) {
+                //  Read everything, the same dance as sphactor_ring_pop
+                sphactor_doorbell_silence (&reader->doorbell);
+                sphactor_atomic_store (&reader->waiting, 1);
+                reader->tail_cache = sphactor_atomic_load (&self->tail);
+                if (cursor >= reader->tail_cache)
+                    return NULL;
+                if (sphactor_atomic_cas (&reader->waiting, 1, 0))
+                    sphactor_doorbell_ring (&reader->doorbell);
+            }
+        }
+        //  Mark the message before checking the producer didn't move us
+        //  past it, the producer moves us before checking the mark
+        sphactor_atomic_store (&reader->reading, cursor);
+        if (sphactor_atomic_load (&reader->cursor) != cursor) {
+            sphactor_atomic_store (&reader->reading, -1);
+            continue;
+        }
+        int64_t slot = cursor & (self->size - 1);
+        zmsg_t *msg = zmsg_new ();
+        assert (msg);
+        s_mcast_msg_share (self->slots [slot], msg);
+        reader->time = self->times [slot];
+        sphactor_atomic_store (&reader->reading, -1);
+        //  Fails if the producer moved us on while we were copying
+        sphactor_atomic_cas (&reader->cursor, cursor, cursor + 1);
+        return msg;
+    }
+}
+
+
+//  --------------------------------------------------------------------------
+//  Return when the message the reader popped last was published
+//  (zclock_usecs), reader only
+
+int64_t
+sphactor_mcast_time (sphactor_mcast_t *self, void *reader)
+{
+    assert (self);
+    assert (reader);
+    return ((mcast_reader_t *) reader)->time;
+}
+
+
+//  --------------------------------------------------------------------------
+//  Return the handle to poll for messages for the reader (zpoller_add).
+//  It stays readable until pop returns NULL.
+
+void *
+sphactor_mcast_handle (sphactor_mcast_t *self, void *reader)
+{
+    assert (self);
+    assert (reader);
+    return sphactor_doorbell_handle (&((mcast_reader_t *) reader)->doorbell);
+}
+
+
+//  --------------------------------------------------------------------------
+//  Return the number of messages the reader is behind
+
+uint64_t
+sphactor_mcast_lag (sphactor_mcast_t *self, void *reader)
+{
+    assert (self);
+    assert (reader);
+    int64_t cursor = sphactor_atomic_load (&((mcast_reader_t *) reader)->cursor);
+    int64_t tail = sphactor_atomic_load (&self->tail);
+    return cursor < tail ? (uint64_t) (tail - cursor) : 0;
+}
+
+
+//  --------------------------------------------------------------------------
+//  Return the number of messages the reader lost to the overwrite policy
+
+uint64_t
+sphactor_mcast_lost (sphactor_mcast_t *self, void *reader)
+{
+    assert (self);
+    assert (reader);
+    return (uint64_t) sphactor_atomic_load (&((mcast_reader_t *) reader)->lost);
+}
+
+
+//  --------------------------------------------------------------------------
+//  Return the number of attached readers, from any thread
+
+size_t
+sphactor_mcast_readers (sphactor_mcast_t *self)
+{
+    assert (self);
+    return (size_t) sphactor_atomic_load (&self->attached);
+}
+
+
+//  --------------------------------------------------------------------------
+//  Return the number of messages the reader at index is behind, from any
+//  thread. Returns 0 if there is no such reader. Replaced lists of
+//  readers and detached readers are only freed with the ring, so the
+//  list we find stays readable.
+
+uint64_t
+sphactor_mcast_reader_lag (sphactor_mcast_t *self, size_t index)
+{
+    assert (self);
+    mcast_readers_t *readers = (mcast_readers_t *) sphactor_atomic_load_ptr (&self->readers);
+    if (index >= readers->size)
+        return 0;
+    return sphactor_mcast_lag (self, readers->readers [index]);
+}
+
+
+//  Make sure no reader still needs the message at sequence oldest, so its
+//  slot can be reused. Returns -1 if the new message must be dropped.
+
+static int
+s_mcast_make_room (sphactor_mcast_t *self, int64_t oldest)
+{
+    int policy = (int) sphactor_atomic_load (&self->policy);
+    mcast_readers_t *readers = (mcast_readers_t *) sphactor_atomic_load_ptr (&self->readers);
+    size_t i;
+    for (i = 0; i < readers->size; i++) {
+        mcast_reader_t *reader = readers->readers [i];
+        int64_t cursor = sphactor_atomic_load (&reader->cursor);
+        if (cursor > oldest)
+            continue;
+
+        if (policy == SPHACTOR_MCAST_DROP)
+            return -1;
+        else
+        if (policy == SPHACTOR_MCAST_BLOCK) {
+            int spins = 0;
+            while (sphactor_atomic_load (&reader->cursor) <= oldest
+               && !sphactor_atomic_load (&reader->detached)) {
+                if (zsys_is_interrupted ())
+                    return -1;
+                if (++spins > SPHACTOR_MCAST_SPINS)
+                    zclock_sleep (1);
+                else
+                    sphactor_atomic_pause ();
+            }
+        }
+        else {
+            //  Move the reader past the message we overwrite
+            while (cursor <= oldest) {
+                if (sphactor_atomic_cas (&reader->cursor, cursor, oldest + 1)) {
+                    sphactor_atomic_add (&reader->lost, oldest + 1 - cursor);
+                    break;
+                }
+                cursor = sphactor_atomic_load (&reader->cursor);
+            }
+        }
+    }
+    //  Wait for readers still taking the message, it takes a moment
+    for (i = 0; i < readers->size; i++) {
+        int spins = 0;
+        while (sphactor_atomic_load (&readers->readers [i]->reading) == oldest) {
+            if (++spins > SPHACTOR_MCAST_SPINS)
+                zclock_sleep (0);
+            else
+                sphactor_atomic_pause ();
+        }
+    }
+    return 0;
+}
+
+//  Replace the readers list adding and/or removing a reader
+
+static void
+s_mcast_replace (sphactor_mcast_t *self, mcast_reader_t *add, mcast_reader_t *remove)
+{
+    while (!sphactor_atomic_cas (&self->locked, 0, 1))
+        zclock_sleep (0);
+    mcast_readers_t *old = (mcast_readers_t *) sphactor_atomic_load_ptr (&self->readers);
+    mcast_readers_t *readers = (mcast_readers_t *) zmalloc (sizeof (mcast_readers_t)
+                                                          + old->size * sizeof (mcast_reader_t *));
+    assert (readers);
+    size_t i;
+    for (i = 0; i < old->size; i++) {
+        if (old->readers [i] != remove)
+            readers->readers [readers->size++] = old->readers [i];
+    }
+    if (add)
+        readers->readers [readers->size++] = add;
+    if (remove) {
+        sphactor_atomic_store (&remove->detached, 1);
+        zlist_append (self->detached, remove);
+    }
+    readers->retired = old;
+    sphactor_atomic_store_ptr (&self->readers, readers);
+    sphactor_atomic_store (&self->attached, (int64_t) readers->size);
+    sphactor_atomic_store (&self->locked, 0);
+}
+
+
+//  Take the frames of a message, leaving it empty
+
+static mcast_msg_t *
+s_mcast_msg_new (zmsg_t *msg)
+{
+    size_t size = zmsg_size (msg);
+    mcast_msg_t *self = (mcast_msg_t *) zmalloc (sizeof (mcast_msg_t)
+                                               + size * sizeof (zframe_t *));
+    assert (self);
+    sphactor_atomic_store (&self->refs, 1);
+    zframe_t *frame = zmsg_pop (msg);
+    while (frame) {
+        self->frames [self->size++] = frame;
+        frame = zmsg_pop (msg);
+    }
+    return self;
+}
+
+//  Drop a reference to the frames of a message
+
+static void
+s_mcast_msg_destroy (mcast_msg_t **self_p)
+{
+    if (*self_p) {
+        mcast_msg_t *self = *self_p;
+        *self_p = NULL;
+        if (sphactor_atomic_add (&self->refs, -1) > 1)
+            return;
+        size_t i;
+        for (i = 0; i < self->size; i++)
+            zframe_destroy (&self->frames [i]);
+        free (self);
+    }
+}
+
+//  Called by libzmq when it releases the last copy of a shared frame
+
+static void
+s_mcast_msg_frame_free (void **hint)
+{
+    mcast_msg_t *self = (mcast_msg_t *) *hint;
+    s_mcast_msg_destroy (&self);
+    *hint = NULL;
+}
+
+//  Append frames sharing the data of the frames of a message
+
+static void
+s_mcast_msg_share (mcast_msg_t *self, zmsg_t *msg)
+{
+    size_t i;
+    for (i = 0; i < self->size; i++) {
+        zframe_t *frame;
+        size_t size = zframe_size (self->frames [i]);
+        if (size == 0)
+            frame = zframe_new_empty ();
+        else {
+            sphactor_atomic_add (&self->refs, 1);
+            frame = zframe_frommem (zframe_data (self->frames [i]), size,
+                                    s_mcast_msg_frame_free, self);
+        }
+        assert (frame);
+        zmsg_append (msg, &frame);
+    }
+}
+
+
+//  --------------------------------------------------------------------------
+//  Self test of this class
+
+#define TEST_MESSAGES 10000
+#define TEST_READERS  4
+
+static void
+mcast_test_free (void *data, void *hint)
+{
+    free (data);
+    (*(int *) hint)++;
+}
+
+static void
+mcast_test_reader (zsock_t *pipe, void *args)
+{
+    sphactor_mcast_t *self = (sphactor_mcast_t *) args;
+    void *reader = sphactor_mcast_attach (self);
+    zpoller_t *poller = zpoller_new (pipe, sphactor_mcast_handle (self, reader), NULL);
+    zsock_signal (pipe, 0);
+
+    //  Messages arrive in order
+    int received = 0;
+    int last = -1;
+    while (!zsys_is_interrupted ()) {
+        zmsg_t *msg = sphactor_mcast_pop (self, reader);
+        if (msg == NULL) {
+            void *which = zpoller_wait (poller, -1);
+            if (which == pipe)
+                break;
+            continue;
+        }
+        char *str = zmsg_popstr (msg);
+        assert (atoi (str) == last + 1);
+        last = atoi (str);
+        zstr_free (&str);
+        zmsg_destroy (&msg);
+        received++;
+    }
+    zpoller_destroy (&poller);
+    sphactor_mcast_detach (self, reader);
+    sphactor_mcast_destroy (&self);
+    zsock_send (pipe, "i", received);
+    zsock_wait (pipe);
+}
+
+void
+sphactor_mcast_test (bool verbose)
+{
+    printf (" * sphactor_mcast: ");
+
+    //  @selftest
+    //  Simple create/destroy test
+    sphactor_mcast_t *self = sphactor_mcast_new (0, SPHACTOR_MCAST_BLOCK);
+    assert (self);
+    assert (sphactor_mcast_policy (self) == SPHACTOR_MCAST_BLOCK);
+    assert (sphactor_mcast_readers (self) == 0);
+    sphactor_mcast_destroy (&self);
+    assert (self == NULL);
+
+    //  Two readers each get every message, without readers nothing is kept
+    self = sphactor_mcast_new (4, SPHACTOR_MCAST_DROP);
+    zmsg_t *msg = zmsg_new ();
+    zmsg_addstr (msg, "nobody");
+    assert (sphactor_mcast_publish (self, msg) == 0);
+    void *reader1 = sphactor_mcast_attach (self);
+    void *reader2 = sphactor_mcast_attach (self);
+    assert (sphactor_mcast_readers (self) == 2);
+    zpoller_t *poller = zpoller_new (sphactor_mcast_handle (self, reader1), NULL);
+    assert (zpoller_wait (poller, 0) == NULL);
+    assert (sphactor_mcast_publish (self, msg) == 0);
+    assert (zpoller_wait (poller, 0) == sphactor_mcast_handle (self, reader1));
+    assert (sphactor_mcast_lag (self, reader1) == 1);
+    assert (sphactor_mcast_reader_lag (self, 1) == 1);
+    zmsg_t *copy = sphactor_mcast_pop (self, reader1);
+    assert (copy && copy != msg);
+    assert (zframe_streq (zmsg_first (copy), "nobody"));
+    //  The reader shares the data of the message, so does the producer
+    assert (zframe_data (zmsg_first (copy)) == zframe_data (zmsg_first (msg)));
+    zmsg_destroy (&copy);
+    assert (sphactor_mcast_pop (self, reader1) == NULL);
+    assert (zpoller_wait (poller, 0) == NULL);
+    assert (sphactor_mcast_lag (self, reader1) == 0);
+    assert (sphactor_mcast_lag (self, reader2) == 1);
+
+    //  The drop policy drops new messages when reader2 is a ring behind
+    int i;
+    for (i = 0; i < 3; i++)
+        assert (sphactor_mcast_publish (self, msg) == 0);
+    assert (sphactor_mcast_lag (self, reader2) == 4);
+    assert (sphactor_mcast_publish (self, msg) == -1);
+    assert (sphactor_mcast_dropped (self) == 1);
+
+    //  The overwrite policy moves reader2 on
+    sphactor_mcast_set_policy (self, SPHACTOR_MCAST_OVERWRITE);
+    assert (sphactor_mcast_publish (self, msg) == 0);
+    assert (sphactor_mcast_lag (self, reader2) == 4);
+    assert (sphactor_mcast_lost (self, reader2) == 1);
+    assert (sphactor_mcast_lost (self, reader1) == 0);
+    zmsg_destroy (&msg);
+
+    //  Readers get the payloads of a message without copying them
+    int freed = 0;
+    sphactor_payload_t *payload = sphactor_payload_new (malloc (10), 10, mcast_test_free, &freed);
+    msg = zmsg_new ();
+    zmsg_addstr (msg, "payload");
+    sphactor_payload_append (payload, msg);
+    assert (sphactor_mcast_publish (self, msg) == 0);
+    assert (sphactor_payload_first (msg) == payload);
+    zmsg_destroy (&msg);
+    while (sphactor_mcast_lag (self, reader1) > 1) {
+        copy = sphactor_mcast_pop (self, reader1);
+        zmsg_destroy (&copy);
+    }
+    copy = sphactor_mcast_pop (self, reader1);
+    assert (sphactor_payload_first (copy) == payload);
+    zmsg_destroy (&copy);
+    assert (sphactor_payload_refs (payload) == 2);  //  ours and the slot's
+    sphactor_payload_destroy (&payload);
+    assert (freed == 0);
+
+    zpoller_destroy (&poller);
+    sphactor_mcast_detach (self, reader1);
+    sphactor_mcast_detach (self, reader2);
+    assert (sphactor_mcast_readers (self) == 0);
+    sphactor_mcast_t *ref = self;
+    sphactor_mcast_destroy (&ref);  //  the readers' references
+    ref = self;
+    sphactor_mcast_destroy (&ref);
+    sphactor_mcast_destroy (&self);
+    assert (freed == 1);
+
+    //  Blocking readers on other threads get every message in order
+    self = sphactor_mcast_new (64, SPHACTOR_MCAST_BLOCK);
+    zactor_t *readers [TEST_READERS];
+    for (i = 0; i < TEST_READERS; i++)
+        readers [i] = zactor_new (mcast_test_reader, self);
+    assert (sphactor_mcast_readers (self) == TEST_READERS);
+    int64_t start = zclock_usecs ();
+    for (i = 0; i < TEST_MESSAGES; i++) {
+        msg = zmsg_new ();
+        zmsg_addstrf (msg, "%d", i);
+        assert (sphactor_mcast_publish (self, msg) == 0);
+        zmsg_destroy (&msg);
+    }
+    for (i = 0; i < TEST_READERS; i++) {
+        while (sphactor_mcast_reader_lag (self, i) > 0)
+            zclock_sleep (1);
+    }
+    if (verbose)
+        zsys_info ("sphactor_mcast: %d messages to %d readers in %" PRId64 " usecs",
+                   TEST_MESSAGES, TEST_READERS, zclock_usecs () - start);
+    for (i = 0; i < TEST_READERS; i++) {
+        zstr_send (readers [i], "STOP");
+        int received = 0;
+        zsock_recv (readers [i], "i", &received);
+        assert (received == TEST_MESSAGES);
+        zsock_signal (readers [i], 0);
+        zactor_destroy (&readers [i]);
+    }
+    assert (sphactor_mcast_readers (self) == 0);
+    assert (sphactor_mcast_dropped (self) == 0);
+    sphactor_mcast_destroy (&self);
+    //  @end
+
+    printf ("OK\n");
+}
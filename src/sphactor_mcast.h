@@ -0,0 +1,114 @@
+/*  =========================================================================
+    sphactor_mcast - class description
+
+    Copyright (c) the Contributors as noted in the AUTHORS file.
+
+    This file is part of Sphactor, an open-source framework for high level
+    actor model concurrency --- http://sphactor.org
+
+    This Source Code Form is subject to the terms of the Mozilla Public
+    License, v. 2.0. If a copy of the MPL was not distributed with this
+    file, You can obtain one at http://mozilla.org/MPL/2.0/.
+    =========================================================================
+*/
+
+#ifndef SPHACTOR_MCAST_H_INCLUDED
+#define SPHACTOR_MCAST_H_INCLUDED
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//  @warning THE FOLLOWING @INTERFACE BLOCK IS AUTO-GENERATED BY ZPROJECT
+//  @warning Please edit the model at "api/sphactor_mcast.api" to make changes.
+//  @interface
+//  This is a stable class, and may not change except for emergencies. It
+//  is provided in stable builds.
+#define SPHACTOR_MCAST_BLOCK 0              // wait for the slowest reader
+#define SPHACTOR_MCAST_OVERWRITE 1          // slow readers lose the oldest messages
+#define SPHACTOR_MCAST_DROP 2               // drop the new message
+
+//  Create a new multicast ring holding up to size messages, rounded up
+//  to a power of 2. The caller holds the first reference.
+SPHACTOR_PRIVATE sphactor_mcast_t *
+    sphactor_mcast_new (size_t size, int policy);
+
+//  Drop a reference to the multicast ring. The last reference destroys
+//  it, including the readers and the messages still in it.
+SPHACTOR_PRIVATE void
+    sphactor_mcast_destroy (sphactor_mcast_t **self_p);
+
+//  Return the policy for a full ring
+SPHACTOR_PRIVATE int
+    sphactor_mcast_policy (sphactor_mcast_t *self);
+
+//  Set the policy for a full ring
+SPHACTOR_PRIVATE void
+    sphactor_mcast_set_policy (sphactor_mcast_t *self, int policy);
+
+//  Publish the message to all readers, producer only. The ring keeps the
+//  frames of the message and puts frames sharing their data back in it,
+//  so the data is never copied. Returns 0, or -1 if the message was
+//  dropped, leaving it untouched.
+SPHACTOR_PRIVATE int
+    sphactor_mcast_publish (sphactor_mcast_t *self, zmsg_t *msg);
+
+//  Return the number of messages dropped by the drop policy
+SPHACTOR_PRIVATE uint64_t
+    sphactor_mcast_dropped (sphactor_mcast_t *self);
+
+//  Add a reader receiving the messages published from now on. The
+//  reader holds a reference to the multicast ring, destroy it after
+//  detaching the reader.
+SPHACTOR_PRIVATE void *
+    sphactor_mcast_attach (sphactor_mcast_t *self);
+
+//  Remove a reader, it won't receive messages anymore
+SPHACTOR_PRIVATE void
+    sphactor_mcast_detach (sphactor_mcast_t *self, void *reader);
+
+//  Return the next message for the reader, reader only. Its frames share
+//  the data of the published message. Returns NULL if the reader has
+//  read all messages.
+//  Caller owns return value and must destroy it when done.
+SPHACTOR_PRIVATE zmsg_t *
+    sphactor_mcast_pop (sphactor_mcast_t *self, void *reader);
+
+//  Return when the message the reader popped last was published
+//  (zclock_usecs), reader only
+SPHACTOR_PRIVATE int64_t
+    sphactor_mcast_time (sphactor_mcast_t *self, void *reader);
+
+//  Return the handle to poll for messages for the reader (zpoller_add).
+//  It stays readable until pop returns NULL.
+SPHACTOR_PRIVATE void *
+    sphactor_mcast_handle (sphactor_mcast_t *self, void *reader);
+
+//  Return the number of messages the reader is behind
+SPHACTOR_PRIVATE uint64_t
+    sphactor_mcast_lag (sphactor_mcast_t *self, void *reader);
+
+//  Return the number of messages the reader lost to the overwrite policy
+SPHACTOR_PRIVATE uint64_t
+    sphactor_mcast_lost (sphactor_mcast_t *self, void *reader);
+
+//  Return the number of attached readers, from any thread
+SPHACTOR_PRIVATE size_t
+    sphactor_mcast_readers (sphactor_mcast_t *self);
+
+//  Return the number of messages the reader at index is behind, from any
+//  thread. Returns 0 if there is no such reader.
+SPHACTOR_PRIVATE uint64_t
+    sphactor_mcast_reader_lag (sphactor_mcast_t *self, size_t index);
+
+//  Self test of this class.
+SPHACTOR_PRIVATE void
+    sphactor_mcast_test (bool verbose);
+
+//  @end
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,389 @@
+/*  =========================================================================
+    sphactor_payload - class description
+
+    Copyright (c) the Contributors as noted in the AUTHORS file.
+
+    This file is part of Sphactor, an open-source framework for high level
+    actor model concurrency --- http://sphactor.org
+
+    This Source Code Form is subject to the terms of the Mozilla Public
+    License, v. 2.0. If a copy of the MPL was not distributed with this
+    file, You can obtain one at http://mozilla.org/MPL/2.0/.
+    =========================================================================
+*/
+
+/*
+@header
+    sphactor_payload - refcounted payload passed by reference between actors
+@discuss
+    Actors in the same process share an address space, yet a video frame
+    returned by a handler would be copied into a frame and through libzmq.
+    A payload wraps the data once. A message carries it in a small frame
+    pointing at the payload, made with zframe_frommem so libzmq shares that
+    frame between subscribers instead of copying it. The frame holds a
+    reference to the payload which is dropped when libzmq releases its last
+    copy, so a payload of many megabytes costs the same as a short string.
+
+    Receivers find the payload with sphactor_payload_lookup or
+    sphactor_payload_first and read its data in place. The data is shared
+    by all receivers so it must be treated as read-only.
+
+    Only a frame whose data is the payload itself carries it. A copy of
+    the frame's contents, made by zframe_dup or zmsg_dup, or a frame from
+    elsewhere holding the same bytes, carries no payload and holds no
+    reference, so lookup returns NULL for it. Never duplicate a message
+    carrying payloads with zmsg_dup, use sphactor_payload_msg_dup.
+@end
+*/
+
+#include "sphactor_classes.h"
+
+//  Tag identifying a frame carrying a payload ("SPHPAYLD")
+#define SPHACTOR_PAYLOAD_TAG 0x5350485041594c44ULL
+
+//  What a frame carrying a payload contains
+
+typedef struct {
+    uint64_t tag;                   //  SPHACTOR_PAYLOAD_TAG
+    sphactor_payload_t *payload;    //  The payload
+} payload_tag_t;
+
+//  Structure of our class
+
+struct _sphactor_payload_t {
+    payload_tag_t tag;              //  Contents of frames carrying us
+    sphactor_atomic_int_t refs;     //  Number of references
+    void    *data;                  //  The payload's data
+    size_t  size;                   //  Size of the data
+    sphactor_payload_free_fn *free_fn;  //  Destroys the data, may be NULL
+    void    *hint;                  //  Argument for free_fn
+};
+
+
+//  --------------------------------------------------------------------------
+//  Constructor, creates a payload for size bytes of data. The caller
+//  holds the first reference. Once the last reference is dropped
+//  free_fn, if not NULL, is called with data and hint.
+
+sphactor_payload_t *
+sphactor_payload_new (void *data, size_t size, sphactor_payload_free_fn free_fn, void *hint)
+{
+    sphactor_payload_t *self = (sphactor_payload_t *) zmalloc (sizeof (sphactor_payload_t));
+    assert (self);
+    self->tag.tag = SPHACTOR_PAYLOAD_TAG;
+    self->tag.payload = self;
+    sphactor_atomic_store (&self->refs, 1);
+    self->data = data;
+    self->size = size;
+    self->free_fn = free_fn;
+    self->hint = hint;
+    return self;
+}
+
+
+//  --------------------------------------------------------------------------
+//  Destructor, drops a reference to the payload.
+
+void
+sphactor_payload_destroy (sphactor_payload_t **self_p)
+{
+    assert (self_p);
+    if (*self_p) {
+        sphactor_payload_t *self = *self_p;
+        *self_p = NULL;
+        int64_t refs = sphactor_atomic_add (&self->refs, -1);
+        assert (refs > 0);
+        if (refs > 1)
+            return;
+
+        if (self->free_fn)
+            self->free_fn (self->data, self->hint);
+        self->tag.tag = 0;      //  frames still pointing here are a bug
+        free (self);
+    }
+}
+
+
+//  --------------------------------------------------------------------------
+//  Add a reference to the payload and return it, destroy the payload
+//  to drop the reference.
+
+sphactor_payload_t *
+sphactor_payload_ref (sphactor_payload_t *self)
+{
+    assert (self);
+    int64_t refs = sphactor_atomic_add (&self->refs, 1);
+    assert (refs > 0);
+    return self;
+}
+
+
+//  --------------------------------------------------------------------------
+//  Return the number of references to the payload
+
+size_t
+sphactor_payload_refs (sphactor_payload_t *self)
+{
+    assert (self);
+    return (size_t) sphactor_atomic_load (&self->refs);
+}
+
+
+//  --------------------------------------------------------------------------
+//  Return the payload's data. Receivers share the data with all other
+//  receivers so they must treat it as read-only.
+
+void *
+sphactor_payload_data (sphactor_payload_t *self)
+{
+    assert (self);
+    return self->data;
+}
+
+
+//  --------------------------------------------------------------------------
+//  Return the size of the payload's data
+
+size_t
+sphactor_payload_size (sphactor_payload_t *self)
+{
+    assert (self);
+    return self->size;
+}
+
+
+//  Called by libzmq when it releases the last copy of a frame
+
+static void
+s_payload_frame_free (void **hint)
+{
+    sphactor_payload_t *self = (sphactor_payload_t *) *hint;
+    sphactor_payload_destroy (&self);
+    *hint = NULL;
+}
+
+
+//  --------------------------------------------------------------------------
+//  Return a new frame carrying a reference to the payload, the
+//  reference is dropped with the last copy of the frame libzmq holds.
+//  Caller owns return value and must destroy it when done.
+
+zframe_t *
+sphactor_payload_frame (sphactor_payload_t *self)
+{
+    assert (self);
+    sphactor_payload_ref (self);
+    zframe_t *frame = zframe_frommem (&self->tag, sizeof (payload_tag_t), s_payload_frame_free, self);
+    assert (frame);
+    return frame;
+}
+
+
+//  --------------------------------------------------------------------------
+//  Append a frame carrying a reference to the payload to the message.
+//  Returns 0 on success.
+
+int
+sphactor_payload_append (sphactor_payload_t *self, zmsg_t *msg)
+{
+    assert (self);
+    assert (msg);
+    zframe_t *frame = sphactor_payload_frame (self);
+    return zmsg_append (msg, &frame);
+}
+
+
+//  --------------------------------------------------------------------------
+//  Return the payload carried by the frame, or NULL if it carries none.
+//  The payload stays valid as long as the frame, take a reference to
+//  keep it longer. Copies of a frame made by zframe_dup carry none.
+
+sphactor_payload_t *
+sphactor_payload_lookup (zframe_t *frame)
+{
+    assert (frame);
+    if (zframe_size (frame) != sizeof (payload_tag_t))
+        return NULL;
+    payload_tag_t tag;
+    memcpy (&tag, zframe_data (frame), sizeof (payload_tag_t));
+    //  Only trust the pointer if the frame's data is the payload's own
+    //  tag, a copy of the tag points at a payload it holds no reference to
+    if (tag.tag != SPHACTOR_PAYLOAD_TAG
+    ||  zframe_data (frame) != (byte *) &tag.payload->tag)
+        return NULL;
+    assert (tag.payload->tag.tag == SPHACTOR_PAYLOAD_TAG);
+    assert (tag.payload->tag.payload == tag.payload);
+    return tag.payload;
+}
+
+
+//  --------------------------------------------------------------------------
+//  Return the first payload carried by the message, or NULL if it
+//  carries none.
+
+sphactor_payload_t *
+sphactor_payload_first (zmsg_t *msg)
+{
+    assert (msg);
+    zframe_t *frame = zmsg_first (msg);
+    while (frame) {
+        sphactor_payload_t *payload = sphactor_payload_lookup (frame);
+        if (payload)
+            return payload;
+        frame = zmsg_next (msg);
+    }
+    return NULL;
+}
+
+
+//  --------------------------------------------------------------------------
+//  Duplicate a message like zmsg_dup, frames carrying a payload get a
+//  new reference instead of a copy. Use this instead of zmsg_dup on
+//  messages carrying payloads, zmsg_dup loses them.
+//  Caller owns return value and must destroy it when done.
+
+zmsg_t *
+sphactor_payload_msg_dup (zmsg_t *msg)
+{
+    assert (msg);
+    zmsg_t *dup = zmsg_new ();
+    assert (dup);
+    zframe_t *frame = zmsg_first (msg);
+    while (frame) {
+        sphactor_payload_t *payload = sphactor_payload_lookup (frame);
+        zframe_t *copy = payload ? sphactor_payload_frame (payload) : zframe_dup (frame);
+        zmsg_append (dup, &copy);
+        frame = zmsg_next (msg);
+    }
+    return dup;
+}
+
+
+//  --------------------------------------------------------------------------
+//  Self test of this class
+
+#define TEST_PAYLOAD_SIZE (32 * 1024 * 1024)
+
+typedef struct {
+    sphactor_payload_t *payload;    //  The payload we expect
+    sphactor_atomic_int_t count;    //  Messages received carrying it
+} payload_test_t;
+
+static void
+payload_test_free (void *data, void *hint)
+{
+    free (data);
+    (*(int *) hint)++;
+}
+
+static zmsg_t *
+payload_test_producer (sphactor_event_t *ev, void *args)
+{
+    if (!streq (ev->type, "TIME"))
+        return NULL;
+    zmsg_t *msg = zmsg_new ();
+    zmsg_addstr (msg, "FRAME");
+    sphactor_payload_append ((sphactor_payload_t *) args, msg);
+    return msg;
+}
+
+static zmsg_t *
+payload_test_consumer (sphactor_event_t *ev, void *args)
+{
+    if (ev->msg == NULL)
+        return NULL;
+    payload_test_t *test = (payload_test_t *) args;
+    //  we see the same payload without it being copied
+    sphactor_payload_t *payload = sphactor_payload_first (ev->msg);
+    assert (payload == test->payload);
+    assert (sphactor_payload_size (payload) == TEST_PAYLOAD_SIZE);
+    sphactor_atomic_add (&test->count, 1);
+    zmsg_destroy (&ev->msg);
+    return NULL;
+}
+
+void
+sphactor_payload_test (bool verbose)
+{
+    printf (" * sphactor_payload: ");
+
+    //  @selftest
+    //  Simple create/destroy test
+    int freed = 0;
+    sphactor_payload_t *self = sphactor_payload_new (malloc (10), 10, payload_test_free, &freed);
+    assert (self);
+    assert (sphactor_payload_size (self) == 10);
+    assert (sphactor_payload_refs (self) == 1);
+
+    //  Frames and duplicates of messages share the payload
+    zframe_t *frame = sphactor_payload_frame (self);
+    assert (sphactor_payload_refs (self) == 2);
+    assert (sphactor_payload_lookup (frame) == self);
+    zframe_destroy (&frame);
+    assert (sphactor_payload_refs (self) == 1);
+
+    zmsg_t *msg = zmsg_new ();
+    zmsg_addstr (msg, "HELLO");
+    assert (sphactor_payload_first (msg) == NULL);
+    int rc = sphactor_payload_append (self, msg);
+    assert (rc == 0);
+    zmsg_t *dup = sphactor_payload_msg_dup (msg);
+    assert (zmsg_size (dup) == 2);
+    assert (zframe_streq (zmsg_first (dup), "HELLO"));
+    assert (sphactor_payload_first (dup) == self);
+    assert (sphactor_payload_refs (self) == 3);
+    //  A plain copy of the frame doesn't carry the payload
+    zmsg_t *plain = zmsg_dup (msg);
+    assert (sphactor_payload_first (plain) == NULL);
+    assert (sphactor_payload_refs (self) == 3);
+    zmsg_destroy (&plain);
+    //  Neither does a frame holding the same bytes
+    frame = zframe_new (zframe_data (zmsg_last (msg)), zframe_size (zmsg_last (msg)));
+    assert (sphactor_payload_lookup (frame) == NULL);
+    zframe_destroy (&frame);
+    zmsg_destroy (&msg);
+    zmsg_destroy (&dup);
+    assert (sphactor_payload_refs (self) == 1);
+    assert (freed == 0);
+    sphactor_payload_destroy (&self);
+    assert (self == NULL);
+    assert (freed == 1);
+
+    //  A large payload travels from one actor to others through the sub
+    //  socket and a ring without being copied
+    freed = 0;
+    self = sphactor_payload_new (malloc (TEST_PAYLOAD_SIZE), TEST_PAYLOAD_SIZE, payload_test_free, &freed);
+    payload_test_t subtest = { self };
+    payload_test_t ringtest = { self };
+    sphactor_atomic_store (&subtest.count, 0);
+    sphactor_atomic_store (&ringtest.count, 0);
+    sphactor_t *producer = sphactor_new (payload_test_producer, self, "producer", NULL);
+    sphactor_t *subconsumer = sphactor_new (payload_test_consumer, &subtest, NULL, NULL);
+    sphactor_t *ringconsumer = sphactor_new (payload_test_consumer, &ringtest, NULL, NULL);
+    sphactor_ask_connect (subconsumer, sphactor_ask_endpoint (producer));
+    char *ringendpoint = zsys_sprintf ("ring+%s", sphactor_ask_endpoint (producer));
+    sphactor_ask_connect (ringconsumer, ringendpoint);
+    zstr_free (&ringendpoint);
+    int64_t start = zclock_usecs ();
+    sphactor_ask_set_timeout (producer, 1);
+    //  a loaded machine can take much longer than a few timeouts
+    int64_t deadline = zclock_mono () + 10000;
+    while ((sphactor_atomic_load (&subtest.count) == 0 || sphactor_atomic_load (&ringtest.count) == 0)
+    &&     zclock_mono () < deadline)
+        zclock_sleep (5);
+    sphactor_destroy (&producer);
+    sphactor_destroy (&subconsumer);
+    sphactor_destroy (&ringconsumer);
+    if (verbose)
+        zsys_info ("sphactor_payload: %d + %d payloads of %d bytes in %" PRId64 " usecs",
+                   (int) sphactor_atomic_load (&subtest.count), (int) sphactor_atomic_load (&ringtest.count),
+                   TEST_PAYLOAD_SIZE, zclock_usecs () - start);
+    assert (sphactor_atomic_load (&subtest.count) > 0);
+    assert (sphactor_atomic_load (&ringtest.count) > 0);
+    assert (sphactor_payload_refs (self) == 1);
+    sphactor_payload_destroy (&self);
+    assert (freed == 1);
+    //  @end
+
+    printf ("OK\n");
+}
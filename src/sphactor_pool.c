@@ -0,0 +1,1074 @@
+/*  =========================================================================
+    sphactor_pool - class description
+
+    Copyright (c) the Contributors as noted in the AUTHORS file.
+
+    This file is part of Sphactor, an open-source framework for high level
+    actor model concurrency --- http://sphactor.org
+
+    This Source Code Form is subject to the terms of the Mozilla Public
+    License, v. 2.0. If a copy of the MPL was not distributed with this
+    file, You can obtain one at http://mozilla.org/MPL/2.0/.
+    =========================================================================
+*/
+
+/*
+@header
+    sphactor_pool - scheduler running many actors on a few worker threads
+@discuss
+    Every sphactor normally runs sphactor_actor_run in its own thread. This
+    limits a process to a few hundred actors before thread stacks and
+    context switches dominate. A pool instead multiplexes actors onto a
+    fixed number of worker threads.
+
+    A dispatcher thread polls the readers (pipe, sub socket and any sockets
+    or file descriptors added by the handler) of all idle actors and keeps
+    track of their timers. When an actor has work it is handed to a worker
+    which calls sphactor_actor_run_once. The actor is not polled again until
+    a worker hands it back, so an actor only ever runs on one thread at
+    the time and handlers don't need any extra locking.
+
+    Every worker has its own run queue, a Chase-Lev work stealing deque. A
+    worker keeps an actor which still has work after a run in its own queue
+    instead of handing it back to the dispatcher, up to a budget of runs.
+    Workers which run out of work steal actors from the queues of the other
+    workers before going to sleep, so a few busy actors get spread over the
+    available cores.
+
+    The pipe of a pooled actor behaves like the pipe of a zactor so the
+    sphactor_ask_* methods work unchanged.
+@end
+*/
+
+#include "sphactor_classes.h"
+
+//  Structure of our class
+
+typedef struct _pool_worker_t pool_worker_t;
+
+struct _sphactor_pool_t {
+    zactor_t *dispatcher;       //  Dispatcher thread scheduling our actors
+    pool_worker_t *workers;     //  Our workers
+    size_t   workers_size;      //  Number of workers
+    sphactor_atomic_int_t sleepers; //  Number of workers waiting for work
+    sphactor_atomic_int_t waking;   //  Is a sleeping worker being woken?
+    sphactor_atomic_int_t size;     //  Number of actors which haven't finished
+};
+
+//  Number of times a worker runs an actor in a row before handing it back
+//  to the dispatcher, so one busy actor can't starve the others
+#define SPHACTOR_POOL_BUDGET 64
+
+//  Initial size of a worker's run queue, it grows when needed
+#define SPHACTOR_POOL_QUEUE_SIZE 256
+
+//  An actor scheduled by the pool
+
+typedef struct {
+    sphactor_actor_t *actor;    //  The actor, NULL when it has finished
+    zsock_t *pipe;              //  The actor's end of its pipe
+    bool    running;            //  Is a worker running the actor?
+    int     runs;               //  Runs in a row by the workers
+    size_t  *slots;             //  Our poll items while we are idle
+    size_t  slots_size;         //  Number of poll items we have
+    size_t  slots_max;          //  Number of slots allocated
+    int64_t time_next;          //  When our timer is due while we are idle
+    size_t  heap_index;         //  Our place in the timer heap, SIZE_MAX if none
+} pool_actor_t;
+
+//  Array of a run queue, replaced by a larger one when full
+
+typedef struct _pool_queue_array_t {
+    int64_t size;                           //  Size, a power of 2
+    struct _pool_queue_array_t *retired;    //  Replaced array, thieves might
+                                            //  still read it so free it last
+    sphactor_atomic_ptr_t items [1];        //  The pool_actor_t items
+} pool_queue_array_t;
+
+//  Run queue of a worker, a Chase-Lev work stealing deque. Only the owner
+//  pushes and takes at the bottom, others steal from the top.
+
+typedef struct {
+    sphactor_atomic_int_t top;
+    char    top_pad [64];       //  keep the owner and thieves off each other's cache line
+    sphactor_atomic_int_t bottom;
+    sphactor_atomic_ptr_t array;
+} pool_queue_t;
+
+//  A worker thread, its run queue and counters
+
+struct _pool_worker_t {
+    sphactor_pool_t *pool;      //  The pool we are in
+    size_t  index;              //  Our index in the pool's workers
+    zactor_t *thread;           //  Worker thread, owned by the dispatcher
+    pool_queue_t queue;         //  Actors ready to run on this worker
+    sphactor_atomic_int_t sleeping; //  Is the worker waiting for work?
+    sphactor_atomic_int_t runs;     //  Number of actor runs
+    sphactor_atomic_int_t steals;   //  Number of actors stolen from other workers
+    sphactor_atomic_int_t idles;    //  Number of times the worker ran out of work
+    char    pad [64];
+};
+
+//  State of the dispatcher thread
+
+typedef struct {
+    zsock_t *pipe;              //  Pipe back to the pool
+    bool    terminated;         //  Did the pool ask us to quit?
+    sphactor_pool_t *pool;      //  The pool we dispatch for
+    zmsg_t  **batches;          //  Actors to hand to each worker
+    size_t  next_worker;        //  Worker to hand the next actor to
+    zlist_t *actors;            //  All actors in the pool
+    zmq_pollitem_t *items;      //  Poll items: pipe, workers, idle actors
+    pool_actor_t **owners;      //  Actor owning each poll item
+    size_t  *owner_slots;       //  Index of each poll item in its owner's slots
+    size_t  items_size;         //  Number of poll items in use
+    size_t  items_max;          //  Number of poll items allocated
+    pool_actor_t **heap;        //  Idle actors with a timer, soonest first
+    size_t  heap_size;          //  Number of actors in the heap
+    size_t  heap_max;           //  Number of heap entries allocated
+} dispatcher_t;
+
+//  Default pool new sphactors are created in
+static sphactor_pool_t *s_default_pool = NULL;
+
+//  (forward declare)
+static void s_pool_dispatcher (zsock_t *pipe, void *args);
+
+
+//  Return the number of available cores
+
+static size_t
+s_pool_cores (void)
+{
+#if defined (__WINDOWS__)
+    SYSTEM_INFO info;
+    GetSystemInfo (&info);
+    return info.dwNumberOfProcessors > 0 ? (size_t) info.dwNumberOfProcessors : 1;
+#else
+    long cores = sysconf (_SC_NPROCESSORS_ONLN);
+    return cores > 0 ? (size_t) cores : 1;
+#endif
+}
+
+//  --------------------------------------------------------------------------
+//  Create a new sphactor_pool
+
+sphactor_pool_t *
+sphactor_pool_new (size_t workers)
+{
+    sphactor_pool_t *self = (sphactor_pool_t *) zmalloc (sizeof (sphactor_pool_t));
+    assert (self);
+    self->workers_size = workers ? workers : s_pool_cores ();
+    self->workers = (pool_worker_t *) zmalloc (self->workers_size * sizeof (pool_worker_t));
+    assert (self->workers);
+    size_t index;
+    for (index = 0; index < self->workers_size; index++) {
+        self->workers [index].pool = self;
+        self->workers [index].index = index;
+    }
+    self->dispatcher = zactor_new (s_pool_dispatcher, self);
+    assert (self->dispatcher);
+    return self;
+}
+
+//  --------------------------------------------------------------------------
+//  Destroy the sphactor_pool
+
+void
+sphactor_pool_destroy (sphactor_pool_t **self_p)
+{
+    assert (self_p);
+    if (*self_p) {
+        sphactor_pool_t *self = *self_p;
+        if (s_default_pool == self)
+            s_default_pool = NULL;
+        zactor_destroy (&self->dispatcher);
+        free (self->workers);
+        //  Free object itself
+        free (self);
+        *self_p = NULL;
+    }
+}
+
+size_t
+sphactor_pool_workers (sphactor_pool_t *self)
+{
+    assert (self);
+    return self->workers_size;
+}
+
+uint64_t
+sphactor_pool_runs (sphactor_pool_t *self, size_t worker)
+{
+    assert (self);
+    assert (worker < self->workers_size);
+    return (uint64_t) sphactor_atomic_load_relaxed (&self->workers [worker].runs);
+}
+
+uint64_t
+sphactor_pool_steals (sphactor_pool_t *self, size_t worker)
+{
+    assert (self);
+    assert (worker < self->workers_size);
+    return (uint64_t) sphactor_atomic_load_relaxed (&self->workers [worker].steals);
+}
+
+uint64_t
+sphactor_pool_idles (sphactor_pool_t *self, size_t worker)
+{
+    assert (self);
+    assert (worker < self->workers_size);
+    return (uint64_t) sphactor_atomic_load_relaxed (&self->workers [worker].idles);
+}
+
+size_t
+sphactor_pool_size (sphactor_pool_t *self)
+{
+    assert (self);
+    //  Finished actors have signalled their pipe, they don't count even if
+    //  their worker didn't report them gone yet
+    return (size_t) sphactor_atomic_load (&self->size);
+}
+
+zsock_t *
+sphactor_pool_spawn (sphactor_pool_t *self, void *args)
+{
+    assert (self);
+    assert (args);
+    zsock_t *backend = NULL;
+    zsock_t *frontend = zsys_create_pipe (&backend);
+    assert (frontend);
+
+    //  Create and start the actor in our thread like the zactor does in its
+    //  thread, from then on the pool runs the actor.
+    sphactor_actor_t *actor = sphactor_actor_new (backend, args);
+    assert (actor);
+    sphactor_actor_set_pooled (actor, true);
+    sphactor_actor_start (actor);
+    zsock_wait (frontend);
+
+    pool_actor_t *item = (pool_actor_t *) zmalloc (sizeof (pool_actor_t));
+    assert (item);
+    item->actor = actor;
+    item->pipe = backend;
+    item->running = false;
+    item->runs = 0;
+    item->heap_index = SIZE_MAX;
+    sphactor_atomic_add (&self->size, 1);
+    zsock_send (self->dispatcher, "sp", "ADD", item);
+    return frontend;
+}
+
+void
+sphactor_pool_set_default (sphactor_pool_t *pool)
+{
+    s_default_pool = pool;
+}
+
+sphactor_pool_t *
+sphactor_pool_default (void)
+{
+    return s_default_pool;
+}
+
+//  --------------------------------------------------------------------------
+//  Run queue of a worker
+
+static pool_queue_array_t *
+s_queue_array_new (int64_t size, pool_queue_array_t *retired)
+{
+    pool_queue_array_t *array = (pool_queue_array_t *) zmalloc (
+        sizeof (pool_queue_array_t) + (size_t) (size - 1) * sizeof (sphactor_atomic_ptr_t));
+    assert (array);
+    array->size = size;
+    array->retired = retired;
+    return array;
+}
+
+static void
+s_queue_init (pool_queue_t *self)
+{
+    sphactor_atomic_store (&self->top, 0);
+    sphactor_atomic_store (&self->bottom, 0);
+    sphactor_atomic_store_ptr (&self->array, s_queue_array_new (SPHACTOR_POOL_QUEUE_SIZE, NULL));
+}
+
+static void
+s_queue_destroy (pool_queue_t *self)
+{
+    pool_queue_array_t *array = (pool_queue_array_t *) sphactor_atomic_load_ptr (&self->array);
+    while (array) {
+        pool_queue_array_t *retired = array->retired;
+        free (array);
+        array = retired;
+    }
+    sphactor_atomic_store_ptr (&self->array, NULL);
+}
+
+static int64_t
+s_queue_size (pool_queue_t *self)
+{
+    int64_t size = sphactor_atomic_load (&self->bottom) - sphactor_atomic_load (&self->top);
+    return size > 0 ? size : 0;
+}
+
+//  Push an actor at the bottom, owner only
+
+static void
+s_queue_push (pool_queue_t *self, pool_actor_t *item)
+{
+    int64_t bottom = sphactor_atomic_load_relaxed (&self->bottom);
+    int64_t top = sphactor_atomic_load (&self->top);
+    pool_queue_array_t *array = (pool_queue_array_t *) sphactor_atomic_load_ptr_relaxed (&self->array);
+    if (bottom - top > array->size - 1) {
+        pool_queue_array_t *grown = s_queue_array_new (array->size * 2, array);
+        int64_t index;
+        for (index = top; index < bottom; index++)
+            sphactor_atomic_store_ptr_relaxed (&grown->items [index & (grown->size - 1)],
+                sphactor_atomic_load_ptr_relaxed (&array->items [index & (array->size - 1)]));
+        sphactor_atomic_store_ptr (&self->array, grown);
+        array = grown;
+    }
+    sphactor_atomic_store_ptr_relaxed (&array->items [bottom & (array->size - 1)], item);
+    sphactor_atomic_store (&self->bottom, bottom + 1);
+}
+
+//  Take the actor at the bottom, owner only. Returns NULL if empty.
+
+static pool_actor_t *
+s_queue_take (pool_queue_t *self)
+{
+    int64_t bottom = sphactor_atomic_load_relaxed (&self->bottom) - 1;
+    pool_queue_array_t *array = (pool_queue_array_t *) sphactor_atomic_load_ptr_relaxed (&self->array);
+    //  Reserve the bottom before looking at the top, thieves do the reverse
+    sphactor_atomic_store (&self->bottom, bottom);
+    int64_t top = sphactor_atomic_load (&self->top);
+    pool_actor_t *item = NULL;
+    if (top <= bottom) {
+        item = (pool_actor_t *) sphactor_atomic_load_ptr_relaxed (&array->items [bottom & (array->size - 1)]);
+        if (top == bottom) {
+            //  Last one in the queue, race the thieves for it
+            if (!sphactor_atomic_cas (&self->top, top, top + 1))
+                item = NULL;
+            sphactor_atomic_store_relaxed (&self->bottom, bottom + 1);
+        }
+    }
+    else
+        sphactor_atomic_store_relaxed (&self->bottom, bottom + 1);
+    return item;
+}
+
+//  Steal the actor at the top, any thread. Returns NULL if empty or if we
+//  lost the race for it.
+
+static pool_actor_t *
+s_queue_steal (pool_queue_t *self)
+{
+    int64_t top = sphactor_atomic_load (&self->top);
+    int64_t bottom = sphactor_atomic_load (&self->bottom);
+    if (top >= bottom)
+        return NULL;
+    pool_queue_array_t *array = (pool_queue_array_t *) sphactor_atomic_load_ptr (&self->array);
+    pool_actor_t *item = (pool_actor_t *) sphactor_atomic_load_ptr_relaxed (&array->items [top & (array->size - 1)]);
+    if (!sphactor_atomic_cas (&self->top, top, top + 1))
+        return NULL;
+    return item;
+}
+
+//  --------------------------------------------------------------------------
+//  Stop and destroy an actor which has finished. Same as the zactor does
+//  when its thread returns: signal the pipe and destroy our end.
+
+static void
+s_pool_actor_finish (sphactor_pool_t *pool, pool_actor_t *item)
+{
+    assert (item->actor);
+    sphactor_actor_stop (item->actor);
+    sphactor_actor_destroy (&item->actor);
+    sphactor_atomic_add (&pool->size, -1);
+    zsock_set_sndtimeo (item->pipe, 0);
+    zsock_signal (item->pipe, 0);
+    zsock_destroy (&item->pipe);
+}
+
+//  Fill in the poll item for an actor's reader. Same as zpoller: a zsock,
+//  zactor or native socket, else a pointer to a file descriptor.
+
+static void
+s_pool_pollitem (zmq_pollitem_t *item, void *reader)
+{
+    memset (item, 0, sizeof (zmq_pollitem_t));
+    void *socket = zsock_resolve (reader);
+    if (socket)
+        item->socket = socket;
+    else
+        item->fd = *(SOCKET *) reader;
+    item->events = ZMQ_POLLIN;
+}
+
+//  Return true if the actor has input waiting or its timer is due
+
+static bool
+s_pool_actor_ready (pool_actor_t *item)
+{
+    if (sphactor_actor_time_next (item->actor) <= zclock_mono ())
+        return true;
+    zlist_t *readers = sphactor_actor_readers (item->actor);
+    void *reader = zlist_first (readers);
+    while (reader) {
+        zmq_pollitem_t pollitem;
+        s_pool_pollitem (&pollitem, reader);
+        if (zmq_poll (&pollitem, 1, 0) > 0)
+            return true;
+        reader = zlist_next (readers);
+    }
+    return false;
+}
+
+//  --------------------------------------------------------------------------
+//  Worker thread, runs the actors in its queue, handed to it by the
+//  dispatcher, and steals from the other workers when it runs out.
+
+//  Ask the dispatcher to wake a sleeping worker if we have more work queued
+//  than we can run right now
+
+static void
+s_pool_worker_share (pool_worker_t *self, zsock_t *pipe)
+{
+    sphactor_pool_t *pool = self->pool;
+    if (s_queue_size (&self->queue) > 1
+    &&  sphactor_atomic_load (&pool->sleepers) > 0
+    &&  sphactor_atomic_cas (&pool->waking, 0, 1))
+        zstr_send (pipe, "WAKE");
+}
+
+static pool_actor_t *
+s_pool_worker_steal (pool_worker_t *self)
+{
+    sphactor_pool_t *pool = self->pool;
+    size_t offset;
+    for (offset = 1; offset < pool->workers_size; offset++) {
+        pool_worker_t *victim = &pool->workers [(self->index + offset) % pool->workers_size];
+        pool_actor_t *item = s_queue_steal (&victim->queue);
+        if (item) {
+            sphactor_atomic_add (&self->steals, 1);
+            return item;
+        }
+    }
+    return NULL;
+}
+
+//  Receive a message from the dispatcher. Returns -1 if we need to quit.
+
+static int
+s_pool_worker_recv (pool_worker_t *self, zsock_t *pipe)
+{
+    zmsg_t *msg = zmsg_recv (pipe);
+    if (!msg)
+        //  keep running our actors on interrupts, they decide to quit
+        return errno == EINTR ? 0 : -1;
+
+    int rc = 0;
+    char *command = zmsg_popstr (msg);
+    if (streq (command, "RUN")) {
+        zframe_t *frame = zmsg_pop (msg);
+        while (frame) {
+            assert (zframe_size (frame) == sizeof (void *));
+            s_queue_push (&self->queue, *(pool_actor_t **) zframe_data (frame));
+            zframe_destroy (&frame);
+            frame = zmsg_pop (msg);
+        }
+        s_pool_worker_share (self, pipe);
+    }
+    else
+    if (streq (command, "WAKE"))
+        sphactor_atomic_store (&self->pool->waking, 0);
+    else
+    if (streq (command, "$TERM"))
+        rc = -1;
+
+    zstr_free (&command);
+    zmsg_destroy (&msg);
+    return rc;
+}
+
+static void
+s_pool_worker_run (pool_worker_t *self, zsock_t *pipe, pool_actor_t *item)
+{
+    sphactor_atomic_add (&self->runs, 1);
+    //  An interrupted actor will return -1, but we keep running it until it
+    //  is terminated through its pipe, as a threaded actor would have
+    //  signalled its pipe on exit.
+    sphactor_actor_run_once (item->actor);
+    if (sphactor_actor_terminated (item->actor)) {
+        s_pool_actor_finish (self->pool, item);
+        zsock_send (pipe, "sp", "GONE", item);
+    }
+    else
+    if (++item->runs < SPHACTOR_POOL_BUDGET && s_pool_actor_ready (item)) {
+        //  Still busy, keep it in our queue where idle workers can steal it
+        s_queue_push (&self->queue, item);
+        s_pool_worker_share (self, pipe);
+    }
+    else {
+        item->runs = 0;
+        zsock_send (pipe, "sp", "DONE", item);
+    }
+}
+
+static void
+s_pool_worker (zsock_t *pipe, void *args)
+{
+    pool_worker_t *self = (pool_worker_t *) args;
+    sphactor_pool_t *pool = self->pool;
+    zsock_signal (pipe, 0);
+
+    while (true) {
+        //  Queue what the dispatcher handed us before running anything
+        if ((zsock_events (pipe) & ZMQ_POLLIN)
+        &&  s_pool_worker_recv (self, pipe) == -1)
+            break;
+
+        pool_actor_t *item = s_queue_take (&self->queue);
+        if (!item)
+            item = s_pool_worker_steal (self);
+        if (!item) {
+            //  Tell we're going to sleep before the last attempt, so a
+            //  worker queueing more work after it knows to wake us
+            sphactor_atomic_store (&self->sleeping, 1);
+            sphactor_atomic_add (&pool->sleepers, 1);
+            item = s_pool_worker_steal (self);
+            int rc = 0;
+            if (!item) {
+                sphactor_atomic_add (&self->idles, 1);
+                rc = s_pool_worker_recv (self, pipe);
+            }
+            sphactor_atomic_add (&pool->sleepers, -1);
+            sphactor_atomic_store (&self->sleeping, 0);
+            if (rc == -1)
+                break;
+        }
+        if (item)
+            s_pool_worker_run (self, pipe, item);
+    }
+}
+
+//  --------------------------------------------------------------------------
+//  Timer heap of the idle actors, a binary min-heap on their time_next. Every
+//  actor knows its index in the heap so it can be taken out when it runs.
+
+static void
+s_heap_set (dispatcher_t *self, size_t index, pool_actor_t *item)
+{
+    self->heap [index] = item;
+    item->heap_index = index;
+}
+
+static void
+s_heap_up (dispatcher_t *self, size_t index)
+{
+    pool_actor_t *item = self->heap [index];
+    while (index > 0) {
+        size_t parent = (index - 1) / 2;
+        if (self->heap [parent]->time_next <= item->time_next)
+            break;
+        s_heap_set (self, index, self->heap [parent]);
+        index = parent;
+    }
+    s_heap_set (self, index, item);
+}
+
+static void
+s_heap_down (dispatcher_t *self, size_t index)
+{
+    pool_actor_t *item = self->heap [index];
+    while (true) {
+        size_t child = 2 * index + 1;
+        if (child >= self->heap_size)
+            break;
+        if (child + 1 < self->heap_size
+        &&  self->heap [child + 1]->time_next < self->heap [child]->time_next)
+            child++;
+        if (item->time_next <= self->heap [child]->time_next)
+            break;
+        s_heap_set (self, index, self->heap [child]);
+        index = child;
+    }
+    s_heap_set (self, index, item);
+}
+
+static void
+s_heap_push (dispatcher_t *self, pool_actor_t *item)
+{
+    assert (item->heap_index == SIZE_MAX);
+    if (self->heap_size == self->heap_max) {
+        self->heap_max = self->heap_max ? self->heap_max * 2 : 64;
+        self->heap = (pool_actor_t **) realloc (self->heap, self->heap_max * sizeof (pool_actor_t *));
+        assert (self->heap);
+    }
+    s_heap_set (self, self->heap_size++, item);
+    s_heap_up (self, item->heap_index);
+}
+
+static void
+s_heap_remove (dispatcher_t *self, pool_actor_t *item)
+{
+    size_t index = item->heap_index;
+    assert (index < self->heap_size && self->heap [index] == item);
+    item->heap_index = SIZE_MAX;
+    pool_actor_t *last = self->heap [--self->heap_size];
+    if (last == item)
+        return;
+    s_heap_set (self, index, last);
+    s_heap_up (self, index);
+    s_heap_down (self, last->heap_index);
+}
+
+//  --------------------------------------------------------------------------
+//  Poll items of the dispatcher: its pipe and the workers first, then the
+//  readers of the idle actors in no particular order. An actor's readers
+//  and timer only change while it runs, so it is added when it becomes
+//  idle and removed when it runs, both in the time of its own readers.
+
+static void
+s_dispatcher_unpoll (dispatcher_t *self, size_t index)
+{
+    //  Move the last poll item into the hole
+    size_t last = --self->items_size;
+    if (index != last) {
+        self->items [index] = self->items [last];
+        self->owners [index] = self->owners [last];
+        self->owner_slots [index] = self->owner_slots [last];
+        self->owners [index]->slots [self->owner_slots [index]] = index;
+    }
+}
+
+//  Add the readers of an actor which became idle to the poll items and its
+//  timer to the timer heap
+
+static void
+s_dispatcher_idle (dispatcher_t *self, pool_actor_t *item)
+{
+    zlist_t *readers = sphactor_actor_readers (item->actor);
+    size_t readers_size = zlist_size (readers);
+    if (self->items_size + readers_size > self->items_max) {
+        self->items_max = (self->items_size + readers_size) * 2;
+        self->items = (zmq_pollitem_t *) realloc (self->items, self->items_max * sizeof (zmq_pollitem_t));
+        assert (self->items);
+        self->owners = (pool_actor_t **) realloc (self->owners, self->items_max * sizeof (pool_actor_t *));
+        assert (self->owners);
+        self->owner_slots = (size_t *) realloc (self->owner_slots, self->items_max * sizeof (size_t));
+        assert (self->owner_slots);
+    }
+    if (readers_size > item->slots_max) {
+        item->slots_max = readers_size;
+        item->slots = (size_t *) realloc (item->slots, item->slots_max * sizeof (size_t));
+        assert (item->slots);
+    }
+    assert (item->slots_size == 0);
+    void *reader = zlist_first (readers);
+    while (reader) {
+        size_t index = self->items_size++;
+        s_pool_pollitem (&self->items [index], reader);
+        self->owners [index] = item;
+        self->owner_slots [index] = item->slots_size;
+        item->slots [item->slots_size++] = index;
+        reader = zlist_next (readers);
+    }
+    item->time_next = sphactor_actor_time_next (item->actor);
+    if (item->time_next < INT64_MAX)
+        s_heap_push (self, item);
+}
+
+//  Take an actor which is going to run out of the poll items and the heap
+
+static void
+s_dispatcher_busy (dispatcher_t *self, pool_actor_t *item)
+{
+    size_t slot;
+    for (slot = 0; slot < item->slots_size; slot++)
+        s_dispatcher_unpoll (self, item->slots [slot]);
+    item->slots_size = 0;
+    if (item->heap_index != SIZE_MAX)
+        s_heap_remove (self, item);
+}
+
+//  Return the time in msecs till the first timer of an idle actor is due,
+//  or -1 if none of the idle actors has a timer
+
+static long
+s_dispatcher_timeout (dispatcher_t *self)
+{
+    if (self->heap_size == 0)
+        return -1;
+    int64_t timeout = self->heap [0]->time_next - zclock_mono ();
+    return timeout > 0 ? (long) timeout : 0;
+}
+
+//  Pick the worker to hand the next actor to: a sleeping worker which
+//  didn't get any actors yet, else the next one in line
+
+static size_t
+s_dispatcher_pick (dispatcher_t *self)
+{
+    sphactor_pool_t *pool = self->pool;
+    size_t offset;
+    for (offset = 0; offset < pool->workers_size; offset++) {
+        size_t worker = (self->next_worker + offset) % pool->workers_size;
+        if (self->batches [worker] == NULL
+        &&  sphactor_atomic_load (&pool->workers [worker].sleeping)) {
+            self->next_worker = (worker + 1) % pool->workers_size;
+            return worker;
+        }
+    }
+    size_t worker = self->next_worker;
+    self->next_worker = (worker + 1) % pool->workers_size;
+    return worker;
+}
+
+//  Add an idle actor to the batch of a worker, send the batches with
+//  s_dispatcher_flush
+
+static void
+s_dispatcher_run (dispatcher_t *self, pool_actor_t *item)
+{
+    assert (!item->running);
+    s_dispatcher_busy (self, item);
+    item->running = true;
+    item->runs = 0;
+    size_t worker = s_dispatcher_pick (self);
+    if (self->batches [worker] == NULL) {
+        self->batches [worker] = zmsg_new ();
+        zmsg_addstr (self->batches [worker], "RUN");
+    }
+    zmsg_addmem (self->batches [worker], &item, sizeof (void *));
+}
+
+static void
+s_dispatcher_flush (dispatcher_t *self)
+{
+    sphactor_pool_t *pool = self->pool;
+    size_t worker;
+    for (worker = 0; worker < pool->workers_size; worker++) {
+        if (self->batches [worker])
+            zmsg_send (&self->batches [worker], pool->workers [worker].thread);
+    }
+}
+
+//  A worker has more actors queued than it can run, wake a sleeping one to
+//  steal some
+
+static void
+s_dispatcher_wake (dispatcher_t *self)
+{
+    sphactor_pool_t *pool = self->pool;
+    size_t worker;
+    for (worker = 0; worker < pool->workers_size; worker++) {
+        if (sphactor_atomic_load (&pool->workers [worker].sleeping)) {
+            zstr_send (pool->workers [worker].thread, "WAKE");
+            return;
+        }
+    }
+    //  Everybody is awake already
+    sphactor_atomic_store (&pool->waking, 0);
+}
+
+static void
+s_dispatcher_recv_api (dispatcher_t *self)
+{
+    char *command = NULL;
+    void *ptr = NULL;
+    if (zsock_recv (self->pipe, "sp", &command, &ptr) == -1)
+        return;     //  Interrupted
+
+    if (streq (command, "ADD")) {
+        zlist_append (self->actors, ptr);
+        s_dispatcher_idle (self, (pool_actor_t *) ptr);
+    }
+    else
+    if (streq (command, "$TERM"))
+        self->terminated = true;
+    else
+        zsys_error ("sphactor_pool: invalid command '%s'", command);
+
+    zstr_free (&command);
+}
+
+static void
+s_dispatcher_recv_worker (dispatcher_t *self, zactor_t *worker)
+{
+    //  Workers report back after every run, read all we've got
+    while (zsock_events (zactor_sock (worker)) & ZMQ_POLLIN) {
+        char *command = NULL;
+        void *ptr = NULL;
+        if (zsock_recv (worker, "sp", &command, &ptr) == -1)
+            return;     //  Interrupted
+
+        pool_actor_t *item = (pool_actor_t *) ptr;
+        if (streq (command, "DONE")) {
+            item->running = false;
+            s_dispatcher_idle (self, item);
+        }
+        else
+        if (streq (command, "GONE")) {
+            zlist_remove (self->actors, item);
+            free (item->slots);
+            free (item);
+        }
+        else
+        if (streq (command, "WAKE"))
+            s_dispatcher_wake (self);
+        zstr_free (&command);
+    }
+}
+
+//  --------------------------------------------------------------------------
+//  Dispatcher thread, polls the idle actors and hands them to the workers
+//  when they have work.
+
+static void
+s_pool_dispatcher (zsock_t *pipe, void *args)
+{
+    dispatcher_t self;
+    memset (&self, 0, sizeof (dispatcher_t));
+    self.pipe = pipe;
+    self.pool = (sphactor_pool_t *) args;
+    sphactor_pool_t *pool = self.pool;
+    self.batches = (zmsg_t **) zmalloc (pool->workers_size * sizeof (zmsg_t *));
+    assert (self.batches);
+    size_t worker;
+    for (worker = 0; worker < pool->workers_size; worker++) {
+        s_queue_init (&pool->workers [worker].queue);
+        pool->workers [worker].thread = zactor_new (s_pool_worker, &pool->workers [worker]);
+        assert (pool->workers [worker].thread);
+    }
+    self.actors = zlist_new ();
+    //  Our pipe and the workers keep the first poll items
+    size_t actors_from = 1 + pool->workers_size;
+    self.items_max = actors_from * 2;
+    self.items = (zmq_pollitem_t *) zmalloc (self.items_max * sizeof (zmq_pollitem_t));
+    assert (self.items);
+    self.owners = (pool_actor_t **) zmalloc (self.items_max * sizeof (pool_actor_t *));
+    assert (self.owners);
+    self.owner_slots = (size_t *) zmalloc (self.items_max * sizeof (size_t));
+    assert (self.owner_slots);
+    self.items [0].socket = zsock_resolve (pipe);
+    self.items [0].events = ZMQ_POLLIN;
+    for (worker = 0; worker < pool->workers_size; worker++) {
+        self.items [1 + worker].socket = zactor_resolve (pool->workers [worker].thread);
+        self.items [1 + worker].events = ZMQ_POLLIN;
+    }
+    self.items_size = actors_from;
+    zsock_signal (pipe, 0);
+
+    while (!self.terminated) {
+        int ready = zmq_poll (self.items, (int) self.items_size, s_dispatcher_timeout (&self));
+        if (ready == -1) {
+            if (errno == EINTR)
+                continue;   //  Actors decide themselves on interrupts
+            break;
+        }
+        for (worker = 0; worker < actors_from; worker++) {
+            if (self.items [worker].revents & ZMQ_POLLIN)
+                ready--;
+        }
+        //  Running an actor moves the last poll items into its holes, so
+        //  walk back to visit every poll item once
+        size_t index = self.items_size;
+        while (ready > 0 && index > actors_from) {
+            index--;
+            if (index >= self.items_size)
+                continue;
+            if (self.items [index].revents & ZMQ_POLLIN) {
+                ready--;
+                s_dispatcher_run (&self, self.owners [index]);
+            }
+        }
+        int64_t now = zclock_mono ();
+        while (self.heap_size > 0 && self.heap [0]->time_next <= now)
+            s_dispatcher_run (&self, self.heap [0]);
+        s_dispatcher_flush (&self);
+        for (worker = 0; worker < pool->workers_size; worker++) {
+            if (self.items [1 + worker].revents & ZMQ_POLLIN)
+                s_dispatcher_recv_worker (&self, pool->workers [worker].thread);
+        }
+        if (self.items [0].revents & ZMQ_POLLIN)
+            s_dispatcher_recv_api (&self);
+    }
+
+    //  Stop the workers first, so no actor is running anymore
+    for (worker = 0; worker < pool->workers_size; worker++) {
+        zactor_destroy (&pool->workers [worker].thread);
+        s_queue_destroy (&pool->workers [worker].queue);
+    }
+    free (self.batches);
+
+    pool_actor_t *item = (pool_actor_t *) zlist_first (self.actors);
+    while (item) {
+        if (item->actor) {
+            zsys_warning ("sphactor_pool: destroying actor %s still running in the pool",
+                          zuuid_str (sphactor_actor_uuid (item->actor)));
+            s_pool_actor_finish (pool, item);
+        }
+        free (item->slots);
+        free (item);
+        item = (pool_actor_t *) zlist_next (self.actors);
+    }
+    zlist_destroy (&self.actors);
+    free (self.items);
+    free (self.owners);
+    free (self.owner_slots);
+    free (self.heap);
+}
+
+//  --------------------------------------------------------------------------
+//  Self test of this class
+
+// If your selftest reads SCMed fixture data, please keep it in
+// src/selftest-ro; if your test creates filesystem objects, please
+// do so under src/selftest-rw.
+// The following pattern is suggested for C selftest code:
+//    char *filename = NULL;
+//    filename = zsys_sprintf ("%s/%s", SELFTEST_DIR_RO, "mytemplate.file");
+//    assert (filename);
+//    ... use the "filename" for I/O ...
+//    zstr_free (&filename);
+// This way the same "filename" variable can be reused for many subtests.
+#define SELFTEST_DIR_RO "src/selftest-ro"
+#define SELFTEST_DIR_RW "src/selftest-rw"
+
+static zmsg_t *
+pool_test_pulse (sphactor_event_t *ev, void *args)
+{
+    if ( streq(ev->type, "TIME") )
+    {
+        zmsg_t *msg = zmsg_new ();
+        zmsg_addstr (msg, "PULSE");
+        return msg;
+    }
+    if ( ev->msg )
+        zmsg_destroy (&ev->msg);
+    return NULL;
+}
+
+static zmsg_t *
+pool_test_count (sphactor_event_t *ev, void *args)
+{
+    if ( streq(ev->type, "SOCK") )
+        sphactor_atomic_add ((sphactor_atomic_int_t *) args, 1);
+    if ( ev->msg )
+        zmsg_destroy (&ev->msg);
+    return NULL;
+}
+
+static zmsg_t *
+pool_test_tick (sphactor_event_t *ev, void *args)
+{
+    if ( streq(ev->type, "TIME") )
+        sphactor_atomic_add ((sphactor_atomic_int_t *) args, 1);
+    if ( ev->msg )
+        zmsg_destroy (&ev->msg);
+    return NULL;
+}
+
+//  Wait until every count is above 0, a loaded machine can take much
+//  longer than the timeouts add up to
+
+static void
+pool_test_wait (sphactor_atomic_int_t *counts, int size)
+{
+    int64_t deadline = zclock_mono () + 10000;
+    int i = 0;
+    while (i < size && zclock_mono () < deadline) {
+        if (sphactor_atomic_load (&counts [i]) > 0)
+            i++;
+        else
+            zclock_sleep (5);
+    }
+}
+
+void
+sphactor_pool_test (bool verbose)
+{
+    printf (" * sphactor_pool: ");
+
+    //  @selftest
+    //  Simple create/destroy test
+    sphactor_pool_t *self = sphactor_pool_new (2);
+    assert (self);
+    assert (sphactor_pool_workers (self) == 2);
+    assert (sphactor_pool_size (self) == 0);
+    sphactor_pool_destroy (&self);
+    assert (self == NULL);
+
+    //  Run many more actors than workers: a pulse feeding counters
+    self = sphactor_pool_new (0);
+    assert (sphactor_pool_workers (self) > 0);
+    sphactor_pool_set_default (self);
+    assert (sphactor_pool_default () == self);
+
+    sphactor_t *pulse = sphactor_new (pool_test_pulse, NULL, "pulse", NULL);
+    assert (pulse);
+    assert (streq (sphactor_ask_name (pulse), "pulse"));
+    sphactor_ask_set_timeout (pulse, 10);
+    assert (sphactor_ask_timeout (pulse) == 10);
+
+    sphactor_atomic_int_t counts [100];
+    sphactor_t *counters [100];
+    int i;
+    for (i = 0; i < 100; i++) {
+        sphactor_atomic_store (&counts [i], 0);
+        counters [i] = sphactor_new (pool_test_count, &counts [i], NULL, NULL);
+        assert (counters [i]);
+        sphactor_ask_connect (counters [i], sphactor_ask_endpoint (pulse));
+    }
+    assert (sphactor_pool_size (self) == 101);
+    pool_test_wait (counts, 100);
+
+    sphactor_destroy (&pulse);
+    for (i = 0; i < 100; i++) {
+        sphactor_destroy (&counters [i]);
+        assert (sphactor_atomic_load (&counts [i]) > 0);
+    }
+    assert (sphactor_pool_size (self) == 0);
+
+    //  All workers got to run actors or steal them. Workers will have
+    //  been idle in between the pulses.
+    uint64_t runs = 0;
+    uint64_t idles = 0;
+    size_t worker;
+    for (worker = 0; worker < sphactor_pool_workers (self); worker++) {
+        if (verbose)
+            zsys_info ("worker %zu: runs %llu, steals %llu, idles %llu", worker,
+                       (unsigned long long) sphactor_pool_runs (self, worker),
+                       (unsigned long long) sphactor_pool_steals (self, worker),
+                       (unsigned long long) sphactor_pool_idles (self, worker));
+        runs += sphactor_pool_runs (self, worker);
+        idles += sphactor_pool_idles (self, worker);
+    }
+    assert (runs >= 101);
+    assert (idles > 0);
+
+    //  Timers of many idle actors with different timeouts all fire
+    sphactor_atomic_int_t ticks [200];
+    sphactor_t *tickers [200];
+    for (i = 0; i < 200; i++) {
+        sphactor_atomic_store (&ticks [i], 0);
+        tickers [i] = sphactor_new (pool_test_tick, &ticks [i], NULL, NULL);
+        sphactor_ask_set_timeout (tickers [i], 5 + i % 20);
+    }
+    assert (sphactor_pool_size (self) == 200);
+    pool_test_wait (ticks, 200);
+    for (i = 0; i < 200; i++) {
+        sphactor_destroy (&tickers [i]);
+        assert (sphactor_atomic_load (&ticks [i]) > 0);
+    }
+    assert (sphactor_pool_size (self) == 0);
+
+    //  New actors run in their own thread again
+    sphactor_pool_set_default (NULL);
+    assert (sphactor_pool_default () == NULL);
+    sphactor_pool_destroy (&self);
+    //  @end
+    printf ("OK\n");
+}
@@ -30,6 +30,15 @@
 void
 sphactor_private_selftest (bool verbose, const char *subtest)
 {
+// Tests for stable private classes:
+    if (streq (subtest, "$ALL") || streq (subtest, "sphactor_ring_test"))
+        sphactor_ring_test (verbose);
+    if (streq (subtest, "$ALL") || streq (subtest, "sphactor_mcast_test"))
+        sphactor_mcast_test (verbose);
+    if (streq (subtest, "$ALL") || streq (subtest, "sph_stage_snapshot_test"))
+        sph_stage_snapshot_test (verbose);
+    if (streq (subtest, "$ALL") || streq (subtest, "sphactor_wheel_test"))
+        sphactor_wheel_test (verbose);
 }
 /*
 ################################################################################
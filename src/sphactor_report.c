@@ -29,6 +29,12 @@ struct _sphactor_report_t {
     int64_t  recv_time;     //  time of last receive on socket
     int64_t  send_time;     //  time of last send on socket
     zosc_t *custom;         //  Optional custom OSC message
+    uint64_t custom_version;    //  Changes with the custom message
+    uint64_t *lags;         //  Messages each multicast reader is behind
+    sphactor_histogram_t *handler_time;     //  Time spent in the handler
+    sphactor_histogram_t *queue_time;       //  Time messages waited for us
+    sphactor_histogram_t *timer_jitter;     //  How late interval events fired
+    size_t   readers;       //  Number of multicast readers
 };
 
 
@@ -46,6 +52,12 @@ sphactor_report_new (void)
     self->recv_time = 0;
     self->send_time = 0;
     self->custom = NULL;
+    self->custom_version = 0;
+    self->lags = NULL;
+    self->readers = 0;
+    self->handler_time = sphactor_histogram_new();
+    self->queue_time = sphactor_histogram_new();
+    self->timer_jitter = sphactor_histogram_new();
     return self;
 }
 
@@ -60,6 +72,12 @@ sphactor_report_construct (int status, uint64_t iterations, int64_t recv_time, i
     self->recv_time = recv_time;
     self->send_time = send_time;
     self->custom = custom;
+    self->custom_version = 0;
+    self->lags = NULL;
+    self->readers = 0;
+    self->handler_time = sphactor_histogram_new();
+    self->queue_time = sphactor_histogram_new();
+    self->timer_jitter = sphactor_histogram_new();
     return self;
 }
 
@@ -105,6 +123,87 @@ sphactor_report_custom (sphactor_report_t *self)
     return self->custom;
 }
 
+//  Return the version of the custom status, it changes whenever the
+//  actor sets a new custom status
+uint64_t
+sphactor_report_custom_version (sphactor_report_t *self)
+{
+    assert( self );
+    return self->custom_version;
+}
+
+//  Return the number of multicast readers in the report, 0 if the
+//  actor doesn't multicast
+size_t
+sphactor_report_readers (sphactor_report_t *self)
+{
+    assert( self );
+    return self->readers;
+}
+
+//  Return the number of messages a multicast reader is behind
+uint64_t
+sphactor_report_lag (sphactor_report_t *self, size_t reader)
+{
+    assert( self );
+    assert( reader < self->readers );
+    return self->lags[reader];
+}
+
+//  Return the histogram of the time the actor's handler took in
+//  microseconds. The report owns the histogram.
+sphactor_histogram_t *
+sphactor_report_handler_time (sphactor_report_t *self)
+{
+    assert( self );
+    return self->handler_time;
+}
+
+//  Return the histogram of the time messages waited between being
+//  published and being received by the actor, in microseconds.
+sphactor_histogram_t *
+sphactor_report_queue_time (sphactor_report_t *self)
+{
+    assert( self );
+    return self->queue_time;
+}
+
+//  Return the histogram of how late the TIME events of the actor's
+//  interval fired, in microseconds. The report owns the histogram.
+sphactor_histogram_t *
+sphactor_report_timer_jitter (sphactor_report_t *self)
+{
+    assert( self );
+    return self->timer_jitter;
+}
+
+//  Return the handler time below which the given percentage of the
+//  handler calls lie, e.g. 99.9 for p999 and 100 for the maximum.
+uint64_t
+sphactor_report_handler_latency (sphactor_report_t *self, double percentile)
+{
+    assert( self );
+    return sphactor_histogram_percentile( self->handler_time, percentile );
+}
+
+//  Return the queue time below which the given percentage of the
+//  messages lie, e.g. 99.9 for p999 and 100 for the maximum.
+uint64_t
+sphactor_report_queue_latency (sphactor_report_t *self, double percentile)
+{
+    assert( self );
+    return sphactor_histogram_percentile( self->queue_time, percentile );
+}
+
+//  Return the timer jitter below which the given percentage of the
+//  interval TIME events lie, e.g. 99.9 for p999 and 100 for the maximum.
+uint64_t
+sphactor_report_jitter_latency (sphactor_report_t *self, double percentile)
+{
+    assert( self );
+    return sphactor_histogram_percentile( self->timer_jitter, percentile );
+}
+
 //  set the status in the report
 void
 sphactor_report_set_status (sphactor_report_t *self, int status)
@@ -147,6 +246,39 @@ sphactor_report_set_custom (sphactor_report_t *self, zosc_t *message)
     self->custom = message;
 }
 
+//  Set the version of the custom status
+void
+sphactor_report_set_custom_version (sphactor_report_t *self, uint64_t version)
+{
+    assert( self );
+    self->custom_version = version;
+}
+
+//  Set the number of multicast readers, new readers have no lag
+void
+sphactor_report_set_readers (sphactor_report_t *self, size_t readers)
+{
+    assert( self );
+    if ( readers > self->readers )
+    {
+        self->lags = (uint64_t *) realloc( self->lags, readers * sizeof(uint64_t) );
+        assert( self->lags );
+        memset( self->lags + self->readers, 0, (readers - self->readers) * sizeof(uint64_t) );
+    }
+    self->readers = readers;
+}
+
+//  Set the number of messages a multicast reader is behind, adds the
+//  reader if needed
+void
+sphactor_report_set_lag (sphactor_report_t *self, size_t reader, uint64_t lag)
+{
+    assert( self );
+    if ( reader >= self->readers )
+        sphactor_report_set_readers( self, reader + 1 );
+    self->lags[reader] = lag;
+}
+
 //  --------------------------------------------------------------------------
 //  Destroy the sphactor_report
 
@@ -160,6 +292,10 @@ sphactor_report_destroy (sphactor_report_t **self_p)
         self->status = 3;
         if ( self->custom )
             zosc_destroy( &self->custom );
+        free( self->lags );
+        sphactor_histogram_destroy( &self->handler_time );
+        sphactor_histogram_destroy( &self->queue_time );
+        sphactor_histogram_destroy( &self->timer_jitter );
         //  Free object itself
         free (self);
         *self_p = NULL;
@@ -199,6 +335,25 @@ sphactor_report_test (bool verbose)
     assert( sphactor_report_recv_time(self) == 333 );
     sphactor_report_set_send_time(self, 444 );
     assert( sphactor_report_send_time(self) == 444 );
+    assert( sphactor_report_readers(self) == 0 );
+    sphactor_report_set_lag(self, 2, 55 );
+    assert( sphactor_report_readers(self) == 3 );
+    assert( sphactor_report_lag(self, 0) == 0 );
+    assert( sphactor_report_lag(self, 2) == 55 );
+    sphactor_report_set_readers(self, 1 );
+    assert( sphactor_report_readers(self) == 1 );
+    sphactor_report_set_readers(self, 2 );
+    assert( sphactor_report_lag(self, 1) == 0 );
+    assert( sphactor_report_custom_version(self) == 0 );
+    sphactor_report_set_custom_version(self, 3 );
+    assert( sphactor_report_custom_version(self) == 3 );
+    sphactor_histogram_record( sphactor_report_handler_time(self), 10 );
+    sphactor_histogram_record( sphactor_report_handler_time(self), 1000 );
+    assert( sphactor_report_handler_latency(self, 50.0) == 10 );
+    assert( sphactor_report_handler_latency(self, 100.0) == 1000 );
+    assert( sphactor_report_queue_latency(self, 99.0) == 0 );
+    sphactor_histogram_record( sphactor_report_timer_jitter(self), 12 );
+    assert( sphactor_report_jitter_latency(self, 100.0) == 12 );
     // Todo test custom message
     sphactor_report_destroy (&self);
 
@@ -0,0 +1,366 @@
+/*  =========================================================================
+    sphactor_ring - class description
+
+    Copyright (c) the Contributors as noted in the AUTHORS file.
+
+    This file is part of Sphactor, an open-source framework for high level
+    actor model concurrency --- http://sphactor.org
+
+    This Source Code Form is subject to the terms of the Mozilla Public
+    License, v. 2.0. If a copy of the MPL was not distributed with this
+    file, You can obtain one at http://mozilla.org/MPL/2.0/.
+    =========================================================================
+*/
+
+/*
+@header
+    sphactor_ring - lock-free single producer, single consumer message ring
+@discuss
+    Actors in the same process normally pass messages through inproc PUB/SUB
+    sockets. Every message then takes a trip through libzmq's pipes, its
+    mailbox and a few locks. A ring hands the zmsg_t pointer from the
+    producing actor's thread to the consuming actor's thread directly.
+
+    The producer only writes the tail and the consumer only writes the head
+    so neither needs a lock. Both keep a cached copy of the other's index so
+    they only touch the other's cache line when the ring seems full or
+    empty.
+
+    The consumer polls the ring through a doorbell (see sphactor_doorbell.h).
+    It is only rung when the consumer ran out of messages and said it is
+    waiting, so a burst of messages costs one system call instead of one
+    per message.
+@end
+*/
+
+#include "sphactor_classes.h"
+
+//  Default number of messages in a ring
+#define SPHACTOR_RING_SIZE 1024
+
+//  Structure of our class
+
+struct _sphactor_ring_t {
+    sphactor_atomic_int_t tail; //  Next slot to push, written by the producer
+    int64_t head_cache;         //  Producer's copy of head
+    char    tail_pad [64];      //  keep producer and consumer off each other's cache line
+    sphactor_atomic_int_t head; //  Next slot to pop, written by the consumer
+    int64_t tail_cache;         //  Consumer's copy of tail
+    int64_t time;               //  When the last popped message was pushed
+    char    head_pad [64];
+    sphactor_atomic_int_t waiting;  //  Is the consumer waiting for the doorbell?
+    sphactor_atomic_int_t closed;   //  Did either end close the ring?
+    sphactor_atomic_int_t refs;     //  Number of references to the ring
+    int64_t size;               //  Number of slots, a power of 2
+    zmsg_t  **slots;            //  The messages
+    int64_t *times;             //  When the messages were pushed
+    sphactor_doorbell_t doorbell;   //  Polled by the consumer
+};
+
+
+//  --------------------------------------------------------------------------
+//  Create a new ring holding up to size messages, rounded up to a power
+//  of 2. The caller holds the first reference to the ring.
+
+sphactor_ring_t *
+sphactor_ring_new (size_t size)
+{
+    sphactor_ring_t *self = (sphactor_ring_t *) zmalloc (sizeof (sphactor_ring_t));
+    assert (self);
+    if (size == 0)
+        size = SPHACTOR_RING_SIZE;
+    self->size = 1;
+    while (self->size < (int64_t) size)
+        self->size <<= 1;
+    self->slots = (zmsg_t **) zmalloc (self->size * sizeof (zmsg_t *));
+    assert (self->slots);
+    self->times = (int64_t *) zmalloc (self->size * sizeof (int64_t));
+    assert (self->times);
+    sphactor_atomic_store (&self->tail, 0);
+    sphactor_atomic_store (&self->head, 0);
+    sphactor_atomic_store (&self->waiting, 1);
+    sphactor_atomic_store (&self->closed, 0);
+    sphactor_atomic_store (&self->refs, 1);
+    sphactor_doorbell_init (&self->doorbell);
+    return self;
+}
+
+
+//  --------------------------------------------------------------------------
+//  Drop a reference to the ring. The last reference destroys the ring
+//  and the messages still in it.
+
+void
+sphactor_ring_destroy (sphactor_ring_t **self_p)
+{
+    assert (self_p);
+    if (*self_p) {
+        sphactor_ring_t *self = *self_p;
+        *self_p = NULL;
+        if (sphactor_atomic_add (&self->refs, -1) > 1)
+            return;
+
+        zmsg_t *msg = sphactor_ring_pop (self);
+        while (msg) {
+            zmsg_destroy (&msg);
+            msg = sphactor_ring_pop (self);
+        }
+        sphactor_doorbell_term (&self->doorbell);
+        free (self->slots);
+        free (self->times);
+        free (self);
+    }
+}
+
+
+//  --------------------------------------------------------------------------
+//  Add a reference to the ring, destroy the ring to drop it.
+
+void
+sphactor_ring_ref (sphactor_ring_t *self)
+{
+    assert (self);
+    int64_t refs = sphactor_atomic_add (&self->refs, 1);
+    assert (refs > 0);
+}
+
+
+//  --------------------------------------------------------------------------
+//  Push a message into the ring, producer only. Takes ownership of the
+//  message and returns 0, or returns -1 when the ring is full or closed
+//  and leaves the message to the caller.
+
+int
+sphactor_ring_push (sphactor_ring_t *self, zmsg_t **msg_p)
+{
+    assert (self);
+    assert (msg_p && *msg_p);
+    if (sphactor_atomic_load_relaxed (&self->closed))
+        return -1;
+
+    int64_t tail = sphactor_atomic_load_relaxed (&self->tail);
+    if (tail - self->head_cache == self->size) {
+        self->head_cache = sphactor_atomic_load (&self->head);
+        if (tail - self->head_cache == self->size)
+            return -1;
+    }
+    self->slots [tail & (self->size - 1)] = *msg_p;
+    self->times [tail & (self->size - 1)] = zclock_usecs ();
+    *msg_p = NULL;
+    sphactor_atomic_store (&self->tail, tail + 1);
+
+    //  Publishing the tail before reading waiting pairs with the consumer
+    //  setting waiting before reading the tail: one of us sees the other
+    if (sphactor_atomic_load (&self->waiting)
+    &&  sphactor_atomic_cas (&self->waiting, 1, 0))
+        sphactor_doorbell_ring (&self->doorbell);
+    return 0;
+}
+
+
+//  --------------------------------------------------------------------------
+//  Pop the next message from the ring, consumer only. Returns NULL when
+//  the ring is empty.
+//  Caller owns return value and must destroy it when done.
+
+zmsg_t *
+sphactor_ring_pop (sphactor_ring_t *self)
+{
+    assert (self);
+    int64_t head = sphactor_atomic_load_relaxed (&self->head);
+    if (head == self->tail_cache) {
+        self->tail_cache = sphactor_atomic_load (&self->tail);
+        if (head == self->tail_cache) {
+            //  Empty, silence the doorbell and ask the producer to ring it
+            //  for the next message
+            sphactor_doorbell_silence (&self->doorbell);
+            sphactor_atomic_store (&self->waiting, 1);
+            self->tail_cache = sphactor_atomic_load (&self->tail);
+            if (head == self->tail_cache)
+                return NULL;
+
+            //  A message slipped in before we asked, ring the doorbell
+            //  ourselves unless the producer beat us to it
+            if (sphactor_atomic_cas (&self->waiting, 1, 0))
+                sphactor_doorbell_ring (&self->doorbell);
+        }
+    }
+    zmsg_t *msg = self->slots [head & (self->size - 1)];
+    self->slots [head & (self->size - 1)] = NULL;
+    self->time = self->times [head & (self->size - 1)];
+    sphactor_atomic_store (&self->head, head + 1);
+    return msg;
+}
+
+
+//  --------------------------------------------------------------------------
+//  Return when the message last popped was pushed (zclock_usecs),
+//  consumer only
+
+int64_t
+sphactor_ring_time (sphactor_ring_t *self)
+{
+    assert (self);
+    return self->time;
+}
+
+
+//  --------------------------------------------------------------------------
+//  Return the handle to poll for messages in the ring (zpoller_add).
+//  It stays readable until the ring is emptied by pop.
+
+void *
+sphactor_ring_handle (sphactor_ring_t *self)
+{
+    assert (self);
+    return sphactor_doorbell_handle (&self->doorbell);
+}
+
+
+//  --------------------------------------------------------------------------
+//  Return the number of messages in the ring
+
+size_t
+sphactor_ring_size (sphactor_ring_t *self)
+{
+    assert (self);
+    int64_t head = sphactor_atomic_load (&self->head);
+    return (size_t) (sphactor_atomic_load (&self->tail) - head);
+}
+
+
+//  --------------------------------------------------------------------------
+//  Close the ring, the producer won't be able to push anymore
+
+void
+sphactor_ring_close (sphactor_ring_t *self)
+{
+    assert (self);
+    sphactor_atomic_store (&self->closed, 1);
+}
+
+
+//  --------------------------------------------------------------------------
+//  Return true if the ring is closed
+
+bool
+sphactor_ring_closed (sphactor_ring_t *self)
+{
+    assert (self);
+    return sphactor_atomic_load (&self->closed) != 0;
+}
+
+
+//  --------------------------------------------------------------------------
+//  Self test of this class
+
+#define TEST_MESSAGES 100000
+
+static void
+ring_test_producer (zsock_t *pipe, void *args)
+{
+    sphactor_ring_t *ring = (sphactor_ring_t *) args;
+    zsock_signal (pipe, 0);
+    int i;
+    for (i = 0; i < TEST_MESSAGES; i++) {
+        zmsg_t *msg = zmsg_new ();
+        zmsg_addstrf (msg, "%d", i);
+        while (sphactor_ring_push (ring, &msg) == -1)
+            zclock_sleep (0);
+    }
+    zsock_wait (pipe);
+}
+
+void
+sphactor_ring_test (bool verbose)
+{
+    printf (" * sphactor_ring: ");
+
+    //  @selftest
+    //  Simple create/destroy test
+    sphactor_ring_t *self = sphactor_ring_new (0);
+    assert (self);
+    assert (sphactor_ring_size (self) == 0);
+    assert (sphactor_ring_pop (self) == NULL);
+    sphactor_ring_destroy (&self);
+    assert (self == NULL);
+
+    //  The size is rounded up to a power of 2
+    self = sphactor_ring_new (3);
+    zpoller_t *poller = zpoller_new (sphactor_ring_handle (self), NULL);
+    assert (poller);
+    assert (zpoller_wait (poller, 0) == NULL);
+
+    int i;
+    for (i = 0; i < 4; i++) {
+        zmsg_t *msg = zmsg_new ();
+        zmsg_addstrf (msg, "%d", i);
+        assert (sphactor_ring_push (self, &msg) == 0);
+        assert (msg == NULL);
+    }
+    assert (sphactor_ring_size (self) == 4);
+    zmsg_t *full = zmsg_new ();
+    assert (sphactor_ring_push (self, &full) == -1);
+    assert (full);
+    assert (zpoller_wait (poller, 0) == sphactor_ring_handle (self));
+
+    for (i = 0; i < 4; i++) {
+        zmsg_t *msg = sphactor_ring_pop (self);
+        assert (msg);
+        char *str = zmsg_popstr (msg);
+        assert (atoi (str) == i);
+        zstr_free (&str);
+        zmsg_destroy (&msg);
+        assert (sphactor_ring_time (self) <= zclock_usecs ());
+    }
+    assert (sphactor_ring_pop (self) == NULL);
+    assert (zpoller_wait (poller, 0) == NULL);
+
+    //  The doorbell rings again for the next message
+    assert (sphactor_ring_push (self, &full) == 0);
+    assert (zpoller_wait (poller, 0) == sphactor_ring_handle (self));
+
+    //  A closed ring refuses messages, the last reference frees the rest
+    sphactor_ring_ref (self);
+    sphactor_ring_t *ref = self;
+    sphactor_ring_close (self);
+    assert (sphactor_ring_closed (self));
+    full = zmsg_new ();
+    assert (sphactor_ring_push (self, &full) == -1);
+    zmsg_destroy (&full);
+    zpoller_destroy (&poller);
+    sphactor_ring_destroy (&ref);
+    assert (sphactor_ring_size (self) == 1);
+    sphactor_ring_destroy (&self);
+
+    //  Messages arrive in order from another thread
+    self = sphactor_ring_new (64);
+    poller = zpoller_new (sphactor_ring_handle (self), NULL);
+    zactor_t *producer = zactor_new (ring_test_producer, self);
+    assert (producer);
+    int64_t start = zclock_usecs ();
+    int received = 0;
+    while (received < TEST_MESSAGES) {
+        zmsg_t *msg = sphactor_ring_pop (self);
+        if (msg == NULL) {
+            void *which = zpoller_wait (poller, 1000);
+            assert (which == sphactor_ring_handle (self));
+            continue;
+        }
+        char *str = zmsg_popstr (msg);
+        assert (atoi (str) == received);
+        zstr_free (&str);
+        zmsg_destroy (&msg);
+        received++;
+    }
+    if (verbose)
+        zsys_info ("sphactor_ring: %d messages in %" PRId64 " usecs",
+                   received, zclock_usecs () - start);
+    zsock_signal (producer, 0);
+    zactor_destroy (&producer);
+    zpoller_destroy (&poller);
+    sphactor_ring_destroy (&self);
+    //  @end
+
+    printf ("OK\n");
+}
@@ -0,0 +1,85 @@
+/*  =========================================================================
+    sphactor_ring - class description
+
+    Copyright (c) the Contributors as noted in the AUTHORS file.
+
+    This file is part of Sphactor, an open-source framework for high level
+    actor model concurrency --- http://sphactor.org
+
+    This Source Code Form is subject to the terms of the Mozilla Public
+    License, v. 2.0. If a copy of the MPL was not distributed with this
+    file, You can obtain one at http://mozilla.org/MPL/2.0/.
+    =========================================================================
+*/
+
+#ifndef SPHACTOR_RING_H_INCLUDED
+#define SPHACTOR_RING_H_INCLUDED
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//  @warning THE FOLLOWING @INTERFACE BLOCK IS AUTO-GENERATED BY ZPROJECT
+//  @warning Please edit the model at "api/sphactor_ring.api" to make changes.
+//  @interface
+//  This is a stable class, and may not change except for emergencies. It
+//  is provided in stable builds.
+//  Create a new ring holding up to size messages, rounded up to a power
+//  of 2. The caller holds the first reference to the ring.
+SPHACTOR_PRIVATE sphactor_ring_t *
+    sphactor_ring_new (size_t size);
+
+//  Drop a reference to the ring. The last reference destroys the ring
+//  and the messages still in it.
+SPHACTOR_PRIVATE void
+    sphactor_ring_destroy (sphactor_ring_t **self_p);
+
+//  Add a reference to the ring, destroy the ring to drop it.
+SPHACTOR_PRIVATE void
+    sphactor_ring_ref (sphactor_ring_t *self);
+
+//  Push a message into the ring, producer only. Takes ownership of the
+//  message and returns 0, or returns -1 when the ring is full or closed
+//  and leaves the message to the caller.
+SPHACTOR_PRIVATE int
+    sphactor_ring_push (sphactor_ring_t *self, zmsg_t **msg_p);
+
+//  Pop the next message from the ring, consumer only. Returns NULL when
+//  the ring is empty.
+//  Caller owns return value and must destroy it when done.
+SPHACTOR_PRIVATE zmsg_t *
+    sphactor_ring_pop (sphactor_ring_t *self);
+
+//  Return when the message last popped was pushed (zclock_usecs),
+//  consumer only
+SPHACTOR_PRIVATE int64_t
+    sphactor_ring_time (sphactor_ring_t *self);
+
+//  Return the handle to poll for messages in the ring (zpoller_add).
+//  It stays readable until the ring is emptied by pop.
+SPHACTOR_PRIVATE void *
+    sphactor_ring_handle (sphactor_ring_t *self);
+
+//  Return the number of messages in the ring
+SPHACTOR_PRIVATE size_t
+    sphactor_ring_size (sphactor_ring_t *self);
+
+//  Close the ring, the producer won't be able to push anymore
+SPHACTOR_PRIVATE void
+    sphactor_ring_close (sphactor_ring_t *self);
+
+//  Return true if the ring is closed
+SPHACTOR_PRIVATE bool
+    sphactor_ring_closed (sphactor_ring_t *self);
+
+//  Self test of this class.
+SPHACTOR_PRIVATE void
+    sphactor_ring_test (bool verbose);
+
+//  @end
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -38,6 +38,22 @@ all_tests [] = {
     { "sphactor_report", sphactor_report_test, true, true, NULL },
     { "sph_stage", sph_stage_test, true, true, NULL },
     { "sph_stock", sph_stock_test, true, true, NULL },
+    { "sphactor_pool", sphactor_pool_test, true, true, NULL },
+    { "sphactor_payload", sphactor_payload_test, true, true, NULL },
+    { "sphactor_histogram", sphactor_histogram_test, true, true, NULL },
+    { "sphactor_trace", sphactor_trace_test, true, true, NULL },
+    { "sphactor_timeline", sphactor_timeline_test, true, true, NULL },
+    { "sphactor_future", sphactor_future_test, true, true, NULL },
+    { "sphactor_tick", sphactor_tick_test, true, true, NULL },
+#ifdef SPHACTOR_BUILD_DRAFT_API
+// Tests for stable/draft private classes:
+// Now built only with --enable-drafts, so even stable builds are hidden behind the flag
+    { "sphactor_ring", NULL, true, false, "sphactor_ring_test" },
+    { "sphactor_mcast", NULL, true, false, "sphactor_mcast_test" },
+    { "sph_stage_snapshot", NULL, true, false, "sph_stage_snapshot_test" },
+    { "sphactor_wheel", NULL, true, false, "sphactor_wheel_test" },
+    { "private_classes", NULL, false, false, "$ALL" }, // compat option for older projects
+#endif // SPHACTOR_BUILD_DRAFT_API
     {NULL, NULL, 0, 0, NULL}          //  Sentinel
 };
 
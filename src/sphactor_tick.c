@@ -0,0 +1,907 @@
+/*  =========================================================================
+    sphactor_tick - class description
+
+    Copyright (c) the Contributors as noted in the AUTHORS file.
+
+    This file is part of Sphactor, an open-source framework for high level
+    actor model concurrency --- http://sphactor.org
+
+    This Source Code Form is subject to the terms of the Mozilla Public
+    License, v. 2.0. If a copy of the MPL was not distributed with this
+    file, You can obtain one at http://mozilla.org/MPL/2.0/.
+    =========================================================================
+*/
+
+/*
+@header
+    sphactor_tick - synchronous dataflow executor running actors per tick
+@discuss
+    Actors normally wake up whenever a message arrives on one of their
+    sockets. A message passing a chain of actors takes a hop, and a wakeup,
+    per actor and the actors of a graph see the output of their sources at
+    different moments. For signal processing it is often better to run the
+    whole graph once per tick instead.
+
+    By default a tick executor runs its actors on its driver thread. It sorts the
+    actors in topological order of their connections and, every tick, calls
+    the handler of each actor in that order. Actors without inputs get a
+    TIME event, the others get a SOCK event for each message their inputs
+    produced. The messages are passed from handler to handler directly, so
+    a value crosses the whole graph in the tick it was produced. Actors in
+    a cycle run after the rest and get the messages of the back edges a
+    tick later.
+
+    With workers the independent branches of the graph run concurrently.
+    Every actor counts the actors it waits on, its neighbours earlier in
+    the tick order. When an actor finishes the counters of its later
+    neighbours go down and the actors reaching zero are handed to an idle
+    worker straight away. A wide graph finishes its tick in about the time
+    of its longest chain instead of the time of all its handlers. An actor
+    only ever runs on one thread at the time.
+
+    The order is recomputed whenever an actor is added, removed or
+    (dis)connected. Messages only flow between actors of the same tick
+    executor, the ticked actors don't publish on their sockets.
+
+    The pipe of a ticked actor behaves like the pipe of a zactor so the
+    sphactor_ask_* methods work unchanged.
+@end
+*/
+
+#include "sphactor_classes.h"
+
+//  Structure of our class
+
+struct _sphactor_tick_t {
+    zactor_t *driver;           //  Driver thread running our actors
+    int64_t interval;           //  Usecs between ticks, 0 for manual ticks
+    size_t  workers;            //  Number of worker threads
+    sphactor_atomic_int_t ticks;    //  Number of ticks done
+};
+
+//  Same prefix the actors use for ring buffer endpoints
+#define SPHACTOR_TICK_RING_PREFIX "ring+"
+
+//  An actor run by the tick executor
+
+typedef struct _tick_actor_t tick_actor_t;
+
+struct _tick_actor_t {
+    sphactor_actor_t *actor;    //  The actor
+    zsock_t *pipe;              //  The actor's end of its pipe
+    tick_actor_t **inputs;      //  Actors we are connected to
+    size_t  inputs_size;        //  Number of inputs
+    zlist_t *downstream;        //  Actors connected to us
+    zlist_t *after;             //  Neighbours later in the tick order
+    size_t  before;             //  Number of neighbours earlier in the tick order
+    size_t  pending;            //  Inputs not sorted yet, or neighbours
+                                //  earlier in the tick order still to run
+    size_t  position;           //  Our position in the tick order
+    bool    sorted;             //  Are we in the tick order?
+    zlist_t *inbox;             //  Messages to handle in our next run
+    zlist_t *outputs;           //  Messages we produced in our last run
+    uint64_t output_tick;       //  Tick of our last run
+};
+
+//  State of the driver thread
+
+typedef struct {
+    zsock_t *pipe;              //  Pipe back to the tick executor
+    bool    terminated;         //  Did the tick executor ask us to quit?
+    sphactor_tick_t *tick;      //  The tick executor we drive
+    zpoller_t *poller;          //  Polls our pipe and the actor pipes
+    zlist_t *actors;            //  All actors in spawn order
+    zlist_t *order;             //  All actors in tick order
+    bool    dirty;              //  Does the tick order need a rebuild?
+    zactor_t **workers;         //  Worker threads
+    size_t  workers_size;       //  Number of worker threads
+    zpoller_t *workers_poller;  //  Polls the worker threads during a tick
+    zlist_t *idle;              //  Workers waiting for an actor
+    zlist_t *ready;             //  Actors waiting for a worker
+} driver_t;
+
+//  Default tick executor new sphactors are created in
+static sphactor_tick_t *s_default_tick = NULL;
+
+//  (forward declare)
+static void s_tick_driver (zsock_t *pipe, void *args);
+static void s_tick_worker (zsock_t *pipe, void *args);
+
+
+//  --------------------------------------------------------------------------
+//  Create a new sphactor_tick
+
+sphactor_tick_t *
+sphactor_tick_new (int64_t interval)
+{
+    assert (interval >= 0);
+    sphactor_tick_t *self = (sphactor_tick_t *) zmalloc (sizeof (sphactor_tick_t));
+    assert (self);
+    self->interval = interval;
+    self->driver = zactor_new (s_tick_driver, self);
+    assert (self->driver);
+    return self;
+}
+
+//  --------------------------------------------------------------------------
+//  Destroy the sphactor_tick
+
+void
+sphactor_tick_destroy (sphactor_tick_t **self_p)
+{
+    assert (self_p);
+    if (*self_p) {
+        sphactor_tick_t *self = *self_p;
+        if (s_default_tick == self)
+            s_default_tick = NULL;
+        zactor_destroy (&self->driver);
+        //  Free object itself
+        free (self);
+        *self_p = NULL;
+    }
+}
+
+size_t
+sphactor_tick_size (sphactor_tick_t *self)
+{
+    assert (self);
+    uint64_t size = 0;
+    zstr_send (self->driver, "SIZE");
+    int rc = zsock_recv (self->driver, "8", &size);
+    assert (rc == 0);
+    return (size_t) size;
+}
+
+size_t
+sphactor_tick_workers (sphactor_tick_t *self)
+{
+    assert (self);
+    return self->workers;
+}
+
+void
+sphactor_tick_set_workers (sphactor_tick_t *self, size_t workers)
+{
+    assert (self);
+    //  The driver reads the number when it gets the command, we wait for
+    //  it to have its workers before returning
+    self->workers = workers;
+    zstr_send (self->driver, "WORKERS");
+    zsock_wait (self->driver);
+}
+
+uint64_t
+sphactor_tick_ticks (sphactor_tick_t *self)
+{
+    assert (self);
+    return (uint64_t) sphactor_atomic_load (&self->ticks);
+}
+
+void
+sphactor_tick_step (sphactor_tick_t *self)
+{
+    assert (self);
+    zstr_send (self->driver, "STEP");
+    zsock_wait (self->driver);
+}
+
+zlist_t *
+sphactor_tick_order (sphactor_tick_t *self)
+{
+    assert (self);
+    zstr_send (self->driver, "ORDER");
+    zmsg_t *reply = zmsg_recv (self->driver);
+    zlist_t *order = zlist_new ();
+    zlist_autofree (order);
+    if (reply == NULL)
+        return order;   //  Interrupted
+    char *endpoint = zmsg_popstr (reply);
+    while (endpoint) {
+        zlist_append (order, endpoint);
+        zstr_free (&endpoint);
+        endpoint = zmsg_popstr (reply);
+    }
+    zmsg_destroy (&reply);
+    return order;
+}
+
+zsock_t *
+sphactor_tick_spawn (sphactor_tick_t *self, void *args)
+{
+    assert (self);
+    assert (args);
+    zsock_t *backend = NULL;
+    zsock_t *frontend = zsys_create_pipe (&backend);
+    assert (frontend);
+
+    //  Create and start the actor in our thread like the zactor does in its
+    //  thread, from then on the driver runs the actor.
+    sphactor_actor_t *actor = sphactor_actor_new (backend, args);
+    assert (actor);
+    sphactor_actor_set_pooled (actor, true);
+    sphactor_actor_set_ticked (actor, true);
+    sphactor_actor_start (actor);
+    zsock_wait (frontend);
+
+    tick_actor_t *item = (tick_actor_t *) zmalloc (sizeof (tick_actor_t));
+    assert (item);
+    item->actor = actor;
+    item->pipe = backend;
+    item->downstream = zlist_new ();
+    item->after = zlist_new ();
+    item->inbox = zlist_new ();
+    item->outputs = zlist_new ();
+    zsock_send (self->driver, "sp", "ADD", item);
+    return frontend;
+}
+
+void
+sphactor_tick_set_default (sphactor_tick_t *tick)
+{
+    s_default_tick = tick;
+}
+
+sphactor_tick_t *
+sphactor_tick_default (void)
+{
+    return s_default_tick;
+}
+
+//  --------------------------------------------------------------------------
+//  Actors of the tick executor
+
+//  Drop a list of messages
+
+static void
+s_tick_purge (zlist_t *msgs)
+{
+    zmsg_t *msg = (zmsg_t *) zlist_pop (msgs);
+    while (msg) {
+        zmsg_destroy (&msg);
+        msg = (zmsg_t *) zlist_pop (msgs);
+    }
+}
+
+//  Run an actor: a TIME event if it has no inputs, a SOCK event for each
+//  message in its inbox. Its replies become its outputs. Only touches the
+//  actor itself so it can run on any thread.
+
+static void
+s_tick_actor_run (tick_actor_t *item)
+{
+    s_tick_purge (item->outputs);
+    zmsg_t *reply;
+    if (item->inputs_size == 0) {
+        reply = sphactor_actor_handle (item->actor, NULL);
+        if (reply)
+            zlist_append (item->outputs, reply);
+    }
+    zmsg_t *msg = (zmsg_t *) zlist_pop (item->inbox);
+    while (msg) {
+        reply = sphactor_actor_handle (item->actor, msg);
+        if (reply)
+            zlist_append (item->outputs, reply);
+        msg = (zmsg_t *) zlist_pop (item->inbox);
+    }
+}
+
+//  Destroy a ticked actor the way sphactor_actor_run ends when its thread
+//  returns: signal the pipe and destroy our end.
+
+static void
+s_tick_actor_destroy (tick_actor_t **item_p)
+{
+    tick_actor_t *item = *item_p;
+    sphactor_actor_stop (item->actor);
+    sphactor_actor_destroy (&item->actor);
+    zsock_set_sndtimeo (item->pipe, 0);
+    zsock_signal (item->pipe, 0);
+    zsock_destroy (&item->pipe);
+    s_tick_purge (item->inbox);
+    s_tick_purge (item->outputs);
+    zlist_destroy (&item->inbox);
+    zlist_destroy (&item->outputs);
+    zlist_destroy (&item->after);
+    zlist_destroy (&item->downstream);
+    free (item->inputs);
+    free (item);
+    *item_p = NULL;
+}
+
+//  Return the actor with the pipe
+
+static tick_actor_t *
+s_driver_lookup (driver_t *self, void *pipe)
+{
+    tick_actor_t *item = (tick_actor_t *) zlist_first (self->actors);
+    while (item && item->pipe != pipe)
+        item = (tick_actor_t *) zlist_next (self->actors);
+    return item;
+}
+
+//  Sort the actors in topological order of their connections (Kahn's
+//  algorithm). Actors which are ready at the same time keep their spawn
+//  order so the tick order doesn't change from run to run. Actors in a
+//  cycle never get ready, they are appended in spawn order.
+
+static void
+s_driver_sort (driver_t *self)
+{
+    zhash_t *endpoints = zhash_new ();
+    tick_actor_t *item = (tick_actor_t *) zlist_first (self->actors);
+    while (item) {
+        zhash_insert (endpoints, sphactor_actor_endpoint (item->actor), item);
+        zlist_purge (item->downstream);
+        zlist_purge (item->after);
+        item->before = 0;
+        item->sorted = false;
+        item = (tick_actor_t *) zlist_next (self->actors);
+    }
+    //  Resolve the connections of every actor to its inputs
+    item = (tick_actor_t *) zlist_first (self->actors);
+    while (item) {
+        zlist_t *connections = sphactor_actor_connections (item->actor);
+        free (item->inputs);
+        item->inputs = (tick_actor_t **) zmalloc ((zlist_size (connections) + 1) * sizeof (tick_actor_t *));
+        assert (item->inputs);
+        item->inputs_size = 0;
+        const char *endpoint = (const char *) zlist_first (connections);
+        while (endpoint) {
+            if (strncmp (endpoint, SPHACTOR_TICK_RING_PREFIX, strlen (SPHACTOR_TICK_RING_PREFIX)) == 0)
+                endpoint += strlen (SPHACTOR_TICK_RING_PREFIX);
+            tick_actor_t *input = (tick_actor_t *) zhash_lookup (endpoints, endpoint);
+            if (input && input != item && !zlist_exists (input->downstream, item)) {
+                item->inputs [item->inputs_size++] = input;
+                zlist_append (input->downstream, item);
+            }
+            endpoint = (const char *) zlist_next (connections);
+        }
+        item->pending = item->inputs_size;
+        item = (tick_actor_t *) zlist_next (self->actors);
+    }
+    zhash_destroy (&endpoints);
+
+    zlist_purge (self->order);
+    zlist_t *ready = zlist_new ();
+    item = (tick_actor_t *) zlist_first (self->actors);
+    while (item) {
+        if (item->pending == 0)
+            zlist_append (ready, item);
+        item = (tick_actor_t *) zlist_next (self->actors);
+    }
+    size_t position = 0;
+    item = (tick_actor_t *) zlist_pop (ready);
+    while (item) {
+        item->position = position++;
+        item->sorted = true;
+        zlist_append (self->order, item);
+        tick_actor_t *next = (tick_actor_t *) zlist_first (item->downstream);
+        while (next) {
+            assert (next->pending > 0);
+            if (--next->pending == 0)
+                zlist_append (ready, next);
+            next = (tick_actor_t *) zlist_next (item->downstream);
+        }
+        item = (tick_actor_t *) zlist_pop (ready);
+    }
+    zlist_destroy (&ready);
+    item = (tick_actor_t *) zlist_first (self->actors);
+    while (item) {
+        if (!item->sorted) {
+            item->position = position++;
+            zlist_append (self->order, item);
+        }
+        item = (tick_actor_t *) zlist_next (self->actors);
+    }
+
+    //  Every connection makes the later of its actors wait on the earlier
+    //  one. Along a back edge the earlier actor reads the previous tick's
+    //  messages so the later one must not replace them before it ran.
+    item = (tick_actor_t *) zlist_first (self->actors);
+    while (item) {
+        size_t index;
+        for (index = 0; index < item->inputs_size; index++) {
+            tick_actor_t *input = item->inputs [index];
+            tick_actor_t *first = input->position < item->position ? input : item;
+            tick_actor_t *last = first == input ? item : input;
+            if (!zlist_exists (first->after, last)) {
+                zlist_append (first->after, last);
+                last->before++;
+            }
+        }
+        item = (tick_actor_t *) zlist_next (self->actors);
+    }
+    self->dirty = false;
+}
+
+//  Fill the inbox of an actor with copies of the messages of its inputs.
+//  Inputs before us ran this tick, inputs after us (the back edges of a
+//  cycle) ran last tick. Neither is running while we are about to run.
+
+static void
+s_driver_deliver (tick_actor_t *item, uint64_t tick)
+{
+    size_t index;
+    for (index = 0; index < item->inputs_size; index++) {
+        tick_actor_t *input = item->inputs [index];
+        uint64_t wanted = input->position < item->position ? tick : tick - 1;
+        if (input->output_tick != wanted)
+            continue;
+        zmsg_t *msg = (zmsg_t *) zlist_first (input->outputs);
+        while (msg) {
+            zlist_append (item->inbox, sphactor_payload_msg_dup (msg));
+            msg = (zmsg_t *) zlist_next (input->outputs);
+        }
+    }
+}
+
+//  Hand the ready actors to the idle workers
+
+static void
+s_driver_dispatch (driver_t *self, uint64_t tick)
+{
+    while (zlist_size (self->ready) && zlist_size (self->idle)) {
+        tick_actor_t *item = (tick_actor_t *) zlist_pop (self->ready);
+        zactor_t *worker = (zactor_t *) zlist_pop (self->idle);
+        s_driver_deliver (item, tick);
+        zsock_send (worker, "sp", "RUN", item);
+    }
+}
+
+//  Run every actor once on the workers, each as soon as the actors it
+//  waits on have finished
+
+static void
+s_driver_tick_parallel (driver_t *self, uint64_t tick)
+{
+    tick_actor_t *item = (tick_actor_t *) zlist_first (self->order);
+    while (item) {
+        item->pending = item->before;
+        if (item->pending == 0)
+            zlist_append (self->ready, item);
+        item = (tick_actor_t *) zlist_next (self->order);
+    }
+    size_t running = 0;
+    size_t done = 0;
+    while (done < zlist_size (self->order)) {
+        running += zlist_size (self->ready) < zlist_size (self->idle)
+                 ? zlist_size (self->ready) : zlist_size (self->idle);
+        s_driver_dispatch (self, tick);
+        assert (running > 0);
+
+        zactor_t *worker = (zactor_t *) zpoller_wait (self->workers_poller, -1);
+        if (worker == NULL)
+            continue;   //  Interrupted, the actors decide themselves
+        char *command = NULL;
+        void *ptr = NULL;
+        if (zsock_recv (worker, "sp", &command, &ptr) == -1)
+            continue;
+        assert (streq (command, "DONE"));
+        zstr_free (&command);
+        zlist_append (self->idle, worker);
+        running--;
+        done++;
+
+        item = (tick_actor_t *) ptr;
+        item->output_tick = tick;
+        tick_actor_t *next = (tick_actor_t *) zlist_first (item->after);
+        while (next) {
+            assert (next->pending > 0);
+            if (--next->pending == 0)
+                zlist_append (self->ready, next);
+            next = (tick_actor_t *) zlist_next (item->after);
+        }
+    }
+}
+
+//  Run every actor once in tick order
+
+static void
+s_driver_tick (driver_t *self)
+{
+    if (self->dirty)
+        s_driver_sort (self);
+    uint64_t tick = (uint64_t) sphactor_atomic_load (&self->tick->ticks) + 1;
+    if (self->workers_size > 0 && zlist_size (self->order) > 1)
+        s_driver_tick_parallel (self, tick);
+    else {
+        tick_actor_t *item = (tick_actor_t *) zlist_first (self->order);
+        while (item) {
+            s_driver_deliver (item, tick);
+            s_tick_actor_run (item);
+            item->output_tick = tick;
+            item = (tick_actor_t *) zlist_next (self->order);
+        }
+    }
+    sphactor_atomic_store (&self->tick->ticks, (int64_t) tick);
+}
+
+//  Start or stop workers till we have as many as the tick executor wants
+
+static void
+s_driver_workers (driver_t *self)
+{
+    size_t workers = self->tick->workers;
+    size_t index;
+    for (index = workers; index < self->workers_size; index++) {
+        zpoller_remove (self->workers_poller, self->workers [index]);
+        zlist_remove (self->idle, self->workers [index]);
+        zactor_destroy (&self->workers [index]);
+    }
+    self->workers = (zactor_t **) realloc (self->workers, (workers + 1) * sizeof (zactor_t *));
+    assert (self->workers);
+    for (index = self->workers_size; index < workers; index++) {
+        self->workers [index] = zactor_new (s_tick_worker, NULL);
+        assert (self->workers [index]);
+        zpoller_add (self->workers_poller, self->workers [index]);
+        zlist_append (self->idle, self->workers [index]);
+    }
+    self->workers_size = workers;
+}
+
+//  Handle a command on the pipe of an actor, the actor is destroyed when
+//  it was told to terminate
+
+static void
+s_driver_recv_actor (driver_t *self, tick_actor_t *item)
+{
+    int rc = sphactor_actor_recv_pipe (item->actor);
+    //  Any command could have (dis)connected the actor
+    self->dirty = true;
+    if (rc == 0 && !sphactor_actor_terminated (item->actor))
+        return;
+    zpoller_remove (self->poller, item->pipe);
+    zlist_remove (self->actors, item);
+    zlist_remove (self->order, item);
+    s_tick_actor_destroy (&item);
+}
+
+static void
+s_driver_recv_api (driver_t *self)
+{
+    char *command = NULL;
+    void *ptr = NULL;
+    if (zsock_recv (self->pipe, "sp", &command, &ptr) == -1)
+        return;     //  Interrupted
+
+    if (streq (command, "ADD")) {
+        tick_actor_t *item = (tick_actor_t *) ptr;
+        zlist_append (self->actors, item);
+        zpoller_add (self->poller, item->pipe);
+        self->dirty = true;
+    }
+    else
+    if (streq (command, "WORKERS")) {
+        s_driver_workers (self);
+        zsock_signal (self->pipe, 0);
+    }
+    else
+    if (streq (command, "STEP")) {
+        s_driver_tick (self);
+        zsock_signal (self->pipe, 0);
+    }
+    else
+    if (streq (command, "SIZE"))
+        zsock_send (self->pipe, "8", (uint64_t) zlist_size (self->actors));
+    else
+    if (streq (command, "ORDER")) {
+        if (self->dirty)
+            s_driver_sort (self);
+        zmsg_t *reply = zmsg_new ();
+        tick_actor_t *item = (tick_actor_t *) zlist_first (self->order);
+        while (item) {
+            zmsg_addstr (reply, sphactor_actor_endpoint (item->actor));
+            item = (tick_actor_t *) zlist_next (self->order);
+        }
+        zmsg_send (&reply, self->pipe);
+    }
+    else
+    if (streq (command, "$TERM"))
+        self->terminated = true;
+    else
+        zsys_error ("sphactor_tick: invalid command '%s'", command);
+
+    zstr_free (&command);
+}
+
+//  Return the msecs till the next tick is due, -1 without an interval
+
+static int
+s_driver_timeout (driver_t *self, int64_t next)
+{
+    if (self->tick->interval == 0)
+        return -1;
+    int64_t timeout = (next - zclock_usecs ()) / 1000;
+    return timeout > 0 ? (int) timeout : 0;
+}
+
+//  --------------------------------------------------------------------------
+//  Driver thread, ticks the actors and handles the commands on their pipes
+//  in between the ticks.
+
+static void
+s_tick_driver (zsock_t *pipe, void *args)
+{
+    driver_t self;
+    memset (&self, 0, sizeof (driver_t));
+    self.pipe = pipe;
+    self.tick = (sphactor_tick_t *) args;
+    self.poller = zpoller_new (pipe, NULL);
+    assert (self.poller);
+    //  Actors decide themselves on interrupts
+    zpoller_set_nonstop (self.poller, true);
+    self.actors = zlist_new ();
+    self.order = zlist_new ();
+    self.workers_poller = zpoller_new (NULL);
+    assert (self.workers_poller);
+    zpoller_set_nonstop (self.workers_poller, true);
+    self.idle = zlist_new ();
+    self.ready = zlist_new ();
+    zsock_signal (pipe, 0);
+
+    //  Ticks are due at fixed times so the interval doesn't drift with the
+    //  time the ticks take
+    int64_t interval = self.tick->interval;
+    int64_t next = zclock_usecs () + interval;
+    while (!self.terminated) {
+        void *which = zpoller_wait (self.poller, s_driver_timeout (&self, next));
+        if (which == pipe)
+            s_driver_recv_api (&self);
+        else
+        if (which) {
+            tick_actor_t *item = s_driver_lookup (&self, which);
+            assert (item);
+            s_driver_recv_actor (&self, item);
+        }
+        if (interval && zclock_usecs () >= next) {
+            s_driver_tick (&self);
+            next += interval;
+            int64_t now = zclock_usecs ();
+            if (next < now)
+                next = now + interval;  //  We fell behind, skip the missed ticks
+        }
+    }
+
+    tick_actor_t *item = (tick_actor_t *) zlist_pop (self.actors);
+    while (item) {
+        zsys_warning ("sphactor_tick: destroying actor %s still running in the tick executor",
+                      zuuid_str (sphactor_actor_uuid (item->actor)));
+        s_tick_actor_destroy (&item);
+        item = (tick_actor_t *) zlist_pop (self.actors);
+    }
+    zlist_destroy (&self.actors);
+    zlist_destroy (&self.order);
+    zpoller_destroy (&self.poller);
+    //  No tick is running so all workers are idle
+    size_t index;
+    for (index = 0; index < self.workers_size; index++)
+        zactor_destroy (&self.workers [index]);
+    free (self.workers);
+    zpoller_destroy (&self.workers_poller);
+    zlist_destroy (&self.idle);
+    zlist_destroy (&self.ready);
+}
+
+//  --------------------------------------------------------------------------
+//  Worker thread, runs the actors the driver hands it
+
+static void
+s_tick_worker (zsock_t *pipe, void *args)
+{
+    zsock_signal (pipe, 0);
+    while (true) {
+        char *command = NULL;
+        void *ptr = NULL;
+        if (zsock_recv (pipe, "sp", &command, &ptr) == -1) {
+            //  keep running our actors on interrupts, they decide to quit
+            if (errno == EINTR)
+                continue;
+            break;
+        }
+        bool term = streq (command, "$TERM");
+        if (streq (command, "RUN")) {
+            tick_actor_t *item = (tick_actor_t *) ptr;
+            s_tick_actor_run (item);
+            zsock_send (pipe, "sp", "DONE", item);
+        }
+        zstr_free (&command);
+        if (term)
+            break;
+    }
+}
+
+//  --------------------------------------------------------------------------
+//  Self test of this class
+
+// If your selftest reads SCMed fixture data, please keep it in
+// src/selftest-ro; if your test creates filesystem objects, please
+// do so under src/selftest-rw.
+// The following pattern is suggested for C selftest code:
+//    char *filename = NULL;
+//    filename = zsys_sprintf ("%s/%s", SELFTEST_DIR_RO, "mytemplate.file");
+//    assert (filename);
+//    ... use the "filename" for I/O ...
+//    zstr_free (&filename);
+// This way the same "filename" variable can be reused for many subtests.
+#define SELFTEST_DIR_RO "src/selftest-ro"
+#define SELFTEST_DIR_RW "src/selftest-rw"
+
+//  Produces an increasing number every tick
+static zmsg_t *
+tick_test_source (sphactor_event_t *ev, void *args)
+{
+    if ( ev->msg )
+        zmsg_destroy (&ev->msg);
+    if ( streq(ev->type, "TIME") )
+    {
+        int *value = (int *) args;
+        zmsg_t *msg = zmsg_new ();
+        zmsg_addstrf (msg, "%d", ++(*value));
+        return msg;
+    }
+    return NULL;
+}
+
+//  Passes its messages on
+static zmsg_t *
+tick_test_mid (sphactor_event_t *ev, void *args)
+{
+    if ( streq(ev->type, "SOCK") )
+        return ev->msg;
+    if ( ev->msg )
+        zmsg_destroy (&ev->msg);
+    return NULL;
+}
+
+//  Keeps the last number it received
+static zmsg_t *
+tick_test_sink (sphactor_event_t *ev, void *args)
+{
+    if ( streq(ev->type, "SOCK") )
+    {
+        char *value = zmsg_popstr (ev->msg);
+        *(int *) args = atoi (value);
+        zstr_free (&value);
+    }
+    if ( ev->msg )
+        zmsg_destroy (&ev->msg);
+    return NULL;
+}
+
+//  Counts the slow handlers running right now and the most seen at once
+typedef struct {
+    sphactor_atomic_int_t running;
+    sphactor_atomic_int_t most;
+} tick_test_overlap_t;
+
+//  Passes its messages on, slowly
+static zmsg_t *
+tick_test_slow (sphactor_event_t *ev, void *args)
+{
+    if ( streq(ev->type, "SOCK") )
+    {
+        tick_test_overlap_t *overlap = (tick_test_overlap_t *) args;
+        int64_t running = sphactor_atomic_add (&overlap->running, 1) + 1;
+        int64_t most = sphactor_atomic_load (&overlap->most);
+        while (running > most && !sphactor_atomic_cas (&overlap->most, most, running))
+            most = sphactor_atomic_load (&overlap->most);
+        zclock_sleep (5);
+        sphactor_atomic_add (&overlap->running, -1);
+        return ev->msg;
+    }
+    if ( ev->msg )
+        zmsg_destroy (&ev->msg);
+    return NULL;
+}
+
+void
+sphactor_tick_test (bool verbose)
+{
+    printf (" * sphactor_tick: ");
+
+    //  @selftest
+    //  Simple create/destroy test
+    sphactor_tick_t *self = sphactor_tick_new (0);
+    assert (self);
+    assert (sphactor_tick_size (self) == 0);
+    assert (sphactor_tick_ticks (self) == 0);
+    sphactor_tick_destroy (&self);
+    assert (self == NULL);
+
+    //  A chain created in reverse runs in connection order and its value
+    //  reaches the end of the chain in the tick it was produced
+    self = sphactor_tick_new (0);
+    sphactor_tick_set_default (self);
+    assert (sphactor_tick_default () == self);
+    int produced = 0;
+    int received = 0;
+    sphactor_t *sink = sphactor_new (tick_test_sink, &received, "sink", NULL);
+    sphactor_t *mid = sphactor_new (tick_test_mid, NULL, "mid", NULL);
+    sphactor_t *source = sphactor_new (tick_test_source, &produced, "source", NULL);
+    assert (sphactor_tick_size (self) == 3);
+    sphactor_ask_connect (sink, sphactor_ask_endpoint (mid));
+    sphactor_ask_connect (mid, sphactor_ask_endpoint (source));
+
+    zlist_t *order = sphactor_tick_order (self);
+    assert (zlist_size (order) == 3);
+    assert (streq ((char *) zlist_first (order), sphactor_ask_endpoint (source)));
+    assert (streq ((char *) zlist_next (order), sphactor_ask_endpoint (mid)));
+    assert (streq ((char *) zlist_next (order), sphactor_ask_endpoint (sink)));
+    zlist_destroy (&order);
+    //  The driver calls the handlers itself, nothing can be fused to them
+    assert (sphactor_new_fused (tick_test_sink, &received, NULL, NULL, source) == NULL);
+    assert (sphactor_tick_size (self) == 3);
+
+    int i;
+    for (i = 1; i <= 10; i++) {
+        sphactor_tick_step (self);
+        assert (produced == i);
+        assert (received == i);
+    }
+    assert (sphactor_tick_ticks (self) == 10);
+
+    sphactor_destroy (&source);
+    sphactor_destroy (&mid);
+    sphactor_destroy (&sink);
+    assert (sphactor_tick_size (self) == 0);
+    sphactor_tick_set_default (NULL);
+    assert (sphactor_tick_default () == NULL);
+    sphactor_tick_destroy (&self);
+
+    //  Independent chains run in parallel on the workers, their slow
+    //  handlers overlap
+#define CHAINS 4
+    self = sphactor_tick_new (0);
+    sphactor_tick_set_workers (self, CHAINS);
+    assert (sphactor_tick_workers (self) == CHAINS);
+    sphactor_tick_set_default (self);
+    int producers [CHAINS];
+    int receivers [CHAINS];
+    sphactor_t *sources [CHAINS];
+    sphactor_t *slows [CHAINS];
+    sphactor_t *sinks [CHAINS];
+    tick_test_overlap_t overlap;
+    sphactor_atomic_store (&overlap.running, 0);
+    sphactor_atomic_store (&overlap.most, 0);
+    for (i = 0; i < CHAINS; i++) {
+        producers [i] = 0;
+        receivers [i] = 0;
+        sources [i] = sphactor_new (tick_test_source, &producers [i], NULL, NULL);
+        slows [i] = sphactor_new (tick_test_slow, &overlap, NULL, NULL);
+        sinks [i] = sphactor_new (tick_test_sink, &receivers [i], NULL, NULL);
+        sphactor_ask_connect (slows [i], sphactor_ask_endpoint (sources [i]));
+        sphactor_ask_connect (sinks [i], sphactor_ask_endpoint (slows [i]));
+    }
+    int j;
+    for (j = 1; j <= 10; j++) {
+        sphactor_tick_step (self);
+        for (i = 0; i < CHAINS; i++)
+            assert (receivers [i] == j);
+    }
+    if (verbose)
+        zsys_info ("at most %d of %d slow handlers ran at once", (int) sphactor_atomic_load (&overlap.most), CHAINS);
+    assert (sphactor_atomic_load (&overlap.running) == 0);
+    assert (sphactor_atomic_load (&overlap.most) >= 2);
+    for (i = 0; i < CHAINS; i++) {
+        sphactor_destroy (&sources [i]);
+        sphactor_destroy (&slows [i]);
+        sphactor_destroy (&sinks [i]);
+    }
+    sphactor_tick_set_workers (self, 0);
+    sphactor_tick_set_default (NULL);
+    sphactor_tick_destroy (&self);
+
+    //  With an interval the driver ticks by itself
+    self = sphactor_tick_new (2000);
+    sphactor_tick_set_default (self);
+    produced = 0;
+    source = sphactor_new (tick_test_source, &produced, "source", NULL);
+    zclock_sleep (50);
+    sphactor_destroy (&source);
+    sphactor_tick_set_default (NULL);
+    assert (sphactor_tick_ticks (self) > 5);
+    assert (produced > 5);
+    sphactor_tick_destroy (&self);
+    //  @end
+    printf ("OK\n");
+}
@@ -0,0 +1,455 @@
+/*  =========================================================================
+    sphactor_timeline - class description
+
+    Copyright (c) the Contributors as noted in the AUTHORS file.
+
+    This file is part of Sphactor, an open-source framework for high level
+    actor model concurrency --- http://sphactor.org
+
+    This Source Code Form is subject to the terms of the Mozilla Public
+    License, v. 2.0. If a copy of the MPL was not distributed with this
+    file, You can obtain one at http://mozilla.org/MPL/2.0/.
+    =========================================================================
+*/
+
+/*
+@header
+    sphactor_timeline - handler calls of actors as Chrome trace events
+@discuss
+    Every actor records its handler calls into its own ring of events. An
+    actor runs on one thread at a time, also when pooled, so a ring has a
+    single writer and needs no lock. The writer only publishes the number
+    of events it recorded; the dump copies the ring and drops the events
+    that were overwritten while it copied.
+
+    Each actor gets its own row in the trace viewer, named after it. When
+    an actor is destroyed its events stay around for the dump until a new
+    actor takes over its ring, so the memory used is bounded by the
+    number of actors running at the same time. An event takes 24 bytes,
+    so a ring of the default 1024 events takes 24KB. Set a larger
+    capacity before enabling when you trace many events of few actors.
+
+    Timelines are registered in a list guarded by a spinlock, only taken
+    when creating timelines and dumping them.
+@end
+*/
+
+#include "sphactor_classes.h"
+
+//  An event slot, the dump may read it while it's written
+typedef struct {
+    sphactor_atomic_ptr_t type;     //  Event type, a string literal
+    sphactor_atomic_int_t begin;    //  Handler called (zclock_usecs)
+    sphactor_atomic_int_t end;      //  Handler returned (zclock_usecs)
+} timeline_event_t;
+
+//  Structure of our class
+
+struct _sphactor_timeline_t {
+    sphactor_atomic_int_t head;     //  Number of events recorded
+    sphactor_atomic_int_t start;    //  First event to dump
+    sphactor_atomic_int_t in_use;   //  Does an actor own us?
+    int64_t id;                     //  Our row in the dump
+    char    name [64];              //  Name of the actor owning us
+    int64_t capacity;               //  Size of the ring, a power of two
+    timeline_event_t *events;       //  The ring
+};
+
+//  All timelines, destroyed ones are reused
+static zlist_t *s_timelines = NULL;
+static sphactor_atomic_int_t s_timelines_locked;
+static int64_t s_timelines_ids = 0;
+//  Size of the rings of new timelines
+static sphactor_atomic_int_t s_capacity = SPHACTOR_TIMELINE_EVENTS;
+//  Are actors recording? And since when?
+static sphactor_atomic_int_t s_enabled;
+static sphactor_atomic_int_t s_epoch;
+
+//  Forward declarations
+static void
+    s_timelines_lock (void);
+static void
+    s_timelines_unlock (void);
+static void
+    s_json_string (FILE *file, const char *string);
+
+
+//  --------------------------------------------------------------------------
+//  Constructor, creates a timeline for the named actor. Destroyed
+//  timelines are kept for the dump until a new timeline takes their
+//  place.
+
+sphactor_timeline_t *
+sphactor_timeline_new (const char *name)
+{
+    assert (name);
+    s_timelines_lock ();
+    if (s_timelines == NULL) {
+        s_timelines = zlist_new ();
+        assert (s_timelines);
+    }
+    sphactor_timeline_t *self = (sphactor_timeline_t *) zlist_first (s_timelines);
+    while (self && sphactor_atomic_load (&self->in_use))
+        self = (sphactor_timeline_t *) zlist_next (s_timelines);
+    if (self == NULL) {
+        self = (sphactor_timeline_t *) zmalloc (sizeof (sphactor_timeline_t));
+        assert (self);
+        zlist_append (s_timelines, self);
+    }
+    //  The dump holds the lock, so nobody reads the ring we replace
+    int64_t capacity = sphactor_atomic_load (&s_capacity);
+    if (self->capacity != capacity) {
+        free (self->events);
+        self->events = (timeline_event_t *) zmalloc (sizeof (timeline_event_t) * capacity);
+        assert (self->events);
+        self->capacity = capacity;
+    }
+    //  The previous owner's events are not ours
+    sphactor_atomic_store (&self->start, sphactor_atomic_load (&self->head));
+    sphactor_atomic_store (&self->in_use, 1);
+    self->id = ++s_timelines_ids;
+    snprintf (self->name, sizeof (self->name), "%s", name);
+    s_timelines_unlock ();
+    return self;
+}
+
+
+//  --------------------------------------------------------------------------
+//  Destructor, destroys a timeline.
+
+void
+sphactor_timeline_destroy (sphactor_timeline_t **self_p)
+{
+    assert (self_p);
+    if (*self_p) {
+        sphactor_timeline_t *self = *self_p;
+        //  Keep the events for the dump, a new timeline reuses us
+        sphactor_atomic_store (&self->in_use, 0);
+        *self_p = NULL;
+    }
+}
+
+
+//  --------------------------------------------------------------------------
+//  Record a handler call for the event type between begin and end
+//  (zclock_usecs). The type must be a string literal. Only one thread
+//  may record into a timeline.
+
+void
+sphactor_timeline_record (sphactor_timeline_t *self, const char *type, uint64_t begin, uint64_t end)
+{
+    assert (self);
+    assert (type);
+    int64_t head = sphactor_atomic_load_relaxed (&self->head);
+    timeline_event_t *event = &self->events [head & (self->capacity - 1)];
+    sphactor_atomic_store_ptr_relaxed (&event->type, (void *) type);
+    sphactor_atomic_store_relaxed (&event->begin, (int64_t) begin);
+    sphactor_atomic_store_relaxed (&event->end, (int64_t) end);
+    sphactor_atomic_store (&self->head, head + 1);
+}
+
+
+//  --------------------------------------------------------------------------
+//  Return the number of events in the timeline
+
+size_t
+sphactor_timeline_size (sphactor_timeline_t *self)
+{
+    assert (self);
+    int64_t head = sphactor_atomic_load (&self->head);
+    int64_t start = sphactor_atomic_load (&self->start);
+    if (head - start > self->capacity)
+        return (size_t) self->capacity;
+    return (size_t) (head - start);
+}
+
+
+//  --------------------------------------------------------------------------
+//  Set the number of events kept per timeline, rounded up to a power of
+//  two. Only timelines created afterwards use it, so set it before
+//  enabling. The default is SPHACTOR_TIMELINE_EVENTS.
+
+void
+sphactor_timeline_set_capacity (size_t events)
+{
+    assert (events > 0);
+    int64_t capacity = 1;
+    while (capacity < (int64_t) events)
+        capacity <<= 1;
+    sphactor_atomic_store (&s_capacity, capacity);
+}
+
+
+//  --------------------------------------------------------------------------
+//  Return the number of events kept per new timeline.
+
+size_t
+sphactor_timeline_capacity (void)
+{
+    return (size_t) sphactor_atomic_load (&s_capacity);
+}
+
+
+//  --------------------------------------------------------------------------
+//  Start or stop recording handler calls in all actors.
+
+void
+sphactor_timeline_enable (bool enable)
+{
+    if (enable && !sphactor_atomic_load (&s_enabled))
+        sphactor_atomic_store (&s_epoch, zclock_usecs ());
+    sphactor_atomic_store (&s_enabled, enable ? 1 : 0);
+}
+
+
+//  --------------------------------------------------------------------------
+//  Return true if actors record their handler calls.
+
+bool
+sphactor_timeline_enabled (void)
+{
+    return sphactor_atomic_load_relaxed (&s_enabled) != 0;
+}
+
+
+//  --------------------------------------------------------------------------
+//  Write the events of all timelines to a file as Chrome trace event
+//  JSON. May be called while actors record.
+//  Returns 0 on success, -1 if the file can't be written.
+
+int
+sphactor_timeline_dump (const char *filename)
+{
+    assert (filename);
+    FILE *file = fopen (filename, "w");
+    if (file == NULL) {
+        zsys_error ("sphactor_timeline: can't write %s", filename);
+        return -1;
+    }
+    int64_t epoch = sphactor_atomic_load (&s_epoch);
+    timeline_event_t *copy = NULL;
+    int64_t copy_size = 0;
+    fprintf (file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    fprintf (file, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"sphactor\"}}");
+
+    s_timelines_lock ();
+    sphactor_timeline_t *self = s_timelines ? (sphactor_timeline_t *) zlist_first (s_timelines) : NULL;
+    while (self) {
+        //  Copy the events, then drop those overwritten while copying
+        if (copy_size < self->capacity) {
+            free (copy);
+            copy = (timeline_event_t *) zmalloc (sizeof (timeline_event_t) * self->capacity);
+            assert (copy);
+            copy_size = self->capacity;
+        }
+        int64_t head = sphactor_atomic_load (&self->head);
+        int64_t first = sphactor_atomic_load (&self->start);
+        if (first < head - self->capacity)
+            first = head - self->capacity;
+        int64_t index;
+        for (index = first; index < head; index++) {
+            timeline_event_t *event = &self->events [index & (self->capacity - 1)];
+            timeline_event_t *dest = &copy [index - first];
+            sphactor_atomic_store_ptr_relaxed (&dest->type, sphactor_atomic_load_ptr_relaxed (&event->type));
+            sphactor_atomic_store_relaxed (&dest->begin, sphactor_atomic_load_relaxed (&event->begin));
+            sphactor_atomic_store_relaxed (&dest->end, sphactor_atomic_load_relaxed (&event->end));
+        }
+        sphactor_atomic_fence ();
+        int64_t valid = sphactor_atomic_load (&self->head) - self->capacity;
+
+        fprintf (file, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%" PRId64 ",\"args\":{\"name\":", self->id);
+        s_json_string (file, self->name);
+        fprintf (file, "}}");
+        for (index = first > valid ? first : valid; index < head; index++) {
+            timeline_event_t *event = &copy [index - first];
+            int64_t begin = sphactor_atomic_load_relaxed (&event->begin);
+            int64_t end = sphactor_atomic_load_relaxed (&event->end);
+            fprintf (file, ",\n{\"name\":");
+            s_json_string (file, (const char *) sphactor_atomic_load_ptr_relaxed (&event->type));
+            fprintf (file, ",\"cat\":\"handler\",\"ph\":\"X\",\"pid\":1,\"tid\":%" PRId64
+                           ",\"ts\":%" PRId64 ",\"dur\":%" PRId64 "}",
+                     self->id, begin - epoch, end - begin);
+        }
+        self = (sphactor_timeline_t *) zlist_next (s_timelines);
+    }
+    s_timelines_unlock ();
+
+    fprintf (file, "\n]}\n");
+    free (copy);
+    int rc = ferror (file) ? -1 : 0;
+    if (fclose (file) != 0)
+        rc = -1;
+    if (rc == -1)
+        zsys_error ("sphactor_timeline: failed writing %s", filename);
+    return rc;
+}
+
+
+//  --------------------------------------------------------------------------
+//  Forget the events of all timelines.
+
+void
+sphactor_timeline_clear (void)
+{
+    s_timelines_lock ();
+    sphactor_timeline_t *self = s_timelines ? (sphactor_timeline_t *) zlist_first (s_timelines) : NULL;
+    while (self) {
+        sphactor_atomic_store (&self->start, sphactor_atomic_load (&self->head));
+        self = (sphactor_timeline_t *) zlist_next (s_timelines);
+    }
+    s_timelines_unlock ();
+}
+
+
+//  --------------------------------------------------------------------------
+//  Free all timelines, only call this when no actors are running.
+
+void
+sphactor_timeline_dispose (void)
+{
+    s_timelines_lock ();
+    if (s_timelines) {
+        sphactor_timeline_t *self = (sphactor_timeline_t *) zlist_pop (s_timelines);
+        while (self) {
+            assert (!sphactor_atomic_load (&self->in_use));
+            free (self->events);
+            free (self);
+            self = (sphactor_timeline_t *) zlist_pop (s_timelines);
+        }
+        zlist_destroy (&s_timelines);
+    }
+    s_timelines_unlock ();
+}
+
+
+static void
+s_timelines_lock (void)
+{
+    while (!sphactor_atomic_cas (&s_timelines_locked, 0, 1))
+        zclock_sleep (0);
+}
+
+static void
+s_timelines_unlock (void)
+{
+    sphactor_atomic_store (&s_timelines_locked, 0);
+}
+
+//  Write a string as a JSON string
+
+static void
+s_json_string (FILE *file, const char *string)
+{
+    fputc ('"', file);
+    for (; *string; string++) {
+        unsigned char c = (unsigned char) *string;
+        if (c == '"' || c == '\\')
+            fprintf (file, "\\%c", c);
+        else
+        if (c < 0x20)
+            fprintf (file, "\\u%04x", c);
+        else
+            fputc (c, file);
+    }
+    fputc ('"', file);
+}
+
+
+//  --------------------------------------------------------------------------
+//  Self test of this class
+
+// If your selftest reads SCMed fixture data, please keep it in
+// src/selftest-ro; if your test creates filesystem objects, please
+// do so under src/selftest-rw.
+#define SELFTEST_DIR_RO "src/selftest-ro"
+#define SELFTEST_DIR_RW "src/selftest-rw"
+
+static zmsg_t *
+timeline_test_handler (sphactor_event_t *ev, void *args)
+{
+    if (ev->msg)
+        zmsg_destroy (&ev->msg);
+    return NULL;
+}
+
+void
+sphactor_timeline_test (bool verbose)
+{
+    printf (" * sphactor_timeline: ");
+
+    //  @selftest
+    //  Simple create/destroy test
+    sphactor_timeline_t *self = sphactor_timeline_new ("test \"actor\"");
+    assert (self);
+    assert (sphactor_timeline_size (self) == 0);
+    sphactor_timeline_record (self, "SOCK", 1000, 1010);
+    sphactor_timeline_record (self, "TIME", 1020, 1025);
+    assert (sphactor_timeline_size (self) == 2);
+
+    //  A timeline keeps the last events
+    int i;
+    for (i = 0; i < SPHACTOR_TIMELINE_EVENTS + 10; i++)
+        sphactor_timeline_record (self, "SOCK", 2000 + i, 2001 + i);
+    assert (sphactor_timeline_size (self) == SPHACTOR_TIMELINE_EVENTS);
+    assert (sphactor_timeline_capacity () == SPHACTOR_TIMELINE_EVENTS);
+    sphactor_timeline_clear ();
+    assert (sphactor_timeline_size (self) == 0);
+
+    //  A destroyed timeline is reused without its events
+    sphactor_timeline_record (self, "API", 3000, 3001);
+    sphactor_timeline_t *reused = self;
+    sphactor_timeline_destroy (&self);
+    assert (self == NULL);
+    self = sphactor_timeline_new ("reused");
+    assert (self == reused);
+    assert (sphactor_timeline_size (self) == 0);
+    sphactor_timeline_destroy (&self);
+
+    //  A new capacity is rounded up to a power of two and used by new
+    //  timelines, also when they reuse a ring
+    sphactor_timeline_set_capacity (100);
+    assert (sphactor_timeline_capacity () == 128);
+    self = sphactor_timeline_new ("resized");
+    assert (self == reused);
+    for (i = 0; i < 200; i++)
+        sphactor_timeline_record (self, "SOCK", 4000 + i, 4001 + i);
+    assert (sphactor_timeline_size (self) == 128);
+    sphactor_timeline_destroy (&self);
+    sphactor_timeline_set_capacity (SPHACTOR_TIMELINE_EVENTS);
+
+    //  Actors record their handler calls while enabled
+    assert (!sphactor_timeline_enabled ());
+    sphactor_timeline_enable (true);
+    assert (sphactor_timeline_enabled ());
+    sphactor_t *actor = sphactor_new (timeline_test_handler, NULL, "timeline", NULL);
+    sphactor_ask_set_timeout (actor, 1);
+    zclock_sleep (20);
+    sphactor_destroy (&actor);
+    sphactor_timeline_enable (false);
+
+    char *filename = zsys_sprintf ("%s/%s", SELFTEST_DIR_RW, "timeline.json");
+    int rc = sphactor_timeline_dump (filename);
+    assert (rc == 0);
+    FILE *file = fopen (filename, "r");
+    assert (file);
+    char line [256];
+    bool named = false;
+    int timed = 0;
+    while (fgets (line, sizeof (line), file)) {
+        if (strstr (line, "\"args\":{\"name\":\"timeline\"}"))
+            named = true;
+        if (strstr (line, "{\"name\":\"TIME\",\"cat\":\"handler\",\"ph\":\"X\""))
+            timed++;
+    }
+    fclose (file);
+    if (verbose)
+        zsys_info ("sphactor_timeline: %d TIME events in %s", timed, filename);
+    assert (named);
+    assert (timed > 0);
+    zsys_file_delete (filename);
+    zstr_free (&filename);
+    sphactor_timeline_dispose ();
+    //  @end
+
+    printf ("OK\n");
+}
@@ -0,0 +1,449 @@
+/*  =========================================================================
+    sphactor_trace - class description
+
+    Copyright (c) the Contributors as noted in the AUTHORS file.
+
+    This file is part of Sphactor, an open-source framework for high level
+    actor model concurrency --- http://sphactor.org
+
+    This Source Code Form is subject to the terms of the Mozilla Public
+    License, v. 2.0. If a copy of the MPL was not distributed with this
+    file, You can obtain one at http://mozilla.org/MPL/2.0/.
+    =========================================================================
+*/
+
+/*
+@header
+    sphactor_trace - trace of a message through a graph of actors
+@discuss
+    A traced message ends with a trace frame, so subscribe filters still
+    match its first frame. Actors take the frame off before calling their
+    handler and add it, with a hop for themselves, to whatever the handler
+    publishes. Handlers never see the frame so forwarding ev->msg keeps
+    the trace going.
+
+    The frame holds the origin actor, a sequence number and for every hop
+    the publishing actor and when the message was published and received.
+    Times are zclock_usecs, which is only comparable between actors in the
+    same process or on the same machine.
+
+    Frame layout, integers in network byte order:
+
+        "SPHTRACE"                  8 bytes
+        origin uuid                 16 bytes
+        sequence                    8 bytes
+        number of hops              4 bytes
+        per hop:
+            actor uuid              16 bytes
+            sent                    8 bytes
+            received                8 bytes
+@end
+*/
+
+#include "sphactor_classes.h"
+
+//  First bytes of a trace frame
+#define SPHACTOR_TRACE_MAGIC    "SPHTRACE"
+#define SPHACTOR_TRACE_HEADER   (8 + 16 + 8 + 4)
+#define SPHACTOR_TRACE_HOP      (16 + 8 + 8)
+
+typedef struct {
+    byte    actor [16];             //  Publishing actor
+    char    actor_str [33];         //  Its uuid as a string
+    int64_t sent;                   //  When it published the message
+    int64_t received;               //  When the next actor received it
+} trace_hop_t;
+
+//  Structure of our class
+
+struct _sphactor_trace_t {
+    byte    origin [16];            //  Actor starting the trace
+    char    origin_str [33];        //  Its uuid as a string
+    uint64_t sequence;              //  Sequence number at the origin
+    size_t  hops;                   //  Number of hops
+    trace_hop_t hop [SPHACTOR_TRACE_MAX_HOPS];
+};
+
+//  Forward declarations
+static void
+    s_uuid_str (const byte *uuid, char *str);
+static void
+    s_put_number (byte **needle, uint64_t value, int size);
+static uint64_t
+    s_get_number (const byte **needle, int size);
+
+
+//  --------------------------------------------------------------------------
+//  Constructor, creates a trace for the message with the given
+//  sequence number published by the origin actor.
+
+sphactor_trace_t *
+sphactor_trace_new (zuuid_t *origin, uint64_t sequence)
+{
+    assert (origin);
+    sphactor_trace_t *self = (sphactor_trace_t *) zmalloc (sizeof (sphactor_trace_t));
+    assert (self);
+    memcpy (self->origin, zuuid_data (origin), 16);
+    s_uuid_str (self->origin, self->origin_str);
+    self->sequence = sequence;
+    return self;
+}
+
+
+//  --------------------------------------------------------------------------
+//  Create a trace from a trace frame, returns NULL if the frame isn't
+//  a trace frame.
+
+sphactor_trace_t *
+sphactor_trace_decode (zframe_t *frame)
+{
+    assert (frame);
+    if (!sphactor_trace_is (frame))
+        return NULL;
+    sphactor_trace_t *self = (sphactor_trace_t *) zmalloc (sizeof (sphactor_trace_t));
+    assert (self);
+    const byte *needle = zframe_data (frame) + 8;
+    memcpy (self->origin, needle, 16);
+    needle += 16;
+    s_uuid_str (self->origin, self->origin_str);
+    self->sequence = s_get_number (&needle, 8);
+    self->hops = (size_t) s_get_number (&needle, 4);
+    size_t hop;
+    for (hop = 0; hop < self->hops; hop++) {
+        memcpy (self->hop [hop].actor, needle, 16);
+        needle += 16;
+        s_uuid_str (self->hop [hop].actor, self->hop [hop].actor_str);
+        self->hop [hop].sent = (int64_t) s_get_number (&needle, 8);
+        self->hop [hop].received = (int64_t) s_get_number (&needle, 8);
+    }
+    return self;
+}
+
+
+//  --------------------------------------------------------------------------
+//  Destructor, destroys a trace.
+
+void
+sphactor_trace_destroy (sphactor_trace_t **self_p)
+{
+    assert (self_p);
+    if (*self_p) {
+        sphactor_trace_t *self = *self_p;
+        free (self);
+        *self_p = NULL;
+    }
+}
+
+
+//  --------------------------------------------------------------------------
+//  Return a copy of the trace.
+//  Caller owns return value and must destroy it when done.
+
+sphactor_trace_t *
+sphactor_trace_dup (sphactor_trace_t *self)
+{
+    assert (self);
+    sphactor_trace_t *copy = (sphactor_trace_t *) zmalloc (sizeof (sphactor_trace_t));
+    assert (copy);
+    memcpy (copy, self, sizeof (sphactor_trace_t));
+    return copy;
+}
+
+
+//  --------------------------------------------------------------------------
+//  Return true if the frame is a trace frame.
+
+bool
+sphactor_trace_is (zframe_t *frame)
+{
+    assert (frame);
+    size_t size = zframe_size (frame);
+    if (size < SPHACTOR_TRACE_HEADER
+    ||  memcmp (zframe_data (frame), SPHACTOR_TRACE_MAGIC, 8) != 0)
+        return false;
+    const byte *needle = zframe_data (frame) + 8 + 16 + 8;
+    uint64_t hops = s_get_number (&needle, 4);
+    return hops <= SPHACTOR_TRACE_MAX_HOPS
+        && size == SPHACTOR_TRACE_HEADER + hops * SPHACTOR_TRACE_HOP;
+}
+
+
+//  --------------------------------------------------------------------------
+//  Return the trace as a frame to append to a message.
+//  Caller owns return value and must destroy it when done.
+
+zframe_t *
+sphactor_trace_encode (sphactor_trace_t *self)
+{
+    assert (self);
+    zframe_t *frame = zframe_new (NULL, SPHACTOR_TRACE_HEADER + self->hops * SPHACTOR_TRACE_HOP);
+    assert (frame);
+    byte *needle = zframe_data (frame);
+    memcpy (needle, SPHACTOR_TRACE_MAGIC, 8);
+    needle += 8;
+    memcpy (needle, self->origin, 16);
+    needle += 16;
+    s_put_number (&needle, self->sequence, 8);
+    s_put_number (&needle, self->hops, 4);
+    size_t hop;
+    for (hop = 0; hop < self->hops; hop++) {
+        memcpy (needle, self->hop [hop].actor, 16);
+        needle += 16;
+        s_put_number (&needle, (uint64_t) self->hop [hop].sent, 8);
+        s_put_number (&needle, (uint64_t) self->hop [hop].received, 8);
+    }
+    return frame;
+}
+
+
+//  --------------------------------------------------------------------------
+//  Return the uuid of the actor that started the trace.
+
+const char *
+sphactor_trace_origin (sphactor_trace_t *self)
+{
+    assert (self);
+    return self->origin_str;
+}
+
+
+//  --------------------------------------------------------------------------
+//  Return the sequence number of the trace at its origin.
+
+uint64_t
+sphactor_trace_sequence (sphactor_trace_t *self)
+{
+    assert (self);
+    return self->sequence;
+}
+
+
+//  --------------------------------------------------------------------------
+//  Return the number of hops, every actor that published the message
+//  adds one.
+
+size_t
+sphactor_trace_hops (sphactor_trace_t *self)
+{
+    assert (self);
+    return self->hops;
+}
+
+
+//  --------------------------------------------------------------------------
+//  Return the uuid of the actor publishing at the given hop.
+
+const char *
+sphactor_trace_hop_actor (sphactor_trace_t *self, size_t hop)
+{
+    assert (self);
+    assert (hop < self->hops);
+    return self->hop [hop].actor_str;
+}
+
+
+//  --------------------------------------------------------------------------
+//  Return when the message was published at the given hop
+//  (zclock_usecs).
+
+int64_t
+sphactor_trace_hop_sent (sphactor_trace_t *self, size_t hop)
+{
+    assert (self);
+    assert (hop < self->hops);
+    return self->hop [hop].sent;
+}
+
+
+//  --------------------------------------------------------------------------
+//  Return when the message published at the given hop was received
+//  (zclock_usecs), 0 if it wasn't yet.
+
+int64_t
+sphactor_trace_hop_received (sphactor_trace_t *self, size_t hop)
+{
+    assert (self);
+    assert (hop < self->hops);
+    return self->hop [hop].received;
+}
+
+
+//  --------------------------------------------------------------------------
+//  Return the microseconds the message took to get from the actor
+//  publishing at the given hop to the next actor.
+
+int64_t
+sphactor_trace_hop_latency (sphactor_trace_t *self, size_t hop)
+{
+    assert (self);
+    assert (hop < self->hops);
+    if (self->hop [hop].received == 0)
+        return 0;
+    return self->hop [hop].received - self->hop [hop].sent;
+}
+
+
+//  --------------------------------------------------------------------------
+//  Return the microseconds between the origin publishing the message
+//  and the last actor receiving it.
+
+int64_t
+sphactor_trace_latency (sphactor_trace_t *self)
+{
+    assert (self);
+    if (self->hops == 0 || self->hop [self->hops - 1].received == 0)
+        return 0;
+    return self->hop [self->hops - 1].received - self->hop [0].sent;
+}
+
+
+//  --------------------------------------------------------------------------
+//  Add a hop for the actor publishing the message, unless the trace
+//  has max hops already.
+
+void
+sphactor_trace_add_hop (sphactor_trace_t *self, zuuid_t *actor, int64_t sent)
+{
+    assert (self);
+    assert (actor);
+    if (self->hops == SPHACTOR_TRACE_MAX_HOPS)
+        return;
+    trace_hop_t *hop = &self->hop [self->hops++];
+    memcpy (hop->actor, zuuid_data (actor), 16);
+    s_uuid_str (hop->actor, hop->actor_str);
+    hop->sent = sent;
+    hop->received = 0;
+}
+
+
+//  --------------------------------------------------------------------------
+//  Set when the message published at the last hop was received.
+
+void
+sphactor_trace_set_received (sphactor_trace_t *self, int64_t received)
+{
+    assert (self);
+    if (self->hops > 0 && self->hop [self->hops - 1].received == 0)
+        self->hop [self->hops - 1].received = received;
+}
+
+
+//  --------------------------------------------------------------------------
+//  Log the latency of every hop.
+
+void
+sphactor_trace_print (sphactor_trace_t *self)
+{
+    assert (self);
+    zsys_info ("trace %s #%" PRIu64 ": %" PRId64 " usecs in %zu hops",
+               self->origin_str, self->sequence, sphactor_trace_latency (self), self->hops);
+    size_t hop;
+    for (hop = 0; hop < self->hops; hop++) {
+        //  Time the actor spent handling the message before publishing it
+        int64_t dwell = hop > 0 && self->hop [hop - 1].received
+                      ? self->hop [hop].sent - self->hop [hop - 1].received : 0;
+        zsys_info ("    %zu: %s handled %" PRId64 " usecs, sent in %" PRId64 " usecs",
+                   hop, self->hop [hop].actor_str, dwell, sphactor_trace_hop_latency (self, hop));
+    }
+}
+
+
+//  Format a uuid like zuuid_str does
+
+static void
+s_uuid_str (const byte *uuid, char *str)
+{
+    static const char hex [] = "0123456789ABCDEF";
+    int byte_nbr;
+    for (byte_nbr = 0; byte_nbr < 16; byte_nbr++) {
+        str [byte_nbr * 2] = hex [uuid [byte_nbr] >> 4];
+        str [byte_nbr * 2 + 1] = hex [uuid [byte_nbr] & 15];
+    }
+    str [32] = 0;
+}
+
+static void
+s_put_number (byte **needle, uint64_t value, int size)
+{
+    int index;
+    for (index = size - 1; index >= 0; index--) {
+        (*needle) [index] = (byte) (value & 255);
+        value >>= 8;
+    }
+    *needle += size;
+}
+
+static uint64_t
+s_get_number (const byte **needle, int size)
+{
+    uint64_t value = 0;
+    int index;
+    for (index = 0; index < size; index++)
+        value = (value << 8) | (*needle) [index];
+    *needle += size;
+    return value;
+}
+
+
+//  --------------------------------------------------------------------------
+//  Self test of this class
+
+void
+sphactor_trace_test (bool verbose)
+{
+    printf (" * sphactor_trace: ");
+
+    //  @selftest
+    //  Simple create/destroy test
+    zuuid_t *origin = zuuid_new ();
+    zuuid_t *forwarder = zuuid_new ();
+    sphactor_trace_t *self = sphactor_trace_new (origin, 42);
+    assert (self);
+    assert (streq (sphactor_trace_origin (self), zuuid_str (origin)));
+    assert (sphactor_trace_sequence (self) == 42);
+    assert (sphactor_trace_hops (self) == 0);
+    assert (sphactor_trace_latency (self) == 0);
+
+    //  Two hops survive encoding
+    sphactor_trace_add_hop (self, origin, 1000);
+    sphactor_trace_set_received (self, 1010);
+    sphactor_trace_add_hop (self, forwarder, 1050);
+    zframe_t *frame = sphactor_trace_encode (self);
+    assert (sphactor_trace_is (frame));
+    sphactor_trace_t *copy = sphactor_trace_decode (frame);
+    zframe_destroy (&frame);
+    assert (copy);
+    sphactor_trace_set_received (copy, 1080);
+    assert (sphactor_trace_sequence (copy) == 42);
+    assert (sphactor_trace_hops (copy) == 2);
+    assert (streq (sphactor_trace_hop_actor (copy, 1), zuuid_str (forwarder)));
+    assert (sphactor_trace_hop_latency (copy, 0) == 10);
+    assert (sphactor_trace_hop_latency (copy, 1) == 30);
+    assert (sphactor_trace_latency (copy) == 80);
+    if (verbose)
+        sphactor_trace_print (copy);
+    sphactor_trace_destroy (&copy);
+
+    //  Other frames aren't traces
+    frame = zframe_from ("SPHTRACE");
+    assert (!sphactor_trace_is (frame));
+    assert (sphactor_trace_decode (frame) == NULL);
+    zframe_destroy (&frame);
+
+    //  A trace stops growing at max hops
+    int hop;
+    for (hop = 0; hop < SPHACTOR_TRACE_MAX_HOPS; hop++)
+        sphactor_trace_add_hop (self, forwarder, 2000 + hop);
+    assert (sphactor_trace_hops (self) == SPHACTOR_TRACE_MAX_HOPS);
+    copy = sphactor_trace_dup (self);
+    assert (sphactor_trace_hops (copy) == SPHACTOR_TRACE_MAX_HOPS);
+    sphactor_trace_destroy (&copy);
+
+    sphactor_trace_destroy (&self);
+    assert (self == NULL);
+    zuuid_destroy (&origin);
+    zuuid_destroy (&forwarder);
+    //  @end
+
+    printf ("OK\n");
+}
@@ -0,0 +1,485 @@
+/*  =========================================================================
+    sphactor_wheel - class description
+
+    Copyright (c) the Contributors as noted in the AUTHORS file.
+
+    This file is part of Sphactor, an open-source framework for high level
+    actor model concurrency --- http://sphactor.org
+
+    This Source Code Form is subject to the terms of the Mozilla Public
+    License, v. 2.0. If a copy of the MPL was not distributed with this
+    file, You can obtain one at http://mozilla.org/MPL/2.0/.
+    =========================================================================
+*/
+
+/*
+@header
+    sphactor_wheel - hierarchical timer wheel
+@discuss
+    The wheel has a few levels of 64 slots. A slot of the first level
+    holds the timers due in a single msec, a slot of the next level the
+    timers due in 64 msecs, and so on. A timer goes into the level of the
+    highest 6 bits in which its expiry differs from the time of the wheel.
+    When the time of the wheel reaches the slot of a higher level its
+    timers move down to the levels below, until they are in the first
+    level and due.
+
+    Every level keeps a bit per slot telling whether the slot holds any
+    timers, so the next slot to visit is found with a bit scan instead of
+    walking the empty slots. Timers live in an array and the slots link
+    them by index. The id of a timer holds its index plus one in the low
+    bits and the generation of its place in the array above them. The
+    generation changes every time the place is freed, so an id of a
+    cancelled or fired timer never matches the timer which reuses the
+    place. Adding a timer and cancelling it by id take constant time.
+@end
+*/
+
+#include "sphactor_classes.h"
+
+#define WHEEL_BITS      6
+#define WHEEL_SLOTS     (1 << WHEEL_BITS)
+#define WHEEL_LEVELS    4
+#define WHEEL_DUE       (WHEEL_LEVELS * WHEEL_SLOTS)    //  List of due timers
+#define WHEEL_OVERFLOW  (WHEEL_DUE + 1)                 //  Timers beyond the levels
+#define WHEEL_LISTS     (WHEEL_OVERFLOW + 1)
+#define WHEEL_FREE      -1                              //  Timer not in use
+#define WHEEL_ID_BITS   20                              //  Bits of the index in an id
+#define WHEEL_ID_INDEX  ((1 << WHEEL_ID_BITS) - 1)
+#define WHEEL_ID_GEN    0x7FF                           //  Generations before they repeat
+
+//  A timer, linked into one of the lists of the wheel
+
+typedef struct {
+    int64_t expiry;             //  When the timer is due
+    int64_t interval;           //  Msecs till it is due again, 0 for a single shot
+    int32_t list;               //  List holding the timer or WHEEL_FREE
+    int32_t prev;               //  Previous timer in the list, -1 for the head
+    int32_t next;               //  Next timer in the list, or free timer, -1 for none
+    int32_t gen;                //  Generation, changed every time the timer is freed
+} wheel_timer_t;
+
+//  Structure of our class
+
+struct _sphactor_wheel_t {
+    int64_t now;                        //  Time the wheel has moved to
+    int32_t heads [WHEEL_LISTS];        //  First timer of each list, -1 if empty
+    int32_t tails [WHEEL_LISTS];        //  Last timer of each list, -1 if empty
+    uint64_t occupied [WHEEL_LEVELS];   //  Bit per slot holding timers
+    wheel_timer_t *timers;              //  All timers, indexed by the low bits of the id
+    size_t  timers_max;                 //  Number of timers allocated
+    int32_t free;                       //  First free timer, -1 for none
+    size_t  size;                       //  Number of timers in use
+};
+
+
+//  --------------------------------------------------------------------------
+//  Create a new sphactor_wheel
+
+sphactor_wheel_t *
+sphactor_wheel_new (int64_t now)
+{
+    sphactor_wheel_t *self = (sphactor_wheel_t *) zmalloc (sizeof (sphactor_wheel_t));
+    assert (self);
+    self->now = now;
+    int list;
+    for (list = 0; list < WHEEL_LISTS; list++) {
+        self->heads [list] = -1;
+        self->tails [list] = -1;
+    }
+    self->free = -1;
+    return self;
+}
+
+//  --------------------------------------------------------------------------
+//  Destroy the sphactor_wheel
+
+void
+sphactor_wheel_destroy (sphactor_wheel_t **self_p)
+{
+    assert (self_p);
+    if (*self_p) {
+        sphactor_wheel_t *self = *self_p;
+        free (self->timers);
+        //  Free object itself
+        free (self);
+        *self_p = NULL;
+    }
+}
+
+//  Return the index of the lowest bit set
+
+static int
+s_wheel_lowest (uint64_t bits)
+{
+    assert (bits);
+#if defined (__GNUC__)
+    return __builtin_ctzll (bits);
+#else
+    int index = 0;
+    while ((bits & 1) == 0) {
+        bits >>= 1;
+        index++;
+    }
+    return index;
+#endif
+}
+
+//  Return the bits of the slots after the slot at index
+
+static uint64_t
+s_wheel_after (uint64_t bits, int index)
+{
+    return index == WHEEL_SLOTS - 1 ? 0 : bits & (~(uint64_t) 0 << (index + 1));
+}
+
+//  Return the id of the timer at index
+
+static int
+s_wheel_id (sphactor_wheel_t *self, int32_t index)
+{
+    return (self->timers [index].gen << WHEEL_ID_BITS) | (index + 1);
+}
+
+//  Return the index of the timer with an id, -1 if there is none
+
+static int32_t
+s_wheel_index (sphactor_wheel_t *self, int id)
+{
+    if (id <= 0)
+        return -1;
+    int32_t index = (id & WHEEL_ID_INDEX) - 1;
+    if (index < 0 || (size_t) index >= self->timers_max
+    ||  self->timers [index].list == WHEEL_FREE
+    ||  self->timers [index].gen != (id >> WHEEL_ID_BITS))
+        return -1;
+    return index;
+}
+
+//  Put a timer on the free list, ids of its last use no longer match
+
+static void
+s_wheel_free (sphactor_wheel_t *self, int32_t index)
+{
+    wheel_timer_t *timer = &self->timers [index];
+    timer->gen = (timer->gen + 1) & WHEEL_ID_GEN;
+    timer->next = self->free;
+    self->free = index;
+    self->size--;
+}
+
+static void
+s_wheel_link (sphactor_wheel_t *self, int32_t index, int32_t list)
+{
+    wheel_timer_t *timer = &self->timers [index];
+    timer->list = list;
+    timer->next = -1;
+    timer->prev = self->tails [list];
+    if (self->tails [list] == -1)
+        self->heads [list] = index;
+    else
+        self->timers [self->tails [list]].next = index;
+    self->tails [list] = index;
+    if (list < WHEEL_DUE)
+        self->occupied [list / WHEEL_SLOTS] |= (uint64_t) 1 << (list % WHEEL_SLOTS);
+}
+
+static void
+s_wheel_unlink (sphactor_wheel_t *self, int32_t index)
+{
+    wheel_timer_t *timer = &self->timers [index];
+    int32_t list = timer->list;
+    assert (list != WHEEL_FREE);
+    if (timer->prev == -1)
+        self->heads [list] = timer->next;
+    else
+        self->timers [timer->prev].next = timer->next;
+    if (timer->next == -1)
+        self->tails [list] = timer->prev;
+    else
+        self->timers [timer->next].prev = timer->prev;
+    if (list < WHEEL_DUE && self->heads [list] == -1)
+        self->occupied [list / WHEEL_SLOTS] &= ~((uint64_t) 1 << (list % WHEEL_SLOTS));
+    timer->list = WHEEL_FREE;
+}
+
+//  Put a timer in the list matching its expiry
+
+static void
+s_wheel_place (sphactor_wheel_t *self, int32_t index)
+{
+    int64_t expiry = self->timers [index].expiry;
+    if (expiry <= self->now) {
+        s_wheel_link (self, index, WHEEL_DUE);
+        return;
+    }
+    //  The level of the highest bits in which the expiry differs from now
+    uint64_t differ = (uint64_t) expiry ^ (uint64_t) self->now;
+    int level;
+    for (level = 0; level < WHEEL_LEVELS; level++) {
+        if ((differ >> (WHEEL_BITS * (level + 1))) == 0) {
+            int slot = (int) (((uint64_t) expiry >> (WHEEL_BITS * level)) & (WHEEL_SLOTS - 1));
+            s_wheel_link (self, index, level * WHEEL_SLOTS + slot);
+            return;
+        }
+    }
+    s_wheel_link (self, index, WHEEL_OVERFLOW);
+}
+
+//  Move the timers of a list to the lists matching their expiry. Timers
+//  beyond the levels can go back to the same list so take it off first.
+
+static void
+s_wheel_cascade (sphactor_wheel_t *self, int32_t list)
+{
+    int32_t index = self->heads [list];
+    self->heads [list] = -1;
+    self->tails [list] = -1;
+    if (list < WHEEL_DUE)
+        self->occupied [list / WHEEL_SLOTS] &= ~((uint64_t) 1 << (list % WHEEL_SLOTS));
+    while (index != -1) {
+        int32_t next = self->timers [index].next;
+        s_wheel_place (self, index);
+        index = next;
+    }
+}
+
+//  Move the wheel to a time. Only call it with times at which nothing
+//  happens before, see sphactor_wheel_next.
+
+static void
+s_wheel_move (sphactor_wheel_t *self, int64_t now)
+{
+    assert (now > self->now);
+    self->now = now;
+    //  Higher levels first, their timers can land in the lower slots we
+    //  reached at the same time
+    if ((now & ((1LL << (WHEEL_BITS * WHEEL_LEVELS)) - 1)) == 0)
+        s_wheel_cascade (self, WHEEL_OVERFLOW);
+    int level;
+    for (level = WHEEL_LEVELS - 1; level >= 0; level--) {
+        if (level > 0 && (now & ((1LL << (WHEEL_BITS * level)) - 1)) != 0)
+            continue;   //  Not at the start of a slot of this level
+        int slot = (int) (((uint64_t) now >> (WHEEL_BITS * level)) & (WHEEL_SLOTS - 1));
+        s_wheel_cascade (self, level * WHEEL_SLOTS + slot);
+    }
+}
+
+int
+sphactor_wheel_add (sphactor_wheel_t *self, int64_t expiry, int64_t interval)
+{
+    assert (self);
+    assert (interval >= 0);
+    if (self->free == -1) {
+        size_t timers_max = self->timers_max ? self->timers_max * 2 : 16;
+        assert (timers_max <= WHEEL_ID_INDEX);
+        self->timers = (wheel_timer_t *) realloc (self->timers, timers_max * sizeof (wheel_timer_t));
+        assert (self->timers);
+        size_t index;
+        for (index = self->timers_max; index < timers_max; index++) {
+            self->timers [index].list = WHEEL_FREE;
+            self->timers [index].gen = 0;
+            self->timers [index].next = index + 1 < timers_max ? (int32_t) index + 1 : -1;
+        }
+        self->free = (int32_t) self->timers_max;
+        self->timers_max = timers_max;
+    }
+    int32_t index = self->free;
+    self->free = self->timers [index].next;
+    self->timers [index].expiry = expiry;
+    self->timers [index].interval = interval;
+    s_wheel_place (self, index);
+    self->size++;
+    return s_wheel_id (self, index);
+}
+
+int
+sphactor_wheel_cancel (sphactor_wheel_t *self, int id)
+{
+    assert (self);
+    int32_t index = s_wheel_index (self, id);
+    if (index == -1)
+        return -1;
+    s_wheel_unlink (self, index);
+    s_wheel_free (self, index);
+    return 0;
+}
+
+size_t
+sphactor_wheel_size (sphactor_wheel_t *self)
+{
+    assert (self);
+    return self->size;
+}
+
+int64_t
+sphactor_wheel_next (sphactor_wheel_t *self)
+{
+    assert (self);
+    if (self->heads [WHEEL_DUE] != -1)
+        return self->now;
+    //  The slots of a level all come after the slots of the level below,
+    //  so the first slot holding timers in the lowest level is next
+    int level;
+    for (level = 0; level < WHEEL_LEVELS; level++) {
+        int shift = WHEEL_BITS * level;
+        int slot = (int) (((uint64_t) self->now >> shift) & (WHEEL_SLOTS - 1));
+        uint64_t after = s_wheel_after (self->occupied [level], slot);
+        if (after) {
+            int64_t above = self->now & ~((1LL << (shift + WHEEL_BITS)) - 1);
+            return above | ((int64_t) s_wheel_lowest (after) << shift);
+        }
+    }
+    if (self->heads [WHEEL_OVERFLOW] != -1) {
+        int shift = WHEEL_BITS * WHEEL_LEVELS;
+        return (self->now & ~((1LL << shift) - 1)) + (1LL << shift);
+    }
+    return INT64_MAX;
+}
+
+int
+sphactor_wheel_pop (sphactor_wheel_t *self, int64_t now)
+{
+    assert (self);
+    //  Visit the times something happens till we're at now or have a timer due
+    while (self->heads [WHEEL_DUE] == -1) {
+        int64_t next = sphactor_wheel_next (self);
+        if (next > now)
+            break;
+        s_wheel_move (self, next);
+    }
+    if (now > self->now && self->heads [WHEEL_DUE] == -1)
+        self->now = now;
+
+    int32_t index = self->heads [WHEEL_DUE];
+    if (index == -1)
+        return 0;
+    s_wheel_unlink (self, index);
+    wheel_timer_t *timer = &self->timers [index];
+    int id = s_wheel_id (self, index);
+    if (timer->interval == 0)
+        s_wheel_free (self, index);
+    else {
+        //  Skip the expiries we missed, like the timeout of an actor does
+        timer->expiry += timer->interval;
+        if (timer->expiry <= now)
+            timer->expiry += ((now - timer->expiry) / timer->interval + 1) * timer->interval;
+        s_wheel_place (self, index);
+    }
+    return id;
+}
+
+//  --------------------------------------------------------------------------
+//  Self test of this class
+
+// If your selftest reads SCMed fixture data, please keep it in
+// src/selftest-ro; if your test creates filesystem objects, please
+// do so under src/selftest-rw.
+// The following pattern is suggested for C selftest code:
+//    char *filename = NULL;
+//    filename = zsys_sprintf ("%s/%s", SELFTEST_DIR_RO, "mytemplate.file");
+//    assert (filename);
+//    ... use the "filename" for I/O ...
+//    zstr_free (&filename);
+// This way the same "filename" variable can be reused for many subtests.
+#define SELFTEST_DIR_RO "src/selftest-ro"
+#define SELFTEST_DIR_RW "src/selftest-rw"
+
+void
+sphactor_wheel_test (bool verbose)
+{
+    printf (" * sphactor_wheel: ");
+
+    //  @selftest
+    //  Simple create/destroy test
+    sphactor_wheel_t *self = sphactor_wheel_new (1000);
+    assert (self);
+    assert (sphactor_wheel_size (self) == 0);
+    assert (sphactor_wheel_next (self) == INT64_MAX);
+    assert (sphactor_wheel_pop (self, 2000) == 0);
+    sphactor_wheel_destroy (&self);
+    assert (self == NULL);
+
+    //  Timers are due at their expiry, periodic ones again after their
+    //  interval, cancelled ones never
+    self = sphactor_wheel_new (0);
+    int once = sphactor_wheel_add (self, 10, 0);
+    int fast = sphactor_wheel_add (self, 5, 5);
+    int slow = sphactor_wheel_add (self, 100000, 0);
+    int gone = sphactor_wheel_add (self, 7, 0);
+    assert (once > 0 && fast > 0 && slow > 0 && gone > 0);
+    assert (sphactor_wheel_size (self) == 4);
+    assert (sphactor_wheel_cancel (self, gone) == 0);
+    assert (sphactor_wheel_cancel (self, gone) == -1);
+    assert (sphactor_wheel_cancel (self, 12345) == -1);
+    assert (sphactor_wheel_size (self) == 3);
+    assert (sphactor_wheel_next (self) == 5);
+    assert (sphactor_wheel_pop (self, 4) == 0);
+    assert (sphactor_wheel_pop (self, 5) == fast);
+    assert (sphactor_wheel_pop (self, 5) == 0);
+    int id = sphactor_wheel_pop (self, 10);
+    int other = sphactor_wheel_pop (self, 10);
+    assert ((id == fast && other == once) || (id == once && other == fast));
+    assert (sphactor_wheel_pop (self, 10) == 0);
+    assert (sphactor_wheel_size (self) == 2);
+    //  A periodic timer which fell behind skips the missed expiries
+    assert (sphactor_wheel_pop (self, 99999) == fast);
+    assert (sphactor_wheel_pop (self, 99999) == 0);
+    assert (sphactor_wheel_pop (self, 100000) != 0);
+    assert (sphactor_wheel_pop (self, 100000) != 0);
+    assert (sphactor_wheel_pop (self, 100000) == 0);
+    assert (sphactor_wheel_size (self) == 1);
+    assert (sphactor_wheel_cancel (self, fast) == 0);
+    assert (sphactor_wheel_size (self) == 0);
+    sphactor_wheel_destroy (&self);
+
+    //  Ids of cancelled and fired timers don't match the timers reusing
+    //  their place
+    self = sphactor_wheel_new (0);
+    gone = sphactor_wheel_add (self, 10, 0);
+    assert (sphactor_wheel_cancel (self, gone) == 0);
+    id = sphactor_wheel_add (self, 0, 0);
+    assert (id > 0 && id != gone);
+    assert (sphactor_wheel_cancel (self, gone) == -1);
+    assert (sphactor_wheel_size (self) == 1);
+    assert (sphactor_wheel_pop (self, 0) == id);
+    other = sphactor_wheel_add (self, 20, 0);
+    assert (other > 0 && other != id && other != gone);
+    assert (sphactor_wheel_cancel (self, id) == -1);
+    assert (sphactor_wheel_size (self) == 1);
+    assert (sphactor_wheel_cancel (self, other) == 0);
+    sphactor_wheel_destroy (&self);
+
+    //  Many timers spread over all levels fire in order of expiry
+#define TIMERS 5000
+    self = sphactor_wheel_new (123);
+    //  A new wheel hands out ids 1 to TIMERS
+    int64_t *expiries = (int64_t *) zmalloc ((TIMERS + 1) * sizeof (int64_t));
+    int i;
+    for (i = 0; i < TIMERS; i++) {
+        int64_t expiry = 123 + 1 + ((int64_t) i * 7919) % 20000000;
+        id = sphactor_wheel_add (self, expiry, 0);
+        assert (id > 0 && id <= TIMERS);
+        expiries [id] = expiry;
+    }
+    int64_t now = 123;
+    int64_t last = 0;
+    int fired = 0;
+    while (sphactor_wheel_size (self) > 0) {
+        now = sphactor_wheel_next (self);
+        assert (now != INT64_MAX);
+        id = sphactor_wheel_pop (self, now);
+        while (id) {
+            assert (expiries [id] == now);
+            assert (expiries [id] >= last);
+            last = expiries [id];
+            fired++;
+            id = sphactor_wheel_pop (self, now);
+        }
+    }
+    assert (fired == TIMERS);
+    free (expiries);
+    sphactor_wheel_destroy (&self);
+    //  @end
+    printf ("OK\n");
+}
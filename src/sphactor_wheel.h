@@ -0,0 +1,72 @@
+/*  =========================================================================
+    sphactor_wheel - class description
+
+    Copyright (c) the Contributors as noted in the AUTHORS file.
+
+    This file is part of Sphactor, an open-source framework for high level
+    actor model concurrency --- http://sphactor.org
+
+    This Source Code Form is subject to the terms of the Mozilla Public
+    License, v. 2.0. If a copy of the MPL was not distributed with this
+    file, You can obtain one at http://mozilla.org/MPL/2.0/.
+    =========================================================================
+*/
+
+#ifndef SPHACTOR_WHEEL_H_INCLUDED
+#define SPHACTOR_WHEEL_H_INCLUDED
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//  @warning THE FOLLOWING @INTERFACE BLOCK IS AUTO-GENERATED BY ZPROJECT
+//  @warning Please edit the model at "api/sphactor_wheel.api" to make changes.
+//  @interface
+//  This is a stable class, and may not change except for emergencies. It
+//  is provided in stable builds.
+//  Create a new timer wheel starting at the given time
+SPHACTOR_PRIVATE sphactor_wheel_t *
+    sphactor_wheel_new (int64_t now);
+
+//  Destroy the timer wheel and its timers
+SPHACTOR_PRIVATE void
+    sphactor_wheel_destroy (sphactor_wheel_t **self_p);
+
+//  Add a timer due at expiry. A timer with an interval is due again
+//  every interval msecs after that, pass 0 for a single shot. Returns
+//  the id of the timer, which is more than 0. The id of a timer which
+//  was cancelled or fired for the last time never matches a later timer.
+SPHACTOR_PRIVATE int
+    sphactor_wheel_add (sphactor_wheel_t *self, int64_t expiry, int64_t interval);
+
+//  Cancel a timer. Returns 0 on success, -1 if there is no such timer.
+SPHACTOR_PRIVATE int
+    sphactor_wheel_cancel (sphactor_wheel_t *self, int id);
+
+//  Return the number of timers
+SPHACTOR_PRIVATE size_t
+    sphactor_wheel_size (sphactor_wheel_t *self);
+
+//  Return the time to wake up for the next timer, INT64_MAX if there
+//  are no timers. The wheel might only need to move timers closer to
+//  their expiry at that time, so pop can find no timer due then.
+SPHACTOR_PRIVATE int64_t
+    sphactor_wheel_next (sphactor_wheel_t *self);
+
+//  Move the wheel to now and return the id of a timer which is due, or
+//  0 when there is none. Single shot timers are removed, timers with an
+//  interval are moved to their next expiry.
+SPHACTOR_PRIVATE int
+    sphactor_wheel_pop (sphactor_wheel_t *self, int64_t now);
+
+//  Self test of this class.
+SPHACTOR_PRIVATE void
+    sphactor_wheel_test (bool verbose);
+
+//  @end
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif